@@ -0,0 +1,12 @@
+#version 330 core
+
+in vec2 uv;
+
+uniform sampler2D source;
+
+layout (location = 0) out vec4 outColor;
+
+void main()
+{
+    outColor = texture(source, uv);
+}
@@ -0,0 +1,46 @@
+#version 330 core
+
+in vec2 uv;
+
+uniform sampler2D source;
+uniform vec4      texelSize; // 1 / source size in xy.
+uniform vec4      prefilter; // Threshold, knee, 1 on the first level.
+
+layout (location = 0) out vec4 outColor;
+
+// Soft knee threshold, only on the first level so the chain carries just the bright parts.
+vec3 Prefilter(vec3 color)
+{
+    float brightness = max(color.r, max(color.g, color.b));
+    float soft       = clamp(brightness - prefilter.x + prefilter.y, 0.0, 2.0 * prefilter.y);
+    soft             = soft * soft / (4.0 * prefilter.y + 1e-4);
+    float weight     = max(soft, brightness - prefilter.x) / max(brightness, 1e-4);
+    return color * weight;
+}
+
+void main()
+{
+    // 13 taps in overlapping 2x2 boxes, stable under motion unlike a plain box.
+    vec2 d = texelSize.xy;
+    vec3 a = texture(source, uv + d * vec2(-2.0, -2.0)).rgb;
+    vec3 b = texture(source, uv + d * vec2(0.0, -2.0)).rgb;
+    vec3 c = texture(source, uv + d * vec2(2.0, -2.0)).rgb;
+    vec3 e = texture(source, uv + d * vec2(-1.0, -1.0)).rgb;
+    vec3 f = texture(source, uv + d * vec2(1.0, -1.0)).rgb;
+    vec3 g = texture(source, uv + d * vec2(-2.0, 0.0)).rgb;
+    vec3 h = texture(source, uv).rgb;
+    vec3 i = texture(source, uv + d * vec2(2.0, 0.0)).rgb;
+    vec3 j = texture(source, uv + d * vec2(-1.0, 1.0)).rgb;
+    vec3 k = texture(source, uv + d * vec2(1.0, 1.0)).rgb;
+    vec3 l = texture(source, uv + d * vec2(-2.0, 2.0)).rgb;
+    vec3 m = texture(source, uv + d * vec2(0.0, 2.0)).rgb;
+    vec3 n = texture(source, uv + d * vec2(2.0, 2.0)).rgb;
+
+    vec3 color = (e + f + j + k) * 0.125;
+    color += (a + b + g + h) * 0.03125;
+    color += (b + c + h + i) * 0.03125;
+    color += (g + h + l + m) * 0.03125;
+    color += (h + i + m + n) * 0.03125;
+
+    outColor = vec4(prefilter.z > 0.5 ? Prefilter(color) : color, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+
+in vec2 uv;
+
+uniform sampler2D source; // The smaller level, added onto the target by blending.
+uniform vec4      texelSize;
+
+layout (location = 0) out vec4 outColor;
+
+void main()
+{
+    // 3x3 tent.
+    vec2 d     = texelSize.xy;
+    vec3 color = texture(source, uv).rgb * 4.0;
+    color += (texture(source, uv + vec2(-d.x, 0.0)).rgb + texture(source, uv + vec2(d.x, 0.0)).rgb +
+              texture(source, uv + vec2(0.0, -d.y)).rgb + texture(source, uv + vec2(0.0, d.y)).rgb) * 2.0;
+    color += texture(source, uv - d).rgb + texture(source, uv + d).rgb +
+             texture(source, uv + vec2(-d.x, d.y)).rgb + texture(source, uv + vec2(d.x, -d.y)).rgb;
+
+    outColor = vec4(color / 16.0, 1.0);
+}
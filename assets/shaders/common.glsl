@@ -0,0 +1,32 @@
+// Shared by every shader through #include "common.glsl".
+
+// std140 blocks, must match the structs in renderer/uniform_ring.hpp.
+layout (std140) uniform FrameBlock
+{
+    vec2  screenSize;
+    float time;
+    float deltaTime;
+} frame;
+
+layout (std140) uniform CameraBlock
+{
+    mat4 viewProjection;
+} camera;
+
+layout (std140) uniform MaterialBlock
+{
+    vec4 color;
+} material;
+
+vec2 QuadCorner(int vertexID)
+{
+    vec2 corners[6];
+    corners[0] = vec2(-0.5, 0.5);
+    corners[1] = vec2(-0.5, -0.5);
+    corners[2] = vec2(0.5, 0.5);
+    corners[3] = vec2(0.5, 0.5);
+    corners[4] = vec2(-0.5, -0.5);
+    corners[5] = vec2(0.5, -0.5);
+
+    return corners[vertexID];
+}
@@ -0,0 +1,15 @@
+// Shared by cull.comp and indirect.vert, must match CullObject in renderer/gpu_culling.hpp.
+
+struct CullObject
+{
+    vec4 bounds; // Center and radius.
+    uint color;
+    uint padding0;
+    uint padding1;
+    uint padding2;
+};
+
+layout (std430, binding = 0) readonly buffer ObjectBuffer
+{
+    CullObject objects[];
+};
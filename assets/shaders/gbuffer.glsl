@@ -0,0 +1,13 @@
+// Second target of the scene pass, read by lighting.frag. Normal xy in rg, emission in b,
+// alpha only weights the blend. Passes with a single target drop it.
+layout (location = 1) out vec4 outSurface;
+
+vec4 Surface(vec3 normal, float emission, float alpha)
+{
+    return vec4(normal.xy * 0.5 + 0.5, emission, alpha);
+}
+
+vec4 FlatSurface(float emission, float alpha)
+{
+    return Surface(vec3(0.0, 0.0, 1.0), emission, alpha);
+}
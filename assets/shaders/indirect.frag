@@ -0,0 +1,13 @@
+#version 430 core
+
+#include "gbuffer.glsl"
+
+flat in vec4 objectColor;
+
+layout (location = 0) out vec4 outColor;
+
+void main()
+{
+    outColor   = objectColor;
+    outSurface = FlatSurface(0.0, objectColor.a);
+}
@@ -0,0 +1,21 @@
+#version 430 core
+
+#include "common.glsl"
+#include "cull_object.glsl"
+
+// Instanced attribute filled with 0..N-1, baseInstance of each command picks the object.
+layout (location = 0) in uint objectIndex;
+
+flat out vec4 objectColor;
+
+void main()
+{
+    CullObject object = objects[objectIndex];
+
+    // Four corners, indexed as two triangles.
+    vec2  corner = vec2((gl_VertexID & 1) != 0 ? 0.5 : -0.5, (gl_VertexID & 2) != 0 ? -0.5 : 0.5);
+    float side   = object.bounds.w * 1.41421356;
+
+    gl_Position = camera.viewProjection * vec4(object.bounds.xy + corner * side, object.bounds.z, 1.0);
+    objectColor = unpackUnorm4x8(object.color);
+}
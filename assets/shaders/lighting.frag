@@ -0,0 +1,45 @@
+#version 330 core
+
+in vec2 uv;
+
+// GLSL 330 has no sampler bindings, the units are set after linking.
+uniform sampler2D      albedo;  // Unit 0.
+uniform sampler2D      surface; // Unit 1.
+uniform samplerBuffer  lights;  // Unit 2. Two texels per light: position, radius, height | color, intensity.
+uniform usamplerBuffer tiles;   // Unit 3. Offset and count per tile, then the light indices.
+
+uniform vec4 ambient; // rgb.
+uniform vec4 grid;    // Tiles x, tiles y, tile size, target pixels per screen pixel.
+
+layout (location = 0) out vec4 outColor;
+
+void main()
+{
+    vec4  base   = texture(albedo, uv);
+    vec4  surfel = texture(surface, uv);
+    vec2  target = vec2(gl_FragCoord.x, float(textureSize(albedo, 0).y) - gl_FragCoord.y); // y down.
+    vec2  pixel  = target / grid.w;
+    ivec2 tile   = min(ivec2(target / grid.z), ivec2(grid.xy) - 1);
+    int   header = (tile.y * int(grid.x) + tile.x) * 2;
+    int   offset = int(texelFetch(tiles, header).r);
+    int   count  = int(texelFetch(tiles, header + 1).r);
+
+    vec3 normal;
+    normal.xy = surfel.rg * 2.0 - 1.0;
+    normal.z  = sqrt(max(1.0 - dot(normal.xy, normal.xy), 0.0));
+
+    vec3 light = ambient.rgb;
+    for (int i = 0; i < count; ++i)
+    {
+        int   index   = int(texelFetch(tiles, offset + i).r);
+        vec4  shape   = texelFetch(lights, index * 2);
+        vec4  color   = texelFetch(lights, index * 2 + 1);
+        vec3  toLight = vec3(shape.xy - pixel, shape.w);
+        float falloff = clamp(1.0 - length(toLight.xy) / shape.z, 0.0, 1.0);
+        float lambert = max(dot(normal, normalize(toLight)), 0.0);
+        light += color.rgb * color.a * falloff * falloff * lambert;
+    }
+
+    // Emissive surfaces ignore the lighting.
+    outColor = vec4(base.rgb * mix(light, vec3(1.0), surfel.b), base.a);
+}
@@ -0,0 +1,16 @@
+#version 330 core
+
+#include "gbuffer.glsl"
+
+in vec2 local;
+in vec4 color;
+
+layout (location = 0) out vec4 outColor;
+
+void main()
+{
+    // Soft round dot.
+    float falloff = 1.0 - smoothstep(0.5, 1.0, length(local));
+    outColor      = vec4(color.rgb, color.a * falloff);
+    outSurface    = FlatSurface(1.0, outColor.a); // Particles glow, lights don't darken them.
+}
@@ -0,0 +1,26 @@
+#version 330 core
+
+#include "common.glsl"
+
+// One stream per array, the particles stay structure of arrays on the GPU too.
+layout (location = 0) in float inX;
+layout (location = 1) in float inY;
+layout (location = 2) in float inSize;
+layout (location = 3) in vec4 inColor;
+
+out vec2 local; // -1..1 across the quad.
+out vec4 color;
+
+void main()
+{
+    vec2 corner = QuadCorner(gl_VertexID) * 2.0;
+    corner.y    = -corner.y; // y down like the pixels.
+
+    vec2 pixel = vec2(inX, inY) + corner * inSize;
+    vec2 ndc   = pixel / frame.screenSize * 2.0 - 1.0;
+    ndc.y      = -ndc.y;
+
+    gl_Position = camera.viewProjection * vec4(ndc, 1.0, 1.0);
+    local       = corner;
+    color       = inColor;
+}
@@ -0,0 +1,45 @@
+#version 330 core
+
+in vec2 uv;
+
+uniform sampler2D scene; // Unit 0, sampler object picks nearest or bilinear upscale.
+uniform sampler2D bloom; // Unit 1.
+uniform sampler3D lut;   // Unit 2.
+
+uniform vec4 effects;  // Bloom intensity (0 when off), exposure, tonemap on, grade on.
+
+layout (location = 0) out vec4 outColor;
+
+// Narkowicz's fit of the ACES filmic curve.
+vec3 Tonemap(vec3 color)
+{
+    return clamp((color * (2.51 * color + 0.03)) / (color * (2.43 * color + 0.59) + 0.14), 0.0, 1.0);
+}
+
+vec3 Grade(vec3 color)
+{
+    // Texel centers, so the ends of the LUT are not blended with the border.
+    float size  = float(textureSize(lut, 0).x);
+    vec3  coord = color * ((size - 1.0) / size) + 0.5 / size;
+    return texture(lut, coord).rgb;
+}
+
+void main()
+{
+    vec3 color = texture(scene, uv).rgb;
+    color += texture(bloom, uv).rgb * effects.x;
+    color *= effects.y;
+
+    if (effects.z > 0.5)
+    {
+        color = Tonemap(color);
+    }
+
+    color = clamp(color, 0.0, 1.0);
+    if (effects.w > 0.5)
+    {
+        color = Grade(color);
+    }
+
+    outColor = vec4(color, 1.0);
+}
@@ -1,8 +1,12 @@
 #version 330 core
 
+#include "common.glsl"
+#include "gbuffer.glsl"
+
 layout (location = 0) out vec4 outColor;
 
 void main()
 {
-    outColor = vec4(1.0);
-}
\ No newline at end of file
+    outColor   = material.color;
+    outSurface = FlatSurface(0.0, material.color.a);
+}
@@ -1,14 +1,8 @@
 #version 330 core
 
+#include "common.glsl"
+
 void main()
 {
-    vec2 vertices[6];
-    vertices[0] = vec2(-0.5, 0.5);
-    vertices[1] = vec2(-0.5, -0.5);
-    vertices[2] = vec2(0.5, 0.5);
-    vertices[3] = vec2(0.5, 0.5);
-    vertices[4] = vec2(-0.5, -0.5);
-    vertices[5] = vec2(0.5, -0.5);
-
-    gl_Position = vec4(vertices[gl_VertexID], 1.0, 1.0);
-}
\ No newline at end of file
+    gl_Position = camera.viewProjection * vec4(QuadCorner(gl_VertexID), 1.0, 1.0);
+}
@@ -0,0 +1,51 @@
+#version 330 core
+
+#include "gbuffer.glsl"
+
+in vec3       uv;
+in vec4       color;
+flat in float distanceField;
+
+// Left at its default of unit 0, GLSL 330 can't set a sampler binding in the shader.
+uniform sampler2DArray atlas;
+
+layout (location = 0) out vec4 outColor;
+
+float Median(vec3 v)
+{
+    return max(min(v.r, v.g), min(max(v.r, v.g), v.b));
+}
+
+// The atlas is point sampled for pixel art, distance fields need the interpolation.
+vec4 SampleBilinear(vec3 coord)
+{
+    vec2  size   = vec2(textureSize(atlas, 0).xy);
+    vec2  texel  = coord.xy * size - 0.5;
+    ivec2 base   = ivec2(floor(texel));
+    vec2  weight = fract(texel);
+    int   layer  = int(coord.z);
+
+    vec4 a = texelFetch(atlas, ivec3(base, layer), 0);
+    vec4 b = texelFetch(atlas, ivec3(base + ivec2(1, 0), layer), 0);
+    vec4 c = texelFetch(atlas, ivec3(base + ivec2(0, 1), layer), 0);
+    vec4 d = texelFetch(atlas, ivec3(base + ivec2(1, 1), layer), 0);
+    return mix(mix(a, b, weight.x), mix(c, d, weight.x), weight.y);
+}
+
+void main()
+{
+    if (distanceField < 0.5)
+    {
+        outColor   = texture(atlas, uv) * color;
+        outSurface = FlatSurface(0.0, outColor.a);
+        return;
+    }
+
+    // Distance fields, edge at 0.5, anti-aliased over one screen pixel whatever the scale.
+    vec4  texel    = SampleBilinear(uv);
+    float distance = distanceField < 1.5 ? texel.a : Median(texel.rgb);
+    float width    = max(fwidth(distance) * 0.5, 1e-4);
+    float alpha    = smoothstep(0.5 - width, 0.5 + width, distance);
+    outColor       = vec4(color.rgb, color.a * alpha);
+    outSurface     = FlatSurface(1.0, outColor.a); // Text stays readable in the dark.
+}
@@ -0,0 +1,29 @@
+#version 330 core
+
+#include "common.glsl"
+
+layout (location = 0) in vec2 inPosition;
+layout (location = 1) in vec2 inSize;
+layout (location = 2) in vec4 inUV;
+layout (location = 3) in vec4 inColor;
+layout (location = 4) in float inLayer;
+layout (location = 5) in float inDistanceField;
+
+out vec3       uv;
+out vec4       color;
+flat out float distanceField;
+
+void main()
+{
+    vec2 corner = QuadCorner(gl_VertexID) + 0.5; // 0..1, y up.
+    corner.y    = 1.0 - corner.y;                // y down, top left origin like the pixels.
+
+    vec2 pixel = inPosition + corner * inSize;
+    vec2 ndc   = pixel / frame.screenSize * 2.0 - 1.0;
+    ndc.y      = -ndc.y;
+
+    gl_Position   = camera.viewProjection * vec4(ndc, 1.0, 1.0);
+    uv            = vec3(mix(inUV.xy, inUV.zw, corner), inLayer);
+    color         = inColor;
+    distanceField = inDistanceField;
+}
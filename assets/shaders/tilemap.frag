@@ -0,0 +1,16 @@
+#version 330 core
+
+#include "gbuffer.glsl"
+
+in vec3 uv;
+
+// Left at its default of unit 0, GLSL 330 can't set a sampler binding in the shader.
+uniform sampler2DArray atlas;
+
+layout (location = 0) out vec4 outColor;
+
+void main()
+{
+    outColor   = texture(atlas, uv);
+    outSurface = FlatSurface(0.0, outColor.a);
+}
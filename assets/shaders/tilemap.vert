@@ -0,0 +1,24 @@
+#version 330 core
+
+#include "common.glsl"
+
+layout (location = 0) in vec2 inTile; // Map coordinates.
+layout (location = 1) in vec4 inUV;
+layout (location = 2) in float inLayer;
+
+uniform vec4 view; // Scroll x, scroll y, zoom, tile size.
+
+out vec3 uv;
+
+void main()
+{
+    vec2 corner = QuadCorner(gl_VertexID) + 0.5; // 0..1, y up.
+    corner.y    = 1.0 - corner.y;                // y down, top left origin like the pixels.
+
+    vec2 pixel = ((inTile + corner) * view.w - view.xy) * view.z;
+    vec2 ndc   = pixel / frame.screenSize * 2.0 - 1.0;
+    ndc.y      = -ndc.y;
+
+    gl_Position = camera.viewProjection * vec4(ndc, 1.0, 1.0);
+    uv          = vec3(mix(inUV.xy, inUV.zw, corner), inLayer);
+}
@@ -1,8 +1,16 @@
 #!/bin/bash
 
+# ./build.sh             builds the game.
+# ./build.sh test        also runs the particle kernel test and the headless render tests (Linux),
+#                        ./build.sh test --bless updates the golden images.
+# ./build.sh bench       also builds and runs the utility microbenchmarks, optimized. Extra arguments go to it.
+# ./build.sh profile     builds the game with PROFILE_SCOPE on, it writes profile_trace.json on exit.
+
 OS_NAME="$(uname -s)"
+TARGET="${1:-game}"
 
 SOURCES="src/main.cpp $(find src/utils -name '*.cpp') $(find src/shared -name '*.cpp')"
+SOURCES="${SOURCES} $(find src/renderer -name '*.cpp' ! -name '*_win32.cpp' ! -name '*_linux.cpp')"
 
 INCLUDES="-Iinclude -Ithird_party"
 WARNINGS="-Wno-writable-strings -Wno-format-security -Wno-write-strings"
@@ -10,12 +18,23 @@ WARNINGS="-Wno-writable-strings -Wno-format-security -Wno-write-strings"
 if [[ "$OS_NAME" == MINGW* || "$OS_NAME" == MSYS* || "$OS_NAME" == CYGWIN* ]]; then
     echo "Running on Windows (via Git Bash, MSYS, or Cygwin)"
     LIBS="-luser32 -lgdi32 -lopengl32"
+    UTILS_LIBS="-pthread"
     SOURCES="${SOURCES} src/platform/window_win32.cpp src/renderer/opengl_win32.cpp"
     OUTPUT="build/x64-Debug/game.exe"
     COMPILER="clang++"
 elif [[ "$OS_NAME" == Linux ]]; then
     echo "Running on Linux"
-    LIBS="-lX11 -lGL -lGLX"
+    # dladdr and the CPU time timers of the sampling profiler, libc has them since glibc 2.34.
+    UTILS_LIBS="-pthread -ldl -lrt"
+    # Frame pointers and exported symbols let the sampling profiler walk and name stacks.
+    FLAGS="-fno-omit-frame-pointer -rdynamic"
+    LIBS="-lX11 -lGL -lGLX ${UTILS_LIBS}"
+    if [[ -f /usr/include/X11/extensions/XInput2.h ]]; then
+        LIBS="${LIBS} -lXi" # Raw mouse motion, window_linux.cpp checks for the same header.
+    fi
+    if [[ -f /usr/include/EGL/egl.h ]]; then
+        LIBS="${LIBS} -lEGL" # --headless, opengl_linux.cpp checks for the same header.
+    fi
     SOURCES="${SOURCES} src/platform/window_linux.cpp src/renderer/opengl_linux.cpp"
     OUTPUT="build/linux-Debug/game"
     COMPILER="g++"
@@ -25,6 +44,33 @@ else
 fi
 
 
+if [[ "$TARGET" == profile ]]; then
+    DEFINES="-DD_PROFILE"
+fi
+
 mkdir -p "${OUTPUT%/*}"
 
-$COMPILER -g $SOURCES -std=c++17 -o$OUTPUT $LIBS $INCLUDES $WARNINGS 
+$COMPILER -g $FLAGS $SOURCES -std=c++17 -o$OUTPUT $LIBS $INCLUDES $DEFINES $WARNINGS || exit 1
+
+if [[ "$TARGET" == test ]]; then
+    # The SIMD kernels against the scalar one, built like the game.
+    KERNELS="${OUTPUT%/*}/particle_kernels"
+    $COMPILER -g tests/particle_kernels.cpp src/renderer/particle_kernels.cpp $(find src/utils -name '*.cpp') -std=c++17 -o$KERNELS $UTILS_LIBS $INCLUDES $WARNINGS || exit 1
+    "$KERNELS" || exit 1
+
+    if [[ "$OS_NAME" != Linux ]]; then
+        echo "The render tests need the headless EGL mode, they only run on Linux."
+        exit 1
+    fi
+
+    COMPARE="${OUTPUT%/*}/image_compare"
+    $COMPILER -g tests/image_compare.cpp $(find src/utils -name '*.cpp') -std=c++17 -o$COMPARE $UTILS_LIBS $INCLUDES $WARNINGS || exit 1
+    tests/render_tests.sh "$OUTPUT" "$COMPARE" "$2" || exit 1
+fi
+
+if [[ "$TARGET" == bench ]]; then
+    BENCH="${OUTPUT%/*}/microbench"
+    $COMPILER -O2 -g tests/microbench.cpp $(find src/utils -name '*.cpp') -std=c++17 -o$BENCH $UTILS_LIBS $INCLUDES $WARNINGS || exit 1
+    mkdir -p build/bench_tmp
+    "$BENCH" "${@:2}"
+fi
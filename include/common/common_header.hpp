@@ -1,6 +1,7 @@
 #pragma once
 
 #define D_DEBUG 1
+// #define D_PROFILE 1 // PROFILE_SCOPE timings, see utils/profiler.hpp. ./build.sh profile defines it too.
 
 // C/C++ headers.
 #include <cstdint>
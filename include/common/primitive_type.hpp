@@ -16,6 +16,7 @@ using i64 = int64_t;
 
 // Float types.
 using f32 = float;
+using f64 = double;
 
 // Char types.
 using Char  = char;
@@ -28,16 +28,30 @@ namespace drop::platform
         Display**    display;
         ::Window*    window;
         GLXFBConfig* fbc;
+        bool         headless {false}; // No X connection, the renderer draws into an offscreen surface.
+        i32          width {0};
+        i32          height {0};
 #endif // _WIN32
     };
 
     using WindowInfoPtr = WindowInfo*;
 
+    void          PlatformSetHeadless(bool headless); // Before PlatformInit, for scripted runs without a display.
     bool          PlatformInit();
+#ifdef _WIN32
+    // WGL can only load extension functions with a current context, which needs a throwaway window.
     WindowInfoPtr PlatformCreateDummyWindow();
     void          PlatformDestroyDummyWindow();
+#endif // _WIN32
     WindowInfoPtr PlatformCreateWindow(i32 width, i32 height, TITLE title);
+    bool          PlatformStartEventThread();
+    void          PlatformStopEventThread();
     void          PlatformUpdateWindow(bool& running);
+    void          PlatformWaitForEvents(i64 timeoutNs);
+#ifdef __linux__
+    // After game thread Xlib calls that may read the connection, so the event thread sees what they buffered.
+    void          PlatformNotifyQueuedEvents();
+#endif // __linux__
     void          PlatformDestroyWindow();
     void          PlatformShutdown();
 } // namespace drop::platform
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "common/common_header.hpp"
+
+#include <vector>
+
+namespace drop::renderer
+{
+    struct SkylineNode
+    {
+        u32 x {0};
+        u32 y {0}; // Height of the skyline over [x, x + width).
+        u32 width {0};
+    };
+
+    // Bottom-left skyline packer. Rectangles are placed where their top edge ends up lowest,
+    // which keeps the free space above the skyline in one piece for the rectangles to come.
+    struct SkylinePacker
+    {
+        u32                      width {0};
+        u32                      height {0};
+        u64                      usedArea {0};
+        std::vector<SkylineNode> nodes;
+    };
+
+    void SkylineInit(SkylinePacker* packer, u32 width, u32 height);
+    bool SkylinePack(SkylinePacker* packer, u32 width, u32 height, u32* outX, u32* outY);
+    f32  SkylineOccupancy(const SkylinePacker* packer);
+} // namespace drop::renderer
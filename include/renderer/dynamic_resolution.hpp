@@ -0,0 +1,37 @@
+#pragma once
+
+#include "common/common_header.hpp"
+
+namespace drop::renderer
+{
+    enum class UpscaleFilter
+    {
+        NEAREST_INTEGER, // Pixel art, the scene is scaled by a whole number and letterboxed.
+        BILINEAR
+    };
+
+    struct DynamicResolutionSettings
+    {
+        bool          enabled {true}; // false keeps the scale fixed at maxScale.
+        f32           targetFrameMs {1000.f / 60.f};
+        f32           minScale {0.5f};
+        f32           maxScale {1.f};
+        UpscaleFilter filter {UpscaleFilter::BILINEAR};
+    };
+
+    // Size of the offscreen scene target and where it lands on the screen.
+    struct InternalResolution
+    {
+        u32 width {0};
+        u32 height {0};
+        u32 viewport[4] {}; // x, y, width, height of the upscaled image on the backbuffer.
+        f32 scale {1.f};
+    };
+
+    // Picks the internal resolution that holds the frame time target. Call Configure before the
+    // first frame, Update once per frame with the GPU time of the frame before.
+    void                             DynamicResolutionConfigure(const DynamicResolutionSettings& settings);
+    const DynamicResolutionSettings& DynamicResolutionGetSettings();
+    void                             DynamicResolutionUpdate(f32 gpuFrameMs);
+    InternalResolution               DynamicResolutionGetSize(u32 screenWidth, u32 screenHeight);
+} // namespace drop::renderer
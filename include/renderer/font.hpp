@@ -0,0 +1,31 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "utils/bump_allocator.hpp"
+
+namespace drop::renderer
+{
+    using FontHandle = u32; // 0 is never a valid handle.
+
+    // Built in 8x8 ASCII bitmap font, always available after FontInit.
+    constexpr FontHandle FONT_DEFAULT {1};
+
+    struct TextMetrics
+    {
+        f32 width {0.f};
+        f32 height {0.f};
+    };
+
+    // Fonts are baked offline (bitmap or SDF / MSDF, AngelCode BMFont text format). The page images
+    // are streamed into the shared texture atlas and the glyphs point into them, a loaded font draws
+    // once FontIsReady. Laid out strings are cached, and every glyph is one instance in the sprite
+    // batch, so text costs no extra draw calls.
+    bool        FontInit();
+    FontHandle  FontLoadBMFont(const Char* filePath, utils::BumpAllocator* transientStorage);
+    bool        FontIsReady(FontHandle font); // False while the pages stream in and after they failed.
+    void        FontBeginFrame(); // Ages the layout cache.
+    void        FontDrawText(FontHandle font, const Char* text, f32 x, f32 y, f32 scale, u32 color); // Inside SpriteBatchBegin/End.
+    TextMetrics FontMeasureText(FontHandle font, const Char* text, f32 scale);
+    f32         FontLineHeight(FontHandle font, f32 scale);
+    void        FontShutdown();
+} // namespace drop::renderer
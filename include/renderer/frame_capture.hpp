@@ -0,0 +1,27 @@
+#pragma once
+
+#include "common/common_header.hpp"
+
+namespace drop::renderer
+{
+    struct FrameCaptureStats
+    {
+        u32 captured {0}; // Frames read back from the GPU.
+        u32 written {0};  // Frames the writer thread finished.
+        u32 dropped {0};  // Skipped because the ring or the writer was behind.
+        u32 inFlight {0}; // Read back, not mapped yet.
+    };
+
+    // Reads the framebuffer into a ring of pixel pack buffers and maps them a few frames later, once
+    // their fence has passed, so the readback never waits on the GPU. A writer thread flips and
+    // swizzles straight out of the mapped buffer and encodes, the main thread only maps and unmaps.
+    // When the ring is full a frame is dropped and counted instead of stalling the game.
+    bool FrameCaptureInit();
+    bool FrameCaptureScreenshot(const Char* filePath); // .qoi or .png, taken at the next FrameCaptureEndFrame.
+    bool FrameCaptureStartVideo(const Char* filePath); // Raw RGBA frames back to back, the log has the ffmpeg line.
+    void FrameCaptureStopVideo();
+    bool FrameCaptureIsRecording();
+    void FrameCaptureEndFrame(u32 framebuffer, u32 width, u32 height); // After the last pass, before the swap.
+    const FrameCaptureStats& FrameCaptureGetStats();
+    void FrameCaptureShutdown(); // Finishes every capture already read back.
+} // namespace drop::renderer
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "renderer/opengl.hpp"
+
+#ifdef _WIN32
+#include <gl/GL.h>
+#elif defined(__linux__)
+#include <GL/gl.h>
+#endif // _WIN32
+
+// Every OpenGL entry point above 1.1 is listed exactly once here and loaded from one table.
+// GL 1.1 functions (glClear, glTexImage2D, glReadPixels, ...) are exported by opengl32 / libGL
+// and are called directly.
+
+// Required by the 3.3 core baseline, the renderer refuses to start without them.
+#define GL_CORE_FUNCTIONS(X)                                           \
+    X(PFNGLCREATEPROGRAMPROC, glCreateProgram)                         \
+    X(PFNGLCREATESHADERPROC, glCreateShader)                           \
+    X(PFNGLGETUNIFORMLOCATIONPROC, glGetUniformLocation)               \
+    X(PFNGLUNIFORM1FPROC, glUniform1f)                                 \
+    X(PFNGLUNIFORM4FPROC, glUniform4f)                                 \
+    X(PFNGLUNIFORM2FVPROC, glUniform2fv)                               \
+    X(PFNGLUNIFORM3FVPROC, glUniform3fv)                               \
+    X(PFNGLUNIFORM1IPROC, glUniform1i)                                 \
+    X(PFNGLUNIFORMMATRIX4FVPROC, glUniformMatrix4fv)                   \
+    X(PFNGLVERTEXATTRIBDIVISORPROC, glVertexAttribDivisor)             \
+    X(PFNGLACTIVETEXTUREPROC, glActiveTexture)                         \
+    X(PFNGLTEXIMAGE3DPROC, glTexImage3D)                               \
+    X(PFNGLTEXSUBIMAGE3DPROC, glTexSubImage3D)                         \
+    X(PFNGLTEXBUFFERPROC, glTexBuffer)                                 \
+    X(PFNGLBUFFERSUBDATAPROC, glBufferSubData)                         \
+    X(PFNGLDRAWARRAYSINSTANCEDPROC, glDrawArraysInstanced)             \
+    X(PFNGLBINDFRAMEBUFFERPROC, glBindFramebuffer)                     \
+    X(PFNGLCHECKFRAMEBUFFERSTATUSPROC, glCheckFramebufferStatus)       \
+    X(PFNGLGENFRAMEBUFFERSPROC, glGenFramebuffers)                     \
+    X(PFNGLFRAMEBUFFERTEXTURE2DPROC, glFramebufferTexture2D)           \
+    X(PFNGLDRAWBUFFERSPROC, glDrawBuffers)                             \
+    X(PFNGLDELETEFRAMEBUFFERSPROC, glDeleteFramebuffers)               \
+    X(PFNGLBLENDEQUATIONPROC, glBlendEquation)                         \
+    X(PFNGLCLEARBUFFERFVPROC, glClearBufferfv)                         \
+    X(PFNGLSHADERSOURCEPROC, glShaderSource)                           \
+    X(PFNGLCOMPILESHADERPROC, glCompileShader)                         \
+    X(PFNGLGETSHADERIVPROC, glGetShaderiv)                             \
+    X(PFNGLGETSHADERINFOLOGPROC, glGetShaderInfoLog)                   \
+    X(PFNGLATTACHSHADERPROC, glAttachShader)                           \
+    X(PFNGLLINKPROGRAMPROC, glLinkProgram)                             \
+    X(PFNGLVALIDATEPROGRAMPROC, glValidateProgram)                     \
+    X(PFNGLGETPROGRAMIVPROC, glGetProgramiv)                           \
+    X(PFNGLGETPROGRAMINFOLOGPROC, glGetProgramInfoLog)                 \
+    X(PFNGLGENBUFFERSPROC, glGenBuffers)                               \
+    X(PFNGLGENVERTEXARRAYSPROC, glGenVertexArrays)                     \
+    X(PFNGLGETATTRIBLOCATIONPROC, glGetAttribLocation)                 \
+    X(PFNGLBINDVERTEXARRAYPROC, glBindVertexArray)                     \
+    X(PFNGLENABLEVERTEXATTRIBARRAYPROC, glEnableVertexAttribArray)     \
+    X(PFNGLVERTEXATTRIBPOINTERPROC, glVertexAttribPointer)             \
+    X(PFNGLVERTEXATTRIBIPOINTERPROC, glVertexAttribIPointer)           \
+    X(PFNGLBINDBUFFERPROC, glBindBuffer)                               \
+    X(PFNGLBINDBUFFERBASEPROC, glBindBufferBase)                       \
+    X(PFNGLBINDBUFFERRANGEPROC, glBindBufferRange)                     \
+    X(PFNGLGETUNIFORMBLOCKINDEXPROC, glGetUniformBlockIndex)           \
+    X(PFNGLUNIFORMBLOCKBINDINGPROC, glUniformBlockBinding)             \
+    X(PFNGLBUFFERDATAPROC, glBufferData)                               \
+    X(PFNGLMAPBUFFERRANGEPROC, glMapBufferRange)                       \
+    X(PFNGLUNMAPBUFFERPROC, glUnmapBuffer)                             \
+    X(PFNGLFENCESYNCPROC, glFenceSync)                                 \
+    X(PFNGLCLIENTWAITSYNCPROC, glClientWaitSync)                       \
+    X(PFNGLDELETESYNCPROC, glDeleteSync)                               \
+    X(PFNGLGETVERTEXATTRIBPOINTERVPROC, glGetVertexAttribPointerv)     \
+    X(PFNGLUSEPROGRAMPROC, glUseProgram)                               \
+    X(PFNGLDELETEVERTEXARRAYSPROC, glDeleteVertexArrays)               \
+    X(PFNGLDELETEBUFFERSPROC, glDeleteBuffers)                         \
+    X(PFNGLDELETEPROGRAMPROC, glDeleteProgram)                         \
+    X(PFNGLDETACHSHADERPROC, glDetachShader)                           \
+    X(PFNGLDELETESHADERPROC, glDeleteShader)                           \
+    X(PFNGLDRAWELEMENTSINSTANCEDPROC, glDrawElementsInstanced)         \
+    X(PFNGLGENERATEMIPMAPPROC, glGenerateMipmap)                       \
+    X(PFNGLGENSAMPLERSPROC, glGenSamplers)                             \
+    X(PFNGLDELETESAMPLERSPROC, glDeleteSamplers)                       \
+    X(PFNGLBINDSAMPLERPROC, glBindSampler)                             \
+    X(PFNGLSAMPLERPARAMETERIPROC, glSamplerParameteri)                 \
+    X(PFNGLGETSTRINGIPROC, glGetStringi)
+
+// Optional groups. A capability is only reported when the version or extension says so
+// AND every entry point of its group resolved.
+#define GL_DEBUG_OUTPUT_FUNCTIONS(X) \
+    X(PFNGLDEBUGMESSAGECALLBACKPROC, glDebugMessageCallback)
+
+#define GL_INDEXED_BLEND_FUNCTIONS(X) \
+    X(PFNGLBLENDFUNCIPROC, glBlendFunci)
+
+#define GL_TIMER_QUERY_FUNCTIONS(X)                          \
+    X(PFNGLGENQUERIESPROC, glGenQueries)                     \
+    X(PFNGLDELETEQUERIESPROC, glDeleteQueries)               \
+    X(PFNGLBEGINQUERYPROC, glBeginQuery)                     \
+    X(PFNGLENDQUERYPROC, glEndQuery)                         \
+    X(PFNGLQUERYCOUNTERPROC, glQueryCounter)                 \
+    X(PFNGLGETQUERYOBJECTIVPROC, glGetQueryObjectiv)         \
+    X(PFNGLGETQUERYOBJECTUI64VPROC, glGetQueryObjectui64v)
+
+#define GL_DIRECT_STATE_ACCESS_FUNCTIONS(X)                  \
+    X(PFNGLCREATEBUFFERSPROC, glCreateBuffers)               \
+    X(PFNGLNAMEDBUFFERDATAPROC, glNamedBufferData)           \
+    X(PFNGLNAMEDBUFFERSUBDATAPROC, glNamedBufferSubData)     \
+    X(PFNGLCREATETEXTURESPROC, glCreateTextures)             \
+    X(PFNGLTEXTURESTORAGE2DPROC, glTextureStorage2D)         \
+    X(PFNGLTEXTURESUBIMAGE2DPROC, glTextureSubImage2D)       \
+    X(PFNGLBINDTEXTUREUNITPROC, glBindTextureUnit)
+
+#define GL_BUFFER_STORAGE_FUNCTIONS(X) \
+    X(PFNGLBUFFERSTORAGEPROC, glBufferStorage)
+
+#define GL_MULTI_DRAW_INDIRECT_FUNCTIONS(X) \
+    X(PFNGLMULTIDRAWELEMENTSINDIRECTPROC, glMultiDrawElementsIndirect)
+
+#define GL_COMPUTE_SHADER_FUNCTIONS(X)               \
+    X(PFNGLDISPATCHCOMPUTEPROC, glDispatchCompute)   \
+    X(PFNGLMEMORYBARRIERPROC, glMemoryBarrier)
+
+#define GL_PARALLEL_SHADER_COMPILE_FUNCTIONS(X) \
+    X(PFNGLMAXSHADERCOMPILERTHREADSKHRPROC, glMaxShaderCompilerThreadsKHR)
+
+namespace drop::renderer
+{
+#define GL_DECLARE_FUNCTION(type, name) extern type name;
+    GL_CORE_FUNCTIONS(GL_DECLARE_FUNCTION)
+    GL_DEBUG_OUTPUT_FUNCTIONS(GL_DECLARE_FUNCTION)
+    GL_INDEXED_BLEND_FUNCTIONS(GL_DECLARE_FUNCTION)
+    GL_TIMER_QUERY_FUNCTIONS(GL_DECLARE_FUNCTION)
+    GL_DIRECT_STATE_ACCESS_FUNCTIONS(GL_DECLARE_FUNCTION)
+    GL_BUFFER_STORAGE_FUNCTIONS(GL_DECLARE_FUNCTION)
+    GL_MULTI_DRAW_INDIRECT_FUNCTIONS(GL_DECLARE_FUNCTION)
+    GL_COMPUTE_SHADER_FUNCTIONS(GL_DECLARE_FUNCTION)
+    GL_PARALLEL_SHADER_COMPILE_FUNCTIONS(GL_DECLARE_FUNCTION)
+#undef GL_DECLARE_FUNCTION
+
+    struct GLCapabilities
+    {
+        i32 major {0};
+        i32 minor {0};
+
+        bool debugOutput {false};
+        bool indexedBlend {false};
+        bool timerQuery {false};
+        bool directStateAccess {false};
+        bool bufferStorage {false};
+        bool multiDrawIndirect {false};
+        bool computeShader {false};
+        bool shaderStorageBuffer {false};
+        bool parallelShaderCompile {false};
+        bool nvxMemoryInfo {false};
+        bool atiMemInfo {false};
+    };
+
+    extern GLCapabilities g_glCaps;
+
+    void* GetGLProcAddress(const Char* name); // Implemented by opengl_<platform>.cpp.
+    bool  LoadOpenGLFunctions();
+    void  LoadOpenGLCapabilities(); // Needs a current context.
+    bool  HasGLExtension(const Char* name);
+    bool  HasGLVersion(i32 major, i32 minor);
+} // namespace drop::renderer
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "utils/bump_allocator.hpp"
+
+namespace drop::renderer
+{
+    // std430, must match assets/shaders/cull_object.glsl.
+    struct CullObject
+    {
+        f32 center[3] {};
+        f32 radius {0.f}; // Bounding sphere, the quad drawn for the object fits inside it.
+        u32 color {0xFFFFFFFF}; // RGBA8, R in the lowest byte.
+        u32 padding[3] {};
+    };
+
+    // GPU driven path for very large scenes. The objects live in a storage buffer, a compute
+    // shader frustum culls them against the camera and writes one indirect command each, and
+    // the whole set is drawn with a single glMultiDrawElementsIndirect. Needs GL 4.3 or the
+    // compute, storage buffer and multi draw indirect extensions.
+    bool GpuCullingIsSupported();
+    bool GpuCullingInit(u32 maxObjects, utils::BumpAllocator* transientStorage);
+    void GpuCullingSetObjects(const CullObject* objects, u32 count);
+    u32  GpuCullingObjectCount();
+    void GpuCullingDispatch(); // After the camera constants are flushed, before GpuCullingDraw.
+    void GpuCullingDraw();
+    void GpuCullingShutdown();
+} // namespace drop::renderer
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "utils/bump_allocator.hpp"
+
+namespace drop::renderer
+{
+    enum class GpuMemoryCategory
+    {
+        VERTEX_BUFFER,
+        INDEX_BUFFER,
+        UNIFORM_BUFFER,
+        STORAGE_BUFFER,
+        STAGING_BUFFER,
+        TEXTURE,
+        RENDER_TARGET,
+        COUNT
+    };
+
+    struct GpuMemoryCategoryStats
+    {
+        utils::Size current {0};
+        utils::Size peak {0};
+        u32         count {0};
+    };
+
+    struct GpuMemoryStats
+    {
+        GpuMemoryCategoryStats categories[(u32) GpuMemoryCategory::COUNT] {};
+
+        utils::Size total {0};
+        utils::Size peak {0};
+        utils::Size budget {0}; // 0 means no budget.
+
+        utils::Size frameUpload {0};     // Bytes uploaded during the last finished frame.
+        utils::Size peakFrameUpload {0}; // Highest frameUpload seen so far.
+
+        // Values reported by GL_NVX_gpu_memory_info / GL_ATI_meminfo, in KB. -1 if not available.
+        i64 driverTotalKB {-1};
+        i64 driverAvailableKB {-1};
+        i64 driverEvictedKB {-1};
+    };
+
+    void GpuMemoryInit(bool hasNVXMemoryInfo, bool hasATIMemInfo);
+    void GpuMemoryTrackAlloc(u32 handle, GpuMemoryCategory category, utils::Size bytes);
+    void GpuMemoryTrackFree(u32 handle, GpuMemoryCategory category);
+    void GpuMemoryTrackUpload(utils::Size bytes);
+    void GpuMemorySetBudget(utils::Size bytes);
+    bool GpuMemoryFitsBudget(utils::Size bytes);
+    void GpuMemoryBeginFrame();
+    void GpuMemoryQueryDriver();
+    void GpuMemoryReport();
+    void GpuMemoryShutdown();
+
+    const GpuMemoryStats& GpuMemoryGetStats();
+} // namespace drop::renderer
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "common/common_header.hpp"
+
+namespace drop::renderer
+{
+    using GpuTimerHandle = u32; // 0 is never a valid handle.
+
+    // GPU durations from timestamp queries. Results are read a few frames late, once the GPU has
+    // them, so measuring never stalls the pipeline. Without ARB_timer_query every timer reads -1.
+    void           GpuTimerInit();
+    GpuTimerHandle GpuTimerCreate(const Char* name);
+    void           GpuTimerBeginFrame(); // Collects finished results.
+    void           GpuTimerBegin(GpuTimerHandle handle);
+    void           GpuTimerEnd(GpuTimerHandle handle);
+    f32            GpuTimerGetMs(GpuTimerHandle handle); // Latest finished measurement, -1 if none.
+    void           GpuTimerShutdown();
+} // namespace drop::renderer
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "utils/bump_allocator.hpp"
+
+namespace drop::renderer
+{
+    constexpr u32 LIGHT_TILE_SIZE {16}; // Target pixels per tile side.
+    constexpr u32 MAX_POINT_LIGHTS {4096};
+
+    // Two RGBA32F texels in the light buffer, must match lighting.frag.
+    struct PointLight
+    {
+        f32 position[2] {}; // Screen pixels, y down like sprites.
+        f32 radius {100.f};
+        f32 height {32.f}; // Above the surface, flattens the normal map response.
+        f32 color[3] {1.f, 1.f, 1.f};
+        f32 intensity {1.f};
+    };
+
+    struct LightingStats
+    {
+        u32 lights {0};
+        u32 tiles {0};
+        u32 indices {0}; // Light references over all tiles.
+        u32 maxPerTile {0};
+    };
+
+    // Deferred 2D lighting. The scene pass writes albedo and a surface target (normal, emission),
+    // lights are binned into a screen tile grid on the CPU, and one fullscreen pass shades each
+    // pixel with only the lights listed for its tile.
+    bool                 LightingInit(utils::BumpAllocator* transientStorage);
+    void                 LightingBeginFrame(); // Clears the lights.
+    void                 LightingSetAmbient(f32 r, f32 g, f32 b);
+    void                 LightingAddPoint(const PointLight& light);
+    void                 LightingCull(u32 targetWidth, u32 targetHeight, f32 pixelScale); // pixelScale is target / screen pixels.
+    bool                 LightingBind(u32 albedoTexture, u32 surfaceTexture);               // Then draw a fullscreen triangle.
+    const LightingStats& LightingGetStats();
+    void                 LightingShutdown();
+} // namespace drop::renderer
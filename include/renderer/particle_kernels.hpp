@@ -0,0 +1,40 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "renderer/particle_system.hpp"
+
+namespace drop::renderer
+{
+    constexpr u32 PARTICLE_LANES {8}; // Widest kernel, capacities and chunks are multiples of it.
+
+    // One array per field, each PARTICLE_LANES aligned in length so kernels never need a tail loop.
+    struct ParticleArrays
+    {
+        f32* x {nullptr};
+        f32* y {nullptr};
+        f32* vx {nullptr};
+        f32* vy {nullptr};
+        f32* life {nullptr}; // Seconds left, dead at <= 0.
+        f32* invLifetime {nullptr};
+        f32* size {nullptr};
+        u32* color {nullptr};
+    };
+
+    struct UpdateParams
+    {
+        f32 deltaTime {0.f};
+        f32 gravity[2] {}; // Already scaled by deltaTime.
+        f32 damping {1.f};
+        f32 colorStart[4] {}; // 0..255 per channel.
+        f32 colorDelta[4] {};
+    };
+
+    // Updates [begin, end) and packs the survivors to begin, returns how many there are.
+    using ParticleKernelFunction = u32 (*)(const ParticleArrays& p, u32 begin, u32 end, const UpdateParams& params);
+
+    // The update kernels of the particle system, apart from it so they build and test without GL.
+    // Every kernel gives the same bits for the same input, colors round half to even like cvtps.
+    void                   ParticleKernelsInit(); // Once, before any kernel runs.
+    ParticleKernel         ParticleKernelBest();  // Widest one the CPU runs.
+    ParticleKernelFunction ParticleKernelGet(ParticleKernel kernel); // Null if the CPU or the build lacks it.
+} // namespace drop::renderer
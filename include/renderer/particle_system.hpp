@@ -0,0 +1,53 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "utils/bump_allocator.hpp"
+
+namespace drop::renderer
+{
+    using ParticleEmitterHandle = u32; // 0 is never a valid handle.
+
+    struct ParticleEmitterDesc
+    {
+        u32 capacity {4096};
+        f32 position[2] {}; // In screen pixels.
+        f32 spawnRate {0.f}; // Particles per second, bursts come on top.
+        f32 lifetime[2] {1.f, 2.f}; // Min, max in seconds.
+        f32 speed[2] {50.f, 100.f}; // Pixels per second.
+        f32 direction {0.f};        // Radians, 0 is +x and y points down like the pixels.
+        f32 spread {6.2831853f};    // Full cone angle around direction.
+        f32 size[2] {2.f, 4.f};     // Radius in pixels.
+        f32 gravity[2] {};          // Pixels per second squared.
+        f32 drag {0.f};             // Fraction of the velocity lost per second.
+        u32 colorStart {0xFFFFFFFF}; // RGBA8, R in the lowest byte. Faded to colorEnd over the lifetime.
+        u32 colorEnd {0x00FFFFFF};
+    };
+
+    enum class ParticleKernel
+    {
+        SCALAR,
+        SSSE3,
+        AVX2
+    };
+
+    struct ParticleStats
+    {
+        u32            emitters {0};
+        u32            alive {0};
+        u32            jobs {0}; // Chunks updated during the last frame.
+        ParticleKernel kernel {ParticleKernel::SCALAR};
+    };
+
+    // Particles are kept as structure of arrays in one arena. Update runs SIMD kernels picked
+    // from the CPU features, split in fixed chunks over the job system, and removes dead
+    // particles with a branchless left pack. Draw uploads the arrays as separate instance streams.
+    bool                  ParticleSystemInit(utils::Size arenaBytes, utils::BumpAllocator* transientStorage);
+    ParticleEmitterHandle ParticleEmitterCreate(const ParticleEmitterDesc& desc); // Memory lives until shutdown.
+    void                  ParticleEmitterSetPosition(ParticleEmitterHandle handle, f32 x, f32 y);
+    void                  ParticleEmitterBurst(ParticleEmitterHandle handle, u32 count);
+    void                  ParticleSystemUpdate(f32 deltaTime); // Spawns, then kicks the update jobs.
+    void                  ParticleSystemDraw();                // Waits for the jobs. Needs a GL context.
+    const ParticleStats&  ParticleSystemGetStats();
+    const Char*           ParticleKernelName(ParticleKernel kernel);
+    void                  ParticleSystemShutdown();
+} // namespace drop::renderer
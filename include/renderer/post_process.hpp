@@ -0,0 +1,43 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "renderer/render_graph.hpp"
+#include "utils/bump_allocator.hpp"
+
+namespace drop::renderer
+{
+    constexpr u32 MAX_BLOOM_LEVELS {6};
+    constexpr u32 COLOR_LUT_SIZE {16}; // Texels per side of the 3D grading LUT.
+
+    struct PostProcessSettings
+    {
+        bool bloom {true};
+        bool tonemap {true};
+        bool colorGrade {true};
+        f32  bloomThreshold {0.8f};
+        f32  bloomKnee {0.4f}; // Soft threshold width.
+        f32  bloomIntensity {0.5f};
+        f32  exposure {1.f};
+    };
+
+    // GPU time of each stage, -1 until the first result is back or while the stage is off.
+    struct PostProcessTimings
+    {
+        f32 bloomDownMs {-1.f};
+        f32 bloomUpMs {-1.f};
+        f32 finalMs {-1.f}; // Tonemap, grade and the upscale share the final pass.
+    };
+
+    // Bloom is a downsample / upsample mip chain starting at half of the scene resolution.
+    // Tonemapping and LUT grading are folded into the pass that upscales to the backbuffer,
+    // so the full resolution image is only touched once.
+    bool                      PostProcessInit(utils::BumpAllocator* transientStorage);
+    PostProcessSettings&      PostProcessGetSettings();
+    bool                      PostProcessLoadLut(const Char* path); // 256x16 strip, blue slices left to right.
+    RenderGraphResource       PostProcessAddBloom(RenderGraphResource hdr, u32 width, u32 height); // 0 when bloom is off.
+    bool                      PostProcessBindFinal(u32 sceneTexture, u32 bloomTexture);           // Units 0..2, then draw.
+    void                      PostProcessBeginFinal();
+    void                      PostProcessEndFinal();
+    const PostProcessTimings& PostProcessGetTimings();
+    void                      PostProcessShutdown();
+} // namespace drop::renderer
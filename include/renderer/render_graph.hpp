@@ -0,0 +1,59 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "utils/bump_allocator.hpp"
+
+namespace drop::renderer
+{
+    using RenderGraphResource = u16; // 0 is never a valid handle.
+    using RenderGraphPass     = u16;
+
+    enum class RenderTargetFormat
+    {
+        RGBA8,
+        RGBA16F,
+        R11G11B10F,
+        DEPTH32F
+    };
+
+    struct RenderTargetDesc
+    {
+        u32                width {0};
+        u32                height {0};
+        RenderTargetFormat format {RenderTargetFormat::RGBA8};
+    };
+
+    struct RenderPassContext
+    {
+        u32 width {0}; // Size of the pass's attachments.
+        u32 height {0};
+    };
+
+    using RenderPassFunction = void (*)(const RenderPassContext& context, void* userData);
+
+    struct RenderGraphStats
+    {
+        u32         passCount {0};
+        u32         culledPasses {0};
+        u32         virtualTextures {0};  // Transient textures declared this frame.
+        u32         physicalTextures {0}; // GL textures they ended up in.
+        utils::Size physicalBytes {0};
+    };
+
+    // Rebuilt every frame: declare textures and passes, then execute. Passes that don't lead to the
+    // backbuffer are culled, the rest run in dependency order, and transient textures whose
+    // lifetimes don't overlap share one GL texture. Textures and framebuffers are pooled across
+    // frames, steady state allocates nothing.
+    void                    RenderGraphBegin(u32 backbufferWidth, u32 backbufferHeight);
+    RenderGraphResource     RenderGraphCreateTexture(const Char* name, const RenderTargetDesc& desc);
+    RenderGraphResource     RenderGraphBackbuffer();
+    RenderGraphPass         RenderGraphAddPass(const Char* name, RenderPassFunction function, void* userData);
+    void                    RenderGraphRead(RenderGraphPass pass, RenderGraphResource resource);
+    void                    RenderGraphWrite(RenderGraphPass pass, RenderGraphResource resource, const f32* clearColor = nullptr);
+    void                    RenderGraphWriteDepth(RenderGraphPass pass, RenderGraphResource resource, bool clear);
+    void                    RenderGraphExecute();
+    u32                     RenderGraphGetTexture(RenderGraphResource resource); // GL texture, valid inside pass functions.
+    const RenderTargetDesc& RenderGraphGetDesc(RenderGraphResource resource);
+    const RenderGraphStats& RenderGraphGetStats();
+    void                    RenderGraphShutdown();
+} // namespace drop::renderer
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "utils/bump_allocator.hpp"
+
+namespace drop::renderer
+{
+    // Platform independent part of the renderer. opengl_<platform>.cpp calls these once the
+    // context is current, every frame before swapping, and before the context goes away.
+    bool RendererSetup(utils::BumpAllocator* transientStorage);
+    void RendererDrawFrame();
+    void RendererTeardown();
+
+    // Fills the scene with this many quads on the GPU culling path. Call before RendererSetup.
+    void RendererSetStressObjects(u32 count);
+
+    // Keeps about this many particles alive from an emitter in the middle of the screen. Call before RendererSetup.
+    void RendererSetStressParticles(u32 count);
+
+    // Dims the ambient light and moves this many point lights around the screen. Call before RendererSetup.
+    void RendererSetStressLights(u32 count);
+
+    // Scrolls a size x size tilemap of random tiles under the scene and edits some of its tiles
+    // every frame, so chunks keep being culled and rebuilt. Call before RendererSetup.
+    void RendererSetStressTilemap(u32 size);
+
+    // Streams this BMFont in and prints a line of sample text with it. The path must outlive the renderer. Call before RendererSetup.
+    void RendererSetFont(const Char* filePath);
+
+    // Animation steps this much per frame instead of following the wall clock, so a given frame
+    // renders the same image on every run whatever the machine. 0 goes back to the wall clock.
+    void RendererSetFixedTimestep(f32 seconds);
+
+    // The next frame steps this much instead of following the wall clock, for replays that drive
+    // the frames with the recorded deltas. A fixed timestep still wins.
+    void RendererSetFrameDelta(f32 seconds);
+
+    // Records every frame as raw RGBA from the first one on. The path must outlive the renderer. Call before RendererSetup.
+    void RendererSetCaptureVideo(const Char* filePath);
+
+    // Caps the GPU memory the renderer allocates, 0 for no cap. Optional storage shrinks or is skipped to stay under it.
+    // Call before RendererSetup.
+    void RendererSetGpuMemoryBudget(utils::Size bytes);
+} // namespace drop::renderer
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "renderer/shader_preprocessor.hpp"
+#include "utils/bump_allocator.hpp"
+
+namespace drop::renderer
+{
+    using ShaderHandle = u32; // 0 is never a valid handle.
+
+    struct ShaderProgramDesc
+    {
+        const Char* vertexPath {nullptr};
+        const Char* fragmentPath {nullptr};
+        const Char* computePath {nullptr}; // Alone, for compute programs.
+
+        const ShaderDefine* defines {nullptr}; // Permutation, injected into every stage.
+        u32                 defineCount {0};
+    };
+
+    // Compiles and links are all submitted up front and polled each frame, so the first frames
+    // render with whatever programs are ready instead of waiting for all of them.
+    // Submitting the same sources with the same defines again returns the cached variant.
+    void         ShaderManagerInit();
+    ShaderHandle ShaderSubmit(const ShaderProgramDesc& desc, utils::BumpAllocator* transientStorage);
+    void         ShaderManagerUpdate();
+    void         ShaderWaitAll();
+    bool         ShaderIsReady(ShaderHandle handle);
+    bool         ShaderIsFailed(ShaderHandle handle);
+    u32          ShaderGetProgram(ShaderHandle handle);
+    void         ShaderManagerShutdown();
+} // namespace drop::renderer
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "utils/bump_allocator.hpp"
+
+namespace drop::renderer
+{
+    struct ShaderDefine
+    {
+        const Char* name {nullptr};
+        const Char* value {nullptr}; // Optional, a bare #define when null.
+    };
+
+    // Resolves #include "file" against assets/shaders/ (each file at most once) and injects the
+    // defines right after #version, so every permutation compiles with its dead branches removed.
+    Char* ShaderPreprocess(const Char* path, const ShaderDefine* defines, u32 defineCount,
+                           utils::BumpAllocator* transientStorage, i32* outSize);
+
+    // FNV-1a over the path and the defines, identifies one variant of one source file.
+    u64 ShaderHashVariant(u64 hash, const Char* path, const ShaderDefine* defines, u32 defineCount);
+} // namespace drop::renderer
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "renderer/texture.hpp"
+#include "utils/bump_allocator.hpp"
+
+namespace drop::renderer
+{
+    enum SpriteDistanceField : u32
+    {
+        SPRITE_BITMAP, // Texel * color.
+        SPRITE_SDF,    // Distance in alpha.
+        SPRITE_MSDF    // Distance is the median of RGB.
+    };
+
+    // One instance per sprite, the quad corners are generated from gl_VertexID.
+    struct SpriteInstance
+    {
+        f32 position[2] {}; // Top left, in pixels.
+        f32 size[2] {};     // In pixels.
+        f32 uv[4] {};
+        u32 color {0xFFFFFFFF}; // RGBA8, R in the lowest byte.
+        f32 layer {0.f};
+        f32 distanceField {0.f}; // SpriteDistanceField, how the fragment shader reads the texel.
+    };
+
+    constexpr u32 MAX_SPRITES_PER_BATCH {16384};
+
+    // Every sprite samples the shared texture atlas, so a batch only flushes when it is full.
+    bool SpriteBatchInit(utils::BumpAllocator* transientStorage);
+    void SpriteBatchBegin();
+    void SpriteBatchDraw(const AtlasRegion& region, f32 x, f32 y, f32 width, f32 height, u32 color);
+    void SpriteBatchDrawInstance(const SpriteInstance& instance);
+    void SpriteBatchEnd();
+    u32  SpriteBatchDrawCalls(); // Since the last SpriteBatchBegin.
+    void SpriteBatchShutdown();
+} // namespace drop::renderer
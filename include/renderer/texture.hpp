@@ -0,0 +1,53 @@
+#pragma once
+
+#include "common/common_header.hpp"
+
+namespace drop::renderer
+{
+    // Every atlas image gets a border copied from its edge pixels so linear filtering
+    // never samples the neighbour.
+    constexpr u32 TEXTURE_ATLAS_PADDING {1};
+
+    struct AtlasRegion
+    {
+        f32 uv[4] {}; // u0, v0, u1, v1.
+        u32 layer {0};
+        u32 x {0}; // Texel position of the padded rectangle.
+        u32 y {0};
+        u32 width {0}; // Without the padding.
+        u32 height {0};
+    };
+
+    enum class TextureFilter
+    {
+        NEAREST,
+        LINEAR
+    };
+
+    // Standalone textures, for the few images that don't belong in the atlas (render targets, LUTs).
+    // The handle is tracked by its address like every other GL object, so it must not move.
+    bool TextureCreate2D(u32* outTexture, u32 width, u32 height, const u8* rgba, TextureFilter filter, bool mipmaps);
+    void TextureDestroy(u32* texture);
+
+    // One GL_TEXTURE_2D_ARRAY shared by every sprite. Images are packed into its layers at runtime,
+    // so drawing sprites from many source images never needs a texture switch.
+    bool               TextureAtlasInit(u32 size, u32 maxLayers, TextureFilter filter);
+    bool               TextureAtlasAdd(const u8* rgba, u32 width, u32 height, AtlasRegion* outRegion);
+    u32                TextureAtlasGetSize();
+
+    // TextureAtlasAdd in steps, for uploads that go through a pixel buffer: reserve the space,
+    // extrude the image into (width + 2 * padding) x (height + 2 * padding) RGBA memory and upload
+    // it. With a GL_PIXEL_UNPACK_BUFFER bound, padded is an offset into that buffer.
+    bool TextureAtlasReserve(u32 width, u32 height, AtlasRegion* outRegion);
+    void TextureAtlasExtrude(const u8* rgba, u32 width, u32 height, u8* outPadded);
+    void TextureAtlasUpload(const AtlasRegion& region, const void* padded);
+
+    // Gives the region's space back. The skyline can't shrink, so it goes on a free list that
+    // TextureAtlasReserve takes from before packing, the texels stay until something overwrites them.
+    void TextureAtlasRelease(const AtlasRegion& region);
+    const AtlasRegion& TextureAtlasWhite(); // 1x1 white texel, for untextured sprites.
+    void               TextureAtlasBind(u32 unit);
+    u32                TextureAtlasGetTexture();
+    void               TextureAtlasReport();
+    void               TextureAtlasShutdown();
+} // namespace drop::renderer
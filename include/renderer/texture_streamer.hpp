@@ -0,0 +1,24 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "renderer/texture.hpp"
+#include "utils/bump_allocator.hpp"
+
+namespace drop::renderer
+{
+    using TextureStreamHandle = u32; // 0 is never a valid handle.
+
+    // Images are read and decoded on the job system, then copied into a ring of pixel buffers
+    // and uploaded from there, so neither the decode nor the texture upload stalls the frame.
+    // Uploads are capped per frame, streaming a new area spreads over a few frames instead of
+    // landing in one.
+    bool                TextureStreamInit(utils::Size uploadBudgetPerFrame);
+    TextureStreamHandle TextureStreamLoad(const Char* filePath);
+    void                TextureStreamUpdate();
+    bool                TextureStreamIsReady(TextureStreamHandle handle);
+    bool                TextureStreamIsFailed(TextureStreamHandle handle);
+    const AtlasRegion*  TextureStreamGetRegion(TextureStreamHandle handle); // Null until ready.
+    void                TextureStreamRelease(TextureStreamHandle handle);   // Frees the atlas space, the handle reads as failed after.
+    u32                 TextureStreamPendingCount();
+    void                TextureStreamShutdown();
+} // namespace drop::renderer
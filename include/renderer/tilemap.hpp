@@ -0,0 +1,44 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "renderer/texture.hpp"
+#include "utils/bump_allocator.hpp"
+
+namespace drop::renderer
+{
+    using TilemapHandle = u32; // 0 is never a valid handle.
+
+    constexpr u32 TILEMAP_CHUNK_SIZE {32}; // Tiles per chunk side.
+    constexpr u16 TILE_EMPTY {0};
+
+    struct TilemapDesc
+    {
+        u32                width {0}; // In tiles.
+        u32                height {0};
+        f32                tileSize {16.f}; // In world pixels.
+        const AtlasRegion* tiles {nullptr}; // Tile id N is drawn with tiles[N - 1], the array is copied.
+        u32                tileCount {0};
+    };
+
+    struct TilemapStats
+    {
+        u32 chunks {0};
+        u32 visibleChunks {0};
+        u32 rebuiltChunks {0}; // During the last draw.
+        u32 drawnTiles {0};
+    };
+
+    // Maps are split into chunks whose tiles stay in a static vertex buffer. Edits only mark
+    // their chunk dirty, a chunk is rebuilt the next time it is visible, and chunks outside the
+    // view are neither rebuilt nor drawn. Maps draw in creation order, so later ones layer on top.
+    bool          TilemapInit(utils::BumpAllocator* transientStorage);
+    TilemapHandle TilemapCreate(const TilemapDesc& desc);
+    void          TilemapDestroy(TilemapHandle handle);
+    void          TilemapSetTile(TilemapHandle handle, u32 x, u32 y, u16 tile);
+    u16           TilemapGetTile(TilemapHandle handle, u32 x, u32 y);
+    void          TilemapFill(TilemapHandle handle, u32 x, u32 y, u32 width, u32 height, u16 tile);
+    void          TilemapSetScroll(TilemapHandle handle, f32 x, f32 y, f32 zoom); // Top left of the view, in world pixels.
+    void          TilemapDrawAll(u32 viewWidth, u32 viewHeight);                  // In screen pixels.
+    TilemapStats  TilemapGetStats();                                               // Summed over every map.
+    void          TilemapShutdown();
+} // namespace drop::renderer
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "common/common_header.hpp"
+
+#include <new>
+
+namespace drop::renderer
+{
+    // Binding points, shaders declare the matching blocks in common.glsl.
+    enum UniformBinding : u32
+    {
+        UNIFORM_BINDING_FRAME,
+        UNIFORM_BINDING_CAMERA,
+        UNIFORM_BINDING_MATERIAL,
+        UNIFORM_BINDING_COUNT
+    };
+
+    // std140 layouts. vec3 is never used on its own, it pads to 16 bytes in std140 anyway.
+    struct alignas(16) FrameConstants
+    {
+        f32 screenSize[2] {};
+        f32 time {0.f};
+        f32 deltaTime {0.f};
+    };
+
+    struct alignas(16) CameraConstants
+    {
+        f32 viewProjection[16] {};
+    };
+
+    struct alignas(16) MaterialConstants
+    {
+        f32 color[4] {};
+    };
+
+    struct UniformAllocation
+    {
+        void* data {nullptr}; // CPU side, write the constants here before UniformRingFlush.
+        u32   offset {0};
+        u32   size {0};
+    };
+
+    // All constants of a frame are sub-allocated from one CPU staging block and uploaded with a
+    // single glBufferSubData. The GPU buffer holds UNIFORM_RING_FRAMES such blocks, so a frame
+    // never writes the region the previous frames may still be reading.
+    bool              UniformRingInit(u32 bytesPerFrame);
+    void              UniformRingBeginFrame();
+    UniformAllocation UniformRingAlloc(u32 bytes);
+    void              UniformRingFlush();
+    void              UniformRingBind(UniformBinding binding, const UniformAllocation& allocation);
+    void              UniformRingBindBlocks(u32 program);
+    void              UniformRingShutdown();
+
+    template<typename T>
+    T* UniformRingPush(UniformBinding binding)
+    {
+        UniformAllocation allocation {UniformRingAlloc(sizeof(T))};
+        if (!allocation.data)
+        {
+            return nullptr;
+        }
+
+        UniformRingBind(binding, allocation);
+        return new (allocation.data) T {};
+    }
+} // namespace drop::renderer
@@ -10,5 +10,114 @@ namespace drop::shared
         u32 height {0};
     };
 
-    extern ScreenSize g_screenSize;
-}
+    struct WindowState
+    {
+        bool focused {true};
+        bool visible {true}; // False while the window is fully covered.
+        bool minimized {false};
+        bool redrawRequested {true}; // Set by expose, resize and input, cleared once a frame is drawn.
+    };
+
+    enum KeyCode : u8
+    {
+        KEY_UNKNOWN,
+        KEY_A, KEY_B, KEY_C, KEY_D, KEY_E, KEY_F, KEY_G, KEY_H, KEY_I, KEY_J, KEY_K, KEY_L, KEY_M,
+        KEY_N, KEY_O, KEY_P, KEY_Q, KEY_R, KEY_S, KEY_T, KEY_U, KEY_V, KEY_W, KEY_X, KEY_Y, KEY_Z,
+        KEY_0, KEY_1, KEY_2, KEY_3, KEY_4, KEY_5, KEY_6, KEY_7, KEY_8, KEY_9,
+        KEY_F1, KEY_F2, KEY_F3, KEY_F4, KEY_F5, KEY_F6, KEY_F7, KEY_F8, KEY_F9, KEY_F10, KEY_F11, KEY_F12,
+        KEY_SPACE,
+        KEY_ENTER,
+        KEY_ESCAPE,
+        KEY_TAB,
+        KEY_BACKSPACE,
+        KEY_SHIFT,
+        KEY_CONTROL,
+        KEY_ALT,
+        KEY_UP,
+        KEY_DOWN,
+        KEY_LEFT,
+        KEY_RIGHT,
+        KEY_COUNT
+    };
+
+    enum MouseButton : u8
+    {
+        MOUSE_BUTTON_LEFT,
+        MOUSE_BUTTON_RIGHT,
+        MOUSE_BUTTON_MIDDLE,
+        MOUSE_BUTTON_COUNT
+    };
+
+    enum InputEventType : u8
+    {
+        INPUT_EVENT_KEY_DOWN,
+        INPUT_EVENT_KEY_UP,
+        INPUT_EVENT_MOUSE_MOVE,       // x, y is the new position in window pixels.
+        INPUT_EVENT_MOUSE_RAW_MOTION, // x, y is the unaccelerated device delta.
+        INPUT_EVENT_MOUSE_BUTTON_DOWN,
+        INPUT_EVENT_MOUSE_BUTTON_UP,
+        INPUT_EVENT_MOUSE_WHEEL, // y is the number of notches, positive is away from the user.
+        INPUT_EVENT_FOCUS_LOST,  // Releases everything that is held.
+        INPUT_EVENT_MOUSE_LEAVE, // The pointer left the window, the next move starts from a new position.
+        INPUT_EVENT_COUNT
+    };
+
+    struct InputEvent
+    {
+        i64            timestamp {0}; // utils::GetTimeNs() when the platform received the event.
+        InputEventType type {INPUT_EVENT_COUNT};
+        u8             code {0}; // KeyCode or MouseButton.
+        i32            x {0};
+        i32            y {0};
+    };
+
+    constexpr u32 INPUT_KEY_WORDS {(KEY_COUNT + 63) / 64};
+    constexpr u32 MAX_INPUT_EVENTS {256};
+
+    struct InputState
+    {
+        // One bit per KeyCode.
+        u64 keysDown[INPUT_KEY_WORDS] {};
+        u64 keysPressed[INPUT_KEY_WORDS] {};  // Went down this frame.
+        u64 keysReleased[INPUT_KEY_WORDS] {}; // Went up this frame. A tap inside one frame sets both edges.
+
+        // One bit per MouseButton.
+        u8 mouseButtonsDown {0};
+        u8 mouseButtonsPressed {0};
+        u8 mouseButtonsReleased {0};
+
+        i32  mouseX {0};
+        i32  mouseY {0};
+        i32  mouseDeltaX {0}; // Raw device motion when available, otherwise the change of mouseX/Y.
+        i32  mouseDeltaY {0};
+        i32  mouseWheel {0};
+        bool hasRawMotion {false};     // Set once the platform delivered a raw motion event.
+        bool hasMousePosition {false}; // mouseX/Y is a real position, cleared when the pointer leaves the window.
+
+        // Every event of this frame in arrival order, for sub-frame ordering.
+        InputEvent events[MAX_INPUT_EVENTS] {};
+        u32        eventCount {0};
+        u32        droppedEvents {0};
+    };
+
+    extern ScreenSize  g_screenSize;
+    extern WindowState g_windowState;
+    extern InputState  g_input;
+
+    void RequestRedraw();
+
+    void InputBeginFrame();
+    bool InputEventIsValid(const InputEvent& event); // Known type, and a code in range for it.
+    void InputPushEvent(const InputEvent& event);    // Rejects invalid events.
+
+    // Called with every pushed event, including the ones past MAX_INPUT_EVENTS that the frame log drops.
+    using InputEventListener = void (*)(const InputEvent& event, void* userData);
+    void InputSetEventListener(InputEventListener listener, void* userData); // Null removes it.
+
+    bool IsKeyDown(KeyCode key);
+    bool IsKeyPressed(KeyCode key);
+    bool IsKeyReleased(KeyCode key);
+    bool IsMouseButtonDown(MouseButton button);
+    bool IsMouseButtonPressed(MouseButton button);
+    bool IsMouseButtonReleased(MouseButton button);
+} // namespace drop::shared
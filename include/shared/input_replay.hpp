@@ -0,0 +1,42 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "shared/input.hpp"
+
+#include <vector>
+
+namespace drop::shared
+{
+    // Records the per-frame input events and frame deltas, and plays them back in place of
+    // the platform events so the same session can be driven any number of times.
+
+    struct InputRecorder
+    {
+        std::vector<u8>         data {};
+        std::vector<InputEvent> events {}; // This frame's, all of them, g_input.events is bounded.
+        const Char*             filePath {nullptr};
+        u32                     frameCount {0};
+        i64                     lastFrameTime {0};
+        bool                    active {false};
+    };
+
+    struct InputReplay
+    {
+        std::vector<u8> data {};
+        u64             cursor {0};
+        u32             frameCount {0};
+        u32             frame {0};
+        i64             virtualTime {0}; // Sum of the recorded frame deltas.
+        i64             startTime {0};   // Wall clock, for the benchmark summary.
+        InputState      state {};        // Replayed input, kept apart from live platform input.
+        bool            active {false};
+    };
+
+    bool InputRecorderBegin(InputRecorder* recorder, const Char* filePath);
+    void InputRecorderFrame(InputRecorder* recorder, i64 frameDeltaNs);
+    void InputRecorderEnd(InputRecorder* recorder);
+
+    bool InputReplayBegin(InputReplay* replay, const Char* filePath);
+    bool InputReplayFrame(InputReplay* replay, i64* outFrameDeltaNs);
+    void InputReplayEnd(InputReplay* replay);
+} // namespace drop::shared
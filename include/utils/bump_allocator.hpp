@@ -15,4 +15,5 @@ namespace drop::utils
 
     BumpAllocator MakeBumpAllocator(Size size);
     Char*         BumpAlloc(BumpAllocator* ba, Size size);
+    void          FreeBumpAllocator(BumpAllocator* ba);
 } // namespace drop::utils
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "common/common_header.hpp"
+
+// x86 SIMD paths are compiled per function with a target attribute and picked at runtime,
+// so the binary still runs on CPUs without the newer extensions.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define D_SIMD_X86 1
+#define D_TARGET(isa) __attribute__((target(isa)))
+#else
+#define D_TARGET(isa)
+#endif // x86 GCC/Clang
+
+namespace drop::utils
+{
+    struct CpuFeatures
+    {
+        bool sse2 {false};
+        bool ssse3 {false};
+        bool sse41 {false};
+        bool avx2 {false};
+    };
+
+    const CpuFeatures& GetCpuFeatures(); // Detected once, safe from any thread.
+} // namespace drop::utils
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "utils/bump_allocator.hpp"
+
+namespace drop::utils
+{
+    // Raw DEFLATE (RFC 1951) into a caller sized buffer. Fails instead of growing, the callers
+    // (PNG, ...) always know how big the output must be.
+    bool Inflate(const u8* data, Size size, u8* out, Size outCapacity, Size* outSize);
+
+    // zlib stream (RFC 1950): 2 byte header, DEFLATE data, Adler-32 trailer.
+    bool ZlibDecompress(const u8* data, Size size, u8* out, Size outCapacity, Size* outSize);
+
+    // zlib stream made of stored blocks only. Nothing is compressed, in exchange writing costs about
+    // as much as a copy, for the writers that care more about time than size (frame captures).
+    Size ZlibStoredBound(Size size);
+    Size ZlibCompressStored(const u8* data, Size size, u8* out); // out holds ZlibStoredBound(size) bytes.
+
+    u32 Adler32(const u8* data, Size size);
+    u32 Crc32(const u8* data, Size size, u32 crc = 0); // PNG / zip polynomial, chain calls by passing the last result.
+} // namespace drop::utils
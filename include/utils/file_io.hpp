@@ -10,7 +10,7 @@ namespace drop::utils
     i32   GetFileSize(Char* filePath);
     Char* ReadFile(Char* filePath, Char* buffer, i32* outSize);
     Char* ReadFile(Char* filePath, BumpAllocator* ba, i32* outSize);
-    void  WriteFile(Char* filePath, Char* buffer, i32 size);
+    bool  WriteFile(Char* filePath, Char* buffer, i32 size);
     bool  CopyFile(Char* fileName, Char* destName, Char* buffer);
     bool  CopyFile(Char* fileName, Char* destName, BumpAllocator* ba);
 } // namespace drop::utils
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "utils/bump_allocator.hpp"
+
+namespace drop::utils
+{
+    // Always RGBA8, rows top to bottom.
+    struct Image
+    {
+        u32 width {0};
+        u32 height {0};
+        u8* pixels {nullptr};
+    };
+
+    // Format is detected from the magic bytes. QOI, and 8 bit non-interlaced PNG
+    // (gray, gray + alpha, RGB, RGBA, palette). Safe to call from worker threads.
+    bool ImageDecode(const u8* data, Size size, Image* outImage);
+    bool ImageLoad(const Char* filePath, Image* outImage);
+    void ImageFree(Image* image);
+
+    enum class ImageFormat : u8
+    {
+        PNG, // 8 bit RGBA, stored DEFLATE blocks: big files, written at about the speed of a copy.
+        QOI
+    };
+
+    // Encoders take the same RGBA8 top to bottom layout the decoders hand out. Safe to call from worker threads.
+    Size ImageEncodeBound(ImageFormat format, u32 width, u32 height);
+    bool ImageEncode(ImageFormat format, const Image* image, u8* out, Size outCapacity, Size* outSize);
+    bool ImageSave(const Char* filePath, const Image* image, ImageFormat format);
+} // namespace drop::utils
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "common/common_header.hpp"
+
+#include <atomic>
+
+namespace drop::utils
+{
+    using JobFunction = void (*)(void* userData);
+
+    // Counts the jobs still running for one batch, shared by every job submitted with it.
+    struct JobCounter
+    {
+        std::atomic<i32> pending {0};
+    };
+
+    // Fixed pool of worker threads pulling from one shared queue. Jobs must not touch GL.
+    bool JobSystemInit(u32 workerCount); // 0 picks hardware threads - 1.
+    void JobSubmit(JobFunction function, void* userData, JobCounter* counter);
+    bool JobIsDone(const JobCounter* counter);
+    void JobWait(JobCounter* counter); // Runs queued jobs on the calling thread while waiting.
+    u32  JobWorkerCount();
+    void JobSystemShutdown();
+} // namespace drop::utils
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "common/common_header.hpp"
+#include "utils/cpu.hpp"
+
+#ifdef D_SIMD_X86
+#include <x86intrin.h> // __rdtsc.
+#else
+#include "utils/timer.hpp"
+#endif // D_SIMD_X86
+
+// Instrumented scope timings for a timeline viewer. PROFILE_SCOPE("Name") times the rest of the
+// enclosing block into a buffer owned by the calling thread: no lock, no allocation after the
+// thread's first scope. PROFILE_WRITE_TRACE writes every thread's scopes as Chrome Trace Event
+// JSON, open it in chrome://tracing or ui.perfetto.dev. Names must outlive the trace, literals.
+// Everything compiles to nothing unless D_PROFILE is defined (./build.sh profile).
+
+namespace drop::utils
+{
+    inline u64 ProfileTimestamp()
+    {
+#ifdef D_SIMD_X86
+        return __rdtsc(); // Converted to time when the trace is written.
+#else
+        return (u64) GetTimeNs();
+#endif // D_SIMD_X86
+    }
+
+    void ProfileRecord(const Char* name, u64 begin, u64 end);
+    void ProfileSetThreadName(const Char* name);
+    bool ProfileWriteTrace(const Char* filePath); // Safe while other threads keep recording.
+    void ProfileShutdown();                      // After every recording thread has stopped.
+
+    struct ProfileScope
+    {
+        const Char* name;
+        u64         begin;
+
+        explicit ProfileScope(const Char* scopeName) : name {scopeName}, begin {ProfileTimestamp()}
+        {
+        }
+
+        ~ProfileScope()
+        {
+            ProfileRecord(name, begin, ProfileTimestamp());
+        }
+    };
+} // namespace drop::utils
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef D_PROFILE
+#define PROFILE_SCOPE(name) drop::utils::ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD(name) drop::utils::ProfileSetThreadName(name)
+#define PROFILE_WRITE_TRACE(filePath) drop::utils::ProfileWriteTrace(filePath)
+#define PROFILE_SHUTDOWN() drop::utils::ProfileShutdown()
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_THREAD(name)
+#define PROFILE_WRITE_TRACE(filePath)
+#define PROFILE_SHUTDOWN()
+#endif // D_PROFILE
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "common/common_header.hpp"
+
+namespace drop::utils
+{
+    struct SamplingProfilerStats
+    {
+        u64 samples {0};
+        u64 dropped {0}; // The stack table was full.
+        u32 stacks {0};  // Distinct thread + stack pairs.
+        u32 threads {0};
+    };
+
+    // Statistical profiler for builds where PROFILE_SCOPE can't stay on. Every registered thread gets
+    // a timer on its own CPU time that raises SIGPROF about hz times per CPU second, so an idle thread
+    // costs nothing. The handler takes the program counter and a short frame pointer walk and counts
+    // the stack in a fixed lock-free table, names are only looked up when dumping. The dump is folded
+    // stacks (thread;outer;...;leaf count) for flamegraph.pl, inferno or speedscope.
+    // Linux only, the other platforms get stubs. Frames past the leaf need frame pointers and names
+    // need exported symbols, build.sh passes -fno-omit-frame-pointer and -rdynamic for that.
+    bool                         SamplingProfilerStart(u32 hz);
+    void                         SamplingProfilerRegisterThread(const Char* name); // From the thread itself, for its whole life.
+    bool                         SamplingProfilerIsRunning();
+    bool                         SamplingProfilerDump(const Char* filePath);       // Sampling keeps going.
+    const SamplingProfilerStats& SamplingProfilerGetStats();
+    void                         SamplingProfilerStop(); // Before any registered thread exits.
+} // namespace drop::utils
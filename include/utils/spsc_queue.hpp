@@ -0,0 +1,56 @@
+#pragma once
+
+#include "common/common_header.hpp"
+
+#include <atomic>
+
+// Lock-free single producer / single consumer ring buffer.
+// One thread only pushes, one thread only pops. Capacity must be a power of two.
+
+namespace drop::utils
+{
+    template <typename T, u32 Capacity>
+    struct SpscQueue
+    {
+        static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two.");
+
+        // Separate cache lines so the producer and the consumer don't fight over them.
+        alignas(64) std::atomic<u32> head {0}; // Next slot to pop, written by the consumer.
+        alignas(64) std::atomic<u32> tail {0}; // Next slot to push, written by the producer.
+        alignas(64) T items[Capacity];
+    };
+
+    template <typename T, u32 Capacity>
+    bool SpscPush(SpscQueue<T, Capacity>* queue, const T& item)
+    {
+        u32 tail {queue->tail.load(std::memory_order_relaxed)};
+        if (tail - queue->head.load(std::memory_order_acquire) == Capacity)
+        {
+            return false; // Full.
+        }
+
+        queue->items[tail & (Capacity - 1)] = item;
+        queue->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename T, u32 Capacity>
+    bool SpscPop(SpscQueue<T, Capacity>* queue, T* outItem)
+    {
+        u32 head {queue->head.load(std::memory_order_relaxed)};
+        if (head == queue->tail.load(std::memory_order_acquire))
+        {
+            return false; // Empty.
+        }
+
+        *outItem = queue->items[head & (Capacity - 1)];
+        queue->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename T, u32 Capacity>
+    u32 SpscCount(SpscQueue<T, Capacity>* queue)
+    {
+        return queue->tail.load(std::memory_order_acquire) - queue->head.load(std::memory_order_acquire);
+    }
+} // namespace drop::utils
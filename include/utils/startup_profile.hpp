@@ -0,0 +1,11 @@
+#pragma once
+
+#include "common/common_header.hpp"
+
+namespace drop::utils
+{
+    // Time-to-first-frame breakdown. Each mark closes the phase that started at the previous mark.
+    void StartupBegin();
+    void StartupMark(const Char* phase);
+    void StartupReport();
+} // namespace drop::utils
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "common/common_header.hpp"
+
+namespace drop::utils
+{
+    i64 GetTimeNs(); // Monotonic, high resolution. Only meaningful as a difference.
+
+    // Summary of a batch of timings, in whatever unit the samples are in.
+    struct TimingStats
+    {
+        u32 count {0};
+        f64 min {0.0};
+        f64 mean {0.0};
+        f64 median {0.0};
+        f64 p95 {0.0};
+        f64 p99 {0.0};
+        f64 max {0.0};
+    };
+
+    TimingStats ComputeTimingStats(f64* samples, u32 count); // Sorts the samples in place. Nearest rank percentiles.
+} // namespace drop::utils
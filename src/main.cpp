@@ -1,16 +1,253 @@
+#include "renderer/dynamic_resolution.hpp"
+#include "renderer/frame_capture.hpp"
 #include "renderer/opengl.hpp"
+#include "renderer/renderer.hpp"
+#include "shared/input.hpp"
+#include "shared/input_replay.hpp"
+#include "utils/file_io.hpp"
+#include "utils/job_system.hpp"
+#include "utils/profiler.hpp"
+#include "utils/sampling_profiler.hpp"
+#include "utils/startup_profile.hpp"
+#include "utils/timer.hpp"
+
+#include <cstdio>  // snprintf.
+#include <cstdlib> // atof, atoi.
+#include <cstring> // strcmp.
+#include <vector>
 
 using namespace drop;
 
-int main()
+namespace
+{
+    enum LoopMode
+    {
+        LOOP_MODE_CONTINUOUS,    // Render as fast as possible, always.
+        LOOP_MODE_THROTTLE_IDLE, // Cap the frame rate when unfocused, stop rendering when hidden.
+        LOOP_MODE_ON_DEMAND      // Only render after input, expose or an explicit RequestRedraw.
+    };
+
+    constexpr i64 UNFOCUSED_FRAME_NS {1000000000 / 10};
+    constexpr i64 IDLE_WAIT_NS {1000000000 / 4};
+    constexpr u32 FRAME_STATS_WARMUP {10}; // Shader compiles and first uploads, not what the stats are about.
+
+    // Returns true when a frame should be drawn now. Otherwise it blocks until an event
+    // arrives or the next capped frame is due, so an idle window doesn't burn a core.
+    bool ThrottleFrame(LoopMode mode, i64 lastRenderTime)
+    {
+        const shared::WindowState& window {shared::g_windowState};
+        switch (mode)
+        {
+        case LOOP_MODE_THROTTLE_IDLE:
+        {
+            if (window.minimized || !window.visible)
+            {
+                platform::PlatformWaitForEvents(IDLE_WAIT_NS);
+                return false;
+            }
+
+            if (!window.focused)
+            {
+                i64 remaining {lastRenderTime + UNFOCUSED_FRAME_NS - utils::GetTimeNs()};
+                if (remaining > 0)
+                {
+                    platform::PlatformWaitForEvents(remaining);
+                    return false;
+                }
+            }
+            return true;
+        }
+        case LOOP_MODE_ON_DEMAND:
+        {
+            if (window.redrawRequested && !window.minimized && window.visible)
+            {
+                return true;
+            }
+
+            platform::PlatformWaitForEvents(IDLE_WAIT_NS);
+            return false;
+        }
+        default:
+            return true;
+        }
+    }
+
+    // Plain "key value" lines, easy to pick apart from a shell script.
+    void WriteFrameStats(const Char* filePath, std::vector<f64>& frameMs)
+    {
+        utils::TimingStats stats {utils::ComputeTimingStats(frameMs.data(), (u32) frameMs.size())};
+
+        Char text[256] {};
+        i32  size {snprintf(text, sizeof(text), "frames %u\nmean_ms %.3f\nmedian_ms %.3f\np95_ms %.3f\np99_ms %.3f\nmax_ms %.3f\n",
+                            stats.count, stats.mean, stats.median, stats.p95, stats.p99, stats.max)};
+        if (!utils::WriteFile((Char*) filePath, text, size))
+        {
+            D_ERROR("Failed to write frame stats: %s", filePath);
+        }
+    }
+} // namespace anonymous
+
+int main(int argc, char** argv)
 {
 #ifdef _WIN32
     // This is just to make the window size not scaled. So it will be pixel perfect.
     SetProcessDPIAware();
 #endif // DEBUG
 
+    utils::StartupBegin();
+    PROFILE_THREAD("Main");
+    utils::SamplingProfilerRegisterThread("Main");
     D_TRACE("Starting Drop Engine!");
 
+    // --record <file> saves the input of this session, --replay <file> drives the session from one.
+    // --loop continuous|throttle|on-demand picks how the main loop behaves while idle.
+    // --upscale nearest|bilinear, --target-fps <n> and --resolution-scale <s> drive the internal resolution,
+    // a fixed scale turns the controller off. --objects <n> fills the scene for the GPU culling path,
+    // --particles <n> keeps that many particles alive, --lights <n> turns the night on with that many lights,
+    // --tilemap <n> scrolls an n x n tilemap under the scene and edits it every frame.
+    // --font <file.fnt> streams a BMFont in and prints sample text with it.
+    // --capture <file> records the frames as raw RGBA video, F11 and F12 capture at runtime.
+    // For scripted runs: --frames <n> quits after n frames, --fixed-step <ms> makes the animation
+    // independent of the frame rate, --screenshot <frame> <file> saves one frame (.png or .qoi)
+    // and --frame-stats <file> writes the frame time median and percentiles on exit.
+    // --headless renders without a window or X server (Linux, EGL), for the render tests.
+    // --sample <file> runs the sampling profiler and writes folded stacks on exit, F8 writes them on demand.
+    // --vram-budget <MB> caps the GPU memory the renderer allocates.
+    const Char*                         recordPath {nullptr};
+    const Char*                         replayPath {nullptr};
+    LoopMode                            loopMode {LOOP_MODE_THROTTLE_IDLE};
+    renderer::DynamicResolutionSettings resolution {};
+    u32                                 frameLimit {0};
+    u32                                 screenshotFrame {0};
+    const Char*                         screenshotPath {nullptr};
+    const Char*                         frameStatsPath {nullptr};
+    const Char*                         samplePath {nullptr};
+    for (i32 i {1}; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            recordPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            replayPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--loop") == 0 && i + 1 < argc)
+        {
+            const Char* mode {argv[++i]};
+            if (strcmp(mode, "continuous") == 0)
+            {
+                loopMode = LOOP_MODE_CONTINUOUS;
+            }
+            else if (strcmp(mode, "throttle") == 0)
+            {
+                loopMode = LOOP_MODE_THROTTLE_IDLE;
+            }
+            else if (strcmp(mode, "on-demand") == 0)
+            {
+                loopMode = LOOP_MODE_ON_DEMAND;
+            }
+            else
+            {
+                D_WARN("Unknown loop mode: %s", mode);
+            }
+        }
+        else if (strcmp(argv[i], "--upscale") == 0 && i + 1 < argc)
+        {
+            const Char* filter {argv[++i]};
+            if (strcmp(filter, "nearest") == 0)
+            {
+                resolution.filter = renderer::UpscaleFilter::NEAREST_INTEGER;
+            }
+            else if (strcmp(filter, "bilinear") == 0)
+            {
+                resolution.filter = renderer::UpscaleFilter::BILINEAR;
+            }
+            else
+            {
+                D_WARN("Unknown upscale filter: %s", filter);
+            }
+        }
+        else if (strcmp(argv[i], "--target-fps") == 0 && i + 1 < argc)
+        {
+            f32 fps {(f32) atof(argv[++i])};
+            if (fps > 0.f)
+            {
+                resolution.targetFrameMs = 1000.f / fps;
+            }
+        }
+        else if (strcmp(argv[i], "--resolution-scale") == 0 && i + 1 < argc)
+        {
+            resolution.enabled  = false;
+            resolution.maxScale = (f32) atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--objects") == 0 && i + 1 < argc)
+        {
+            renderer::RendererSetStressObjects((u32) atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--particles") == 0 && i + 1 < argc)
+        {
+            renderer::RendererSetStressParticles((u32) atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--lights") == 0 && i + 1 < argc)
+        {
+            renderer::RendererSetStressLights((u32) atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--tilemap") == 0 && i + 1 < argc)
+        {
+            renderer::RendererSetStressTilemap((u32) atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--font") == 0 && i + 1 < argc)
+        {
+            renderer::RendererSetFont(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+        {
+            renderer::RendererSetCaptureVideo(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            frameLimit = (u32) atoi(argv[++i]);
+            loopMode   = LOOP_MODE_CONTINUOUS; // A scripted run must not wait on focus.
+        }
+        else if (strcmp(argv[i], "--fixed-step") == 0 && i + 1 < argc)
+        {
+            renderer::RendererSetFixedTimestep((f32) atof(argv[++i]) / 1000.f);
+        }
+        else if (strcmp(argv[i], "--screenshot") == 0 && i + 2 < argc)
+        {
+            screenshotFrame = (u32) atoi(argv[++i]);
+            screenshotPath  = argv[++i];
+        }
+        else if (strcmp(argv[i], "--frame-stats") == 0 && i + 1 < argc)
+        {
+            frameStatsPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--headless") == 0)
+        {
+            platform::PlatformSetHeadless(true);
+        }
+        else if (strcmp(argv[i], "--sample") == 0 && i + 1 < argc)
+        {
+            samplePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--vram-budget") == 0 && i + 1 < argc)
+        {
+            renderer::RendererSetGpuMemoryBudget(MB((utils::Size) atoi(argv[++i])));
+        }
+        else
+        {
+            D_WARN("Unknown argument: %s", argv[i]);
+        }
+    }
+    renderer::DynamicResolutionConfigure(resolution);
+
+    // Started before the workers so loading is sampled too, they register themselves.
+    if (samplePath && !utils::SamplingProfilerStart(0))
+    {
+        samplePath = nullptr;
+    }
+
     // Initialize platform and renderer.
     {
         if (!platform::PlatformInit())
@@ -19,6 +256,14 @@ int main()
             return -1;
         }
 
+        // Workers for asset decoding, started early so they are warm by the first load.
+        if (!utils::JobSystemInit(0))
+        {
+            D_ASSERT(false, "Failed to start job system!");
+            return -1;
+        }
+
+#ifdef _WIN32
         platform::WindowInfoPtr windowInfo {platform::PlatformCreateDummyWindow()};
         if (!windowInfo)
         {
@@ -33,6 +278,7 @@ int main()
         }
 
         platform::PlatformDestroyDummyWindow();
+#endif // _WIN32
     }
 
     // Creating Window and Context.
@@ -43,6 +289,18 @@ int main()
         return -1;
     }
 
+#ifdef __linux__
+    // GLX doesn't need a dummy window or context, the renderer loads straight against the real window.
+    if (!renderer::RendererInit(windowInfo))
+    {
+        D_ASSERT(false, "Failed to initialize renderer!");
+        return -1;
+    }
+#endif // __linux__
+
+    // Optional, the synchronous pump in PlatformUpdateWindow is used when this fails.
+    platform::PlatformStartEventThread();
+
     utils::BumpAllocator transientStorage {utils::MakeBumpAllocator(MB(50))};
 
     if (!renderer::RendererCreateContext(windowInfo, &transientStorage))
@@ -51,12 +309,112 @@ int main()
         return -1;
     }
 
+    shared::InputRecorder recorder {};
+    shared::InputReplay   replay {};
+    if (replayPath)
+    {
+        if (!shared::InputReplayBegin(&replay, replayPath))
+        {
+            D_ASSERT(false, "Failed to open replay!");
+            return -1;
+        }
+
+        // Benchmark runs must not depend on focus or window visibility.
+        loopMode = LOOP_MODE_CONTINUOUS;
+    }
+    else if (recordPath)
+    {
+        // Replay steps every loop iteration, so the recording must too: a throttled iteration would still be
+        // recorded while its input edges and time never reach a rendered frame.
+        shared::InputRecorderBegin(&recorder, recordPath);
+        loopMode = LOOP_MODE_CONTINUOUS;
+    }
+
     // Main loop.
-    bool running {true};
+    bool             running {true};
+    i64              lastFrameTime {utils::GetTimeNs()};
+    i64              lastRenderTime {0};
+    bool             firstFrame {true};
+    u32              renderedFrames {0};
+    std::vector<f64> frameMs {};
     while (running)
     {
+        PROFILE_SCOPE("Frame");
+        i64 now {utils::GetTimeNs()};
+        i64 frameDeltaNs {now - lastFrameTime};
+        lastFrameTime = now;
+
+        shared::InputBeginFrame();
         platform::PlatformUpdateWindow(running);
+
+        if (samplePath && shared::IsKeyPressed(shared::KEY_F8))
+        {
+            utils::SamplingProfilerDump(samplePath);
+        }
+
+        if (replay.active)
+        {
+            // The recorded delta replaces the wall clock so every run steps the same way.
+            if (!shared::InputReplayFrame(&replay, &frameDeltaNs))
+            {
+                running = false;
+            }
+            renderer::RendererSetFrameDelta((f32) (frameDeltaNs / 1e9));
+        }
+        else if (recorder.active)
+        {
+            // Step with the delta that gets recorded so the replay renders the same frames.
+            shared::InputRecorderFrame(&recorder, frameDeltaNs);
+            renderer::RendererSetFrameDelta((f32) (frameDeltaNs / 1e9));
+        }
+
+        if (!running || !ThrottleFrame(loopMode, lastRenderTime))
+        {
+            continue;
+        }
+
+        // Frames count from 1.
+        if (screenshotPath && renderedFrames + 1 == screenshotFrame)
+        {
+            renderer::FrameCaptureScreenshot(screenshotPath);
+        }
+
         renderer::RendererUpdateContext();
+        shared::g_windowState.redrawRequested = false;
+
+        i64 renderTime {utils::GetTimeNs()};
+        if (frameStatsPath && lastRenderTime && renderedFrames >= FRAME_STATS_WARMUP)
+        {
+            frameMs.push_back((renderTime - lastRenderTime) / 1e6);
+        }
+        lastRenderTime = renderTime;
+
+        if (++renderedFrames == frameLimit)
+        {
+            running = false;
+        }
+
+        if (firstFrame)
+        {
+            utils::StartupMark("First frame");
+            utils::StartupReport();
+            firstFrame = false;
+        }
+    }
+
+    shared::InputRecorderEnd(&recorder);
+    shared::InputReplayEnd(&replay);
+
+    if (frameStatsPath)
+    {
+        WriteFrameStats(frameStatsPath, frameMs);
+    }
+
+    // Every sampled thread is still alive here, the workers and the event thread stop below.
+    if (samplePath)
+    {
+        utils::SamplingProfilerDump(samplePath);
+        utils::SamplingProfilerStop();
     }
 
     // Destroying Window and Context.
@@ -66,6 +424,11 @@ int main()
     // Shutdown renderer and platform.
     renderer::RendererShutdown();
     platform::PlatformShutdown();
+    utils::JobSystemShutdown();
+
+    // Every thread that records has stopped, the trace is complete.
+    PROFILE_WRITE_TRACE("profile_trace.json");
+    PROFILE_SHUTDOWN();
 
     TRACK_LEAK_REPORT();
     return 0;
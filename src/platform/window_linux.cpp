@@ -1,5 +1,27 @@
 #include "platform/window.hpp"
 #include "shared/input.hpp"
+#include "utils/profiler.hpp"
+#include "utils/sampling_profiler.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/startup_profile.hpp"
+#include "utils/timer.hpp"
+
+#include <X11/XKBlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+
+// Raw mouse motion bypasses pointer acceleration and the compositor. Optional, needs libXi.
+#if __has_include(<X11/extensions/XInput2.h>)
+#define D_XINPUT2 1
+#include <X11/extensions/XInput2.h>
+#endif // __has_include
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <poll.h>
+#include <unistd.h>
 
 namespace drop::platform
 {
@@ -11,6 +33,19 @@ namespace drop::platform
             QUIT
         };
 
+        struct QueuedEvent
+        {
+            XEvent event;
+            i64    timestamp; // utils::GetTimeNs() when the event was read from the connection.
+
+            // XInput2 payloads only live until the next XNextEvent, so they are resolved on read.
+            bool rawMotion;
+            f64  rawDeltaX;
+            f64  rawDeltaY;
+        };
+
+        constexpr u32 EVENT_QUEUE_CAPACITY {1024};
+
         Display*      g_display {nullptr};
         ::Window      g_window {0};
         Atom          g_wmDeleteAtom {0};
@@ -18,6 +53,19 @@ namespace drop::platform
         GLXFBConfig   g_bestConfig {nullptr};
         Colormap      g_cmap {0};
         WindowInfoPtr g_windowInfo {nullptr};
+        bool          g_headless {false};
+
+        // Event pump thread. It only produces into g_eventQueue, the game thread only consumes.
+        utils::SpscQueue<QueuedEvent, EVENT_QUEUE_CAPACITY> g_eventQueue {};
+        std::thread                                         g_eventThread {};
+        std::atomic<bool>                                   g_eventThreadRunning {false};
+        i32                                                 g_wakePipe[2] {-1, -1};
+        std::mutex                                          g_waitMutex {};
+        std::condition_variable                             g_waitCondition {};
+
+        i32  g_xiOpcode {-1}; // -1 when XInput2 raw motion is not available.
+        f64  g_rawRemainderX {0.0};
+        f64  g_rawRemainderY {0.0};
 
         void CalculateCenterPosition(i32 screen, i32 width, i32 height, i32& outX, i32& outY)
         {
@@ -29,8 +77,96 @@ namespace drop::platform
             outY = (screenHeight - height) / 2;
         }
 
-        CallbackResult CallbackHandle(XEvent& event)
+        shared::KeyCode TranslateKey(KeySym keySym)
+        {
+            if (keySym >= XK_a && keySym <= XK_z)
+            {
+                return (shared::KeyCode) (shared::KEY_A + (keySym - XK_a));
+            }
+            if (keySym >= XK_0 && keySym <= XK_9)
+            {
+                return (shared::KeyCode) (shared::KEY_0 + (keySym - XK_0));
+            }
+            if (keySym >= XK_F1 && keySym <= XK_F12)
+            {
+                return (shared::KeyCode) (shared::KEY_F1 + (keySym - XK_F1));
+            }
+
+            switch (keySym)
+            {
+            case XK_space:
+                return shared::KEY_SPACE;
+            case XK_Return:
+                return shared::KEY_ENTER;
+            case XK_Escape:
+                return shared::KEY_ESCAPE;
+            case XK_Tab:
+                return shared::KEY_TAB;
+            case XK_BackSpace:
+                return shared::KEY_BACKSPACE;
+            case XK_Shift_L:
+            case XK_Shift_R:
+                return shared::KEY_SHIFT;
+            case XK_Control_L:
+            case XK_Control_R:
+                return shared::KEY_CONTROL;
+            case XK_Alt_L:
+            case XK_Alt_R:
+                return shared::KEY_ALT;
+            case XK_Up:
+                return shared::KEY_UP;
+            case XK_Down:
+                return shared::KEY_DOWN;
+            case XK_Left:
+                return shared::KEY_LEFT;
+            case XK_Right:
+                return shared::KEY_RIGHT;
+            default:
+                return shared::KEY_UNKNOWN;
+            }
+        }
+
+        // Must run on the thread that called XNextEvent, before the next XNextEvent.
+        void ResolveGenericEvent(QueuedEvent& queued)
+        {
+#ifdef D_XINPUT2
+            XGenericEventCookie* cookie {&queued.event.xcookie};
+            if (queued.event.type != GenericEvent || cookie->extension != g_xiOpcode)
+            {
+                return;
+            }
+
+            if (!XGetEventData(g_display, cookie))
+            {
+                return;
+            }
+
+            if (cookie->evtype == XI_RawMotion)
+            {
+                XIRawEvent* raw {(XIRawEvent*) cookie->data};
+                const f64*  values {raw->raw_values};
+
+                // Only the valuators set in the mask are present in raw_values, 0 is X and 1 is Y.
+                for (i32 i {0}; i < raw->valuators.mask_len * 8 && i < 2; ++i)
+                {
+                    if (XIMaskIsSet(raw->valuators.mask, i))
+                    {
+                        (i == 0 ? queued.rawDeltaX : queued.rawDeltaY) = *values++;
+                    }
+                }
+                queued.rawMotion = true;
+            }
+
+            XFreeEventData(g_display, cookie);
+#endif // D_XINPUT2
+        }
+
+        CallbackResult CallbackHandle(QueuedEvent& queued)
         {
+            XEvent&            event {queued.event};
+            shared::InputEvent input {};
+            input.timestamp = queued.timestamp;
+
             switch (event.type)
             {
             case ClientMessage:
@@ -45,6 +181,136 @@ namespace drop::platform
             {
                 shared::g_screenSize.width  = event.xconfigure.width;
                 shared::g_screenSize.height = event.xconfigure.height;
+                shared::RequestRedraw();
+                break;
+            }
+            case Expose:
+            {
+                // Only the last of a series of exposes matters, we redraw the whole window anyway.
+                if (event.xexpose.count == 0)
+                {
+                    shared::RequestRedraw();
+                }
+                break;
+            }
+            case VisibilityNotify:
+            {
+                shared::g_windowState.visible = event.xvisibility.state != VisibilityFullyObscured;
+                if (shared::g_windowState.visible)
+                {
+                    shared::RequestRedraw();
+                }
+                break;
+            }
+            case MapNotify:
+            {
+                shared::g_windowState.minimized = false;
+                shared::RequestRedraw();
+                break;
+            }
+            case UnmapNotify:
+            {
+                // Iconified or otherwise hidden by the window manager.
+                shared::g_windowState.minimized = true;
+                break;
+            }
+            case KeyPress:
+            case KeyRelease:
+            {
+                shared::KeyCode key {TranslateKey(XLookupKeysym(&event.xkey, 0))};
+                if (key != shared::KEY_UNKNOWN)
+                {
+                    input.type = event.type == KeyPress ? shared::INPUT_EVENT_KEY_DOWN : shared::INPUT_EVENT_KEY_UP;
+                    input.code = key;
+                    shared::InputPushEvent(input);
+                }
+                break;
+            }
+            case ButtonPress:
+            case ButtonRelease:
+            {
+                // Buttons 4 and 5 are the wheel, they only come as press / release pairs.
+                if (event.xbutton.button == Button4 || event.xbutton.button == Button5)
+                {
+                    if (event.type == ButtonPress)
+                    {
+                        input.type = shared::INPUT_EVENT_MOUSE_WHEEL;
+                        input.y    = event.xbutton.button == Button4 ? 1 : -1;
+                        shared::InputPushEvent(input);
+                    }
+                    break;
+                }
+
+                shared::MouseButton button {shared::MOUSE_BUTTON_COUNT};
+                switch (event.xbutton.button)
+                {
+                case Button1:
+                    button = shared::MOUSE_BUTTON_LEFT;
+                    break;
+                case Button2:
+                    button = shared::MOUSE_BUTTON_MIDDLE;
+                    break;
+                case Button3:
+                    button = shared::MOUSE_BUTTON_RIGHT;
+                    break;
+                default:
+                    break;
+                }
+
+                if (button != shared::MOUSE_BUTTON_COUNT)
+                {
+                    input.type = event.type == ButtonPress ? shared::INPUT_EVENT_MOUSE_BUTTON_DOWN : shared::INPUT_EVENT_MOUSE_BUTTON_UP;
+                    input.code = button;
+                    shared::InputPushEvent(input);
+                }
+                break;
+            }
+            case MotionNotify:
+            {
+                input.type = shared::INPUT_EVENT_MOUSE_MOVE;
+                input.x    = event.xmotion.x;
+                input.y    = event.xmotion.y;
+                shared::InputPushEvent(input);
+                break;
+            }
+            case LeaveNotify:
+            {
+                input.type = shared::INPUT_EVENT_MOUSE_LEAVE;
+                shared::InputPushEvent(input);
+                break;
+            }
+            case FocusIn:
+            {
+                shared::g_windowState.focused = true;
+                break;
+            }
+            case FocusOut:
+            {
+                shared::g_windowState.focused = false;
+                input.type = shared::INPUT_EVENT_FOCUS_LOST;
+                shared::InputPushEvent(input);
+                break;
+            }
+            case GenericEvent:
+            {
+                // Raw events are selected on the root window, so they arrive even when we are not focused.
+                if (queued.rawMotion && shared::g_windowState.focused)
+                {
+                    // Keep the sub-pixel part so slow movements don't get lost.
+                    g_rawRemainderX += queued.rawDeltaX;
+                    g_rawRemainderY += queued.rawDeltaY;
+
+                    input.type = shared::INPUT_EVENT_MOUSE_RAW_MOTION;
+                    input.x    = (i32) g_rawRemainderX;
+                    input.y    = (i32) g_rawRemainderY;
+                    g_rawRemainderX -= input.x;
+                    g_rawRemainderY -= input.y;
+
+                    if (input.x || input.y)
+                    {
+                        shared::InputPushEvent(input);
+                    }
+                }
                 break;
             }
             default:
@@ -53,10 +319,115 @@ namespace drop::platform
 
             return NONE;
         }
+
+        void SelectRawMotion(::Window root)
+        {
+#ifdef D_XINPUT2
+            i32 event {0}, error {0};
+            if (!XQueryExtension(g_display, "XInputExtension", &g_xiOpcode, &event, &error))
+            {
+                D_WARN("XInput extension not available, using core pointer motion.");
+                g_xiOpcode = -1;
+                return;
+            }
+
+            i32 major {2}, minor {0};
+            if (XIQueryVersion(g_display, &major, &minor) != Success)
+            {
+                D_WARN("XInput2 not available, using core pointer motion.");
+                g_xiOpcode = -1;
+                return;
+            }
+
+            unsigned char mask[XIMaskLen(XI_RawMotion)] {};
+            XISetMask(mask, XI_RawMotion);
+
+            XIEventMask eventMask {};
+            eventMask.deviceid = XIAllMasterDevices;
+            eventMask.mask_len = sizeof(mask);
+            eventMask.mask     = mask;
+            XISelectEvents(g_display, root, &eventMask, 1);
+#else
+            D_TRACE("Built without XInput2, using core pointer motion.");
+#endif // D_XINPUT2
+        }
+
+        void EventPumpThread()
+        {
+            PROFILE_THREAD("Events");
+            utils::SamplingProfilerRegisterThread("Events");
+            pollfd fds[2] {};
+            fds[0].fd     = ConnectionNumber(g_display);
+            fds[0].events = POLLIN;
+            fds[1].fd     = g_wakePipe[0];
+            fds[1].events = POLLIN;
+
+            while (g_eventThreadRunning.load(std::memory_order_acquire))
+            {
+                // Xlib may already hold events in its own buffer (read while the game thread
+                // waited on a reply), so only block on the fd when there is nothing pending.
+                QueuedEvent queued {};
+                bool        hasEvent {false};
+
+                XLockDisplay(g_display);
+                if (XPending(g_display))
+                {
+                    XNextEvent(g_display, &queued.event);
+                    ResolveGenericEvent(queued);
+                    hasEvent = true;
+                }
+                XUnlockDisplay(g_display);
+
+                if (!hasEvent)
+                {
+                    // Events Xlib buffered while the game thread read the connection never make the fd readable,
+                    // PlatformNotifyQueuedEvents wakes us for those through the pipe.
+                    poll(fds, 2, -1);
+                    if (fds[1].revents & POLLIN)
+                    {
+                        Char drain[16];
+                        read(g_wakePipe[0], drain, sizeof(drain));
+                    }
+                    continue;
+                }
+
+                queued.timestamp = utils::GetTimeNs();
+
+                // The game thread is behind, wait for room instead of dropping input.
+                // The display lock is not held here, so the game thread can still swap buffers.
+                while (!utils::SpscPush(&g_eventQueue, queued))
+                {
+                    if (!g_eventThreadRunning.load(std::memory_order_acquire))
+                    {
+                        return;
+                    }
+                    std::this_thread::yield();
+                }
+
+                // Wakes PlatformWaitForEvents. The lock orders the push against the waiter's check.
+                {
+                    std::lock_guard<std::mutex> lock(g_waitMutex);
+                }
+                g_waitCondition.notify_one();
+            }
+        }
     } // namespace anonymous
 
+    void PlatformSetHeadless(bool headless)
+    {
+        g_headless = headless;
+    }
+
     bool PlatformInit()
     {
+        if (g_headless)
+        {
+            g_windowInfo           = new WindowInfo {&g_display, &g_window, &g_bestConfig};
+            g_windowInfo->headless = true;
+            TRACK_LEAK_ALLOC(g_windowInfo, LeakType::CUSTOM, "WindowInfo");
+            return true;
+        }
+
         if (!XInitThreads())
         {
             D_ASSERT(false, "Failed to initialize X11 threads");
@@ -81,43 +452,23 @@ namespace drop::platform
         g_windowInfo = new WindowInfo {&g_display, &g_window, &g_bestConfig};
         TRACK_LEAK_ALLOC(g_windowInfo, LeakType::CUSTOM, "WindowInfo");
 
+        utils::StartupMark("X connect");
         return true;
     }
 
-    WindowInfoPtr PlatformCreateDummyWindow()
+    WindowInfoPtr PlatformCreateWindow(i32 width, i32 height, TITLE title)
     {
-        i32      screen {XDefaultScreen(g_display)};
-        ::Window root {XRootWindow(g_display, screen)};
-
-        g_window = XCreateSimpleWindow(
-            g_display,
-            root,
-            0,
-            0,
-            50,
-            50,
-            1,
-            XWhitePixel(g_display, screen),
-            XBlackPixel(g_display, screen));
-        if (!g_window)
+        if (g_headless)
         {
-            D_ASSERT(false, "Failed to create X11 window");
-            return nullptr;
+            // Always focused and visible, nothing can change that without a window.
+            g_windowInfo->width         = width;
+            g_windowInfo->height        = height;
+            shared::g_screenSize.width  = width;
+            shared::g_screenSize.height = height;
+            shared::g_windowState       = {};
+            return g_windowInfo;
         }
-        TRACK_LEAK_ALLOC((void*) g_window, LeakType::HANDLE, "X11 dummy window");
 
-        return g_windowInfo;
-    }
-
-    void PlatformDestroyDummyWindow()
-    {
-        XDestroyWindow(g_display, g_window);
-        TRACK_LEAK_FREE((void*) g_window);
-        g_window = 0;
-    }
-
-    WindowInfoPtr PlatformCreateWindow(i32 width, i32 height, TITLE title)
-    {
         i32      screen {XDefaultScreen(g_display)};
         ::Window root {XRootWindow(g_display, screen)};
 
@@ -153,13 +504,15 @@ namespace drop::platform
             return nullptr;
         }
         TRACK_LEAK_ALLOC(vi, LeakType::HANDLE, "X11 visual info");
+        utils::StartupMark("FBConfig selection");
 
         g_cmap = XCreateColormap(g_display, root, vi->visual, AllocNone);
         TRACK_LEAK_ALLOC((void*) g_cmap, LeakType::HANDLE, "X11 colormap");
 
         XSetWindowAttributes attrs {};
         attrs.colormap   = g_cmap;
-        attrs.event_mask = ExposureMask | KeyPressMask | StructureNotifyMask;
+        attrs.event_mask = ExposureMask | KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask |
+                           PointerMotionMask | LeaveWindowMask | FocusChangeMask | VisibilityChangeMask | StructureNotifyMask;
 
         i32 x {0}, y {0};
         CalculateCenterPosition(screen, width, height, x, y);
@@ -184,24 +537,125 @@ namespace drop::platform
         }
         TRACK_LEAK_ALLOC((void*) g_window, LeakType::HANDLE, "X11 window");
 
+        // Focus arrives with FocusIn once the window manager gives it to us.
+        shared::g_windowState           = {};
+        shared::g_windowState.focused   = false;
+        shared::g_windowState.minimized = true; // Until MapNotify.
+
         XStoreName(g_display, g_window, title);
         g_wmDeleteAtom = XInternAtom(g_display, "WM_DELETE_WINDOW", false);
         XSetWMProtocols(g_display, g_window, &g_wmDeleteAtom, 1);
+
+        // Report held keys as repeated KeyPress instead of fake KeyRelease / KeyPress pairs.
+        XkbSetDetectableAutoRepeat(g_display, true, nullptr);
+        SelectRawMotion(root);
         XMapWindow(g_display, g_window);
         XFlush(g_display);
         XFree(vi);
         TRACK_LEAK_FREE(vi);
 
+        utils::StartupMark("Window creation");
         return g_windowInfo;
     }
 
+    bool PlatformStartEventThread()
+    {
+        if (g_headless)
+        {
+            return false;
+        }
+
+        if (g_eventThreadRunning.load(std::memory_order_acquire))
+        {
+            return true;
+        }
+
+        if (pipe(g_wakePipe) != 0)
+        {
+            D_ASSERT(false, "Failed to create event thread wake pipe");
+            return false;
+        }
+        TRACK_LEAK_ALLOC((void*) (intptr_t) g_wakePipe[0], LeakType::HANDLE, "Event thread wake pipe");
+
+        g_eventThreadRunning.store(true, std::memory_order_release);
+        g_eventThread = std::thread(EventPumpThread);
+
+        D_TRACE("Started X11 event thread.");
+        return true;
+    }
+
+    void PlatformStopEventThread()
+    {
+        if (!g_eventThreadRunning.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        g_eventThreadRunning.store(false, std::memory_order_release);
+        Char wake {0};
+        write(g_wakePipe[1], &wake, 1);
+        g_eventThread.join();
+
+        close(g_wakePipe[0]);
+        close(g_wakePipe[1]);
+        TRACK_LEAK_FREE((void*) (intptr_t) g_wakePipe[0]);
+        g_wakePipe[0] = -1;
+        g_wakePipe[1] = -1;
+
+        // Drop whatever the pump read after the last update.
+        QueuedEvent queued {};
+        while (utils::SpscPop(&g_eventQueue, &queued))
+        {
+        }
+    }
+
+    void PlatformNotifyQueuedEvents()
+    {
+        if (!g_eventThreadRunning.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        XLockDisplay(g_display);
+        i32 queued {XEventsQueued(g_display, QueuedAlready)};
+        XUnlockDisplay(g_display);
+        if (queued > 0)
+        {
+            Char wake {0};
+            write(g_wakePipe[1], &wake, 1);
+        }
+    }
+
     void PlatformUpdateWindow(bool& running)
     {
+        if (g_eventThreadRunning.load(std::memory_order_acquire))
+        {
+            QueuedEvent queued {};
+            while (utils::SpscPop(&g_eventQueue, &queued))
+            {
+                CallbackResult result {CallbackHandle(queued)};
+                if (result == QUIT)
+                {
+                    running = false;
+                    break;
+                }
+            }
+            return;
+        }
+
+        if (g_headless)
+        {
+            return;
+        }
+
         while (XPending(g_display))
         {
-            XEvent event {};
-            XNextEvent(g_display, &event);
-            CallbackResult result {CallbackHandle(event)};
+            QueuedEvent queued {};
+            XNextEvent(g_display, &queued.event);
+            queued.timestamp = utils::GetTimeNs();
+            ResolveGenericEvent(queued);
+
+            CallbackResult result {CallbackHandle(queued)};
             if (result == QUIT)
             {
                 running = false;
@@ -210,8 +664,36 @@ namespace drop::platform
         }
     }
 
+    void PlatformWaitForEvents(i64 timeoutNs)
+    {
+        if (g_eventThreadRunning.load(std::memory_order_acquire))
+        {
+            std::unique_lock<std::mutex> lock(g_waitMutex);
+            g_waitCondition.wait_for(lock, std::chrono::nanoseconds(timeoutNs), []()
+                                     { return utils::SpscCount(&g_eventQueue) > 0; });
+            return;
+        }
+
+        // Xlib may already have events buffered, the fd would not become readable for those.
+        if (g_headless || XPending(g_display))
+        {
+            return;
+        }
+
+        pollfd fd {};
+        fd.fd     = ConnectionNumber(g_display);
+        fd.events = POLLIN;
+        poll(&fd, 1, (i32) (timeoutNs / 1000000));
+    }
+
     void PlatformDestroyWindow()
     {
+        PlatformStopEventThread();
+        if (g_headless)
+        {
+            return;
+        }
+
         XFreeColormap(g_display, g_cmap);
         TRACK_LEAK_FREE((void*) g_cmap);
         XDestroyWindow(g_display, g_window);
@@ -223,13 +705,17 @@ namespace drop::platform
         g_window     = 0;
         g_fbc        = nullptr;
         g_bestConfig = nullptr;
+        g_xiOpcode   = -1;
     }
 
     void PlatformShutdown()
     {
-        XCloseDisplay(g_display);
-        TRACK_LEAK_FREE(g_display);
-        g_display = nullptr;
+        if (g_display)
+        {
+            XCloseDisplay(g_display);
+            TRACK_LEAK_FREE(g_display);
+            g_display = nullptr;
+        }
 
         delete g_windowInfo;
         TRACK_LEAK_FREE(g_windowInfo);
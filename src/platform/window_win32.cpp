@@ -1,5 +1,8 @@
 #include "platform/window.hpp"
 #include "shared/input.hpp"
+#include "utils/timer.hpp"
+
+#include <windowsx.h> // GET_X_LPARAM, GET_Y_LPARAM.
 
 namespace drop::platform
 {
@@ -11,6 +14,7 @@ namespace drop::platform
         HDC           g_hdc {nullptr};
         WindowInfoPtr g_windowInfo {nullptr};
         bool          g_running {true};
+        bool          g_trackingMouseLeave {false}; // WM_MOUSELEAVE is armed for one leave at a time.
 
         void CalculateCenterPosition(const RECT& rc, i32& outX, i32& outY)
         {
@@ -27,10 +31,181 @@ namespace drop::platform
             outY = dr.top + (dh - wh) / 2;
         }
 
+        shared::KeyCode TranslateKey(WPARAM vk)
+        {
+            if (vk >= 'A' && vk <= 'Z')
+            {
+                return (shared::KeyCode) (shared::KEY_A + (vk - 'A'));
+            }
+            if (vk >= '0' && vk <= '9')
+            {
+                return (shared::KeyCode) (shared::KEY_0 + (vk - '0'));
+            }
+            if (vk >= VK_F1 && vk <= VK_F12)
+            {
+                return (shared::KeyCode) (shared::KEY_F1 + (vk - VK_F1));
+            }
+
+            switch (vk)
+            {
+            case VK_SPACE:
+                return shared::KEY_SPACE;
+            case VK_RETURN:
+                return shared::KEY_ENTER;
+            case VK_ESCAPE:
+                return shared::KEY_ESCAPE;
+            case VK_TAB:
+                return shared::KEY_TAB;
+            case VK_BACK:
+                return shared::KEY_BACKSPACE;
+            case VK_SHIFT:
+                return shared::KEY_SHIFT;
+            case VK_CONTROL:
+                return shared::KEY_CONTROL;
+            case VK_MENU:
+                return shared::KEY_ALT;
+            case VK_UP:
+                return shared::KEY_UP;
+            case VK_DOWN:
+                return shared::KEY_DOWN;
+            case VK_LEFT:
+                return shared::KEY_LEFT;
+            case VK_RIGHT:
+                return shared::KEY_RIGHT;
+            default:
+                return shared::KEY_UNKNOWN;
+            }
+        }
+
+        void PushMouseButton(shared::MouseButton button, bool down)
+        {
+            shared::InputEvent input {};
+            input.timestamp = utils::GetTimeNs();
+            input.type      = down ? shared::INPUT_EVENT_MOUSE_BUTTON_DOWN : shared::INPUT_EVENT_MOUSE_BUTTON_UP;
+            input.code      = button;
+            shared::InputPushEvent(input);
+        }
+
+        // Raw mouse motion through WM_INPUT, bypasses pointer ballistics.
+        void RegisterRawMouse(HWND hwnd)
+        {
+            RAWINPUTDEVICE device {};
+            device.usUsagePage = 0x01; // HID_USAGE_PAGE_GENERIC.
+            device.usUsage     = 0x02; // HID_USAGE_GENERIC_MOUSE.
+            device.dwFlags     = 0;
+            device.hwndTarget  = hwnd;
+
+            if (!RegisterRawInputDevices(&device, 1, sizeof(device)))
+            {
+                D_WARN("Failed to register raw mouse input, using WM_MOUSEMOVE.");
+            }
+        }
+
         LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         {
             switch (msg)
             {
+            case WM_KEYDOWN:
+            case WM_SYSKEYDOWN:
+            case WM_KEYUP:
+            case WM_SYSKEYUP:
+            {
+                shared::KeyCode key {TranslateKey(wParam)};
+                if (key != shared::KEY_UNKNOWN)
+                {
+                    shared::InputEvent input {};
+                    input.timestamp = utils::GetTimeNs();
+                    input.type      = (msg == WM_KEYDOWN || msg == WM_SYSKEYDOWN) ? shared::INPUT_EVENT_KEY_DOWN : shared::INPUT_EVENT_KEY_UP;
+                    input.code      = key;
+                    shared::InputPushEvent(input);
+                }
+                break;
+            }
+            case WM_MOUSEMOVE:
+            {
+                if (!g_trackingMouseLeave)
+                {
+                    TRACKMOUSEEVENT track {};
+                    track.cbSize    = sizeof(track);
+                    track.dwFlags   = TME_LEAVE;
+                    track.hwndTrack = hwnd;
+
+                    g_trackingMouseLeave = TrackMouseEvent(&track) != FALSE;
+                }
+
+                shared::InputEvent input {};
+                input.timestamp = utils::GetTimeNs();
+                input.type      = shared::INPUT_EVENT_MOUSE_MOVE;
+                input.x         = GET_X_LPARAM(lParam);
+                input.y         = GET_Y_LPARAM(lParam);
+                shared::InputPushEvent(input);
+                break;
+            }
+            case WM_MOUSELEAVE:
+            {
+                g_trackingMouseLeave = false;
+
+                shared::InputEvent input {};
+                input.timestamp = utils::GetTimeNs();
+                input.type      = shared::INPUT_EVENT_MOUSE_LEAVE;
+                shared::InputPushEvent(input);
+                break;
+            }
+            case WM_INPUT:
+            {
+                RAWINPUT raw {};
+                UINT     size {sizeof(raw)};
+                if (GetRawInputData((HRAWINPUT) lParam, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) != (UINT) -1 &&
+                    raw.header.dwType == RIM_TYPEMOUSE &&
+                    !(raw.data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE) &&
+                    (raw.data.mouse.lLastX || raw.data.mouse.lLastY))
+                {
+                    shared::InputEvent input {};
+                    input.timestamp = utils::GetTimeNs();
+                    input.type      = shared::INPUT_EVENT_MOUSE_RAW_MOTION;
+                    input.x         = raw.data.mouse.lLastX;
+                    input.y         = raw.data.mouse.lLastY;
+                    shared::InputPushEvent(input);
+                }
+                break;
+            }
+            case WM_LBUTTONDOWN:
+            case WM_LBUTTONUP:
+            {
+                PushMouseButton(shared::MOUSE_BUTTON_LEFT, msg == WM_LBUTTONDOWN);
+                break;
+            }
+            case WM_RBUTTONDOWN:
+            case WM_RBUTTONUP:
+            {
+                PushMouseButton(shared::MOUSE_BUTTON_RIGHT, msg == WM_RBUTTONDOWN);
+                break;
+            }
+            case WM_MBUTTONDOWN:
+            case WM_MBUTTONUP:
+            {
+                PushMouseButton(shared::MOUSE_BUTTON_MIDDLE, msg == WM_MBUTTONDOWN);
+                break;
+            }
+            case WM_MOUSEWHEEL:
+            {
+                shared::InputEvent input {};
+                input.timestamp = utils::GetTimeNs();
+                input.type      = shared::INPUT_EVENT_MOUSE_WHEEL;
+                input.y         = GET_WHEEL_DELTA_WPARAM(wParam) / WHEEL_DELTA;
+                shared::InputPushEvent(input);
+                break;
+            }
+            case WM_KILLFOCUS:
+            {
+                shared::g_windowState.focused = false;
+
+                shared::InputEvent input {};
+                input.timestamp = utils::GetTimeNs();
+                input.type      = shared::INPUT_EVENT_FOCUS_LOST;
+                shared::InputPushEvent(input);
+                break;
+            }
             case WM_CLOSE:
             {
                 PostQuitMessage(0);
@@ -44,6 +219,18 @@ namespace drop::platform
                 shared::g_screenSize.width  = rc.right - rc.left;
                 shared::g_screenSize.height = rc.bottom - rc.top;
 
+                shared::g_windowState.minimized = wParam == SIZE_MINIMIZED;
+                shared::RequestRedraw();
+                break;
+            }
+            case WM_PAINT:
+            {
+                shared::RequestRedraw();
+                break;
+            }
+            case WM_SETFOCUS:
+            {
+                shared::g_windowState.focused = true;
                 break;
             }
             default:
@@ -55,6 +242,14 @@ namespace drop::platform
 
     } // namespace anonymous
 
+    void PlatformSetHeadless(bool headless)
+    {
+        if (headless)
+        {
+            D_WARN("Headless mode is only implemented on Linux, opening a window.");
+        }
+    }
+
     bool PlatformInit()
     {
         g_windowInfo = new WindowInfo {&g_hwnd, &g_hdc};
@@ -167,6 +362,8 @@ namespace drop::platform
         g_hdc = GetDC(g_hwnd);
         TRACK_LEAK_ALLOC(g_hdc, LeakType::HANDLE, "HDC");
 
+        RegisterRawMouse(g_hwnd);
+
         ShowWindow(g_hwnd, SW_SHOW);
         UpdateWindow(g_hwnd);
 
@@ -178,6 +375,17 @@ namespace drop::platform
         return g_windowInfo;
     }
 
+    // Win32 delivers messages to the thread that created the window, so the pump stays on the game thread.
+    bool PlatformStartEventThread()
+    {
+        D_WARN("Event thread is not supported on Win32.");
+        return false;
+    }
+
+    void PlatformStopEventThread()
+    {
+    }
+
     void PlatformUpdateWindow(bool& running)
     {
         MSG msg {};
@@ -195,6 +403,11 @@ namespace drop::platform
         running = g_running;
     }
 
+    void PlatformWaitForEvents(i64 timeoutNs)
+    {
+        MsgWaitForMultipleObjects(0, nullptr, false, (DWORD) (timeoutNs / 1000000), QS_ALLINPUT);
+    }
+
     void PlatformDestroyWindow()
     {
         ReleaseDC(g_hwnd, g_hdc);
@@ -0,0 +1,131 @@
+#include "renderer/atlas_packer.hpp"
+
+namespace drop::renderer
+{
+    namespace
+    {
+        // Lowest y at which a width x height rectangle fits with its left edge on node index, or -1.
+        i64 FitAt(const SkylinePacker* packer, u32 index, u32 width, u32 height)
+        {
+            u32 x {packer->nodes[index].x};
+            if (x + width > packer->width)
+            {
+                return -1;
+            }
+
+            u32 y {0};
+            u32 remaining {width};
+            for (u32 i {index}; remaining > 0; ++i)
+            {
+                D_ASSERT(i < packer->nodes.size(), "Skyline does not cover the atlas width.");
+
+                const SkylineNode& node {packer->nodes[i]};
+                if (node.y > y)
+                {
+                    y = node.y;
+                }
+                if (y + height > packer->height)
+                {
+                    return -1;
+                }
+
+                remaining = node.width >= remaining ? 0 : remaining - node.width;
+            }
+
+            return y;
+        }
+    } // namespace anonymous
+
+    void SkylineInit(SkylinePacker* packer, u32 width, u32 height)
+    {
+        packer->width    = width;
+        packer->height   = height;
+        packer->usedArea = 0;
+        packer->nodes.clear();
+        packer->nodes.push_back({0, 0, width});
+    }
+
+    bool SkylinePack(SkylinePacker* packer, u32 width, u32 height, u32* outX, u32* outY)
+    {
+        if (!width || !height || width > packer->width || height > packer->height)
+        {
+            return false;
+        }
+
+        i64 bestIndex {-1};
+        u32 bestTop {UINT32_MAX};
+        u32 bestWidth {UINT32_MAX};
+        u32 bestY {0};
+        for (u32 i {0}; i < packer->nodes.size(); ++i)
+        {
+            i64 y {FitAt(packer, i, width, height)};
+            if (y < 0)
+            {
+                continue;
+            }
+
+            // Lowest top edge first, narrower node on ties to leave wide gaps for wide rectangles.
+            u32 top {(u32) y + height};
+            if (top < bestTop || (top == bestTop && packer->nodes[i].width < bestWidth))
+            {
+                bestIndex = i;
+                bestTop   = top;
+                bestWidth = packer->nodes[i].width;
+                bestY     = (u32) y;
+            }
+        }
+
+        if (bestIndex < 0)
+        {
+            return false;
+        }
+
+        u32 x {packer->nodes[bestIndex].x};
+        packer->nodes.insert(packer->nodes.begin() + bestIndex, {x, bestTop, width});
+
+        // Trim or drop the nodes the new one now covers.
+        for (u32 i {(u32) bestIndex + 1}; i < packer->nodes.size();)
+        {
+            SkylineNode& node {packer->nodes[i]};
+            u32          coveredUntil {x + width};
+            if (node.x >= coveredUntil)
+            {
+                break;
+            }
+
+            u32 shrink {coveredUntil - node.x};
+            if (shrink >= node.width)
+            {
+                packer->nodes.erase(packer->nodes.begin() + i);
+                continue;
+            }
+
+            node.x += shrink;
+            node.width -= shrink;
+            break;
+        }
+
+        // Merge neighbours at the same height.
+        for (u32 i {0}; i + 1 < packer->nodes.size();)
+        {
+            if (packer->nodes[i].y == packer->nodes[i + 1].y)
+            {
+                packer->nodes[i].width += packer->nodes[i + 1].width;
+                packer->nodes.erase(packer->nodes.begin() + i + 1);
+                continue;
+            }
+            ++i;
+        }
+
+        packer->usedArea += (u64) width * height;
+        *outX = x;
+        *outY = bestY;
+        return true;
+    }
+
+    f32 SkylineOccupancy(const SkylinePacker* packer)
+    {
+        u64 area {(u64) packer->width * packer->height};
+        return area ? (f32) packer->usedArea / area : 0.f;
+    }
+} // namespace drop::renderer
@@ -0,0 +1,138 @@
+#include "renderer/dynamic_resolution.hpp"
+
+#include <cmath> // sqrtf, floorf, ceilf.
+
+namespace drop::renderer
+{
+    namespace
+    {
+        constexpr f32 SCALE_STEP {0.05f};     // Bilinear scales are quantized so the target pool isn't churned.
+        constexpr f32 EMA_WEIGHT {0.1f};      // Weight of the newest frame in the average.
+        constexpr f32 OVER_BUDGET {1.05f};    // Drop the resolution above this fraction of the target.
+        constexpr f32 UNDER_BUDGET {0.8f};    // Raise it only below this one, the gap stops oscillation.
+        constexpr u32 COOLDOWN_FRAMES {30};   // A new size needs a few frames before its timing means anything.
+        constexpr u32 MAX_INTEGER_DIVISOR {8};
+
+        DynamicResolutionSettings g_settings {};
+        f32                       g_scale {1.f};
+        f32                       g_averageMs {0.f};
+        u32                       g_cooldown {0};
+
+        f32 Clamp(f32 value, f32 low, f32 high)
+        {
+            return value < low ? low : (value > high ? high : value);
+        }
+
+        // Whole number divisor for the scale, 1 / divisor is the largest integer scale that fits.
+        u32 IntegerDivisor(f32 scale)
+        {
+            u32 divisor {(u32) ceilf(1.f / scale - 0.001f)};
+            return divisor < 1 ? 1 : (divisor > MAX_INTEGER_DIVISOR ? MAX_INTEGER_DIVISOR : divisor);
+        }
+
+        f32 MinimumScale()
+        {
+            if (g_settings.filter == UpscaleFilter::NEAREST_INTEGER)
+            {
+                // The smallest 1/n scale that is still above minScale.
+                u32 divisor {(u32) floorf(1.f / g_settings.minScale + 0.001f)};
+                return 1.f / (f32) (divisor > MAX_INTEGER_DIVISOR ? MAX_INTEGER_DIVISOR : divisor);
+            }
+
+            return g_settings.minScale;
+        }
+
+        f32 Quantize(f32 scale)
+        {
+            if (g_settings.filter == UpscaleFilter::NEAREST_INTEGER)
+            {
+                return 1.f / (f32) IntegerDivisor(scale);
+            }
+
+            // Rounding to the nearest step may go past a maximum that isn't a multiple of it.
+            f32 rounded {floorf(scale / SCALE_STEP + 0.5f) * SCALE_STEP};
+            return rounded > g_settings.maxScale ? g_settings.maxScale : rounded;
+        }
+    } // namespace anonymous
+
+    void DynamicResolutionConfigure(const DynamicResolutionSettings& settings)
+    {
+        g_settings          = settings;
+        g_settings.maxScale = Clamp(g_settings.maxScale, SCALE_STEP, 1.f);
+        g_settings.minScale = Clamp(g_settings.minScale, SCALE_STEP, g_settings.maxScale);
+        g_scale             = Quantize(g_settings.maxScale);
+        g_averageMs         = 0.f;
+        g_cooldown          = COOLDOWN_FRAMES;
+    }
+
+    const DynamicResolutionSettings& DynamicResolutionGetSettings()
+    {
+        return g_settings;
+    }
+
+    void DynamicResolutionUpdate(f32 gpuFrameMs)
+    {
+        if (!g_settings.enabled || gpuFrameMs <= 0.f)
+        {
+            return;
+        }
+
+        g_averageMs = g_averageMs > 0.f ? g_averageMs + (gpuFrameMs - g_averageMs) * EMA_WEIGHT : gpuFrameMs;
+        if (g_cooldown)
+        {
+            --g_cooldown;
+            return;
+        }
+
+        f32 target {g_settings.targetFrameMs};
+        if (g_averageMs < target * OVER_BUDGET && g_averageMs > target * UNDER_BUDGET)
+        {
+            return;
+        }
+
+        // GPU time goes with the pixel count, which is the square of the scale.
+        f32 scale {g_scale * sqrtf(target / g_averageMs)};
+        scale = Quantize(Clamp(scale, MinimumScale(), g_settings.maxScale));
+        if (g_settings.filter == UpscaleFilter::NEAREST_INTEGER && g_averageMs < target && scale < g_scale)
+        {
+            scale = g_scale; // Rounding a raise down to the next divisor would be a drop.
+        }
+
+        if (scale != g_scale)
+        {
+            D_TRACE("Dynamic resolution %.2f -> %.2f (%.2f ms, target %.2f ms)", g_scale, scale, g_averageMs, target);
+            g_scale     = scale;
+            g_averageMs = 0.f;
+            g_cooldown  = COOLDOWN_FRAMES;
+        }
+    }
+
+    InternalResolution DynamicResolutionGetSize(u32 screenWidth, u32 screenHeight)
+    {
+        InternalResolution result {};
+        result.scale = g_scale;
+
+        if (g_settings.filter == UpscaleFilter::NEAREST_INTEGER)
+        {
+            // Every scene pixel becomes an exact n x n block, the remainder is letterboxed.
+            u32 divisor {IntegerDivisor(g_scale)};
+            result.width       = screenWidth / divisor;
+            result.height      = screenHeight / divisor;
+            result.viewport[2] = result.width * divisor;
+            result.viewport[3] = result.height * divisor;
+            result.viewport[0] = (screenWidth - result.viewport[2]) / 2;
+            result.viewport[1] = (screenHeight - result.viewport[3]) / 2;
+        }
+        else
+        {
+            result.width       = (u32) (screenWidth * g_scale + 0.5f);
+            result.height      = (u32) (screenHeight * g_scale + 0.5f);
+            result.viewport[2] = screenWidth;
+            result.viewport[3] = screenHeight;
+        }
+
+        result.width  = result.width ? result.width : 1;
+        result.height = result.height ? result.height : 1;
+        return result;
+    }
+} // namespace drop::renderer
@@ -0,0 +1,673 @@
+#include "renderer/font.hpp"
+#include "renderer/sprite_batch.hpp"
+#include "renderer/texture.hpp"
+#include "renderer/texture_streamer.hpp"
+#include "utils/file_io.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace drop::renderer
+{
+    namespace
+    {
+        constexpr u32 MAX_FONTS {8};
+        constexpr u32 MAX_FONT_PAGES {16};
+        constexpr u16 NO_GLYPH {0xFFFF};
+
+        // Layouts not drawn for this many frames are dropped, text that changes every frame
+        // (timers, counters) would otherwise grow the cache forever.
+        constexpr u64 SHAPED_TEXT_MAX_AGE {120};
+        constexpr u32 SHAPED_TEXT_EVICT_INTERVAL {60};
+
+        constexpr u64 FNV_OFFSET_BASIS {0xcbf29ce484222325ull};
+        constexpr u64 FNV_PRIME {0x100000001b3ull};
+
+        // Public domain font8x8_basic, ASCII 32..126. One byte per row, bit 0 is the leftmost pixel.
+        constexpr u8 FONT_8X8[95][8] {
+            {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+            {0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00}, // !
+            {0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // "
+            {0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00}, // #
+            {0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00}, // $
+            {0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00}, // %
+            {0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00}, // &
+            {0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00}, // '
+            {0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00}, // (
+            {0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00}, // )
+            {0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00}, // *
+            {0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00}, // +
+            {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06}, // ,
+            {0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00}, // -
+            {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // .
+            {0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00}, // /
+            {0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00}, // 0
+            {0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00}, // 1
+            {0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00}, // 2
+            {0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00}, // 3
+            {0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00}, // 4
+            {0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00}, // 5
+            {0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00}, // 6
+            {0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00}, // 7
+            {0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00}, // 8
+            {0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00}, // 9
+            {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // :
+            {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06}, // ;
+            {0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00}, // <
+            {0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00}, // =
+            {0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00}, // >
+            {0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00}, // ?
+            {0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00}, // @
+            {0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00}, // A
+            {0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00}, // B
+            {0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00}, // C
+            {0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00}, // D
+            {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00}, // E
+            {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00}, // F
+            {0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00}, // G
+            {0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00}, // H
+            {0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // I
+            {0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00}, // J
+            {0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00}, // K
+            {0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00}, // L
+            {0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00}, // M
+            {0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00}, // N
+            {0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00}, // O
+            {0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00}, // P
+            {0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00}, // Q
+            {0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00}, // R
+            {0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00}, // S
+            {0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // T
+            {0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00}, // U
+            {0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, // V
+            {0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00}, // W
+            {0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00}, // X
+            {0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00}, // Y
+            {0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00}, // Z
+            {0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00}, // [
+            {0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00}, // backslash
+            {0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00}, // ]
+            {0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00}, // ^
+            {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF}, // _
+            {0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00}, // `
+            {0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00}, // a
+            {0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00}, // b
+            {0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00}, // c
+            {0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00}, // d
+            {0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00}, // e
+            {0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00}, // f
+            {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F}, // g
+            {0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00}, // h
+            {0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // i
+            {0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E}, // j
+            {0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00}, // k
+            {0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // l
+            {0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00}, // m
+            {0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00}, // n
+            {0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00}, // o
+            {0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F}, // p
+            {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78}, // q
+            {0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00}, // r
+            {0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00}, // s
+            {0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00}, // t
+            {0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00}, // u
+            {0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, // v
+            {0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00}, // w
+            {0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00}, // x
+            {0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F}, // y
+            {0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00}, // z
+            {0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00}, // {
+            {0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00}, // |
+            {0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00}, // }
+            {0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ~
+        };
+
+        struct Glyph
+        {
+            AtlasRegion region {}; // Size only until the page is streamed in.
+            f32         xOffset {0.f};
+            f32         yOffset {0.f};
+            f32         xAdvance {0.f};
+            u32         page {0};
+            u32         pageX {0}; // Position on the page.
+            u32         pageY {0};
+            bool        visible {false}; // Space and friends only advance.
+        };
+
+        struct Font
+        {
+            std::vector<Glyph>           glyphs;
+            u16                          ascii[128] {};
+            std::unordered_map<u32, u16> extended; // Codepoints above ASCII.
+            std::unordered_map<u64, f32> kerning;  // (first << 32 | second).
+            f32                          lineHeight {0.f};
+            SpriteDistanceField          distanceField {SPRITE_BITMAP};
+            TextureStreamHandle          pages[MAX_FONT_PAGES] {};
+            bool                         streaming {false}; // Pages requested, glyphs not placed yet.
+            bool                         loaded {false};
+        };
+
+        struct ShapedGlyph
+        {
+            u16 glyph {0};
+            f32 x {0.f}; // Unscaled, relative to the text origin.
+            f32 y {0.f};
+        };
+
+        struct ShapedText
+        {
+            std::string              text; // Hash collisions are checked against this.
+            FontHandle               font {0};
+            std::vector<ShapedGlyph> glyphs;
+            TextMetrics              metrics {};
+            u64                      lastUsed {0};
+        };
+
+        Font                                g_fonts[MAX_FONTS] {};
+        u32                                 g_fontCount {0};
+        std::unordered_map<u64, ShapedText> g_shapedCache;
+        u64                                 g_frame {0};
+
+        Font* GetFont(FontHandle handle)
+        {
+            if (!handle || handle > g_fontCount || !g_fonts[handle - 1].loaded)
+            {
+                return nullptr;
+            }
+
+            return &g_fonts[handle - 1];
+        }
+
+        u16 FindGlyph(const Font& font, u32 codepoint)
+        {
+            if (codepoint < 128)
+            {
+                return font.ascii[codepoint];
+            }
+
+            auto it {font.extended.find(codepoint)};
+            return it != font.extended.end() ? it->second : NO_GLYPH;
+        }
+
+        void AddGlyph(Font& font, u32 codepoint, const Glyph& glyph)
+        {
+            u16 index {(u16) font.glyphs.size()};
+            font.glyphs.push_back(glyph);
+            if (codepoint < 128)
+            {
+                font.ascii[codepoint] = index;
+            }
+            else
+            {
+                font.extended[codepoint] = index;
+            }
+        }
+
+        // Invalid sequences come out as U+FFFD, one byte at a time.
+        u32 NextCodepoint(const Char*& text)
+        {
+            const u8* bytes {(const u8*) text};
+            u32       length {bytes[0] < 0x80 ? 1u : (bytes[0] >> 5) == 0x6 ? 2u : (bytes[0] >> 4) == 0xE ? 3u : (bytes[0] >> 3) == 0x1E ? 4u : 0u};
+            if (!length)
+            {
+                text++;
+                return 0xFFFD;
+            }
+
+            u32 codepoint {length == 1 ? bytes[0] : bytes[0] & (0x7Fu >> length)};
+            for (u32 i {1}; i < length; ++i)
+            {
+                if ((bytes[i] & 0xC0) != 0x80)
+                {
+                    text++;
+                    return 0xFFFD;
+                }
+                codepoint = codepoint << 6 | (bytes[i] & 0x3F);
+            }
+
+            text += length;
+            return codepoint;
+        }
+
+        u64 HashText(FontHandle font, const Char* text)
+        {
+            u64 hash {FNV_OFFSET_BASIS ^ font};
+            for (; *text; ++text)
+            {
+                hash ^= (u8) *text;
+                hash *= FNV_PRIME;
+            }
+            return hash;
+        }
+
+        const ShapedText* Shape(FontHandle handle, const Char* text)
+        {
+            Font* font {GetFont(handle)};
+            if (!font)
+            {
+                return nullptr;
+            }
+
+            u64  hash {HashText(handle, text)};
+            auto it {g_shapedCache.find(hash)};
+            if (it != g_shapedCache.end() && it->second.font == handle && it->second.text == text)
+            {
+                it->second.lastUsed = g_frame;
+                return &it->second;
+            }
+
+            ShapedText& shaped {g_shapedCache[hash]}; // Replaces a colliding entry.
+            shaped          = {};
+            shaped.text     = text;
+            shaped.font     = handle;
+            shaped.lastUsed = g_frame;
+
+            f32 penX {0.f};
+            f32 penY {0.f};
+            u32 previous {0};
+            u16 fallback {FindGlyph(*font, '?')};
+            for (const Char* cursor {text}; *cursor;)
+            {
+                u32 codepoint {NextCodepoint(cursor)};
+                if (codepoint == '\n')
+                {
+                    shaped.metrics.width = penX > shaped.metrics.width ? penX : shaped.metrics.width;
+                    penX                 = 0.f;
+                    penY += font->lineHeight;
+                    previous = 0;
+                    continue;
+                }
+
+                // Kerning pairs are looked up by what ends up on screen, the fallback included.
+                u16 index {FindGlyph(*font, codepoint)};
+                if (index == NO_GLYPH)
+                {
+                    index     = fallback;
+                    codepoint = '?';
+                    if (index == NO_GLYPH)
+                    {
+                        continue;
+                    }
+                }
+
+                if (previous && !font->kerning.empty())
+                {
+                    auto kerning {font->kerning.find((u64) previous << 32 | codepoint)};
+                    if (kerning != font->kerning.end())
+                    {
+                        penX += kerning->second;
+                    }
+                }
+
+                const Glyph& glyph {font->glyphs[index]};
+                if (glyph.visible)
+                {
+                    shaped.glyphs.push_back({index, penX + glyph.xOffset, penY + glyph.yOffset});
+                }
+                penX += glyph.xAdvance;
+                previous = codepoint;
+            }
+
+            shaped.metrics.width  = penX > shaped.metrics.width ? penX : shaped.metrics.width;
+            shaped.metrics.height = penY + font->lineHeight;
+            return &shaped;
+        }
+
+        // --- BMFont text format ---
+
+        // Value of key=value on a BMFont line, quotes stripped. Empty when missing.
+        std::string FindValue(const std::string& line, const Char* key)
+        {
+            std::string pattern {std::string(" ") + key + "="};
+            size_t      start {line.find(pattern)};
+            if (start == std::string::npos)
+            {
+                return {};
+            }
+
+            start += pattern.size();
+            if (start < line.size() && line[start] == '"')
+            {
+                size_t end {line.find('"', start + 1)};
+                return line.substr(start + 1, end == std::string::npos ? std::string::npos : end - start - 1);
+            }
+
+            size_t end {line.find_first_of(" \t\r", start)};
+            return line.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        }
+
+        i32 FindInt(const std::string& line, const Char* key)
+        {
+            return atoi(FindValue(line, key).c_str());
+        }
+
+        bool StartsWith(const std::string& line, const Char* tag)
+        {
+            size_t length {strlen(tag)};
+            return line.compare(0, length, tag) == 0 && (line.size() == length || line[length] == ' ');
+        }
+
+        // The pages that made it into the atlas give their space back, the others are dropped when decoded.
+        void ReleasePages(Font& font)
+        {
+            for (TextureStreamHandle& page : font.pages)
+            {
+                TextureStreamRelease(page);
+                page = 0;
+            }
+        }
+
+        // Pages go into the atlas whole, a glyph is the part of its page's region it covers. The atlas
+        // samples nearest, so the glyph spacing of the page is enough to keep neighbours out.
+        void PlaceGlyphs(Font& font)
+        {
+            for (const TextureStreamHandle page : font.pages)
+            {
+                if (page && !TextureStreamIsReady(page))
+                {
+                    if (TextureStreamIsFailed(page))
+                    {
+                        D_ERROR("A font page failed to load, the font is unusable.");
+                        ReleasePages(font);
+                        font = {};
+                    }
+                    return; // Still streaming.
+                }
+            }
+
+            f32 texel {1.f / TextureAtlasGetSize()};
+            for (Glyph& glyph : font.glyphs)
+            {
+                if (!glyph.visible)
+                {
+                    continue;
+                }
+
+                const AtlasRegion* page {TextureStreamGetRegion(font.pages[glyph.page])};
+                if (!page || glyph.pageX + glyph.region.width > page->width || glyph.pageY + glyph.region.height > page->height)
+                {
+                    glyph.visible = false;
+                    continue;
+                }
+
+                u32 x {page->x + glyph.pageX};
+                u32 y {page->y + glyph.pageY};
+                glyph.region.uv[0] = (x + TEXTURE_ATLAS_PADDING) * texel;
+                glyph.region.uv[1] = (y + TEXTURE_ATLAS_PADDING) * texel;
+                glyph.region.uv[2] = (x + TEXTURE_ATLAS_PADDING + glyph.region.width) * texel;
+                glyph.region.uv[3] = (y + TEXTURE_ATLAS_PADDING + glyph.region.height) * texel;
+                glyph.region.layer = page->layer;
+                glyph.region.x     = x;
+                glyph.region.y     = y;
+            }
+
+            font.streaming = false;
+            font.loaded    = true;
+        }
+    } // namespace anonymous
+
+    bool FontInit()
+    {
+        D_ASSERT(!g_fontCount, "Fonts already initialized.");
+
+        Font& font {g_fonts[g_fontCount++]};
+        memset(font.ascii, 0xFF, sizeof(font.ascii));
+        font.lineHeight = 10.f; // 8 pixel glyphs and 2 rows of spacing.
+
+        for (u32 codepoint {32}; codepoint < 127; ++codepoint)
+        {
+            const u8* bitmap {FONT_8X8[codepoint - 32]};
+
+            Glyph glyph {};
+            glyph.xAdvance = 8.f;
+            for (u32 row {0}; row < 8 && !glyph.visible; ++row)
+            {
+                glyph.visible = bitmap[row] != 0;
+            }
+
+            if (glyph.visible)
+            {
+                u8 pixels[8 * 8 * 4] {};
+                for (u32 row {0}; row < 8; ++row)
+                {
+                    for (u32 column {0}; column < 8; ++column)
+                    {
+                        u8* pixel {pixels + (row * 8 + column) * 4};
+                        memset(pixel, 255, 3);
+                        pixel[3] = (bitmap[row] >> column) & 1 ? 255 : 0;
+                    }
+                }
+
+                if (!TextureAtlasAdd(pixels, 8, 8, &glyph.region))
+                {
+                    D_ASSERT(false, "Failed to add the default font to the atlas.");
+                    return false;
+                }
+            }
+
+            AddGlyph(font, codepoint, glyph);
+        }
+
+        font.loaded = true;
+        return true;
+    }
+
+    FontHandle FontLoadBMFont(const Char* filePath, utils::BumpAllocator* transientStorage)
+    {
+        if (g_fontCount == MAX_FONTS)
+        {
+            D_ASSERT(false, "Too many fonts.");
+            return 0;
+        }
+
+        i32   fileSize {0};
+        Char* source {utils::ReadFile((Char*) filePath, transientStorage, &fileSize)};
+        if (!source)
+        {
+            D_ERROR("Failed to read font: %s", filePath);
+            return 0;
+        }
+
+        // Page files are relative to the .fnt.
+        std::string directory {filePath};
+        size_t      slash {directory.find_last_of("/\\")};
+        directory = slash == std::string::npos ? std::string {} : directory.substr(0, slash + 1);
+
+        Font& font {g_fonts[g_fontCount]};
+        font = {};
+        memset(font.ascii, 0xFF, sizeof(font.ascii));
+
+        std::string pagePaths[MAX_FONT_PAGES] {};
+        bool        success {true};
+
+        const Char* cursor {source};
+        const Char* end {source + fileSize};
+        while (cursor < end && success)
+        {
+            const Char* lineEnd {(const Char*) memchr(cursor, '\n', end - cursor)};
+            if (!lineEnd)
+            {
+                lineEnd = end;
+            }
+            std::string line(cursor, lineEnd);
+            cursor = lineEnd + 1;
+
+            if (StartsWith(line, "common"))
+            {
+                font.lineHeight = (f32) FindInt(line, "lineHeight");
+            }
+            else if (StartsWith(line, "distanceField"))
+            {
+                // Written by msdf-bmfont-xml.
+                std::string type {FindValue(line, "fieldType")};
+                font.distanceField = type == "msdf" ? SPRITE_MSDF : SPRITE_SDF;
+            }
+            else if (StartsWith(line, "page"))
+            {
+                i32 id {FindInt(line, "id")};
+                if (id < 0 || id >= (i32) MAX_FONT_PAGES)
+                {
+                    D_ERROR("Font page %d out of range in %s.", id, filePath);
+                    success = false;
+                    continue;
+                }
+
+                pagePaths[id] = directory + FindValue(line, "file");
+            }
+            else if (StartsWith(line, "char"))
+            {
+                i32 id {FindInt(line, "id")};
+                i32 page {FindInt(line, "page")};
+                i32 width {FindInt(line, "width")};
+                i32 height {FindInt(line, "height")};
+                i32 x {FindInt(line, "x")};
+                i32 y {FindInt(line, "y")};
+                if (id < 0 || page < 0 || page >= (i32) MAX_FONT_PAGES || x < 0 || y < 0)
+                {
+                    continue;
+                }
+
+                Glyph glyph {};
+                glyph.xOffset  = (f32) FindInt(line, "xoffset");
+                glyph.yOffset  = (f32) FindInt(line, "yoffset");
+                glyph.xAdvance = (f32) FindInt(line, "xadvance");
+                glyph.visible  = width > 0 && height > 0;
+
+                if (glyph.visible)
+                {
+                    if (pagePaths[page].empty())
+                    {
+                        D_ERROR("Glyph %d of %s is on page %d, which has no file.", id, filePath, page);
+                        success = false;
+                        continue;
+                    }
+                    glyph.page          = (u32) page;
+                    glyph.pageX         = (u32) x;
+                    glyph.pageY         = (u32) y;
+                    glyph.region.width  = (u32) width;
+                    glyph.region.height = (u32) height;
+                }
+
+                AddGlyph(font, (u32) id, glyph);
+            }
+            else if (StartsWith(line, "kerning"))
+            {
+                u64 pair {(u64) (u32) FindInt(line, "first") << 32 | (u32) FindInt(line, "second")};
+                font.kerning[pair] = (f32) FindInt(line, "amount");
+            }
+        }
+
+        if (!success || font.glyphs.empty())
+        {
+            D_ERROR("Failed to load font: %s", filePath);
+            font = {};
+            return 0;
+        }
+
+        // Decoded on the workers and uploaded through the streamer's pixel buffers, the font is
+        // usable once FontBeginFrame finds every page in.
+        for (u32 page {0}; page < MAX_FONT_PAGES; ++page)
+        {
+            if (!pagePaths[page].empty())
+            {
+                font.pages[page] = TextureStreamLoad(pagePaths[page].c_str());
+                if (!font.pages[page])
+                {
+                    D_ERROR("Failed to stream page %u of %s.", page, filePath);
+                    ReleasePages(font);
+                    font = {};
+                    return 0;
+                }
+            }
+        }
+        font.streaming = true;
+
+        D_TRACE("Loading font %s: %u glyphs, %u kerning pairs.", filePath, (u32) font.glyphs.size(), (u32) font.kerning.size());
+        return ++g_fontCount;
+    }
+
+    void FontBeginFrame()
+    {
+        for (u32 i {0}; i < g_fontCount; ++i)
+        {
+            if (g_fonts[i].streaming)
+            {
+                PlaceGlyphs(g_fonts[i]);
+            }
+        }
+
+        g_frame++;
+        if (g_frame % SHAPED_TEXT_EVICT_INTERVAL)
+        {
+            return;
+        }
+
+        for (auto it {g_shapedCache.begin()}; it != g_shapedCache.end();)
+        {
+            it = g_frame - it->second.lastUsed > SHAPED_TEXT_MAX_AGE ? g_shapedCache.erase(it) : std::next(it);
+        }
+    }
+
+    void FontDrawText(FontHandle handle, const Char* text, f32 x, f32 y, f32 scale, u32 color)
+    {
+        const ShapedText* shaped {Shape(handle, text)};
+        if (!shaped)
+        {
+            return;
+        }
+
+        const Font&    font {g_fonts[handle - 1]};
+        SpriteInstance instance {};
+        instance.color         = color;
+        instance.distanceField = (f32) font.distanceField;
+        for (const ShapedGlyph& shapedGlyph : shaped->glyphs)
+        {
+            const AtlasRegion& region {font.glyphs[shapedGlyph.glyph].region};
+            instance.position[0] = x + shapedGlyph.x * scale;
+            instance.position[1] = y + shapedGlyph.y * scale;
+            instance.size[0]     = region.width * scale;
+            instance.size[1]     = region.height * scale;
+            memcpy(instance.uv, region.uv, sizeof(instance.uv));
+            instance.layer = (f32) region.layer;
+            SpriteBatchDrawInstance(instance);
+        }
+    }
+
+    TextMetrics FontMeasureText(FontHandle handle, const Char* text, f32 scale)
+    {
+        const ShapedText* shaped {Shape(handle, text)};
+        if (!shaped)
+        {
+            return {};
+        }
+
+        return {shaped->metrics.width * scale, shaped->metrics.height * scale};
+    }
+
+    bool FontIsReady(FontHandle handle)
+    {
+        return GetFont(handle) != nullptr;
+    }
+
+    f32 FontLineHeight(FontHandle handle, f32 scale)
+    {
+        Font* font {GetFont(handle)};
+        return font ? font->lineHeight * scale : 0.f;
+    }
+
+    void FontShutdown()
+    {
+        // The glyphs live in the texture atlas, which goes away on its own.
+        for (Font& font : g_fonts)
+        {
+            font = {};
+        }
+        g_fontCount = 0;
+        g_shapedCache.clear();
+        g_frame = 0;
+    }
+} // namespace drop::renderer
@@ -0,0 +1,562 @@
+#include "renderer/frame_capture.hpp"
+#include "renderer/gl_loader.hpp"
+#include "renderer/gpu_memory.hpp"
+#include "utils/cpu.hpp"
+#include "utils/image.hpp"
+#include "utils/profiler.hpp"
+#include "utils/sampling_profiler.hpp"
+#include "utils/spsc_queue.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#ifdef D_SIMD_X86
+#include <immintrin.h>
+#endif // D_SIMD_X86
+
+namespace drop::renderer
+{
+    namespace
+    {
+        constexpr u32      READBACK_BUFFER_COUNT {4}; // A map lands 2-3 frames after its read.
+        constexpr u32      CAPTURE_QUEUE_SIZE {16};   // Every readback plus a video open and close, never fills.
+        constexpr u32      MAX_CAPTURE_PATH {256};
+        constexpr GLuint64 SHUTDOWN_WAIT_NS {1000000000};
+
+        enum class CaptureOp : u8
+        {
+            SCREENSHOT,
+            VIDEO_OPEN,
+            VIDEO_FRAME,
+            VIDEO_CLOSE
+        };
+
+        enum class ReadbackState : u8
+        {
+            FREE,
+            IN_FLIGHT, // Read issued, waiting on the fence.
+            WRITING,   // Mapped, the writer thread reads from it.
+            DONE       // The writer is done with the mapping, the main thread unmaps.
+        };
+
+        struct Readback
+        {
+            GLuint                     buffer {0};
+            utils::Size                size {0};
+            GLsync                     fence {nullptr};
+            u32                        width {0};
+            u32                        height {0};
+            CaptureOp                  op {CaptureOp::VIDEO_FRAME};
+            Char                       path[MAX_CAPTURE_PATH] {};
+            std::atomic<ReadbackState> state {ReadbackState::FREE};
+        };
+
+        struct CaptureWork
+        {
+            CaptureOp   op {CaptureOp::VIDEO_FRAME};
+            Readback*   readback {nullptr};
+            const u8*   pixels {nullptr}; // BGRA, bottom row first, as GL reads it.
+            Char        path[MAX_CAPTURE_PATH] {};
+        };
+
+        using SwizzleRowFunction = void (*)(const u8* bgra, u8* rgba, u32 width);
+
+        Readback                                          g_readbacks[READBACK_BUFFER_COUNT] {};
+        u32                                               g_readbackHead {0}; // Oldest read still in flight.
+        u32                                               g_readbackTail {0}; // Next read, both only grow.
+        utils::SpscQueue<CaptureWork, CAPTURE_QUEUE_SIZE> g_queue {};
+        std::thread                                       g_writer;
+        std::mutex                                        g_wakeMutex;
+        std::condition_variable                           g_wakeCondition;
+        std::atomic<bool>                                 g_stopping {false};
+        std::atomic<u32>                                  g_written {0};
+        SwizzleRowFunction                                g_swizzleRow {nullptr};
+        Char                                              g_screenshotPath[MAX_CAPTURE_PATH] {};
+        bool                                              g_screenshotPending {false};
+        bool                                              g_recording {false};
+        bool                                              g_closePending {false}; // The close waits for the frames in flight.
+        u32                                               g_videoWidth {0};
+        u32                                               g_videoHeight {0};
+        FrameCaptureStats                                 g_stats {};
+
+        // BGRA is what most drivers keep the framebuffer in, reading it as is saves a swizzle inside
+        // the driver. Alpha is forced opaque, the backbuffer alpha is whatever blending left there.
+        void SwizzleRowScalar(const u8* bgra, u8* rgba, u32 width)
+        {
+            for (u32 x {0}; x < width; ++x, bgra += 4, rgba += 4)
+            {
+                rgba[0] = bgra[2];
+                rgba[1] = bgra[1];
+                rgba[2] = bgra[0];
+                rgba[3] = 255;
+            }
+        }
+
+#ifdef D_SIMD_X86
+        D_TARGET("ssse3") void SwizzleRowSSSE3(const u8* bgra, u8* rgba, u32 width)
+        {
+            const __m128i shuffle {_mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15)};
+            const __m128i alpha {_mm_set1_epi32((i32) 0xFF000000)};
+
+            u32 x {0};
+            for (; x + 4 <= width; x += 4)
+            {
+                __m128i pixels {_mm_loadu_si128((const __m128i*) (bgra + x * 4))};
+                _mm_storeu_si128((__m128i*) (rgba + x * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+            }
+            SwizzleRowScalar(bgra + x * 4, rgba + x * 4, width - x);
+        }
+
+        D_TARGET("avx2") void SwizzleRowAVX2(const u8* bgra, u8* rgba, u32 width)
+        {
+            // vpshufb shuffles within each 128 bit lane, the same pattern twice.
+            const __m256i shuffle {_mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                                    2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15)};
+            const __m256i alpha {_mm256_set1_epi32((i32) 0xFF000000)};
+
+            u32 x {0};
+            for (; x + 8 <= width; x += 8)
+            {
+                __m256i pixels {_mm256_loadu_si256((const __m256i*) (bgra + x * 4))};
+                _mm256_storeu_si256((__m256i*) (rgba + x * 4), _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle), alpha));
+            }
+            SwizzleRowScalar(bgra + x * 4, rgba + x * 4, width - x);
+        }
+#endif // D_SIMD_X86
+
+        utils::ImageFormat FormatFromPath(const Char* path)
+        {
+            const Char* extension {strrchr(path, '.')};
+            return extension && strcmp(extension, ".qoi") == 0 ? utils::ImageFormat::QOI : utils::ImageFormat::PNG;
+        }
+
+        // --- Writer thread ---
+
+        void WriteFrame(const CaptureWork& work, std::ofstream& video, u8*& frame, utils::Size& frameCapacity)
+        {
+            PROFILE_SCOPE("Capture write");
+            Readback&   readback {*work.readback};
+            u32         width {readback.width};
+            u32         height {readback.height};
+            utils::Size rowBytes {(utils::Size) width * 4};
+            if (frameCapacity < readback.size)
+            {
+                if (frame)
+                {
+                    TRACK_LEAK_FREE(frame);
+                    free(frame);
+                }
+                frame         = (u8*) malloc(readback.size);
+                frameCapacity = frame ? readback.size : 0;
+                if (frame)
+                {
+                    TRACK_LEAK_ALLOC(frame, LeakType::HEAP, "Frame capture pixels");
+                }
+            }
+
+            // Flipped and swizzled out of the mapping, then the buffer goes back to the main thread
+            // while the slow part (encoding, the disk) runs on our own copy.
+            if (frame)
+            {
+                for (u32 y {0}; y < height; ++y)
+                {
+                    g_swizzleRow(work.pixels + (height - 1 - y) * rowBytes, frame + y * rowBytes, width);
+                }
+            }
+            readback.state.store(ReadbackState::DONE, std::memory_order_release);
+
+            if (!frame)
+            {
+                D_ERROR("Failed to allocate %ux%u capture.", width, height);
+                return;
+            }
+
+            if (work.op == CaptureOp::SCREENSHOT)
+            {
+                utils::Image image {width, height, frame};
+                if (utils::ImageSave(work.path, &image, FormatFromPath(work.path)))
+                {
+                    D_TRACE("Saved screenshot %s.", work.path);
+                }
+            }
+            else if (video.is_open())
+            {
+                video.write((const Char*) frame, (std::streamsize) (rowBytes * height));
+            }
+            g_written.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void WriterLoop()
+        {
+            PROFILE_THREAD("Capture writer");
+            utils::SamplingProfilerRegisterThread("Capture writer");
+            std::ofstream video;
+            Char          videoPath[MAX_CAPTURE_PATH] {};
+            bool          videoAnnounced {false};
+            u8*           frame {nullptr}; // Grows to the largest capture so far.
+            utils::Size   frameCapacity {0};
+
+            while (true)
+            {
+                CaptureWork work {};
+                if (!utils::SpscPop(&g_queue, &work))
+                {
+                    std::unique_lock<std::mutex> lock(g_wakeMutex);
+                    g_wakeCondition.wait(lock, [] { return g_stopping.load(std::memory_order_relaxed) || utils::SpscCount(&g_queue); });
+                    if (!utils::SpscCount(&g_queue))
+                    {
+                        break; // Stopping and drained.
+                    }
+                    continue;
+                }
+
+                switch (work.op)
+                {
+                case CaptureOp::VIDEO_OPEN:
+                    video.open(work.path, std::ios::binary | std::ios::trunc);
+                    if (!video)
+                    {
+                        D_ERROR("Failed to open video capture: %s", work.path);
+                    }
+                    strcpy(videoPath, work.path);
+                    videoAnnounced = false;
+                    break;
+                case CaptureOp::VIDEO_CLOSE:
+                    video.close();
+                    D_TRACE("Closed video capture %s.", videoPath);
+                    break;
+                case CaptureOp::VIDEO_FRAME:
+                    if (!videoAnnounced && video.is_open())
+                    {
+                        D_TRACE("Recording %s, encode it with: ffmpeg -f rawvideo -pixel_format rgba -video_size %ux%u -framerate <fps> -i %s out.mp4",
+                                videoPath, work.readback->width, work.readback->height, videoPath);
+                        videoAnnounced = true;
+                    }
+                    WriteFrame(work, video, frame, frameCapacity);
+                    break;
+                case CaptureOp::SCREENSHOT:
+                    WriteFrame(work, video, frame, frameCapacity);
+                    break;
+                }
+            }
+
+            if (frame)
+            {
+                TRACK_LEAK_FREE(frame);
+                free(frame);
+            }
+        }
+
+        // --- Main thread ---
+
+        bool PushWork(const CaptureWork& work)
+        {
+            if (!utils::SpscPush(&g_queue, work))
+            {
+                D_ASSERT(false, "Frame capture queue is full.");
+                return false;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(g_wakeMutex);
+            }
+            g_wakeCondition.notify_one();
+            return true;
+        }
+
+        void ReclaimReadbacks()
+        {
+            for (Readback& readback : g_readbacks)
+            {
+                if (readback.state.load(std::memory_order_acquire) == ReadbackState::DONE)
+                {
+                    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+                    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                    readback.state.store(ReadbackState::FREE, std::memory_order_relaxed);
+                }
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+
+        // Hands every finished read to the writer, oldest first so video frames stay in order.
+        // A timeout of 0 only takes the reads the GPU is already done with.
+        void PollReadbacks(GLuint64 timeoutNs)
+        {
+            while (g_readbackHead != g_readbackTail)
+            {
+                Readback& readback {g_readbacks[g_readbackHead % READBACK_BUFFER_COUNT]};
+                GLenum    status {glClientWaitSync(readback.fence, timeoutNs ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeoutNs)};
+                if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                {
+                    break;
+                }
+
+                glDeleteSync(readback.fence);
+                readback.fence = nullptr;
+                g_readbackHead++;
+
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+                CaptureWork work {};
+                work.op       = readback.op;
+                work.readback = &readback;
+                work.pixels   = (const u8*) glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readback.size, GL_MAP_READ_BIT);
+                strcpy(work.path, readback.path);
+
+                // Set before the push, the writer may be done with it before PushWork returns.
+                readback.state.store(ReadbackState::WRITING, std::memory_order_relaxed);
+                if (!work.pixels || !PushWork(work))
+                {
+                    if (work.pixels)
+                    {
+                        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                    }
+                    D_ERROR("Failed to map a frame capture.");
+                    readback.state.store(ReadbackState::FREE, std::memory_order_relaxed);
+                    g_stats.dropped++;
+                }
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+
+        bool IssueReadback(CaptureOp op, const Char* path, u32 framebuffer, u32 width, u32 height)
+        {
+            Readback& readback {g_readbacks[g_readbackTail % READBACK_BUFFER_COUNT]};
+            if (readback.state.load(std::memory_order_acquire) != ReadbackState::FREE)
+            {
+                return false; // The ring is full, the GPU or the writer is behind.
+            }
+
+            utils::Size size {(utils::Size) width * height * 4};
+            if (size > readback.size && !GpuMemoryFitsBudget(size - readback.size))
+            {
+                return false; // Dropped like a full ring, a pending screenshot retries next frame.
+            }
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+            if (readback.size != size)
+            {
+                if (readback.size)
+                {
+                    GpuMemoryTrackFree(readback.buffer, GpuMemoryCategory::STAGING_BUFFER);
+                }
+                glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+                GpuMemoryTrackAlloc(readback.buffer, GpuMemoryCategory::STAGING_BUFFER, size);
+                readback.size = size;
+            }
+
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+            glReadPixels(0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, nullptr); // Into the buffer, returns at once.
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            readback.fence  = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            readback.width  = width;
+            readback.height = height;
+            readback.op     = op;
+            strcpy(readback.path, path);
+            readback.state.store(ReadbackState::IN_FLIGHT, std::memory_order_relaxed);
+
+            g_readbackTail++;
+            g_stats.captured++;
+            return true;
+        }
+
+        void PushVideoClose()
+        {
+            CaptureWork work {};
+            work.op = CaptureOp::VIDEO_CLOSE;
+            PushWork(work);
+            g_closePending = false;
+        }
+    } // namespace anonymous
+
+    bool FrameCaptureInit()
+    {
+        g_swizzleRow = SwizzleRowScalar;
+#ifdef D_SIMD_X86
+        const utils::CpuFeatures& cpu {utils::GetCpuFeatures()};
+        if (cpu.avx2)
+        {
+            g_swizzleRow = SwizzleRowAVX2;
+        }
+        else if (cpu.ssse3)
+        {
+            g_swizzleRow = SwizzleRowSSSE3;
+        }
+#endif // D_SIMD_X86
+
+        // Sized on the first capture, most sessions never take one.
+        for (Readback& readback : g_readbacks)
+        {
+            glGenBuffers(1, &readback.buffer);
+            TRACK_LEAK_ALLOC(&readback.buffer, LeakType::OPENGL, "Frame capture pixel buffer");
+        }
+
+        g_stats = {};
+        g_written.store(0, std::memory_order_relaxed);
+        g_stopping.store(false, std::memory_order_relaxed);
+        g_writer = std::thread(WriterLoop);
+        return true;
+    }
+
+    bool FrameCaptureScreenshot(const Char* filePath)
+    {
+        if (strlen(filePath) >= MAX_CAPTURE_PATH)
+        {
+            D_ASSERT(false, "Screenshot path too long: %s", filePath);
+            return false;
+        }
+
+        strcpy(g_screenshotPath, filePath);
+        g_screenshotPending = true;
+        return true;
+    }
+
+    bool FrameCaptureStartVideo(const Char* filePath)
+    {
+        if (g_recording || g_closePending)
+        {
+            D_WARN("A video capture is still running.");
+            return false;
+        }
+
+        if (strlen(filePath) >= MAX_CAPTURE_PATH)
+        {
+            D_ASSERT(false, "Video capture path too long: %s", filePath);
+            return false;
+        }
+
+        CaptureWork work {};
+        work.op = CaptureOp::VIDEO_OPEN;
+        strcpy(work.path, filePath);
+        if (!PushWork(work))
+        {
+            return false;
+        }
+
+        g_recording   = true;
+        g_videoWidth  = 0;
+        g_videoHeight = 0;
+        return true;
+    }
+
+    void FrameCaptureStopVideo()
+    {
+        if (g_recording)
+        {
+            g_recording    = false;
+            g_closePending = true;
+        }
+    }
+
+    bool FrameCaptureIsRecording()
+    {
+        return g_recording;
+    }
+
+    void FrameCaptureEndFrame(u32 framebuffer, u32 width, u32 height)
+    {
+        ReclaimReadbacks();
+        PollReadbacks(0);
+
+        // Every frame of the video has been handed over, the close lands after them in the queue.
+        if (g_closePending && g_readbackHead == g_readbackTail)
+        {
+            PushVideoClose();
+        }
+
+        if (!width || !height)
+        {
+            return;
+        }
+
+        // A screenshot waits for a free buffer, a video frame is dropped.
+        if (g_screenshotPending && IssueReadback(CaptureOp::SCREENSHOT, g_screenshotPath, framebuffer, width, height))
+        {
+            g_screenshotPending = false;
+        }
+
+        if (g_recording)
+        {
+            if (!g_videoWidth)
+            {
+                g_videoWidth  = width;
+                g_videoHeight = height;
+            }
+
+            // A raw stream has one size, frames after a resize are dropped.
+            if (width != g_videoWidth || height != g_videoHeight ||
+                !IssueReadback(CaptureOp::VIDEO_FRAME, "", framebuffer, width, height))
+            {
+                g_stats.dropped++;
+            }
+        }
+    }
+
+    const FrameCaptureStats& FrameCaptureGetStats()
+    {
+        g_stats.written  = g_written.load(std::memory_order_relaxed);
+        g_stats.inFlight = g_readbackTail - g_readbackHead;
+        return g_stats;
+    }
+
+    void FrameCaptureShutdown()
+    {
+        // Whatever was read back still gets written, the last frames of a video included.
+        FrameCaptureStopVideo();
+        if (g_screenshotPending)
+        {
+            D_WARN("Screenshot %s was never read back, the ring stayed full or over the GPU memory budget.", g_screenshotPath);
+        }
+        if (g_writer.joinable())
+        {
+            ReclaimReadbacks();
+            PollReadbacks(SHUTDOWN_WAIT_NS);
+            if (g_closePending)
+            {
+                PushVideoClose();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(g_wakeMutex);
+                g_stopping.store(true, std::memory_order_relaxed);
+            }
+            g_wakeCondition.notify_one();
+            g_writer.join();
+        }
+        ReclaimReadbacks();
+
+        for (Readback& readback : g_readbacks)
+        {
+            if (readback.fence)
+            {
+                glDeleteSync(readback.fence);
+                readback.fence = nullptr;
+            }
+
+            if (readback.buffer)
+            {
+                if (readback.size)
+                {
+                    GpuMemoryTrackFree(readback.buffer, GpuMemoryCategory::STAGING_BUFFER);
+                }
+                glDeleteBuffers(1, &readback.buffer);
+                TRACK_LEAK_FREE(&readback.buffer);
+                readback.buffer = 0;
+            }
+            readback.size = 0;
+            readback.state.store(ReadbackState::FREE, std::memory_order_relaxed);
+        }
+
+        g_readbackHead      = 0;
+        g_readbackTail      = 0;
+        g_screenshotPending = false;
+        g_closePending      = false;
+        g_swizzleRow        = nullptr;
+    }
+} // namespace drop::renderer
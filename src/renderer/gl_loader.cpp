@@ -0,0 +1,157 @@
+#include "renderer/gl_loader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace drop::renderer
+{
+#define GL_DEFINE_FUNCTION(type, name) type name {nullptr};
+    GL_CORE_FUNCTIONS(GL_DEFINE_FUNCTION)
+    GL_DEBUG_OUTPUT_FUNCTIONS(GL_DEFINE_FUNCTION)
+    GL_INDEXED_BLEND_FUNCTIONS(GL_DEFINE_FUNCTION)
+    GL_TIMER_QUERY_FUNCTIONS(GL_DEFINE_FUNCTION)
+    GL_DIRECT_STATE_ACCESS_FUNCTIONS(GL_DEFINE_FUNCTION)
+    GL_BUFFER_STORAGE_FUNCTIONS(GL_DEFINE_FUNCTION)
+    GL_MULTI_DRAW_INDIRECT_FUNCTIONS(GL_DEFINE_FUNCTION)
+    GL_COMPUTE_SHADER_FUNCTIONS(GL_DEFINE_FUNCTION)
+    GL_PARALLEL_SHADER_COMPILE_FUNCTIONS(GL_DEFINE_FUNCTION)
+#undef GL_DEFINE_FUNCTION
+
+    GLCapabilities g_glCaps {};
+
+    namespace
+    {
+        struct GLFunctionEntry
+        {
+            void**      address;
+            const Char* name;
+        };
+
+#define GL_FUNCTION_ENTRY(type, name) {(void**) &name, #name},
+        const GLFunctionEntry g_coreFunctions[] {GL_CORE_FUNCTIONS(GL_FUNCTION_ENTRY)};
+        const GLFunctionEntry g_debugOutputFunctions[] {GL_DEBUG_OUTPUT_FUNCTIONS(GL_FUNCTION_ENTRY)};
+        const GLFunctionEntry g_indexedBlendFunctions[] {GL_INDEXED_BLEND_FUNCTIONS(GL_FUNCTION_ENTRY)};
+        const GLFunctionEntry g_timerQueryFunctions[] {GL_TIMER_QUERY_FUNCTIONS(GL_FUNCTION_ENTRY)};
+        const GLFunctionEntry g_directStateAccessFunctions[] {GL_DIRECT_STATE_ACCESS_FUNCTIONS(GL_FUNCTION_ENTRY)};
+        const GLFunctionEntry g_bufferStorageFunctions[] {GL_BUFFER_STORAGE_FUNCTIONS(GL_FUNCTION_ENTRY)};
+        const GLFunctionEntry g_multiDrawIndirectFunctions[] {GL_MULTI_DRAW_INDIRECT_FUNCTIONS(GL_FUNCTION_ENTRY)};
+        const GLFunctionEntry g_computeShaderFunctions[] {GL_COMPUTE_SHADER_FUNCTIONS(GL_FUNCTION_ENTRY)};
+        const GLFunctionEntry g_parallelShaderCompileFunctions[] {GL_PARALLEL_SHADER_COMPILE_FUNCTIONS(GL_FUNCTION_ENTRY)};
+#undef GL_FUNCTION_ENTRY
+
+        // Sorted, points into strings owned by the driver for the lifetime of the context.
+        std::vector<const Char*> g_extensions;
+
+        template <u32 Count>
+        bool LoadTable(const GLFunctionEntry (&table)[Count], bool required)
+        {
+            bool complete {true};
+            for (const GLFunctionEntry& entry : table)
+            {
+                *entry.address = GetGLProcAddress(entry.name);
+                if (!*entry.address)
+                {
+                    complete = false;
+                    if (required)
+                    {
+                        D_ERROR("Failed to load OpenGL function: %s", entry.name);
+                    }
+                }
+            }
+
+            return complete;
+        }
+
+        // A capability needs both the driver's word for it and resolved entry points.
+        // glXGetProcAddress returns non null for any name, so the pointers alone prove nothing.
+        template <u32 Count>
+        bool LoadCapability(const GLFunctionEntry (&table)[Count], bool supported, const Char* name)
+        {
+            if (!supported)
+            {
+                for (const GLFunctionEntry& entry : table)
+                {
+                    *entry.address = nullptr; // Calling an unsupported function must crash loudly, not misbehave.
+                }
+                return false;
+            }
+
+            if (!LoadTable(table, false))
+            {
+                D_WARN("%s is advertised but its functions are missing, disabling it.", name);
+                return false;
+            }
+
+            return true;
+        }
+    } // namespace anonymous
+
+    bool LoadOpenGLFunctions()
+    {
+        return LoadTable(g_coreFunctions, true);
+    }
+
+    void LoadOpenGLCapabilities()
+    {
+        g_glCaps = {};
+        glGetIntegerv(GL_MAJOR_VERSION, &g_glCaps.major);
+        glGetIntegerv(GL_MINOR_VERSION, &g_glCaps.minor);
+
+        GLint extensionCount {0};
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+
+        g_extensions.clear();
+        g_extensions.reserve(extensionCount);
+        for (GLint i {0}; i < extensionCount; ++i)
+        {
+            g_extensions.push_back((const Char*) glGetStringi(GL_EXTENSIONS, i));
+        }
+        std::sort(g_extensions.begin(), g_extensions.end(), [](const Char* a, const Char* b)
+                  { return strcmp(a, b) < 0; });
+
+        g_glCaps.debugOutput = LoadCapability(g_debugOutputFunctions,
+                                              HasGLVersion(4, 3) || HasGLExtension("GL_KHR_debug"), "Debug output");
+        g_glCaps.indexedBlend = LoadCapability(g_indexedBlendFunctions,
+                                               HasGLVersion(4, 0), "Indexed blending");
+        g_glCaps.timerQuery = LoadCapability(g_timerQueryFunctions,
+                                             HasGLVersion(3, 3) || HasGLExtension("GL_ARB_timer_query"), "Timer queries");
+        g_glCaps.directStateAccess = LoadCapability(g_directStateAccessFunctions,
+                                                    HasGLVersion(4, 5) || HasGLExtension("GL_ARB_direct_state_access"), "Direct state access");
+        g_glCaps.bufferStorage = LoadCapability(g_bufferStorageFunctions,
+                                                HasGLVersion(4, 4) || HasGLExtension("GL_ARB_buffer_storage"), "Buffer storage");
+        g_glCaps.multiDrawIndirect = LoadCapability(g_multiDrawIndirectFunctions,
+                                                    HasGLVersion(4, 3) || HasGLExtension("GL_ARB_multi_draw_indirect"), "Multi draw indirect");
+        g_glCaps.computeShader = LoadCapability(g_computeShaderFunctions,
+                                                HasGLVersion(4, 3) || HasGLExtension("GL_ARB_compute_shader"), "Compute shaders");
+        g_glCaps.shaderStorageBuffer = HasGLVersion(4, 3) || HasGLExtension("GL_ARB_shader_storage_buffer_object");
+
+        // The ARB flavour has the same signature and enums as the KHR one.
+        g_glCaps.parallelShaderCompile = LoadCapability(g_parallelShaderCompileFunctions,
+                                                        HasGLExtension("GL_KHR_parallel_shader_compile"), "Parallel shader compile");
+        if (!g_glCaps.parallelShaderCompile && HasGLExtension("GL_ARB_parallel_shader_compile"))
+        {
+            glMaxShaderCompilerThreadsKHR   = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) GetGLProcAddress("glMaxShaderCompilerThreadsARB");
+            g_glCaps.parallelShaderCompile = glMaxShaderCompilerThreadsKHR != nullptr;
+        }
+
+        g_glCaps.nvxMemoryInfo = HasGLExtension("GL_NVX_gpu_memory_info");
+        g_glCaps.atiMemInfo    = HasGLExtension("GL_ATI_meminfo");
+
+        D_TRACE("OpenGL %d.%d, %d extensions. DSA: %d, buffer storage: %d, MDI: %d, compute: %d, parallel compile: %d, timer queries: %d",
+                g_glCaps.major, g_glCaps.minor, extensionCount,
+                g_glCaps.directStateAccess, g_glCaps.bufferStorage, g_glCaps.multiDrawIndirect,
+                g_glCaps.computeShader, g_glCaps.parallelShaderCompile, g_glCaps.timerQuery);
+    }
+
+    bool HasGLExtension(const Char* name)
+    {
+        return std::binary_search(g_extensions.begin(), g_extensions.end(), name, [](const Char* a, const Char* b)
+                                  { return strcmp(a, b) < 0; });
+    }
+
+    bool HasGLVersion(i32 major, i32 minor)
+    {
+        return g_glCaps.major > major || (g_glCaps.major == major && g_glCaps.minor >= minor);
+    }
+} // namespace drop::renderer
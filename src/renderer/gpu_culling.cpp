@@ -0,0 +1,196 @@
+#include "renderer/gpu_culling.hpp"
+#include "renderer/gl_loader.hpp"
+#include "renderer/gpu_memory.hpp"
+#include "renderer/shader.hpp"
+
+#include <vector>
+
+namespace drop::renderer
+{
+    namespace
+    {
+        constexpr u32 CULL_GROUP_SIZE {64}; // local_size_x in cull.comp.
+
+        // GL layout of one indirect command, written by cull.comp.
+        struct DrawElementsIndirectCommand
+        {
+            u32 count;
+            u32 instanceCount;
+            u32 firstIndex;
+            i32 baseVertex;
+            u32 baseInstance;
+        };
+
+        ShaderHandle g_cullShader {0};
+        ShaderHandle g_drawShader {0};
+        GLuint       g_VAO {0};
+        GLuint       g_objectBuffer {0};  // CullObject per object.
+        GLuint       g_commandBuffer {0}; // DrawElementsIndirectCommand per object.
+        GLuint       g_indexBuffer {0};   // Quad indices.
+        GLuint       g_instanceBuffer {0}; // 0..maxObjects-1, read through baseInstance.
+        GLint        g_objectCountLocation {-1};
+        u32          g_maxObjects {0};
+        u32          g_objectCount {0};
+
+        void CreateBuffer(GLuint* buffer, GLenum target, GpuMemoryCategory category, utils::Size bytes, const void* data, const Char* name)
+        {
+            glGenBuffers(1, buffer);
+            glBindBuffer(target, *buffer);
+            glBufferData(target, bytes, data, GL_STATIC_DRAW);
+            GpuMemoryTrackAlloc(*buffer, category, bytes);
+            TRACK_LEAK_ALLOC(buffer, LeakType::OPENGL, name);
+        }
+
+        void DestroyBuffer(GLuint* buffer, GpuMemoryCategory category)
+        {
+            if (*buffer)
+            {
+                GpuMemoryTrackFree(*buffer, category);
+                glDeleteBuffers(1, buffer);
+                TRACK_LEAK_FREE(buffer);
+                *buffer = 0;
+            }
+        }
+    } // namespace anonymous
+
+    bool GpuCullingIsSupported()
+    {
+        return g_glCaps.computeShader && g_glCaps.shaderStorageBuffer && g_glCaps.multiDrawIndirect;
+    }
+
+    bool GpuCullingInit(u32 maxObjects, utils::BumpAllocator* transientStorage)
+    {
+        if (!GpuCullingIsSupported())
+        {
+            D_WARN("GPU culling needs compute shaders, storage buffers and multi draw indirect.");
+            return false;
+        }
+
+        g_cullShader = ShaderSubmit({nullptr, nullptr, "assets/shaders/cull.comp"}, transientStorage);
+        g_drawShader = ShaderSubmit({"assets/shaders/indirect.vert", "assets/shaders/indirect.frag"}, transientStorage);
+        if (!g_cullShader || !g_drawShader)
+        {
+            D_ASSERT(false, "Failed to submit GPU culling shaders.");
+            return false;
+        }
+
+        utils::Size bytes {6 * sizeof(u32) + maxObjects * (sizeof(u32) + sizeof(CullObject) + sizeof(DrawElementsIndirectCommand))};
+        if (!GpuMemoryFitsBudget(bytes))
+        {
+            D_ERROR("GPU culling of %u objects does not fit the GPU memory budget.", maxObjects);
+            return false;
+        }
+
+        g_maxObjects = maxObjects;
+
+        glGenVertexArrays(1, &g_VAO);
+        glBindVertexArray(g_VAO);
+        TRACK_LEAK_ALLOC(&g_VAO, LeakType::OPENGL, "GPU culling VAO");
+
+        const u32 indices[6] {0, 1, 2, 2, 1, 3};
+        CreateBuffer(&g_indexBuffer, GL_ELEMENT_ARRAY_BUFFER, GpuMemoryCategory::INDEX_BUFFER, sizeof(indices), indices, "GPU culling indices");
+
+        std::vector<u32> instances(maxObjects);
+        for (u32 i {0}; i < maxObjects; ++i)
+        {
+            instances[i] = i;
+        }
+        CreateBuffer(&g_instanceBuffer, GL_ARRAY_BUFFER, GpuMemoryCategory::VERTEX_BUFFER, maxObjects * sizeof(u32), instances.data(), "GPU culling instances");
+        glEnableVertexAttribArray(0);
+        glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(u32), nullptr);
+        glVertexAttribDivisor(0, 1);
+        glBindVertexArray(0);
+
+        CreateBuffer(&g_objectBuffer, GL_SHADER_STORAGE_BUFFER, GpuMemoryCategory::STORAGE_BUFFER, maxObjects * sizeof(CullObject), nullptr, "GPU culling objects");
+        CreateBuffer(&g_commandBuffer, GL_SHADER_STORAGE_BUFFER, GpuMemoryCategory::STORAGE_BUFFER, maxObjects * sizeof(DrawElementsIndirectCommand), nullptr, "GPU culling commands");
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        return true;
+    }
+
+    void GpuCullingSetObjects(const CullObject* objects, u32 count)
+    {
+        if (!g_objectBuffer)
+        {
+            return;
+        }
+
+        if (count > g_maxObjects)
+        {
+            D_WARN("%u objects for GPU culling, only %u fit.", count, g_maxObjects);
+            count = g_maxObjects;
+        }
+
+        // Only the bounds change here, the per frame work is all on the GPU.
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, g_objectBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(CullObject), objects);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        GpuMemoryTrackUpload(count * sizeof(CullObject));
+        g_objectCount = count;
+    }
+
+    u32 GpuCullingObjectCount()
+    {
+        return g_objectCount;
+    }
+
+    void GpuCullingDispatch()
+    {
+        if (!g_objectCount || !ShaderIsReady(g_cullShader))
+        {
+            return;
+        }
+
+        u32 program {ShaderGetProgram(g_cullShader)};
+        if (g_objectCountLocation < 0)
+        {
+            g_objectCountLocation = glGetUniformLocation(program, "objectCount");
+        }
+
+        glUseProgram(program);
+        glUniform1i(g_objectCountLocation, (GLint) g_objectCount);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, g_objectBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, g_commandBuffer);
+        glDispatchCompute((g_objectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+        // The commands are read as indirect arguments, not through a shader.
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+    }
+
+    void GpuCullingDraw()
+    {
+        if (!g_objectCount || !ShaderIsReady(g_cullShader) || !ShaderIsReady(g_drawShader))
+        {
+            return;
+        }
+
+        glUseProgram(ShaderGetProgram(g_drawShader));
+        glBindVertexArray(g_VAO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, g_objectBuffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, g_commandBuffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei) g_objectCount, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    void GpuCullingShutdown()
+    {
+        DestroyBuffer(&g_objectBuffer, GpuMemoryCategory::STORAGE_BUFFER);
+        DestroyBuffer(&g_commandBuffer, GpuMemoryCategory::STORAGE_BUFFER);
+        DestroyBuffer(&g_indexBuffer, GpuMemoryCategory::INDEX_BUFFER);
+        DestroyBuffer(&g_instanceBuffer, GpuMemoryCategory::VERTEX_BUFFER);
+
+        if (g_VAO)
+        {
+            glDeleteVertexArrays(1, &g_VAO);
+            TRACK_LEAK_FREE(&g_VAO);
+            g_VAO = 0;
+        }
+
+        // The programs belong to the shader manager.
+        g_cullShader          = 0;
+        g_drawShader          = 0;
+        g_objectCountLocation = -1;
+        g_maxObjects          = 0;
+        g_objectCount         = 0;
+    }
+} // namespace drop::renderer
@@ -0,0 +1,247 @@
+#include "renderer/gpu_memory.hpp"
+#include "renderer/opengl.hpp"
+
+#ifdef _WIN32
+#include <gl/GL.h>
+#elif defined(__linux__)
+#include <GL/gl.h>
+#endif // _WIN32
+
+#include <unordered_map>
+
+// Byte accounting for every GL allocation the renderer makes.
+// The leak tracker only knows that a GL object exists, this knows how big it is.
+
+namespace drop::renderer
+{
+    namespace
+    {
+        struct Allocation
+        {
+            GpuMemoryCategory category;
+            utils::Size       bytes;
+        };
+
+        std::unordered_map<u64, Allocation> g_allocations;
+        GpuMemoryStats                      g_stats {};
+        utils::Size                         g_currentFrameUpload {0};
+        bool                                g_hasNVXMemoryInfo {false};
+        bool                                g_hasATIMemInfo {false};
+        bool                                g_overBudget {false};
+
+        const char* ToString(GpuMemoryCategory category)
+        {
+            switch (category)
+            {
+            case GpuMemoryCategory::VERTEX_BUFFER:
+                return "VERTEX_BUFFER";
+            case GpuMemoryCategory::INDEX_BUFFER:
+                return "INDEX_BUFFER";
+            case GpuMemoryCategory::UNIFORM_BUFFER:
+                return "UNIFORM_BUFFER";
+            case GpuMemoryCategory::STORAGE_BUFFER:
+                return "STORAGE_BUFFER";
+            case GpuMemoryCategory::STAGING_BUFFER:
+                return "STAGING_BUFFER";
+            case GpuMemoryCategory::TEXTURE:
+                return "TEXTURE";
+            case GpuMemoryCategory::RENDER_TARGET:
+                return "RENDER_TARGET";
+            default:
+                return "UNKNOWN";
+            }
+        }
+
+        // Buffers, textures and renderbuffers live in different GL namespaces,
+        // so the category is part of the key.
+        u64 MakeKey(u32 handle, GpuMemoryCategory category)
+        {
+            return ((u64) category << 32) | handle;
+        }
+
+        void CheckBudget()
+        {
+            if (!g_stats.budget)
+            {
+                return;
+            }
+
+            bool overBudget {g_stats.total > g_stats.budget};
+            if (overBudget && !g_overBudget)
+            {
+                D_WARN("GPU memory budget exceeded: %llu / %llu bytes.", g_stats.total, g_stats.budget);
+            }
+            g_overBudget = overBudget;
+        }
+    } // namespace anonymous
+
+    void GpuMemoryInit(bool hasNVXMemoryInfo, bool hasATIMemInfo)
+    {
+        g_hasNVXMemoryInfo = hasNVXMemoryInfo;
+        g_hasATIMemInfo    = hasATIMemInfo;
+
+        GpuMemoryQueryDriver();
+        if (g_stats.driverTotalKB >= 0)
+        {
+            D_TRACE("GPU memory: %lld KB total, %lld KB available.", g_stats.driverTotalKB, g_stats.driverAvailableKB);
+        }
+        else if (g_stats.driverAvailableKB >= 0)
+        {
+            D_TRACE("GPU memory: %lld KB available.", g_stats.driverAvailableKB);
+        }
+    }
+
+    void GpuMemoryTrackAlloc(u32 handle, GpuMemoryCategory category, utils::Size bytes)
+    {
+        D_ASSERT(category < GpuMemoryCategory::COUNT, "Invalid GPU memory category.");
+
+        GpuMemoryCategoryStats& categoryStats {g_stats.categories[(u32) category]};
+
+        // Respecifying storage (glBufferData / glTexImage on the same name) replaces the old size.
+        Allocation& allocation {g_allocations[MakeKey(handle, category)]};
+        if (allocation.bytes)
+        {
+            categoryStats.current -= allocation.bytes;
+            g_stats.total -= allocation.bytes;
+        }
+        else
+        {
+            categoryStats.count++;
+        }
+
+        allocation.category = category;
+        allocation.bytes    = bytes;
+
+        categoryStats.current += bytes;
+        g_stats.total += bytes;
+
+        if (categoryStats.current > categoryStats.peak)
+        {
+            categoryStats.peak = categoryStats.current;
+        }
+        if (g_stats.total > g_stats.peak)
+        {
+            g_stats.peak = g_stats.total;
+        }
+
+        CheckBudget();
+    }
+
+    void GpuMemoryTrackFree(u32 handle, GpuMemoryCategory category)
+    {
+        auto it {g_allocations.find(MakeKey(handle, category))};
+        if (it == g_allocations.end())
+        {
+            D_WARN("Freeing untracked GPU allocation: %u, category: %s", handle, ToString(category));
+            return;
+        }
+
+        GpuMemoryCategoryStats& categoryStats {g_stats.categories[(u32) category]};
+        categoryStats.current -= it->second.bytes;
+        categoryStats.count--;
+        g_stats.total -= it->second.bytes;
+
+        g_allocations.erase(it);
+        CheckBudget();
+    }
+
+    void GpuMemoryTrackUpload(utils::Size bytes)
+    {
+        g_currentFrameUpload += bytes;
+    }
+
+    void GpuMemorySetBudget(utils::Size bytes)
+    {
+        g_stats.budget = bytes;
+        g_overBudget   = false;
+        CheckBudget();
+    }
+
+    bool GpuMemoryFitsBudget(utils::Size bytes)
+    {
+        return !g_stats.budget || g_stats.total + bytes <= g_stats.budget;
+    }
+
+    void GpuMemoryBeginFrame()
+    {
+        g_stats.frameUpload = g_currentFrameUpload;
+        if (g_stats.frameUpload > g_stats.peakFrameUpload)
+        {
+            g_stats.peakFrameUpload = g_stats.frameUpload;
+        }
+        g_currentFrameUpload = 0;
+    }
+
+    void GpuMemoryQueryDriver()
+    {
+        if (g_hasNVXMemoryInfo)
+        {
+            GLint total {0}, available {0}, evicted {0};
+            glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &total);
+            glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+            glGetIntegerv(GL_GPU_MEMORY_INFO_EVICTED_MEMORY_NVX, &evicted);
+
+            g_stats.driverTotalKB     = total;
+            g_stats.driverAvailableKB = available;
+            g_stats.driverEvictedKB   = evicted;
+        }
+        else if (g_hasATIMemInfo)
+        {
+            // [0] total free in the pool, [1] largest free block, [2] total auxiliary free, [3] largest auxiliary block.
+            GLint textureFree[4] {};
+            glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, textureFree);
+
+            g_stats.driverAvailableKB = textureFree[0];
+        }
+    }
+
+    void GpuMemoryReport()
+    {
+        GpuMemoryQueryDriver();
+
+        D_TRACE("GPU memory: %llu bytes in use, %llu bytes peak, %llu bytes budget.", g_stats.total, g_stats.peak, g_stats.budget);
+        for (u32 i {0}; i < (u32) GpuMemoryCategory::COUNT; ++i)
+        {
+            const GpuMemoryCategoryStats& categoryStats {g_stats.categories[i]};
+            if (!categoryStats.peak)
+            {
+                continue;
+            }
+
+            D_TRACE("  %-15s %u objects, %llu bytes, %llu bytes peak.",
+                    ToString((GpuMemoryCategory) i), categoryStats.count, categoryStats.current, categoryStats.peak);
+        }
+        D_TRACE("  Upload: %llu bytes last frame, %llu bytes peak frame.", g_stats.frameUpload, g_stats.peakFrameUpload);
+
+        // GL_ATI_meminfo only reports what is free.
+        if (g_stats.driverTotalKB >= 0)
+        {
+            D_TRACE("  Driver: %lld KB total, %lld KB available, %lld KB evicted.",
+                    g_stats.driverTotalKB, g_stats.driverAvailableKB, g_stats.driverEvictedKB);
+        }
+        else if (g_stats.driverAvailableKB >= 0)
+        {
+            D_TRACE("  Driver: %lld KB available.", g_stats.driverAvailableKB);
+        }
+    }
+
+    void GpuMemoryShutdown()
+    {
+        for (const auto& [key, allocation] : g_allocations)
+        {
+            D_LEAK("GPU allocation still alive: %u, category: %s, bytes: %llu", (u32) key, ToString(allocation.category), allocation.bytes);
+        }
+
+        g_allocations.clear();
+        g_stats              = {};
+        g_currentFrameUpload = 0;
+        g_hasNVXMemoryInfo   = false;
+        g_hasATIMemInfo      = false;
+        g_overBudget         = false;
+    }
+
+    const GpuMemoryStats& GpuMemoryGetStats()
+    {
+        return g_stats;
+    }
+} // namespace drop::renderer
@@ -0,0 +1,137 @@
+#include "renderer/gpu_timer.hpp"
+#include "renderer/gl_loader.hpp"
+
+namespace drop::renderer
+{
+    namespace
+    {
+        constexpr u32 MAX_GPU_TIMERS {16};
+        constexpr u32 GPU_TIMER_FRAMES {4}; // Queries in flight per timer, results lag this many frames at most.
+
+        struct GpuTimer
+        {
+            const Char* name {nullptr};
+            GLuint      queries[GPU_TIMER_FRAMES][2] {};
+            bool        issued[GPU_TIMER_FRAMES] {};
+            f32         ms {-1.f};
+        };
+
+        GpuTimer g_timers[MAX_GPU_TIMERS] {};
+        u32      g_timerCount {0};
+        u32      g_frameIndex {0};
+
+        GpuTimer* GetTimer(GpuTimerHandle handle)
+        {
+            if (!g_glCaps.timerQuery || !handle || handle > g_timerCount)
+            {
+                return nullptr;
+            }
+
+            return &g_timers[handle - 1];
+        }
+
+        // Reads a slot if the GPU is done with it.
+        void Collect(GpuTimer& timer, u32 slot)
+        {
+            if (!timer.issued[slot])
+            {
+                return;
+            }
+
+            GLint available {GL_FALSE};
+            glGetQueryObjectiv(timer.queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+            {
+                return; // Still in flight, the slot gets overwritten and this sample is lost.
+            }
+
+            GLuint64 begin {0};
+            GLuint64 end {0};
+            glGetQueryObjectui64v(timer.queries[slot][0], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(timer.queries[slot][1], GL_QUERY_RESULT, &end);
+            timer.ms           = (f32) ((end - begin) / 1e6);
+            timer.issued[slot] = false;
+        }
+    } // namespace anonymous
+
+    void GpuTimerInit()
+    {
+        g_timerCount = 0;
+        g_frameIndex = 0;
+    }
+
+    GpuTimerHandle GpuTimerCreate(const Char* name)
+    {
+        if (g_timerCount == MAX_GPU_TIMERS)
+        {
+            D_ASSERT(false, "Too many GPU timers.");
+            return 0;
+        }
+
+        GpuTimer& timer {g_timers[g_timerCount]};
+        timer      = {};
+        timer.name = name;
+        if (g_glCaps.timerQuery)
+        {
+            glGenQueries(GPU_TIMER_FRAMES * 2, &timer.queries[0][0]);
+            TRACK_LEAK_ALLOC(&timer.queries, LeakType::OPENGL, "GPU timer queries");
+        }
+
+        return ++g_timerCount;
+    }
+
+    void GpuTimerBeginFrame()
+    {
+        if (!g_glCaps.timerQuery)
+        {
+            return;
+        }
+
+        g_frameIndex = (g_frameIndex + 1) % GPU_TIMER_FRAMES;
+        for (u32 i {0}; i < g_timerCount; ++i)
+        {
+            // Oldest first, the slot about to be reused, so a newer result that is ready overwrites it.
+            for (u32 age {0}; age < GPU_TIMER_FRAMES; ++age)
+            {
+                Collect(g_timers[i], (g_frameIndex + age) % GPU_TIMER_FRAMES);
+            }
+        }
+    }
+
+    void GpuTimerBegin(GpuTimerHandle handle)
+    {
+        if (GpuTimer* timer {GetTimer(handle)})
+        {
+            glQueryCounter(timer->queries[g_frameIndex][0], GL_TIMESTAMP);
+        }
+    }
+
+    void GpuTimerEnd(GpuTimerHandle handle)
+    {
+        if (GpuTimer* timer {GetTimer(handle)})
+        {
+            glQueryCounter(timer->queries[g_frameIndex][1], GL_TIMESTAMP);
+            timer->issued[g_frameIndex] = true;
+        }
+    }
+
+    f32 GpuTimerGetMs(GpuTimerHandle handle)
+    {
+        GpuTimer* timer {GetTimer(handle)};
+        return timer ? timer->ms : -1.f;
+    }
+
+    void GpuTimerShutdown()
+    {
+        for (u32 i {0}; i < g_timerCount; ++i)
+        {
+            if (g_glCaps.timerQuery)
+            {
+                glDeleteQueries(GPU_TIMER_FRAMES * 2, &g_timers[i].queries[0][0]);
+                TRACK_LEAK_FREE(&g_timers[i].queries);
+            }
+            g_timers[i] = {};
+        }
+        g_timerCount = 0;
+    }
+} // namespace drop::renderer
@@ -0,0 +1,280 @@
+#include "renderer/lighting.hpp"
+#include "renderer/gl_loader.hpp"
+#include "renderer/gpu_memory.hpp"
+#include "renderer/shader.hpp"
+
+#include <cmath> // floorf.
+#include <vector>
+
+namespace drop::renderer
+{
+    namespace
+    {
+        struct LightBuffer
+        {
+            GLuint      buffer {0};
+            GLuint      texture {0}; // GL_TEXTURE_BUFFER view of buffer.
+            utils::Size bytes {0};
+        };
+
+        enum LightingUniform
+        {
+            LIGHTING_UNIFORM_ALBEDO,
+            LIGHTING_UNIFORM_SURFACE,
+            LIGHTING_UNIFORM_LIGHTS,
+            LIGHTING_UNIFORM_TILES,
+            LIGHTING_UNIFORM_AMBIENT,
+            LIGHTING_UNIFORM_GRID,
+            LIGHTING_UNIFORM_COUNT
+        };
+
+        constexpr const Char* UNIFORM_NAMES[LIGHTING_UNIFORM_COUNT] {"albedo", "surface", "lights", "tiles", "ambient", "grid"};
+
+        ShaderHandle            g_lightingShader {0};
+        GLint                   g_uniforms[LIGHTING_UNIFORM_COUNT] {};
+        bool                    g_uniformsLoaded {false};
+        LightBuffer             g_lightBuffer {};
+        LightBuffer             g_tileBuffer {};
+        std::vector<PointLight> g_lights;
+        std::vector<u32>        g_tileData;   // Header of offset and count per tile, then the indices.
+        std::vector<u32>        g_tileCounts; // Scratch for the binning.
+        f32                     g_ambient[3] {1.f, 1.f, 1.f};
+        f32                     g_grid[4] {};
+        LightingStats           g_stats {};
+
+        bool CreateLightBuffer(LightBuffer& light, GLenum format, const Char* name)
+        {
+            glGenBuffers(1, &light.buffer);
+            glBindBuffer(GL_TEXTURE_BUFFER, light.buffer);
+            glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+            light.bytes = 16;
+            GpuMemoryTrackAlloc(light.buffer, GpuMemoryCategory::STORAGE_BUFFER, light.bytes);
+            TRACK_LEAK_ALLOC(&light.buffer, LeakType::OPENGL, name);
+
+            glGenTextures(1, &light.texture);
+            glBindTexture(GL_TEXTURE_BUFFER, light.texture);
+            glTexBuffer(GL_TEXTURE_BUFFER, format, light.buffer);
+            glBindTexture(GL_TEXTURE_BUFFER, 0);
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+            TRACK_LEAK_ALLOC(&light.texture, LeakType::OPENGL, name);
+            return light.buffer && light.texture;
+        }
+
+        void DestroyLightBuffer(LightBuffer& light)
+        {
+            if (light.texture)
+            {
+                glDeleteTextures(1, &light.texture);
+                TRACK_LEAK_FREE(&light.texture);
+            }
+
+            if (light.buffer)
+            {
+                GpuMemoryTrackFree(light.buffer, GpuMemoryCategory::STORAGE_BUFFER);
+                glDeleteBuffers(1, &light.buffer);
+                TRACK_LEAK_FREE(&light.buffer);
+            }
+            light = {};
+        }
+
+        // Orphans the storage every frame, grows it when the data no longer fits.
+        void Upload(LightBuffer& light, const void* data, utils::Size bytes)
+        {
+            if (!bytes)
+            {
+                return;
+            }
+
+            glBindBuffer(GL_TEXTURE_BUFFER, light.buffer);
+            if (bytes > light.bytes)
+            {
+                // The data itself is bounded by MAX_POINT_LIGHTS and the tile grid, only the headroom gives way to the budget.
+                utils::Size grown {bytes + bytes / 2};
+                if (!GpuMemoryFitsBudget(grown - light.bytes))
+                {
+                    grown = bytes;
+                }
+
+                GpuMemoryTrackFree(light.buffer, GpuMemoryCategory::STORAGE_BUFFER);
+                light.bytes = grown;
+                GpuMemoryTrackAlloc(light.buffer, GpuMemoryCategory::STORAGE_BUFFER, light.bytes);
+            }
+            glBufferData(GL_TEXTURE_BUFFER, light.bytes, nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+            GpuMemoryTrackUpload(bytes);
+        }
+
+        // Tiles covered by the bounding square of a light, inclusive. Empty (min > max) when off screen.
+        void TileRange(const PointLight& light, i32* range)
+        {
+            f32 scale {g_grid[3] / (f32) LIGHT_TILE_SIZE};
+            range[0] = (i32) floorf((light.position[0] - light.radius) * scale);
+            range[1] = (i32) floorf((light.position[1] - light.radius) * scale);
+            range[2] = (i32) floorf((light.position[0] + light.radius) * scale);
+            range[3] = (i32) floorf((light.position[1] + light.radius) * scale);
+            range[0] = range[0] < 0 ? 0 : range[0];
+            range[1] = range[1] < 0 ? 0 : range[1];
+            range[2] = range[2] >= (i32) g_grid[0] ? (i32) g_grid[0] - 1 : range[2];
+            range[3] = range[3] >= (i32) g_grid[1] ? (i32) g_grid[1] - 1 : range[3];
+        }
+    } // namespace anonymous
+
+    bool LightingInit(utils::BumpAllocator* transientStorage)
+    {
+        g_lightingShader = ShaderSubmit({"assets/shaders/fullscreen.vert", "assets/shaders/lighting.frag"}, transientStorage);
+        if (!g_lightingShader)
+        {
+            D_ASSERT(false, "Failed to submit lighting shader.");
+            return false;
+        }
+
+        if (!CreateLightBuffer(g_lightBuffer, GL_RGBA32F, "Light buffer") ||
+            !CreateLightBuffer(g_tileBuffer, GL_R32UI, "Light tile buffer"))
+        {
+            D_ASSERT(false, "Failed to create light buffers.");
+            return false;
+        }
+
+        g_lights.reserve(MAX_POINT_LIGHTS);
+        return true;
+    }
+
+    void LightingBeginFrame()
+    {
+        g_lights.clear();
+    }
+
+    void LightingSetAmbient(f32 r, f32 g, f32 b)
+    {
+        g_ambient[0] = r;
+        g_ambient[1] = g;
+        g_ambient[2] = b;
+    }
+
+    void LightingAddPoint(const PointLight& light)
+    {
+        if (g_lights.size() == MAX_POINT_LIGHTS)
+        {
+            D_WARN("More than %u point lights, the rest are dropped.", MAX_POINT_LIGHTS);
+            return;
+        }
+
+        if (light.radius > 0.f && light.intensity > 0.f)
+        {
+            g_lights.push_back(light);
+        }
+    }
+
+    void LightingCull(u32 targetWidth, u32 targetHeight, f32 pixelScale)
+    {
+        u32 tilesX {(targetWidth + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE};
+        u32 tilesY {(targetHeight + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE};
+        u32 tileCount {tilesX * tilesY};
+        g_grid[0] = (f32) tilesX;
+        g_grid[1] = (f32) tilesY;
+        g_grid[2] = (f32) LIGHT_TILE_SIZE;
+        g_grid[3] = pixelScale;
+
+        // Count, prefix sum, then fill, so every tile's list is contiguous.
+        g_tileCounts.assign(tileCount, 0);
+        for (const PointLight& light : g_lights)
+        {
+            i32 range[4];
+            TileRange(light, range);
+            for (i32 y {range[1]}; y <= range[3]; ++y)
+            {
+                for (i32 x {range[0]}; x <= range[2]; ++x)
+                {
+                    g_tileCounts[y * tilesX + x]++;
+                }
+            }
+        }
+
+        g_stats        = {};
+        g_stats.lights = (u32) g_lights.size();
+        g_stats.tiles  = tileCount;
+        u32 offset {tileCount * 2};
+        g_tileData.resize(offset);
+        for (u32 tile {0}; tile < tileCount; ++tile)
+        {
+            g_tileData[tile * 2]     = offset;
+            g_tileData[tile * 2 + 1] = 0;
+            offset += g_tileCounts[tile];
+            g_stats.maxPerTile = g_tileCounts[tile] > g_stats.maxPerTile ? g_tileCounts[tile] : g_stats.maxPerTile;
+        }
+        g_tileData.resize(offset);
+        g_stats.indices = offset - tileCount * 2;
+
+        for (u32 index {0}; index < g_lights.size(); ++index)
+        {
+            i32 range[4];
+            TileRange(g_lights[index], range);
+            for (i32 y {range[1]}; y <= range[3]; ++y)
+            {
+                for (i32 x {range[0]}; x <= range[2]; ++x)
+                {
+                    u32* header {&g_tileData[(y * tilesX + x) * 2]};
+                    g_tileData[header[0] + header[1]++] = index;
+                }
+            }
+        }
+
+        static_assert(sizeof(PointLight) == 8 * sizeof(f32), "PointLight must be two RGBA32F texels.");
+        Upload(g_lightBuffer, g_lights.data(), g_lights.size() * sizeof(PointLight));
+        Upload(g_tileBuffer, g_tileData.data(), g_tileData.size() * sizeof(u32));
+    }
+
+    bool LightingBind(u32 albedoTexture, u32 surfaceTexture)
+    {
+        if (!ShaderIsReady(g_lightingShader))
+        {
+            return false;
+        }
+
+        u32 program {ShaderGetProgram(g_lightingShader)};
+        glUseProgram(program);
+        if (!g_uniformsLoaded)
+        {
+            for (u32 i {0}; i < LIGHTING_UNIFORM_COUNT; ++i)
+            {
+                g_uniforms[i] = glGetUniformLocation(program, UNIFORM_NAMES[i]);
+            }
+            glUniform1i(g_uniforms[LIGHTING_UNIFORM_ALBEDO], 0);
+            glUniform1i(g_uniforms[LIGHTING_UNIFORM_SURFACE], 1);
+            glUniform1i(g_uniforms[LIGHTING_UNIFORM_LIGHTS], 2);
+            glUniform1i(g_uniforms[LIGHTING_UNIFORM_TILES], 3);
+            g_uniformsLoaded = true;
+        }
+        glUniform4f(g_uniforms[LIGHTING_UNIFORM_AMBIENT], g_ambient[0], g_ambient[1], g_ambient[2], 1.f);
+        glUniform4f(g_uniforms[LIGHTING_UNIFORM_GRID], g_grid[0], g_grid[1], g_grid[2], g_grid[3]);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, albedoTexture);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, surfaceTexture);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_BUFFER, g_lightBuffer.texture);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_BUFFER, g_tileBuffer.texture);
+        glActiveTexture(GL_TEXTURE0);
+        return true;
+    }
+
+    const LightingStats& LightingGetStats()
+    {
+        return g_stats;
+    }
+
+    void LightingShutdown()
+    {
+        DestroyLightBuffer(g_lightBuffer);
+        DestroyLightBuffer(g_tileBuffer);
+        g_lights.clear();
+        g_tileData.clear();
+        g_tileCounts.clear();
+        g_lightingShader = 0;
+        g_uniformsLoaded = false;
+        g_stats          = {};
+    }
+} // namespace drop::renderer
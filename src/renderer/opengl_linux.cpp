@@ -1,212 +1,184 @@
 #include "renderer/opengl.hpp"
-#include "utils/file_io.hpp"
-#include "shared/input.hpp"
+#include "renderer/gl_loader.hpp"
+#include "renderer/renderer.hpp"
+#include "utils/profiler.hpp"
+#include "utils/startup_profile.hpp"
 
 #include "opengl/glxext.h"
-#include <GL/gl.h>
+
+// Headless runs render into an EGL pbuffer on Mesa's surfaceless platform, no X server needed.
+#if __has_include(<EGL/egl.h>)
+#define D_EGL 1
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif // __has_include
 
 namespace drop::renderer
 {
 
     namespace
     {
-#define LOAD_GL_FUNCTION(type, name)                         \
-    name = (type) glXGetProcAddress((const GLubyte*) #name); \
-    D_ASSERT(name, "Failed to load OpenGL function: %s", #name);
-
-#pragma region OpenGL Functions
-        static PFNGLCREATEPROGRAMPROC           glCreateProgram;
-        static PFNGLCREATESHADERPROC            glCreateShader;
-        static PFNGLGETUNIFORMLOCATIONPROC      glGetUniformLocation;
-        static PFNGLUNIFORM1FPROC               glUniform1f;
-        static PFNGLUNIFORM2FVPROC              glUniform2fv;
-        static PFNGLUNIFORM3FVPROC              glUniform3fv;
-        static PFNGLUNIFORM1IPROC               glUniform1i;
-        static PFNGLUNIFORMMATRIX4FVPROC        glUniformMatrix4fv;
-        static PFNGLVERTEXATTRIBDIVISORPROC     glVertexAttribDivisor;
-        static PFNGLACTIVETEXTUREPROC           glActiveTexture;
-        static PFNGLBUFFERSUBDATAPROC           glBufferSubData;
-        static PFNGLDRAWARRAYSINSTANCEDPROC     glDrawArraysInstanced;
-        static PFNGLBINDFRAMEBUFFERPROC         glBindFramebuffer;
-        static PFNGLCHECKFRAMEBUFFERSTATUSPROC  glCheckFramebufferStatus;
-        static PFNGLGENFRAMEBUFFERSPROC         glGenFramebuffers;
-        static PFNGLFRAMEBUFFERTEXTURE2DPROC    glFramebufferTexture2D;
-        static PFNGLDRAWBUFFERSPROC             glDrawBuffers;
-        static PFNGLDELETEFRAMEBUFFERSPROC      glDeleteFramebuffers;
-        static PFNGLBLENDFUNCIPROC              glBlendFunci;
-        static PFNGLBLENDEQUATIONPROC           glBlendEquation;
-        static PFNGLCLEARBUFFERFVPROC           glClearBufferfv;
-        static PFNGLSHADERSOURCEPROC            glShaderSource;
-        static PFNGLCOMPILESHADERPROC           glCompileShader;
-        static PFNGLGETSHADERIVPROC             glGetShaderiv;
-        static PFNGLGETSHADERINFOLOGPROC        glGetShaderInfoLog;
-        static PFNGLATTACHSHADERPROC            glAttachShader;
-        static PFNGLLINKPROGRAMPROC             glLinkProgram;
-        static PFNGLVALIDATEPROGRAMPROC         glValidateProgram;
-        static PFNGLGETPROGRAMIVPROC            glGetProgramiv;
-        static PFNGLGETPROGRAMINFOLOGPROC       glGetProgramInfoLog;
-        static PFNGLGENBUFFERSPROC              glGenBuffers;
-        static PFNGLGENVERTEXARRAYSPROC         glGenVertexArrays;
-        static PFNGLGETATTRIBLOCATIONPROC       glGetAttribLocation;
-        static PFNGLBINDVERTEXARRAYPROC         glBindVertexArray;
-        static PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArray;
-        static PFNGLVERTEXATTRIBPOINTERPROC     glVertexAttribPointer;
-        static PFNGLBINDBUFFERPROC              glBindBuffer;
-        static PFNGLBINDBUFFERBASEPROC          glBindBufferBase;
-        static PFNGLBUFFERDATAPROC              glBufferData;
-        static PFNGLGETVERTEXATTRIBPOINTERVPROC glGetVertexAttribPointerv;
-        static PFNGLUSEPROGRAMPROC              glUseProgram;
-        static PFNGLDELETEVERTEXARRAYSPROC      glDeleteVertexArrays;
-        static PFNGLDELETEBUFFERSPROC           glDeleteBuffers;
-        static PFNGLDELETEPROGRAMPROC           glDeleteProgram;
-        static PFNGLDETACHSHADERPROC            glDetachShader;
-        static PFNGLDELETESHADERPROC            glDeleteShader;
-        static PFNGLDRAWELEMENTSINSTANCEDPROC   glDrawElementsInstanced;
-        static PFNGLGENERATEMIPMAPPROC          glGenerateMipmap;
-        static PFNGLDEBUGMESSAGECALLBACKPROC    glDebugMessageCallback;
-#pragma endregion
-
-        void LoadOpenGLFunctions()
-        {
-            LOAD_GL_FUNCTION(PFNGLCREATEPROGRAMPROC, glCreateProgram);
-            LOAD_GL_FUNCTION(PFNGLCREATESHADERPROC, glCreateShader);
-            LOAD_GL_FUNCTION(PFNGLGETUNIFORMLOCATIONPROC, glGetUniformLocation);
-            LOAD_GL_FUNCTION(PFNGLUNIFORM1FPROC, glUniform1f);
-            LOAD_GL_FUNCTION(PFNGLUNIFORM2FVPROC, glUniform2fv);
-            LOAD_GL_FUNCTION(PFNGLUNIFORM3FVPROC, glUniform3fv);
-            LOAD_GL_FUNCTION(PFNGLUNIFORM1IPROC, glUniform1i);
-            LOAD_GL_FUNCTION(PFNGLUNIFORMMATRIX4FVPROC, glUniformMatrix4fv);
-            LOAD_GL_FUNCTION(PFNGLVERTEXATTRIBDIVISORPROC, glVertexAttribDivisor);
-            LOAD_GL_FUNCTION(PFNGLACTIVETEXTUREPROC, glActiveTexture);
-            LOAD_GL_FUNCTION(PFNGLBUFFERSUBDATAPROC, glBufferSubData);
-            LOAD_GL_FUNCTION(PFNGLDRAWARRAYSINSTANCEDPROC, glDrawArraysInstanced);
-            LOAD_GL_FUNCTION(PFNGLBINDFRAMEBUFFERPROC, glBindFramebuffer);
-            LOAD_GL_FUNCTION(PFNGLCHECKFRAMEBUFFERSTATUSPROC, glCheckFramebufferStatus);
-            LOAD_GL_FUNCTION(PFNGLGENFRAMEBUFFERSPROC, glGenFramebuffers);
-            LOAD_GL_FUNCTION(PFNGLFRAMEBUFFERTEXTURE2DPROC, glFramebufferTexture2D);
-            LOAD_GL_FUNCTION(PFNGLDRAWBUFFERSPROC, glDrawBuffers);
-            LOAD_GL_FUNCTION(PFNGLDELETEFRAMEBUFFERSPROC, glDeleteFramebuffers);
-            LOAD_GL_FUNCTION(PFNGLBLENDFUNCIPROC, glBlendFunci);
-            LOAD_GL_FUNCTION(PFNGLBLENDEQUATIONPROC, glBlendEquation);
-            LOAD_GL_FUNCTION(PFNGLCLEARBUFFERFVPROC, glClearBufferfv);
-            LOAD_GL_FUNCTION(PFNGLSHADERSOURCEPROC, glShaderSource);
-            LOAD_GL_FUNCTION(PFNGLCOMPILESHADERPROC, glCompileShader);
-            LOAD_GL_FUNCTION(PFNGLGETSHADERIVPROC, glGetShaderiv);
-            LOAD_GL_FUNCTION(PFNGLGETSHADERINFOLOGPROC, glGetShaderInfoLog);
-            LOAD_GL_FUNCTION(PFNGLATTACHSHADERPROC, glAttachShader);
-            LOAD_GL_FUNCTION(PFNGLLINKPROGRAMPROC, glLinkProgram);
-            LOAD_GL_FUNCTION(PFNGLVALIDATEPROGRAMPROC, glValidateProgram);
-            LOAD_GL_FUNCTION(PFNGLGETPROGRAMIVPROC, glGetProgramiv);
-            LOAD_GL_FUNCTION(PFNGLGETPROGRAMINFOLOGPROC, glGetProgramInfoLog);
-            LOAD_GL_FUNCTION(PFNGLGENBUFFERSPROC, glGenBuffers);
-            LOAD_GL_FUNCTION(PFNGLGENVERTEXARRAYSPROC, glGenVertexArrays);
-            LOAD_GL_FUNCTION(PFNGLGETATTRIBLOCATIONPROC, glGetAttribLocation);
-            LOAD_GL_FUNCTION(PFNGLBINDVERTEXARRAYPROC, glBindVertexArray);
-            LOAD_GL_FUNCTION(PFNGLENABLEVERTEXATTRIBARRAYPROC, glEnableVertexAttribArray);
-            LOAD_GL_FUNCTION(PFNGLVERTEXATTRIBPOINTERPROC, glVertexAttribPointer);
-            LOAD_GL_FUNCTION(PFNGLBINDBUFFERPROC, glBindBuffer);
-            LOAD_GL_FUNCTION(PFNGLBINDBUFFERBASEPROC, glBindBufferBase);
-            LOAD_GL_FUNCTION(PFNGLBUFFERDATAPROC, glBufferData);
-            LOAD_GL_FUNCTION(PFNGLGETVERTEXATTRIBPOINTERVPROC, glGetVertexAttribPointerv);
-            LOAD_GL_FUNCTION(PFNGLUSEPROGRAMPROC, glUseProgram);
-            LOAD_GL_FUNCTION(PFNGLDELETEVERTEXARRAYSPROC, glDeleteVertexArrays);
-            LOAD_GL_FUNCTION(PFNGLDELETEBUFFERSPROC, glDeleteBuffers);
-            LOAD_GL_FUNCTION(PFNGLDELETEPROGRAMPROC, glDeleteProgram);
-            LOAD_GL_FUNCTION(PFNGLDETACHSHADERPROC, glDetachShader);
-            LOAD_GL_FUNCTION(PFNGLDELETESHADERPROC, glDeleteShader);
-            LOAD_GL_FUNCTION(PFNGLDRAWELEMENTSINSTANCEDPROC, glDrawElementsInstanced);
-            LOAD_GL_FUNCTION(PFNGLGENERATEMIPMAPPROC, glGenerateMipmap);
-            LOAD_GL_FUNCTION(PFNGLDEBUGMESSAGECALLBACKPROC, glDebugMessageCallback);
-        }
-
         PFNGLXCREATECONTEXTATTRIBSARBPROC glXCreateContextAttribsARB {nullptr};
 
         GLXContext g_ctx {nullptr};
         Display*   g_display {nullptr};
         ::Window   g_window {0};
-        GLuint     g_programID {0};
-        GLuint     g_VAO {0};
 
-    } // namespace anonymous
+        // Newest first. The renderer picks its fast paths from whatever version it gets.
+        constexpr i32 CONTEXT_VERSIONS[][2] {{4, 6}, {4, 5}, {4, 3}, {3, 3}};
 
-    bool RendererInit(platform::WindowInfoPtr windowInfo)
-    {
-        if (!windowInfo)
-        {
-            D_ASSERT(false, "Window info is null.");
-            return false;
-        }
+        bool g_contextCreationFailed {false};
+        bool g_headless {false};
 
-        i32      screen {XDefaultScreen(*windowInfo->display)};
-        ::Window root {XRootWindow(*windowInfo->display, screen)};
-
-        const i32 visualAttribs[] {
-            GLX_X_RENDERABLE, True,
-            GLX_DRAWABLE_TYPE, GLX_WINDOW_BIT,
-            GLX_RENDER_TYPE, GLX_RGBA_BIT,
-            GLX_X_VISUAL_TYPE, GLX_TRUE_COLOR,
-            GLX_RED_SIZE, 8,
-            GLX_GREEN_SIZE, 8,
-            GLX_BLUE_SIZE, 8,
-            GLX_ALPHA_SIZE, 8,
-            GLX_DEPTH_SIZE, 24,
-            GLX_STENCIL_SIZE, 8,
-            GLX_DOUBLEBUFFER, True,
-            None};
-
-        i32          fbcount {0};
-        GLXFBConfig* fbc {glXChooseFBConfig(*windowInfo->display, screen, visualAttribs, &fbcount)};
-        if (!fbc || !fbcount)
-        {
-            D_ASSERT(false, "Failed to choose X11 framebuffer config");
-            return false;
-        }
-        TRACK_LEAK_ALLOC(fbc, LeakType::OPENGL, "X11 dummy framebuffer config");
+#ifdef D_EGL
+        EGLDisplay g_eglDisplay {EGL_NO_DISPLAY};
+        EGLSurface g_eglSurface {EGL_NO_SURFACE};
+        EGLContext g_eglContext {EGL_NO_CONTEXT};
 
-        XVisualInfo* vi {glXGetVisualFromFBConfig(*windowInfo->display, fbc[0])};
-        if (!vi)
+        bool CreateHeadlessContext(i32 width, i32 height)
         {
-            D_ASSERT(false, "Failed to get X11 visual info");
-            return false;
+            PFNEGLGETPLATFORMDISPLAYEXTPROC eglGetPlatformDisplayEXT {
+                (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT")};
+            if (!eglGetPlatformDisplayEXT)
+            {
+                D_ERROR("EGL has no eglGetPlatformDisplayEXT.");
+                return false;
+            }
+
+            g_eglDisplay = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (g_eglDisplay == EGL_NO_DISPLAY || !eglInitialize(g_eglDisplay, nullptr, nullptr))
+            {
+                D_ERROR("Failed to initialize the surfaceless EGL display: 0x%x", eglGetError());
+                g_eglDisplay = EGL_NO_DISPLAY;
+                return false;
+            }
+
+            const EGLint configAttribs[] {
+                EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                EGL_RED_SIZE, 8,
+                EGL_GREEN_SIZE, 8,
+                EGL_BLUE_SIZE, 8,
+                EGL_ALPHA_SIZE, 8,
+                EGL_NONE};
+
+            EGLConfig config {nullptr};
+            EGLint    configCount {0};
+            if (!eglChooseConfig(g_eglDisplay, configAttribs, &config, 1, &configCount) || !configCount)
+            {
+                D_ERROR("No EGL pbuffer config.");
+                return false;
+            }
+
+            const EGLint surfaceAttribs[] {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+            g_eglSurface = eglCreatePbufferSurface(g_eglDisplay, config, surfaceAttribs);
+            if (g_eglSurface == EGL_NO_SURFACE)
+            {
+                D_ERROR("Failed to create the EGL pbuffer: 0x%x", eglGetError());
+                return false;
+            }
+
+            eglBindAPI(EGL_OPENGL_API);
+            for (const auto& version : CONTEXT_VERSIONS)
+            {
+                const EGLint contextAttribs[] {
+                    EGL_CONTEXT_MAJOR_VERSION, version[0],
+                    EGL_CONTEXT_MINOR_VERSION, version[1],
+                    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                    EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+                    EGL_NONE};
+
+                g_eglContext = eglCreateContext(g_eglDisplay, config, EGL_NO_CONTEXT, contextAttribs);
+                if (g_eglContext != EGL_NO_CONTEXT)
+                {
+                    break;
+                }
+            }
+
+            if (g_eglContext == EGL_NO_CONTEXT || !eglMakeCurrent(g_eglDisplay, g_eglSurface, g_eglSurface, g_eglContext))
+            {
+                D_ERROR("Failed to create the EGL context: 0x%x", eglGetError());
+                return false;
+            }
+            TRACK_LEAK_ALLOC(g_eglContext, LeakType::HANDLE, "EGL context");
+            return true;
         }
-        TRACK_LEAK_ALLOC(vi, LeakType::CUSTOM, "X11 dummy visual info");
-        XFree(fbc);
-        TRACK_LEAK_FREE(fbc);
 
-        GLXContext dummyCtx {glXCreateContext(*windowInfo->display, vi, nullptr, GL_TRUE)};
-        if (!dummyCtx)
+        void DestroyHeadlessContext()
         {
-            D_ASSERT(false, "Failed to create X11 dummy context");
-            return false;
+            if (g_eglDisplay == EGL_NO_DISPLAY)
+            {
+                return;
+            }
+
+            eglMakeCurrent(g_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (g_eglContext != EGL_NO_CONTEXT)
+            {
+                eglDestroyContext(g_eglDisplay, g_eglContext);
+                TRACK_LEAK_FREE(g_eglContext);
+            }
+            if (g_eglSurface != EGL_NO_SURFACE)
+            {
+                eglDestroySurface(g_eglDisplay, g_eglSurface);
+            }
+            eglTerminate(g_eglDisplay);
+
+            g_eglDisplay = EGL_NO_DISPLAY;
+            g_eglSurface = EGL_NO_SURFACE;
+            g_eglContext = EGL_NO_CONTEXT;
         }
-        TRACK_LEAK_ALLOC(dummyCtx, LeakType::OPENGL, "X11 dummy context");
-        XFree(vi);
-        TRACK_LEAK_FREE(vi);
+#endif // D_EGL
 
-        if (!glXMakeCurrent(*windowInfo->display, *windowInfo->window, dummyCtx))
+        // A refused glXCreateContextAttribsARB raises an X error, which kills the process by default.
+        i32 ContextErrorHandler(Display*, XErrorEvent*)
         {
-            D_ASSERT(false, "Failed to make X11 context current");
-            return false;
+            g_contextCreationFailed = true;
+            return 0;
         }
 
-        LoadOpenGLFunctions(); // Load OpenGL functions.
-        LOAD_GL_FUNCTION(PFNGLXCREATECONTEXTATTRIBSARBPROC, glXCreateContextAttribsARB);
-        if (!glXCreateContextAttribsARB)
+        GLXContext CreateNewestContext(Display* display, GLXFBConfig fbc)
         {
-            D_ASSERT(false, "Failed to load glXCreateContextAttribsARB function");
-            return false;
-        }
+            XErrorHandler previousHandler {XSetErrorHandler(&ContextErrorHandler)};
 
-        D_TRACE("OpenGL version: %s", glGetString(GL_VERSION));
+            GLXContext ctx {nullptr};
+            for (const auto& version : CONTEXT_VERSIONS)
+            {
+                i32 contextAttribs[] {
+                    GLX_CONTEXT_MAJOR_VERSION_ARB, version[0],
+                    GLX_CONTEXT_MINOR_VERSION_ARB, version[1],
+                    GLX_CONTEXT_PROFILE_MASK_ARB, GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
+                    GLX_CONTEXT_FLAGS_ARB, GLX_CONTEXT_DEBUG_BIT_ARB,
+                    0};
+
+                g_contextCreationFailed = false;
+                ctx                     = glXCreateContextAttribsARB(display, fbc, nullptr, GL_TRUE, contextAttribs);
+                XSync(display, false);
+                if (ctx && !g_contextCreationFailed)
+                {
+                    break;
+                }
+                ctx = nullptr;
+            }
 
-        glXMakeCurrent(*windowInfo->display, None, nullptr);
-        glXDestroyContext(*windowInfo->display, dummyCtx);
-        TRACK_LEAK_FREE(dummyCtx);
+            XSetErrorHandler(previousHandler);
+            return ctx;
+        }
+    } // namespace anonymous
 
-        return true;
+    void* GetGLProcAddress(const Char* name)
+    {
+#ifdef D_EGL
+        if (g_headless)
+        {
+            return (void*) eglGetProcAddress(name);
+        }
+#endif // D_EGL
+        return (void*) glXGetProcAddress((const GLubyte*) name);
     }
 
-    bool RendererCreateContext(platform::WindowInfoPtr windowInfo, utils::BumpAllocator* transientStorage)
+    // GLX hands out function pointers without a current context, so unlike WGL there is
+    // no dummy window or dummy context here. The pointers are resolved once, up front.
+    bool RendererInit(platform::WindowInfoPtr windowInfo)
     {
         if (!windowInfo)
         {
@@ -214,118 +186,121 @@ namespace drop::renderer
             return false;
         }
 
-        i32 contextAttribs[] {
-            GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
-            GLX_CONTEXT_MINOR_VERSION_ARB, 3,
-            GLX_CONTEXT_PROFILE_MASK_ARB, GLX_CONTEXT_CORE_PROFILE_BIT_ARB,
-            GLX_CONTEXT_FLAGS_ARB, GLX_CONTEXT_DEBUG_BIT_ARB,
-            0};
-
-        g_ctx = glXCreateContextAttribsARB(*windowInfo->display, *windowInfo->fbc, nullptr, GL_TRUE, contextAttribs);
-        if (!g_ctx)
+        g_headless = windowInfo->headless;
+#ifndef D_EGL
+        if (g_headless)
         {
-            D_ASSERT(false, "Failed to create X11 context");
+            D_ASSERT(false, "Headless mode needs EGL, this build has no EGL headers.");
             return false;
         }
-        TRACK_LEAK_ALLOC(g_ctx, LeakType::HANDLE, "X11 context");
+#endif // D_EGL
 
-        if (!glXMakeCurrent(*windowInfo->display, *windowInfo->window, g_ctx))
+        if (!LoadOpenGLFunctions())
         {
-            D_ASSERT(false, "Failed to make X11 context current");
+            D_ASSERT(false, "Failed to load OpenGL functions");
             return false;
         }
 
-        // Initalize shaders.
-        GLuint vertShaderID {glCreateShader(GL_VERTEX_SHADER)};
-        GLuint fragShaderID {glCreateShader(GL_FRAGMENT_SHADER)};
+        if (g_headless)
+        {
+            utils::StartupMark("GL function loading");
+            return true;
+        }
 
-        i32   fileSize {0};
-        Char* vertShader {utils::ReadFile("assets/shaders/quad.vert", transientStorage, &fileSize)};
-        Char* fragShader {utils::ReadFile("assets/shaders/quad.frag", transientStorage, &fileSize)};
-        if (!vertShader || !fragShader)
+        glXCreateContextAttribsARB = (PFNGLXCREATECONTEXTATTRIBSARBPROC) GetGLProcAddress("glXCreateContextAttribsARB");
+        if (!glXCreateContextAttribsARB)
         {
-            D_ASSERT(false, "Failed to read shaders.");
+            D_ASSERT(false, "Failed to load glXCreateContextAttribsARB function");
             return false;
         }
 
-        glShaderSource(vertShaderID, 1, &vertShader, 0);
-        glShaderSource(fragShaderID, 1, &fragShader, 0);
-
-        glCompileShader(vertShaderID);
-        glCompileShader(fragShaderID);
+        utils::StartupMark("GL function loading");
+        return true;
+    }
 
-        // Test the vertex shader.
+    bool RendererCreateContext(platform::WindowInfoPtr windowInfo, utils::BumpAllocator* transientStorage)
+    {
+        if (!windowInfo)
         {
-            i32  success {0};
-            Char shaderLog[2048] {};
+            D_ASSERT(false, "Window info is null.");
+            return false;
+        }
 
-            glGetShaderiv(vertShaderID, GL_COMPILE_STATUS, &success);
-            if (!success)
+#ifdef D_EGL
+        if (g_headless)
+        {
+            if (!CreateHeadlessContext(windowInfo->width, windowInfo->height))
             {
-                glGetShaderInfoLog(vertShaderID, 2048, nullptr, shaderLog);
-                D_ASSERT(false, "Failed to compile vertex shader: %s", shaderLog);
+                D_ASSERT(false, "Failed to create headless context");
+                DestroyHeadlessContext();
                 return false;
             }
         }
-        // Test the fragment shader.
+        else
+#endif // D_EGL
         {
-            i32  success {0};
-            Char shaderLog[2048] {};
+            g_ctx = CreateNewestContext(*windowInfo->display, *windowInfo->fbc);
+            if (!g_ctx)
+            {
+                D_ASSERT(false, "Failed to create X11 context");
+                return false;
+            }
+            TRACK_LEAK_ALLOC(g_ctx, LeakType::HANDLE, "X11 context");
 
-            glGetShaderiv(fragShaderID, GL_COMPILE_STATUS, &success);
-            if (!success)
+            if (!glXMakeCurrent(*windowInfo->display, *windowInfo->window, g_ctx))
             {
-                glGetShaderInfoLog(fragShaderID, 2048, nullptr, shaderLog);
-                D_ASSERT(false, "Failed to compile fragment shader: %s", shaderLog);
+                D_ASSERT(false, "Failed to make X11 context current");
                 return false;
             }
         }
 
-        // Create new program.
-        g_programID = glCreateProgram();
-        glAttachShader(g_programID, vertShaderID);
-        glAttachShader(g_programID, fragShaderID);
-        glLinkProgram(g_programID);
-        TRACK_LEAK_ALLOC(&g_programID, LeakType::OPENGL, "OpenGL program");
-
-        // Delete shaders.
-        glDetachShader(g_programID, vertShaderID);
-        glDetachShader(g_programID, fragShaderID);
-        glDeleteShader(vertShaderID);
-        glDeleteShader(fragShaderID);
-
-        glGenVertexArrays(1, &g_VAO);
-        glBindVertexArray(g_VAO);
-        TRACK_LEAK_ALLOC(&g_VAO, LeakType::OPENGL, "OpenGL VAO");
-
-        // Enable depth testing.
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_GREATER);
+        D_TRACE("OpenGL version: %s", glGetString(GL_VERSION));
+        LoadOpenGLCapabilities();
+        utils::StartupMark("Context creation");
 
-        glUseProgram(g_programID);
+        if (!RendererSetup(transientStorage))
+        {
+            D_ASSERT(false, "Failed to set up renderer.");
+            return false;
+        }
 
-        XFlush(*windowInfo->display);
-        g_display = *windowInfo->display;
-        g_window  = *windowInfo->window;
+        if (!g_headless)
+        {
+            XFlush(*windowInfo->display);
+            g_display = *windowInfo->display;
+            g_window  = *windowInfo->window;
+        }
 
         return true;
     }
 
     void RendererUpdateContext()
     {
-        glClearColor(0.f, 0.f, 0.f, 1.f);
-        glClearDepth(0.f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        glViewport(0, 0, shared::g_screenSize.width, shared::g_screenSize.height);
-
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        RendererDrawFrame();
 
+        PROFILE_SCOPE("Swap buffers");
+#ifdef D_EGL
+        if (g_headless)
+        {
+            eglSwapBuffers(g_eglDisplay, g_eglSurface);
+            return;
+        }
+#endif // D_EGL
         glXSwapBuffers(g_display, g_window);
+        platform::PlatformNotifyQueuedEvents();
     }
 
     void RendererDestroyContext()
     {
+        RendererTeardown();
+
+#ifdef D_EGL
+        if (g_headless)
+        {
+            DestroyHeadlessContext();
+            return;
+        }
+#endif // D_EGL
         glXMakeCurrent(g_display, None, nullptr);
         glXDestroyContext(g_display, g_ctx);
         TRACK_LEAK_FREE(g_ctx);
@@ -336,10 +311,7 @@ namespace drop::renderer
 
     void RendererShutdown()
     {
-        glDeleteVertexArrays(1, &g_VAO);
-        TRACK_LEAK_FREE(&g_VAO);
-        glDeleteProgram(g_programID);
-        TRACK_LEAK_FREE(&g_programID);
+        // Nothing left, GL objects go away in RendererDestroyContext while the context is current.
     }
 
 } // namespace drop::renderer
\ No newline at end of file
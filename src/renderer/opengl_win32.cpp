@@ -1,9 +1,10 @@
 #include "renderer/opengl.hpp"
-#include "utils/file_io.hpp"
-#include "shared/input.hpp"
+#include "renderer/gl_loader.hpp"
+#include "renderer/renderer.hpp"
+#include "utils/profiler.hpp"
+#include "utils/startup_profile.hpp"
 
 #include "opengl/wglext.h"
-#include <gl/GL.h>
 
 namespace drop::renderer
 {
@@ -11,138 +12,11 @@ namespace drop::renderer
     {
         HMODULE g_openglDLL {nullptr};
 
-#define LOAD_GL_FUNCTION(type, name)                      \
-    name = (type) wglGetProcAddress(#name);               \
-    if (!name)                                            \
-    {                                                     \
-        name = (type) GetProcAddress(g_openglDLL, #name); \
-    }                                                     \
-    D_ASSERT(name, "Failed to load OpenGL function: %s", #name);
-
-#pragma region OpenGL Functions
-        static PFNGLCREATEPROGRAMPROC           glCreateProgram;
-        static PFNGLDELETETEXTURESPROC          glDeleteTextures;
-        static PFNGLGENTEXTURESPROC             glGenTextures;
-        static PFNGLBINDTEXTUREPROC             glBindTexture;
-        static PFNGLDRAWBUFFERPROC              glDrawBuffer;
-        static PFNGLDRAWARRAYSPROC              glDrawArrays;
-        static PFNGLCREATESHADERPROC            glCreateShader;
-        static PFNGLGETUNIFORMLOCATIONPROC      glGetUniformLocation;
-        static PFNGLUNIFORM1FPROC               glUniform1f;
-        static PFNGLUNIFORM2FVPROC              glUniform2fv;
-        static PFNGLUNIFORM3FVPROC              glUniform3fv;
-        static PFNGLUNIFORM1IPROC               glUniform1i;
-        static PFNGLUNIFORMMATRIX4FVPROC        glUniformMatrix4fv;
-        static PFNGLVERTEXATTRIBDIVISORPROC     glVertexAttribDivisor;
-        static PFNGLACTIVETEXTUREPROC           glActiveTexture;
-        static PFNGLBUFFERSUBDATAPROC           glBufferSubData;
-        static PFNGLDRAWARRAYSINSTANCEDPROC     glDrawArraysInstanced;
-        static PFNGLBINDFRAMEBUFFERPROC         glBindFramebuffer;
-        static PFNGLCHECKFRAMEBUFFERSTATUSPROC  glCheckFramebufferStatus;
-        static PFNGLGENFRAMEBUFFERSPROC         glGenFramebuffers;
-        static PFNGLFRAMEBUFFERTEXTURE2DPROC    glFramebufferTexture2D;
-        static PFNGLDRAWBUFFERSPROC             glDrawBuffers;
-        static PFNGLDELETEFRAMEBUFFERSPROC      glDeleteFramebuffers;
-        static PFNGLBLENDFUNCIPROC              glBlendFunci;
-        static PFNGLBLENDEQUATIONPROC           glBlendEquation;
-        static PFNGLCLEARBUFFERFVPROC           glClearBufferfv;
-        static PFNGLSHADERSOURCEPROC            glShaderSource;
-        static PFNGLCOMPILESHADERPROC           glCompileShader;
-        static PFNGLGETSHADERIVPROC             glGetShaderiv;
-        static PFNGLGETSHADERINFOLOGPROC        glGetShaderInfoLog;
-        static PFNGLATTACHSHADERPROC            glAttachShader;
-        static PFNGLLINKPROGRAMPROC             glLinkProgram;
-        static PFNGLVALIDATEPROGRAMPROC         glValidateProgram;
-        static PFNGLGETPROGRAMIVPROC            glGetProgramiv;
-        static PFNGLGETPROGRAMINFOLOGPROC       glGetProgramInfoLog;
-        static PFNGLGENBUFFERSPROC              glGenBuffers;
-        static PFNGLGENVERTEXARRAYSPROC         glGenVertexArrays;
-        static PFNGLGETATTRIBLOCATIONPROC       glGetAttribLocation;
-        static PFNGLBINDVERTEXARRAYPROC         glBindVertexArray;
-        static PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArray;
-        static PFNGLVERTEXATTRIBPOINTERPROC     glVertexAttribPointer;
-        static PFNGLBINDBUFFERPROC              glBindBuffer;
-        static PFNGLBINDBUFFERBASEPROC          glBindBufferBase;
-        static PFNGLBUFFERDATAPROC              glBufferData;
-        static PFNGLGETVERTEXATTRIBPOINTERVPROC glGetVertexAttribPointerv;
-        static PFNGLUSEPROGRAMPROC              glUseProgram;
-        static PFNGLDELETEVERTEXARRAYSPROC      glDeleteVertexArrays;
-        static PFNGLDELETEBUFFERSPROC           glDeleteBuffers;
-        static PFNGLDELETEPROGRAMPROC           glDeleteProgram;
-        static PFNGLDETACHSHADERPROC            glDetachShader;
-        static PFNGLDELETESHADERPROC            glDeleteShader;
-        static PFNGLDRAWELEMENTSINSTANCEDPROC   glDrawElementsInstanced;
-        static PFNGLGENERATEMIPMAPPROC          glGenerateMipmap;
-        static PFNGLDEBUGMESSAGECALLBACKPROC    glDebugMessageCallback;
-#pragma endregion
-
-        void LoadOpenGLFunctions()
-        {
-            g_openglDLL = LoadLibraryA("opengl32.dll");
-            D_ASSERT(g_openglDLL, "Failed to load opengl32.dll");
-            LOAD_GL_FUNCTION(PFNGLCREATEPROGRAMPROC, glCreateProgram);
-            LOAD_GL_FUNCTION(PFNGLDELETETEXTURESPROC, glDeleteTextures);
-            LOAD_GL_FUNCTION(PFNGLGENTEXTURESPROC, glGenTextures);
-            LOAD_GL_FUNCTION(PFNGLBINDTEXTUREPROC, glBindTexture);
-            LOAD_GL_FUNCTION(PFNGLDRAWBUFFERPROC, glDrawBuffer);
-            LOAD_GL_FUNCTION(PFNGLDRAWARRAYSPROC, glDrawArrays);
-            LOAD_GL_FUNCTION(PFNGLCREATESHADERPROC, glCreateShader);
-            LOAD_GL_FUNCTION(PFNGLGETUNIFORMLOCATIONPROC, glGetUniformLocation);
-            LOAD_GL_FUNCTION(PFNGLUNIFORM1FPROC, glUniform1f);
-            LOAD_GL_FUNCTION(PFNGLUNIFORM2FVPROC, glUniform2fv);
-            LOAD_GL_FUNCTION(PFNGLUNIFORM3FVPROC, glUniform3fv);
-            LOAD_GL_FUNCTION(PFNGLUNIFORM1IPROC, glUniform1i);
-            LOAD_GL_FUNCTION(PFNGLUNIFORMMATRIX4FVPROC, glUniformMatrix4fv);
-            LOAD_GL_FUNCTION(PFNGLVERTEXATTRIBDIVISORPROC, glVertexAttribDivisor);
-            LOAD_GL_FUNCTION(PFNGLACTIVETEXTUREPROC, glActiveTexture);
-            LOAD_GL_FUNCTION(PFNGLBUFFERSUBDATAPROC, glBufferSubData);
-            LOAD_GL_FUNCTION(PFNGLDRAWARRAYSINSTANCEDPROC, glDrawArraysInstanced);
-            LOAD_GL_FUNCTION(PFNGLBINDFRAMEBUFFERPROC, glBindFramebuffer);
-            LOAD_GL_FUNCTION(PFNGLCHECKFRAMEBUFFERSTATUSPROC, glCheckFramebufferStatus);
-            LOAD_GL_FUNCTION(PFNGLGENFRAMEBUFFERSPROC, glGenFramebuffers);
-            LOAD_GL_FUNCTION(PFNGLFRAMEBUFFERTEXTURE2DPROC, glFramebufferTexture2D);
-            LOAD_GL_FUNCTION(PFNGLDRAWBUFFERSPROC, glDrawBuffers);
-            LOAD_GL_FUNCTION(PFNGLDELETEFRAMEBUFFERSPROC, glDeleteFramebuffers);
-            LOAD_GL_FUNCTION(PFNGLBLENDFUNCIPROC, glBlendFunci);
-            LOAD_GL_FUNCTION(PFNGLBLENDEQUATIONPROC, glBlendEquation);
-            LOAD_GL_FUNCTION(PFNGLCLEARBUFFERFVPROC, glClearBufferfv);
-            LOAD_GL_FUNCTION(PFNGLSHADERSOURCEPROC, glShaderSource);
-            LOAD_GL_FUNCTION(PFNGLCOMPILESHADERPROC, glCompileShader);
-            LOAD_GL_FUNCTION(PFNGLGETSHADERIVPROC, glGetShaderiv);
-            LOAD_GL_FUNCTION(PFNGLGETSHADERINFOLOGPROC, glGetShaderInfoLog);
-            LOAD_GL_FUNCTION(PFNGLATTACHSHADERPROC, glAttachShader);
-            LOAD_GL_FUNCTION(PFNGLLINKPROGRAMPROC, glLinkProgram);
-            LOAD_GL_FUNCTION(PFNGLVALIDATEPROGRAMPROC, glValidateProgram);
-            LOAD_GL_FUNCTION(PFNGLGETPROGRAMIVPROC, glGetProgramiv);
-            LOAD_GL_FUNCTION(PFNGLGETPROGRAMINFOLOGPROC, glGetProgramInfoLog);
-            LOAD_GL_FUNCTION(PFNGLGENBUFFERSPROC, glGenBuffers);
-            LOAD_GL_FUNCTION(PFNGLGENVERTEXARRAYSPROC, glGenVertexArrays);
-            LOAD_GL_FUNCTION(PFNGLGETATTRIBLOCATIONPROC, glGetAttribLocation);
-            LOAD_GL_FUNCTION(PFNGLBINDVERTEXARRAYPROC, glBindVertexArray);
-            LOAD_GL_FUNCTION(PFNGLENABLEVERTEXATTRIBARRAYPROC, glEnableVertexAttribArray);
-            LOAD_GL_FUNCTION(PFNGLVERTEXATTRIBPOINTERPROC, glVertexAttribPointer);
-            LOAD_GL_FUNCTION(PFNGLBINDBUFFERPROC, glBindBuffer);
-            LOAD_GL_FUNCTION(PFNGLBINDBUFFERBASEPROC, glBindBufferBase);
-            LOAD_GL_FUNCTION(PFNGLBUFFERDATAPROC, glBufferData);
-            LOAD_GL_FUNCTION(PFNGLGETVERTEXATTRIBPOINTERVPROC, glGetVertexAttribPointerv);
-            LOAD_GL_FUNCTION(PFNGLUSEPROGRAMPROC, glUseProgram);
-            LOAD_GL_FUNCTION(PFNGLDELETEVERTEXARRAYSPROC, glDeleteVertexArrays);
-            LOAD_GL_FUNCTION(PFNGLDELETEBUFFERSPROC, glDeleteBuffers);
-            LOAD_GL_FUNCTION(PFNGLDELETEPROGRAMPROC, glDeleteProgram);
-            LOAD_GL_FUNCTION(PFNGLDETACHSHADERPROC, glDetachShader);
-            LOAD_GL_FUNCTION(PFNGLDELETESHADERPROC, glDeleteShader);
-            LOAD_GL_FUNCTION(PFNGLDRAWELEMENTSINSTANCEDPROC, glDrawElementsInstanced);
-            LOAD_GL_FUNCTION(PFNGLGENERATEMIPMAPPROC, glGenerateMipmap);
-            LOAD_GL_FUNCTION(PFNGLDEBUGMESSAGECALLBACKPROC, glDebugMessageCallback);
-        }
-
         PFNWGLCREATECONTEXTATTRIBSARBPROC wglCreateContextAttribsARB {nullptr};
         PFNWGLCHOOSEPIXELFORMATARBPROC    wglChoosePixelFormatARB {nullptr};
 
         HGLRC  g_hglrc {nullptr};
         HDC    g_hdc {nullptr};
-        GLuint g_programID {0};
-        GLuint g_VAO {0};
 
         void CALLBACK GLDebugCallback(GLenum source, GLenum type, GLuint id,
                                       GLenum severity, GLsizei length, const GLchar* message,
@@ -160,8 +34,22 @@ namespace drop::renderer
             }
         }
 
+        // Newest first. The renderer picks its fast paths from whatever version it gets.
+        constexpr i32 CONTEXT_VERSIONS[][2] {{4, 6}, {4, 5}, {4, 3}, {3, 3}};
     } // namespace anonymous
 
+    void* GetGLProcAddress(const Char* name)
+    {
+        // wglGetProcAddress only knows extension functions and may return small sentinel values on failure.
+        void* proc {(void*) wglGetProcAddress(name)};
+        if (proc == nullptr || proc == (void*) 0x1 || proc == (void*) 0x2 || proc == (void*) 0x3 || proc == (void*) -1)
+        {
+            proc = (void*) GetProcAddress(g_openglDLL, name);
+        }
+
+        return proc;
+    }
+
     bool RendererInit(platform::WindowInfoPtr windowInfo)
     {
         if (!windowInfo)
@@ -170,6 +58,13 @@ namespace drop::renderer
             return false;
         }
 
+        g_openglDLL = LoadLibraryW(L"opengl32.dll");
+        if (!g_openglDLL)
+        {
+            D_ASSERT(false, "Failed to load opengl32.dll.");
+            return false;
+        }
+
         PIXELFORMATDESCRIPTOR pfd {};
         pfd.nSize        = sizeof(PIXELFORMATDESCRIPTOR);
         pfd.nVersion     = 1;
@@ -206,26 +101,25 @@ namespace drop::renderer
             return false;
         }
 
-        LoadOpenGLFunctions(); // Load OpenGL functions.
-        LOAD_GL_FUNCTION(PFNWGLCREATECONTEXTATTRIBSARBPROC, wglCreateContextAttribsARB);
-        LOAD_GL_FUNCTION(PFNWGLCHOOSEPIXELFORMATARBPROC, wglChoosePixelFormatARB);
-        if (!wglCreateContextAttribsARB || !wglChoosePixelFormatARB)
+        if (!LoadOpenGLFunctions())
         {
             D_ASSERT(false, "Failed to load OpenGL functions.");
             return false;
         }
 
-        D_TRACE("OpenGL version: %s", glGetString(GL_VERSION));
-
-        // Enable debug messages.
-        glDebugMessageCallback(&GLDebugCallback, nullptr);
-        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-        glEnable(GL_DEBUG_OUTPUT);
+        wglCreateContextAttribsARB = (PFNWGLCREATECONTEXTATTRIBSARBPROC) GetGLProcAddress("wglCreateContextAttribsARB");
+        wglChoosePixelFormatARB    = (PFNWGLCHOOSEPIXELFORMATARBPROC) GetGLProcAddress("wglChoosePixelFormatARB");
+        if (!wglCreateContextAttribsARB || !wglChoosePixelFormatARB)
+        {
+            D_ASSERT(false, "Failed to load OpenGL functions.");
+            return false;
+        }
 
         wglMakeCurrent(nullptr, nullptr);
         wglDeleteContext(rc);
         TRACK_LEAK_FREE(rc);
 
+        utils::StartupMark("Dummy context");
         return true;
     }
 
@@ -270,14 +164,22 @@ namespace drop::renderer
             return false;
         }
 
-        const i32 contextAttribs[] {
-            WGL_CONTEXT_MAJOR_VERSION_ARB, 4,
-            WGL_CONTEXT_MINOR_VERSION_ARB, 3,
-            WGL_CONTEXT_PROFILE_MASK_ARB, WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
-            WGL_CONTEXT_FLAGS_ARB, WGL_CONTEXT_DEBUG_BIT_ARB,
-            0}; // Last entry must be 0 to terminate the list.
+        for (const auto& version : CONTEXT_VERSIONS)
+        {
+            const i32 contextAttribs[] {
+                WGL_CONTEXT_MAJOR_VERSION_ARB, version[0],
+                WGL_CONTEXT_MINOR_VERSION_ARB, version[1],
+                WGL_CONTEXT_PROFILE_MASK_ARB, WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
+                WGL_CONTEXT_FLAGS_ARB, WGL_CONTEXT_DEBUG_BIT_ARB,
+                0}; // Last entry must be 0 to terminate the list.
+
+            g_hglrc = wglCreateContextAttribsARB(*windowInfo->hdc, nullptr, contextAttribs);
+            if (g_hglrc)
+            {
+                break;
+            }
+        }
 
-        g_hglrc = wglCreateContextAttribsARB(*windowInfo->hdc, nullptr, contextAttribs);
         if (!g_hglrc)
         {
             D_ASSERT(false, "Failed to create OpenGL context.");
@@ -293,75 +195,24 @@ namespace drop::renderer
 
         g_hdc = *windowInfo->hdc;
 
-        // Initalize shaders.
-        GLuint vertShaderID {glCreateShader(GL_VERTEX_SHADER)};
-        GLuint fragShaderID {glCreateShader(GL_FRAGMENT_SHADER)};
+        D_TRACE("OpenGL version: %s", glGetString(GL_VERSION));
+        LoadOpenGLCapabilities();
 
-        i32   fileSize {0};
-        Char* vertShader {utils::ReadFile("assets/shaders/quad.vert", transientStorage, &fileSize)};
-        Char* fragShader {utils::ReadFile("assets/shaders/quad.frag", transientStorage, &fileSize)};
-        if (!vertShader || !fragShader)
+        // Enable debug messages.
+        if (g_glCaps.debugOutput)
         {
-            D_ASSERT(false, "Failed to read shaders.");
-            return false;
+            glDebugMessageCallback(&GLDebugCallback, nullptr);
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+            glEnable(GL_DEBUG_OUTPUT);
         }
+        utils::StartupMark("Context creation");
 
-        glShaderSource(vertShaderID, 1, &vertShader, 0);
-        glShaderSource(fragShaderID, 1, &fragShader, 0);
-
-        glCompileShader(vertShaderID);
-        glCompileShader(fragShaderID);
-
-        // Test the vertex shader.
+        if (!RendererSetup(transientStorage))
         {
-            i32  success {0};
-            Char shaderLog[2048] {};
-
-            glGetShaderiv(vertShaderID, GL_COMPILE_STATUS, &success);
-            if (!success)
-            {
-                glGetShaderInfoLog(vertShaderID, 2048, nullptr, shaderLog);
-                D_ASSERT(false, "Failed to compile vertex shader: %s", shaderLog);
-                return false;
-            }
-        }
-        // Test the fragment shader.
-        {
-            i32  success {0};
-            Char shaderLog[2048] {};
-
-            glGetShaderiv(fragShaderID, GL_COMPILE_STATUS, &success);
-            if (!success)
-            {
-                glGetShaderInfoLog(fragShaderID, 2048, nullptr, shaderLog);
-                D_ASSERT(false, "Failed to compile fragment shader: %s", shaderLog);
-                return false;
-            }
+            D_ASSERT(false, "Failed to set up renderer.");
+            return false;
         }
 
-        // Create new program.
-        g_programID = glCreateProgram();
-        glAttachShader(g_programID, vertShaderID);
-        glAttachShader(g_programID, fragShaderID);
-        glLinkProgram(g_programID);
-        TRACK_LEAK_ALLOC(&g_programID, LeakType::OPENGL, "OpenGL program");
-
-        // Delete shaders.
-        glDetachShader(g_programID, vertShaderID);
-        glDetachShader(g_programID, fragShaderID);
-        glDeleteShader(vertShaderID);
-        glDeleteShader(fragShaderID);
-
-        glGenVertexArrays(1, &g_VAO);
-        glBindVertexArray(g_VAO);
-        TRACK_LEAK_ALLOC(&g_VAO, LeakType::OPENGL, "OpenGL VAO");
-
-        // Enable depth testing.
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_GREATER);
-
-        glUseProgram(g_programID);
-
         UpdateWindow(*windowInfo->hwnd);
 
         return true;
@@ -369,19 +220,16 @@ namespace drop::renderer
 
     void RendererUpdateContext()
     {
-        glClearColor(0.f, 0.f, 0.f, 1.f);
-        glClearDepth(0.f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        glViewport(0, 0, shared::g_screenSize.width, shared::g_screenSize.height);
-
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        RendererDrawFrame();
 
+        PROFILE_SCOPE("Swap buffers");
         SwapBuffers(g_hdc);
     }
 
     void RendererDestroyContext()
     {
+        RendererTeardown();
+
         wglMakeCurrent(nullptr, nullptr);
         wglDeleteContext(g_hglrc);
         TRACK_LEAK_FREE(g_hglrc);
@@ -393,11 +241,6 @@ namespace drop::renderer
     {
         FreeLibrary(g_openglDLL);
         g_openglDLL = nullptr;
-
-        glDeleteVertexArrays(1, &g_VAO);
-        TRACK_LEAK_FREE(&g_VAO);
-        glDeleteProgram(g_programID);
-        TRACK_LEAK_FREE(&g_programID);
     }
 
 } // namespace drop::renderer
\ No newline at end of file
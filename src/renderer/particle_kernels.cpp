@@ -0,0 +1,256 @@
+#include "renderer/particle_kernels.hpp"
+#include "utils/cpu.hpp"
+
+#include <cmath>   // lrintf.
+#include <cstring> // memset.
+
+#ifdef D_SIMD_X86
+#include <immintrin.h>
+#endif // D_SIMD_X86
+
+namespace drop::renderer
+{
+    namespace
+    {
+        // Lane indices of the set bits of a mask, packed to the front. Index 0 fills the rest.
+        alignas(32) u32 g_leftPack8[256][8] {};
+        alignas(16) u8 g_leftPack4[16][16] {}; // pshufb masks, 0x80 zeroes the unused bytes.
+
+        void BuildLeftPackTables()
+        {
+            for (u32 mask {0}; mask < 256; ++mask)
+            {
+                u32 lane {0};
+                for (u32 bit {0}; bit < 8; ++bit)
+                {
+                    if (mask & (1u << bit))
+                    {
+                        g_leftPack8[mask][lane++] = bit;
+                    }
+                }
+            }
+
+            for (u32 mask {0}; mask < 16; ++mask)
+            {
+                memset(g_leftPack4[mask], 0x80, sizeof(g_leftPack4[mask]));
+                u32 lane {0};
+                for (u32 bit {0}; bit < 4; ++bit)
+                {
+                    if (mask & (1u << bit))
+                    {
+                        for (u32 byte {0}; byte < 4; ++byte)
+                        {
+                            g_leftPack4[mask][lane * 4 + byte] = (u8) (bit * 4 + byte);
+                        }
+                        ++lane;
+                    }
+                }
+            }
+        }
+
+        u32 UpdateScalar(const ParticleArrays& p, u32 begin, u32 end, const UpdateParams& params)
+        {
+            u32 write {begin};
+            for (u32 i {begin}; i < end; ++i)
+            {
+                f32 vx {(p.vx[i] + params.gravity[0]) * params.damping};
+                f32 vy {(p.vy[i] + params.gravity[1]) * params.damping};
+                f32 life {p.life[i] - params.deltaTime};
+                f32 t {1.f - life * p.invLifetime[i]};
+                t = t < 0.f ? 0.f : (t > 1.f ? 1.f : t);
+
+                // lrintf rounds half to even like cvtps in the SIMD kernels, a + 0.5 truncation would not.
+                u32 color {0};
+                for (u32 channel {0}; channel < 4; ++channel)
+                {
+                    color |= (u32) lrintf(params.colorStart[channel] + params.colorDelta[channel] * t) << (channel * 8);
+                }
+
+                // Always written, the write index only moves past survivors.
+                p.x[write]           = p.x[i] + vx * params.deltaTime;
+                p.y[write]           = p.y[i] + vy * params.deltaTime;
+                p.vx[write]          = vx;
+                p.vy[write]          = vy;
+                p.life[write]        = life;
+                p.invLifetime[write] = p.invLifetime[i];
+                p.size[write]        = p.size[i];
+                p.color[write]       = color;
+                write += life > 0.f;
+            }
+
+            return write - begin;
+        }
+
+#ifdef D_SIMD_X86
+        // The packed store writes a full vector at the write index. It is never past the block
+        // being read, so it only overwrites particles that are already loaded or padding.
+        D_TARGET("ssse3") u32 UpdateSSSE3(const ParticleArrays& p, u32 begin, u32 end, const UpdateParams& params)
+        {
+            const __m128  deltaTime {_mm_set1_ps(params.deltaTime)};
+            const __m128  gravityX {_mm_set1_ps(params.gravity[0])};
+            const __m128  gravityY {_mm_set1_ps(params.gravity[1])};
+            const __m128  damping {_mm_set1_ps(params.damping)};
+            const __m128  zero {_mm_setzero_ps()};
+            const __m128  one {_mm_set1_ps(1.f)};
+            const __m128i iota {_mm_setr_epi32(0, 1, 2, 3)};
+            __m128        colorStart[4];
+            __m128        colorDelta[4];
+            for (u32 channel {0}; channel < 4; ++channel)
+            {
+                colorStart[channel] = _mm_set1_ps(params.colorStart[channel]);
+                colorDelta[channel] = _mm_set1_ps(params.colorDelta[channel]);
+            }
+
+            u32 write {begin};
+            for (u32 i {begin}; i < end; i += 4)
+            {
+                __m128 vx {_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(p.vx + i), gravityX), damping)};
+                __m128 vy {_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(p.vy + i), gravityY), damping)};
+                __m128 x {_mm_add_ps(_mm_loadu_ps(p.x + i), _mm_mul_ps(vx, deltaTime))};
+                __m128 y {_mm_add_ps(_mm_loadu_ps(p.y + i), _mm_mul_ps(vy, deltaTime))};
+                __m128 life {_mm_sub_ps(_mm_loadu_ps(p.life + i), deltaTime)};
+                __m128 invLifetime {_mm_loadu_ps(p.invLifetime + i)};
+                __m128 size {_mm_loadu_ps(p.size + i)};
+                __m128 t {_mm_min_ps(_mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(life, invLifetime)), zero), one)};
+
+                __m128i color {_mm_setzero_si128()};
+                for (u32 channel {0}; channel < 4; ++channel)
+                {
+                    __m128i value {_mm_cvtps_epi32(_mm_add_ps(colorStart[channel], _mm_mul_ps(colorDelta[channel], t)))};
+                    color = _mm_or_si128(color, _mm_sll_epi32(value, _mm_cvtsi32_si128(channel * 8)));
+                }
+
+                // Alive and before end, lanes past end are padding.
+                __m128i inside {_mm_cmpgt_epi32(_mm_set1_epi32((i32) (end - i)), iota)};
+                __m128  alive {_mm_and_ps(_mm_cmpgt_ps(life, zero), _mm_castsi128_ps(inside))};
+                i32     mask {_mm_movemask_ps(alive)};
+                __m128i pack {_mm_load_si128((const __m128i*) g_leftPack4[mask])};
+
+#define D_PACK_STORE(dest, value) _mm_storeu_si128((__m128i*) (dest), _mm_shuffle_epi8(value, pack))
+                D_PACK_STORE(p.x + write, _mm_castps_si128(x));
+                D_PACK_STORE(p.y + write, _mm_castps_si128(y));
+                D_PACK_STORE(p.vx + write, _mm_castps_si128(vx));
+                D_PACK_STORE(p.vy + write, _mm_castps_si128(vy));
+                D_PACK_STORE(p.life + write, _mm_castps_si128(life));
+                D_PACK_STORE(p.invLifetime + write, _mm_castps_si128(invLifetime));
+                D_PACK_STORE(p.size + write, _mm_castps_si128(size));
+                D_PACK_STORE(p.color + write, color);
+#undef D_PACK_STORE
+                write += __builtin_popcount(mask);
+            }
+
+            return write - begin;
+        }
+
+        D_TARGET("avx2") u32 UpdateAVX2(const ParticleArrays& p, u32 begin, u32 end, const UpdateParams& params)
+        {
+            const __m256  deltaTime {_mm256_set1_ps(params.deltaTime)};
+            const __m256  gravityX {_mm256_set1_ps(params.gravity[0])};
+            const __m256  gravityY {_mm256_set1_ps(params.gravity[1])};
+            const __m256  damping {_mm256_set1_ps(params.damping)};
+            const __m256  zero {_mm256_setzero_ps()};
+            const __m256  one {_mm256_set1_ps(1.f)};
+            const __m256i iota {_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)};
+            __m256        colorStart[4];
+            __m256        colorDelta[4];
+            for (u32 channel {0}; channel < 4; ++channel)
+            {
+                colorStart[channel] = _mm256_set1_ps(params.colorStart[channel]);
+                colorDelta[channel] = _mm256_set1_ps(params.colorDelta[channel]);
+            }
+
+            u32 write {begin};
+            for (u32 i {begin}; i < end; i += 8)
+            {
+                __m256 vx {_mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(p.vx + i), gravityX), damping)};
+                __m256 vy {_mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(p.vy + i), gravityY), damping)};
+                __m256 x {_mm256_add_ps(_mm256_loadu_ps(p.x + i), _mm256_mul_ps(vx, deltaTime))};
+                __m256 y {_mm256_add_ps(_mm256_loadu_ps(p.y + i), _mm256_mul_ps(vy, deltaTime))};
+                __m256 life {_mm256_sub_ps(_mm256_loadu_ps(p.life + i), deltaTime)};
+                __m256 invLifetime {_mm256_loadu_ps(p.invLifetime + i)};
+                __m256 size {_mm256_loadu_ps(p.size + i)};
+                __m256 t {_mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(one, _mm256_mul_ps(life, invLifetime)), zero), one)};
+
+                __m256i color {_mm256_setzero_si256()};
+                for (u32 channel {0}; channel < 4; ++channel)
+                {
+                    __m256i value {_mm256_cvtps_epi32(_mm256_add_ps(colorStart[channel], _mm256_mul_ps(colorDelta[channel], t)))};
+                    color = _mm256_or_si256(color, _mm256_sllv_epi32(value, _mm256_set1_epi32(channel * 8)));
+                }
+
+                __m256i inside {_mm256_cmpgt_epi32(_mm256_set1_epi32((i32) (end - i)), iota)};
+                __m256  alive {_mm256_and_ps(_mm256_cmp_ps(life, zero, _CMP_GT_OQ), _mm256_castsi256_ps(inside))};
+                i32     mask {_mm256_movemask_ps(alive)};
+                __m256i pack {_mm256_load_si256((const __m256i*) g_leftPack8[mask])};
+
+                _mm256_storeu_ps(p.x + write, _mm256_permutevar8x32_ps(x, pack));
+                _mm256_storeu_ps(p.y + write, _mm256_permutevar8x32_ps(y, pack));
+                _mm256_storeu_ps(p.vx + write, _mm256_permutevar8x32_ps(vx, pack));
+                _mm256_storeu_ps(p.vy + write, _mm256_permutevar8x32_ps(vy, pack));
+                _mm256_storeu_ps(p.life + write, _mm256_permutevar8x32_ps(life, pack));
+                _mm256_storeu_ps(p.invLifetime + write, _mm256_permutevar8x32_ps(invLifetime, pack));
+                _mm256_storeu_ps(p.size + write, _mm256_permutevar8x32_ps(size, pack));
+                _mm256_storeu_si256((__m256i*) (p.color + write), _mm256_permutevar8x32_epi32(color, pack));
+                write += __builtin_popcount(mask);
+            }
+
+            return write - begin;
+        }
+#endif // D_SIMD_X86
+    } // namespace anonymous
+
+    void ParticleKernelsInit()
+    {
+        BuildLeftPackTables();
+    }
+
+    const Char* ParticleKernelName(ParticleKernel kernel)
+    {
+        switch (kernel)
+        {
+        case ParticleKernel::AVX2:
+            return "AVX2";
+        case ParticleKernel::SSSE3:
+            return "SSSE3";
+        default:
+            return "scalar";
+        }
+    }
+
+    ParticleKernel ParticleKernelBest()
+    {
+#ifdef D_SIMD_X86
+        const utils::CpuFeatures& cpu {utils::GetCpuFeatures()};
+        if (cpu.avx2)
+        {
+            return ParticleKernel::AVX2;
+        }
+        if (cpu.ssse3)
+        {
+            return ParticleKernel::SSSE3;
+        }
+#endif // D_SIMD_X86
+        return ParticleKernel::SCALAR;
+    }
+
+    ParticleKernelFunction ParticleKernelGet(ParticleKernel kernel)
+    {
+#ifdef D_SIMD_X86
+        const utils::CpuFeatures& cpu {utils::GetCpuFeatures()};
+        if (kernel == ParticleKernel::AVX2)
+        {
+            return cpu.avx2 ? UpdateAVX2 : nullptr;
+        }
+        if (kernel == ParticleKernel::SSSE3)
+        {
+            return cpu.ssse3 ? UpdateSSSE3 : nullptr;
+        }
+#else
+        if (kernel != ParticleKernel::SCALAR)
+        {
+            return nullptr;
+        }
+#endif // D_SIMD_X86
+        return UpdateScalar;
+    }
+} // namespace drop::renderer
@@ -0,0 +1,416 @@
+#include "renderer/particle_system.hpp"
+#include "renderer/gl_loader.hpp"
+#include "renderer/gpu_memory.hpp"
+#include "renderer/particle_kernels.hpp"
+#include "renderer/shader.hpp"
+#include "utils/job_system.hpp"
+#include "utils/profiler.hpp"
+
+#include <cmath>   // cosf, sinf.
+#include <cstring> // memmove.
+
+namespace drop::renderer
+{
+    namespace
+    {
+        constexpr u32 MAX_PARTICLE_EMITTERS {32};
+        constexpr u32 PARTICLE_CHUNK_SIZE {16384};  // Particles per job.
+        constexpr u32 MAX_PARTICLE_JOBS {1024};     // 16M particles over all emitters.
+        constexpr u32 PARTICLE_STREAM_COUNT {4};    // x, y, size, color are uploaded.
+
+        struct ParticleEmitter
+        {
+            ParticleEmitterDesc desc {};
+            ParticleArrays      arrays {};
+            UpdateParams        params {};
+            u32                 capacity {0};
+            u32                 count {0};
+            u32                 pendingBurst {0};
+            f32                 spawnAccumulator {0.f};
+            u32                 seed {0};
+        };
+
+        struct ParticleJob
+        {
+            ParticleEmitter* emitter {nullptr};
+            u32              begin {0};
+            u32              end {0};
+            u32              survivors {0}; // Packed to the front of [begin, end).
+        };
+
+        utils::BumpAllocator   g_arena {};
+        ParticleEmitter        g_emitters[MAX_PARTICLE_EMITTERS] {};
+        u32                    g_emitterCount {0};
+        u32                    g_totalCapacity {0};
+        ParticleJob            g_jobs[MAX_PARTICLE_JOBS] {};
+        u32                    g_jobCount {0};
+        utils::JobCounter      g_jobCounter {};
+        bool                   g_jobsInFlight {false};
+        ParticleKernelFunction g_kernel {nullptr};
+        ParticleStats          g_stats {};
+
+        ShaderHandle g_particleShader {0};
+        GLuint       g_VAO {0};
+        GLuint       g_streamBuffer {0};
+        utils::Size  g_streamBytes {0};
+
+        void UpdateJob(void* userData)
+        {
+            PROFILE_SCOPE("Particle update");
+            ParticleJob* job {(ParticleJob*) userData};
+            job->survivors = g_kernel(job->emitter->arrays, job->begin, job->end, job->emitter->params);
+        }
+
+        f32 Random(u32& seed)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            return (seed >> 8) * (1.f / 16777216.f);
+        }
+
+        f32 RandomRange(u32& seed, const f32 (&range)[2])
+        {
+            return range[0] + (range[1] - range[0]) * Random(seed);
+        }
+
+        void Spawn(ParticleEmitter& emitter, u32 count)
+        {
+            const ParticleEmitterDesc& desc {emitter.desc};
+            const ParticleArrays&      p {emitter.arrays};
+            count = count < emitter.desc.capacity - emitter.count ? count : emitter.desc.capacity - emitter.count;
+            for (u32 n {0}; n < count; ++n)
+            {
+                u32 i {emitter.count++};
+                f32 angle {desc.direction + (Random(emitter.seed) - 0.5f) * desc.spread};
+                f32 speed {RandomRange(emitter.seed, desc.speed)};
+                f32 lifetime {RandomRange(emitter.seed, desc.lifetime)};
+
+                p.x[i]           = desc.position[0];
+                p.y[i]           = desc.position[1];
+                p.vx[i]          = cosf(angle) * speed;
+                p.vy[i]          = sinf(angle) * speed;
+                p.life[i]        = lifetime;
+                p.invLifetime[i] = lifetime > 0.f ? 1.f / lifetime : 0.f;
+                p.size[i]        = RandomRange(emitter.seed, desc.size);
+                p.color[i]       = desc.colorStart;
+            }
+        }
+
+        // Each job left its survivors at the front of its chunk, close the gaps between chunks.
+        void FinishJobs()
+        {
+            if (!g_jobsInFlight)
+            {
+                return;
+            }
+
+            utils::JobWait(&g_jobCounter);
+            g_jobsInFlight = false;
+
+            ParticleEmitter* emitter {nullptr};
+            u32              write {0};
+            for (u32 j {0}; j < g_jobCount; ++j)
+            {
+                ParticleJob& job {g_jobs[j]};
+                if (job.emitter != emitter)
+                {
+                    emitter = job.emitter;
+                    write   = 0;
+                }
+
+                if (job.begin != write && job.survivors)
+                {
+                    const ParticleArrays& p {emitter->arrays};
+                    utils::Size           bytes {job.survivors * sizeof(f32)};
+                    memmove(p.x + write, p.x + job.begin, bytes);
+                    memmove(p.y + write, p.y + job.begin, bytes);
+                    memmove(p.vx + write, p.vx + job.begin, bytes);
+                    memmove(p.vy + write, p.vy + job.begin, bytes);
+                    memmove(p.life + write, p.life + job.begin, bytes);
+                    memmove(p.invLifetime + write, p.invLifetime + job.begin, bytes);
+                    memmove(p.size + write, p.size + job.begin, bytes);
+                    memmove(p.color + write, p.color + job.begin, bytes);
+                }
+                write += job.survivors;
+                emitter->count = write;
+            }
+
+            g_stats.alive = 0;
+            for (u32 i {0}; i < g_emitterCount; ++i)
+            {
+                g_stats.alive += g_emitters[i].count;
+            }
+        }
+
+        ParticleEmitter* GetEmitter(ParticleEmitterHandle handle)
+        {
+            if (!handle || handle > g_emitterCount)
+            {
+                return nullptr;
+            }
+
+            return &g_emitters[handle - 1];
+        }
+    } // namespace anonymous
+
+    bool ParticleSystemInit(utils::Size arenaBytes, utils::BumpAllocator* transientStorage)
+    {
+        g_particleShader = ShaderSubmit({"assets/shaders/particle.vert", "assets/shaders/particle.frag"}, transientStorage);
+        if (!g_particleShader)
+        {
+            D_ASSERT(false, "Failed to submit particle shader.");
+            return false;
+        }
+
+        g_arena = utils::MakeBumpAllocator(arenaBytes);
+        if (!g_arena.memory)
+        {
+            return false;
+        }
+        TRACK_LEAK_ALLOC(g_arena.memory, LeakType::HEAP, "Particle arena");
+
+        ParticleKernelsInit();
+        g_stats        = {};
+        g_stats.kernel = ParticleKernelBest();
+        g_kernel       = ParticleKernelGet(g_stats.kernel);
+
+        glGenVertexArrays(1, &g_VAO);
+        glBindVertexArray(g_VAO);
+        TRACK_LEAK_ALLOC(&g_VAO, LeakType::OPENGL, "Particle VAO");
+        for (u32 i {0}; i < PARTICLE_STREAM_COUNT; ++i)
+        {
+            glEnableVertexAttribArray(i);
+            glVertexAttribDivisor(i, 1);
+        }
+        glBindVertexArray(0);
+
+        glGenBuffers(1, &g_streamBuffer);
+        TRACK_LEAK_ALLOC(&g_streamBuffer, LeakType::OPENGL, "Particle stream buffer");
+
+        D_TRACE("Particle system, %s kernel, %.1f MB arena.", ParticleKernelName(g_stats.kernel), arenaBytes / (1024.0 * 1024.0));
+        return true;
+    }
+
+    ParticleEmitterHandle ParticleEmitterCreate(const ParticleEmitterDesc& desc)
+    {
+        if (g_emitterCount == MAX_PARTICLE_EMITTERS)
+        {
+            D_ASSERT(false, "Too many particle emitters.");
+            return 0;
+        }
+
+        u32 capacity {(desc.capacity + PARTICLE_LANES - 1) & ~(PARTICLE_LANES - 1)};
+        if ((g_totalCapacity + capacity) / PARTICLE_CHUNK_SIZE + g_emitterCount + 1 > MAX_PARTICLE_JOBS)
+        {
+            D_ASSERT(false, "Particle capacity is over what the job table can split.");
+            return 0;
+        }
+
+        // The stream buffer grows to the total capacity on the next draw.
+        utils::Size streamBytes {(utils::Size) (g_totalCapacity + capacity) * PARTICLE_STREAM_COUNT * sizeof(f32)};
+        if (streamBytes > g_streamBytes && !GpuMemoryFitsBudget(streamBytes - g_streamBytes))
+        {
+            D_ERROR("Particle emitter of %u does not fit the GPU memory budget.", capacity);
+            return 0;
+        }
+
+        // Nothing is ever freed from the arena, emitters live until shutdown.
+        ParticleArrays arrays {};
+        utils::Size    bytes {capacity * sizeof(f32)};
+        if (g_arena.used + bytes * 8 + 16 * 8 > g_arena.capacity)
+        {
+            D_ASSERT(false, "Particle arena is full.");
+            return 0;
+        }
+        arrays.x           = (f32*) utils::BumpAlloc(&g_arena, bytes);
+        arrays.y           = (f32*) utils::BumpAlloc(&g_arena, bytes);
+        arrays.vx          = (f32*) utils::BumpAlloc(&g_arena, bytes);
+        arrays.vy          = (f32*) utils::BumpAlloc(&g_arena, bytes);
+        arrays.life        = (f32*) utils::BumpAlloc(&g_arena, bytes);
+        arrays.invLifetime = (f32*) utils::BumpAlloc(&g_arena, bytes);
+        arrays.size        = (f32*) utils::BumpAlloc(&g_arena, bytes);
+        arrays.color       = (u32*) utils::BumpAlloc(&g_arena, bytes);
+
+        ParticleEmitter& emitter {g_emitters[g_emitterCount]};
+        emitter               = {};
+        emitter.desc          = desc;
+        emitter.desc.capacity = capacity;
+        emitter.arrays        = arrays;
+        emitter.capacity      = capacity;
+        emitter.seed          = 0x9E3779B9u * (g_emitterCount + 1);
+
+        for (u32 channel {0}; channel < 4; ++channel)
+        {
+            f32 start {(f32) ((desc.colorStart >> (channel * 8)) & 0xFF)};
+            f32 end {(f32) ((desc.colorEnd >> (channel * 8)) & 0xFF)};
+            emitter.params.colorStart[channel] = start;
+            emitter.params.colorDelta[channel] = end - start;
+        }
+
+        g_totalCapacity += capacity;
+        g_stats.emitters = ++g_emitterCount;
+        return g_emitterCount;
+    }
+
+    void ParticleEmitterSetPosition(ParticleEmitterHandle handle, f32 x, f32 y)
+    {
+        if (ParticleEmitter* emitter {GetEmitter(handle)})
+        {
+            emitter->desc.position[0] = x;
+            emitter->desc.position[1] = y;
+        }
+    }
+
+    void ParticleEmitterBurst(ParticleEmitterHandle handle, u32 count)
+    {
+        if (ParticleEmitter* emitter {GetEmitter(handle)})
+        {
+            emitter->pendingBurst += count;
+        }
+    }
+
+    void ParticleSystemUpdate(f32 deltaTime)
+    {
+        FinishJobs(); // Update without a Draw in between.
+
+        g_jobCount = 0;
+        for (u32 e {0}; e < g_emitterCount; ++e)
+        {
+            ParticleEmitter& emitter {g_emitters[e]};
+            emitter.spawnAccumulator += emitter.desc.spawnRate * deltaTime;
+            u32 spawnCount {(u32) emitter.spawnAccumulator};
+            emitter.spawnAccumulator -= (f32) spawnCount;
+            Spawn(emitter, spawnCount + emitter.pendingBurst);
+            emitter.pendingBurst = 0;
+
+            f32 damping {1.f - emitter.desc.drag * deltaTime};
+            emitter.params.deltaTime  = deltaTime;
+            emitter.params.gravity[0] = emitter.desc.gravity[0] * deltaTime;
+            emitter.params.gravity[1] = emitter.desc.gravity[1] * deltaTime;
+            emitter.params.damping    = damping > 0.f ? damping : 0.f;
+
+            // Chunks start on a lane boundary, so a packed store never reaches the next chunk.
+            for (u32 begin {0}; begin < emitter.count; begin += PARTICLE_CHUNK_SIZE)
+            {
+                ParticleJob& job {g_jobs[g_jobCount++]};
+                job.emitter   = &emitter;
+                job.begin     = begin;
+                job.end       = begin + PARTICLE_CHUNK_SIZE < emitter.count ? begin + PARTICLE_CHUNK_SIZE : emitter.count;
+                job.survivors = 0;
+            }
+        }
+
+        for (u32 j {0}; j < g_jobCount; ++j)
+        {
+            utils::JobSubmit(UpdateJob, &g_jobs[j], &g_jobCounter);
+        }
+        g_jobsInFlight = g_jobCount > 0;
+        g_stats.jobs   = g_jobCount;
+    }
+
+    void ParticleSystemDraw()
+    {
+        FinishJobs();
+        if (!g_stats.alive || !ShaderIsReady(g_particleShader))
+        {
+            return;
+        }
+
+        utils::Size needed {(utils::Size) g_totalCapacity * PARTICLE_STREAM_COUNT * sizeof(f32)};
+        glBindBuffer(GL_ARRAY_BUFFER, g_streamBuffer);
+        if (g_streamBytes < needed)
+        {
+            if (g_streamBytes)
+            {
+                GpuMemoryTrackFree(g_streamBuffer, GpuMemoryCategory::VERTEX_BUFFER);
+            }
+            g_streamBytes = needed;
+            GpuMemoryTrackAlloc(g_streamBuffer, GpuMemoryCategory::VERTEX_BUFFER, g_streamBytes);
+        }
+
+        // Orphaned every frame like the sprite batch, the driver hands out fresh storage.
+        glBufferData(GL_ARRAY_BUFFER, g_streamBytes, nullptr, GL_STREAM_DRAW);
+
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glUseProgram(ShaderGetProgram(g_particleShader));
+        glBindVertexArray(g_VAO);
+
+        utils::Size offset {0};
+        for (u32 e {0}; e < g_emitterCount; ++e)
+        {
+            const ParticleEmitter& emitter {g_emitters[e]};
+            if (!emitter.count)
+            {
+                continue;
+            }
+
+            // The arrays go up as they are, one stream each.
+            utils::Size bytes {emitter.count * sizeof(f32)};
+            const void* streams[PARTICLE_STREAM_COUNT] {emitter.arrays.x, emitter.arrays.y, emitter.arrays.size, emitter.arrays.color};
+            for (u32 s {0}; s < PARTICLE_STREAM_COUNT; ++s)
+            {
+                glBufferSubData(GL_ARRAY_BUFFER, offset + s * bytes, bytes, streams[s]);
+            }
+            GpuMemoryTrackUpload(bytes * PARTICLE_STREAM_COUNT);
+
+            glVertexAttribPointer(0, 1, GL_FLOAT, GL_FALSE, sizeof(f32), (void*) offset);
+            glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(f32), (void*) (offset + bytes));
+            glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(f32), (void*) (offset + bytes * 2));
+            glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(u32), (void*) (offset + bytes * 3));
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, emitter.count);
+            offset += bytes * PARTICLE_STREAM_COUNT;
+        }
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDisable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+    }
+
+    const ParticleStats& ParticleSystemGetStats()
+    {
+        return g_stats;
+    }
+
+
+    void ParticleSystemShutdown()
+    {
+        FinishJobs(); // Jobs point into the arena.
+
+        if (g_streamBuffer)
+        {
+            if (g_streamBytes)
+            {
+                GpuMemoryTrackFree(g_streamBuffer, GpuMemoryCategory::VERTEX_BUFFER);
+            }
+            glDeleteBuffers(1, &g_streamBuffer);
+            TRACK_LEAK_FREE(&g_streamBuffer);
+            g_streamBuffer = 0;
+            g_streamBytes  = 0;
+        }
+
+        if (g_VAO)
+        {
+            glDeleteVertexArrays(1, &g_VAO);
+            TRACK_LEAK_FREE(&g_VAO);
+            g_VAO = 0;
+        }
+
+        if (g_arena.memory)
+        {
+            TRACK_LEAK_FREE(g_arena.memory);
+            utils::FreeBumpAllocator(&g_arena);
+        }
+
+        for (ParticleEmitter& emitter : g_emitters)
+        {
+            emitter = {};
+        }
+        g_emitterCount   = 0;
+        g_totalCapacity  = 0;
+        g_jobCount       = 0;
+        g_particleShader = 0;
+        g_stats          = {};
+    }
+} // namespace drop::renderer
@@ -0,0 +1,348 @@
+#include "renderer/post_process.hpp"
+#include "renderer/gl_loader.hpp"
+#include "renderer/gpu_memory.hpp"
+#include "renderer/gpu_timer.hpp"
+#include "renderer/shader.hpp"
+#include "utils/image.hpp"
+
+#include <cstring> // memcpy.
+#include <vector>
+
+namespace drop::renderer
+{
+    namespace
+    {
+        constexpr u32 MIN_BLOOM_SIZE {8}; // The chain stops before a level gets smaller than this.
+
+        constexpr const Char* BLOOM_LEVEL_NAMES[MAX_BLOOM_LEVELS] {"Bloom0", "Bloom1", "Bloom2", "Bloom3", "Bloom4", "Bloom5"};
+        constexpr const Char* BLOOM_DOWN_NAMES[MAX_BLOOM_LEVELS] {"BloomDown0", "BloomDown1", "BloomDown2", "BloomDown3", "BloomDown4", "BloomDown5"};
+        constexpr const Char* BLOOM_UP_NAMES[MAX_BLOOM_LEVELS] {"BloomUp0", "BloomUp1", "BloomUp2", "BloomUp3", "BloomUp4", "BloomUp5"};
+
+        struct BloomPass
+        {
+            RenderGraphResource source {0};
+            bool                first {false}; // Starts the stage timer, and prefilters when downsampling.
+            bool                last {false};
+        };
+
+        struct ProgramUniforms
+        {
+            ShaderHandle shader {0};
+            GLint        texelSize {-1};
+            GLint        extra {-1}; // prefilter or effects.
+            bool         loaded {false};
+        };
+
+        PostProcessSettings g_settings {};
+        PostProcessTimings  g_timings {};
+        ProgramUniforms     g_down {};
+        ProgramUniforms     g_up {};
+        ProgramUniforms     g_final {};
+        BloomPass           g_downPasses[MAX_BLOOM_LEVELS] {};
+        BloomPass           g_upPasses[MAX_BLOOM_LEVELS] {};
+        GLuint              g_lut {0};
+        GLuint              g_VAO {0}; // Empty, the fullscreen triangle comes from gl_VertexID.
+        GpuTimerHandle      g_bloomDownTimer {0};
+        GpuTimerHandle      g_bloomUpTimer {0};
+        GpuTimerHandle      g_finalTimer {0};
+
+        // Binds the program, and on first use looks up the uniforms and points the samplers at their units.
+        bool UseProgram(ProgramUniforms& program, const Char* extraName)
+        {
+            if (!ShaderIsReady(program.shader))
+            {
+                return false;
+            }
+
+            u32 id {ShaderGetProgram(program.shader)};
+            glUseProgram(id);
+            if (!program.loaded)
+            {
+                program.texelSize = glGetUniformLocation(id, "texelSize");
+                program.extra     = glGetUniformLocation(id, extraName);
+                glUniform1i(glGetUniformLocation(id, "source"), 0);
+                glUniform1i(glGetUniformLocation(id, "scene"), 0);
+                glUniform1i(glGetUniformLocation(id, "bloom"), 1);
+                glUniform1i(glGetUniformLocation(id, "lut"), 2);
+                program.loaded = true;
+            }
+
+            return true;
+        }
+
+        void DrawFullscreen()
+        {
+            glBindVertexArray(g_VAO);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+
+        void BindSource(const ProgramUniforms& program, RenderGraphResource source)
+        {
+            const RenderTargetDesc& desc {RenderGraphGetDesc(source)};
+            glUniform4f(program.texelSize, 1.f / desc.width, 1.f / desc.height, 0.f, 0.f);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, RenderGraphGetTexture(source));
+        }
+
+        void BloomDownPass(const RenderPassContext&, void* userData)
+        {
+            const BloomPass* pass {(const BloomPass*) userData};
+            if (pass->first)
+            {
+                GpuTimerBegin(g_bloomDownTimer);
+            }
+
+            if (UseProgram(g_down, "prefilter"))
+            {
+                glUniform4f(g_down.extra, g_settings.bloomThreshold, g_settings.bloomKnee, pass->first ? 1.f : 0.f, 0.f);
+                BindSource(g_down, pass->source);
+                glDisable(GL_DEPTH_TEST);
+                DrawFullscreen();
+                glEnable(GL_DEPTH_TEST);
+            }
+
+            if (pass->last)
+            {
+                GpuTimerEnd(g_bloomDownTimer);
+            }
+        }
+
+        void BloomUpPass(const RenderPassContext&, void* userData)
+        {
+            const BloomPass* pass {(const BloomPass*) userData};
+            if (pass->first)
+            {
+                GpuTimerBegin(g_bloomUpTimer);
+            }
+
+            if (UseProgram(g_up, "source"))
+            {
+                BindSource(g_up, pass->source);
+                glDisable(GL_DEPTH_TEST);
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_ONE, GL_ONE); // Onto the downsampled level already in the target.
+                DrawFullscreen();
+                glDisable(GL_BLEND);
+                glEnable(GL_DEPTH_TEST);
+            }
+
+            if (pass->last)
+            {
+                GpuTimerEnd(g_bloomUpTimer);
+            }
+        }
+
+        bool UploadLut(const u8* rgba)
+        {
+            if (!g_lut)
+            {
+                if (!GpuMemoryFitsBudget(COLOR_LUT_SIZE * COLOR_LUT_SIZE * COLOR_LUT_SIZE * 4))
+                {
+                    D_ERROR("Color grading LUT does not fit the GPU memory budget.");
+                    return false;
+                }
+
+                glGenTextures(1, &g_lut);
+                TRACK_LEAK_ALLOC(&g_lut, LeakType::OPENGL, "Color grading LUT");
+                GpuMemoryTrackAlloc(g_lut, GpuMemoryCategory::TEXTURE, COLOR_LUT_SIZE * COLOR_LUT_SIZE * COLOR_LUT_SIZE * 4);
+            }
+
+            glBindTexture(GL_TEXTURE_3D, g_lut);
+            glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA8, COLOR_LUT_SIZE, COLOR_LUT_SIZE, COLOR_LUT_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+            glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+            glBindTexture(GL_TEXTURE_3D, 0);
+            GpuMemoryTrackUpload(COLOR_LUT_SIZE * COLOR_LUT_SIZE * COLOR_LUT_SIZE * 4);
+            return true;
+        }
+    } // namespace anonymous
+
+    bool PostProcessInit(utils::BumpAllocator* transientStorage)
+    {
+        g_down.shader  = ShaderSubmit({"assets/shaders/fullscreen.vert", "assets/shaders/bloom_down.frag"}, transientStorage);
+        g_up.shader    = ShaderSubmit({"assets/shaders/fullscreen.vert", "assets/shaders/bloom_up.frag"}, transientStorage);
+        g_final.shader = ShaderSubmit({"assets/shaders/fullscreen.vert", "assets/shaders/post.frag"}, transientStorage);
+        if (!g_down.shader || !g_up.shader || !g_final.shader)
+        {
+            D_ASSERT(false, "Failed to submit post processing shaders.");
+            return false;
+        }
+
+        // Identity until a grade is loaded.
+        std::vector<u8> identity(COLOR_LUT_SIZE * COLOR_LUT_SIZE * COLOR_LUT_SIZE * 4);
+        for (u32 b {0}; b < COLOR_LUT_SIZE; ++b)
+        {
+            for (u32 g {0}; g < COLOR_LUT_SIZE; ++g)
+            {
+                for (u32 r {0}; r < COLOR_LUT_SIZE; ++r)
+                {
+                    u8* texel {&identity[((b * COLOR_LUT_SIZE + g) * COLOR_LUT_SIZE + r) * 4]};
+                    texel[0] = (u8) (r * 255 / (COLOR_LUT_SIZE - 1));
+                    texel[1] = (u8) (g * 255 / (COLOR_LUT_SIZE - 1));
+                    texel[2] = (u8) (b * 255 / (COLOR_LUT_SIZE - 1));
+                    texel[3] = 255;
+                }
+            }
+        }
+        UploadLut(identity.data());
+
+        glGenVertexArrays(1, &g_VAO);
+        TRACK_LEAK_ALLOC(&g_VAO, LeakType::OPENGL, "Post processing VAO");
+
+        g_bloomDownTimer = GpuTimerCreate("Bloom down");
+        g_bloomUpTimer   = GpuTimerCreate("Bloom up");
+        g_finalTimer     = GpuTimerCreate("Post final");
+        return true;
+    }
+
+    PostProcessSettings& PostProcessGetSettings()
+    {
+        return g_settings;
+    }
+
+    bool PostProcessLoadLut(const Char* path)
+    {
+        utils::Image image {};
+        if (!utils::ImageLoad(path, &image))
+        {
+            D_ASSERT(false, "Failed to load color grading LUT: %s", path);
+            return false;
+        }
+
+        if (image.width != COLOR_LUT_SIZE * COLOR_LUT_SIZE || image.height != COLOR_LUT_SIZE)
+        {
+            D_ASSERT(false, "Color grading LUT %s is %ux%u, expected %ux%u.", path, image.width, image.height,
+                     COLOR_LUT_SIZE * COLOR_LUT_SIZE, COLOR_LUT_SIZE);
+            utils::ImageFree(&image);
+            return false;
+        }
+
+        // The strip is one 16x16 red/green slice per blue value, side by side.
+        std::vector<u8> volume(COLOR_LUT_SIZE * COLOR_LUT_SIZE * COLOR_LUT_SIZE * 4);
+        for (u32 b {0}; b < COLOR_LUT_SIZE; ++b)
+        {
+            for (u32 g {0}; g < COLOR_LUT_SIZE; ++g)
+            {
+                const u8* row {image.pixels + (g * image.width + b * COLOR_LUT_SIZE) * 4};
+                memcpy(&volume[(b * COLOR_LUT_SIZE + g) * COLOR_LUT_SIZE * 4], row, COLOR_LUT_SIZE * 4);
+            }
+        }
+        utils::ImageFree(&image);
+
+        return UploadLut(volume.data());
+    }
+
+    RenderGraphResource PostProcessAddBloom(RenderGraphResource hdr, u32 width, u32 height)
+    {
+        if (!g_settings.bloom)
+        {
+            return 0;
+        }
+
+        RenderGraphResource levels[MAX_BLOOM_LEVELS] {};
+        u32                 levelCount {0};
+        for (u32 w {width / 2}, h {height / 2}; levelCount < MAX_BLOOM_LEVELS && w >= MIN_BLOOM_SIZE && h >= MIN_BLOOM_SIZE; w /= 2, h /= 2)
+        {
+            levels[levelCount] = RenderGraphCreateTexture(BLOOM_LEVEL_NAMES[levelCount], {w, h, RenderTargetFormat::R11G11B10F});
+            levelCount++;
+        }
+
+        if (!levelCount)
+        {
+            return 0;
+        }
+
+        for (u32 i {0}; i < levelCount; ++i)
+        {
+            BloomPass& data {g_downPasses[i]};
+            data.source = i ? levels[i - 1] : hdr;
+            data.first  = i == 0;
+            data.last   = i == levelCount - 1;
+
+            RenderGraphPass pass {RenderGraphAddPass(BLOOM_DOWN_NAMES[i], BloomDownPass, &data)};
+            RenderGraphRead(pass, data.source);
+            RenderGraphWrite(pass, levels[i]);
+        }
+
+        // Back up the chain, each level blurred onto the next larger one.
+        for (u32 i {levelCount - 1}; i > 0; --i)
+        {
+            BloomPass& data {g_upPasses[i]};
+            data.source = levels[i];
+            data.first  = i == levelCount - 1;
+            data.last   = i == 1;
+
+            RenderGraphPass pass {RenderGraphAddPass(BLOOM_UP_NAMES[i], BloomUpPass, &data)};
+            RenderGraphRead(pass, data.source);
+            RenderGraphWrite(pass, levels[i - 1]);
+        }
+
+        return levels[0];
+    }
+
+    bool PostProcessBindFinal(u32 sceneTexture, u32 bloomTexture)
+    {
+        if (!UseProgram(g_final, "effects"))
+        {
+            return false;
+        }
+
+        f32 bloom {g_settings.bloom && bloomTexture ? g_settings.bloomIntensity : 0.f};
+        glUniform4f(g_final.extra, bloom, g_settings.exposure, g_settings.tonemap ? 1.f : 0.f, g_settings.colorGrade && g_lut ? 1.f : 0.f);
+
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, bloomTexture);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_3D, g_lut);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, sceneTexture);
+        return true;
+    }
+
+    void PostProcessBeginFinal()
+    {
+        GpuTimerBegin(g_finalTimer);
+    }
+
+    void PostProcessEndFinal()
+    {
+        GpuTimerEnd(g_finalTimer);
+    }
+
+    const PostProcessTimings& PostProcessGetTimings()
+    {
+        g_timings.bloomDownMs = g_settings.bloom ? GpuTimerGetMs(g_bloomDownTimer) : -1.f;
+        g_timings.bloomUpMs   = g_settings.bloom ? GpuTimerGetMs(g_bloomUpTimer) : -1.f;
+        g_timings.finalMs     = GpuTimerGetMs(g_finalTimer);
+        return g_timings;
+    }
+
+    void PostProcessShutdown()
+    {
+        if (g_lut)
+        {
+            GpuMemoryTrackFree(g_lut, GpuMemoryCategory::TEXTURE);
+            glDeleteTextures(1, &g_lut);
+            TRACK_LEAK_FREE(&g_lut);
+            g_lut = 0;
+        }
+
+        if (g_VAO)
+        {
+            glDeleteVertexArrays(1, &g_VAO);
+            TRACK_LEAK_FREE(&g_VAO);
+            g_VAO = 0;
+        }
+
+        // Programs belong to the shader manager, timers to the GPU timer module.
+        g_down           = {};
+        g_up             = {};
+        g_final          = {};
+        g_bloomDownTimer = 0;
+        g_bloomUpTimer   = 0;
+        g_finalTimer     = 0;
+    }
+} // namespace drop::renderer
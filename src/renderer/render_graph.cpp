@@ -0,0 +1,647 @@
+#include "renderer/render_graph.hpp"
+#include "renderer/gl_loader.hpp"
+#include "renderer/gpu_memory.hpp"
+#include "utils/profiler.hpp"
+
+#include <cstring>
+#include <vector>
+
+// GL can't alias memory between textures, so aliasing here means handing the same physical texture
+// to every virtual texture of the same size and format whose lifetimes don't overlap.
+
+namespace drop::renderer
+{
+    namespace
+    {
+        constexpr u32 MAX_RENDER_PASSES {32};
+        constexpr u32 MAX_RENDER_RESOURCES {32};
+        constexpr u32 MAX_PASS_READS {8};
+        constexpr u32 MAX_PASS_COLOR_WRITES {4};
+        constexpr u32 NO_INDEX {0xFFFFFFFF};
+
+        // Pooled textures and framebuffers not used for this many frames are released,
+        // after a resize the old sizes go away on their own.
+        constexpr u64 POOL_MAX_AGE {3};
+
+        struct ColorWrite
+        {
+            RenderGraphResource resource {0};
+            bool                clear {false};
+            f32                 clearColor[4] {};
+        };
+
+        struct Pass
+        {
+            const Char*         name {nullptr};
+            RenderPassFunction  function {nullptr};
+            void*               userData {nullptr};
+            RenderGraphResource reads[MAX_PASS_READS] {};
+            u32                 readCount {0};
+            ColorWrite          writes[MAX_PASS_COLOR_WRITES] {};
+            u32                 writeCount {0};
+            RenderGraphResource depth {0};
+            bool                clearDepth {false};
+            bool                alive {false};
+        };
+
+        struct Resource
+        {
+            const Char*      name {nullptr};
+            RenderTargetDesc desc {};
+            bool             backbuffer {false};
+            u32              firstUse {NO_INDEX}; // Positions in the execution order.
+            u32              lastUse {0};
+            u32              physical {NO_INDEX};
+        };
+
+        // Released entries stay in the pool with texture 0, so the indices held in Resource::physical
+        // never shift, CreatePhysical fills them again.
+        struct PhysicalTexture
+        {
+            GLuint           texture {0};
+            RenderTargetDesc desc {};
+            u32              busyUntil {0}; // Execution position of the last use this frame.
+            bool             assigned {false};
+            u64              lastUsedFrame {0};
+        };
+
+        struct Framebuffer
+        {
+            GLuint fbo {0};
+            GLuint colors[MAX_PASS_COLOR_WRITES] {};
+            u32    colorCount {0};
+            GLuint depth {0};
+            u64    lastUsedFrame {0};
+        };
+
+        Pass     g_passes[MAX_RENDER_PASSES] {};
+        u32      g_passCount {0};
+        Resource g_resources[MAX_RENDER_RESOURCES] {};
+        u32      g_resourceCount {0};
+        u32      g_order[MAX_RENDER_PASSES] {};
+        u32      g_orderCount {0};
+
+        std::vector<PhysicalTexture> g_pool;
+        std::vector<Framebuffer>     g_framebuffers;
+        RenderGraphStats             g_stats {};
+        u64                          g_frame {0};
+        RenderGraphResource          g_backbuffer {0};
+
+        struct FormatInfo
+        {
+            GLenum internalFormat;
+            GLenum format;
+            GLenum type;
+            u32    bytesPerPixel;
+        };
+
+        FormatInfo GetFormatInfo(RenderTargetFormat format)
+        {
+            switch (format)
+            {
+            case RenderTargetFormat::RGBA16F:
+                return {GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8};
+            case RenderTargetFormat::R11G11B10F:
+                return {GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, 4};
+            case RenderTargetFormat::DEPTH32F:
+                return {GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, 4};
+            case RenderTargetFormat::RGBA8:
+            default:
+                return {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4};
+            }
+        }
+
+        bool SameDesc(const RenderTargetDesc& a, const RenderTargetDesc& b)
+        {
+            return a.width == b.width && a.height == b.height && a.format == b.format;
+        }
+
+        Pass* GetPass(RenderGraphPass handle)
+        {
+            if (!handle || handle > g_passCount)
+            {
+                D_ASSERT(false, "Invalid render pass %u.", handle);
+                return nullptr;
+            }
+            return &g_passes[handle - 1];
+        }
+
+        Resource* GetResource(RenderGraphResource handle)
+        {
+            if (!handle || handle > g_resourceCount)
+            {
+                D_ASSERT(false, "Invalid render graph resource %u.", handle);
+                return nullptr;
+            }
+            return &g_resources[handle - 1];
+        }
+
+        bool PassWrites(const Pass& pass, RenderGraphResource resource)
+        {
+            if (pass.depth == resource)
+            {
+                return true;
+            }
+            for (u32 i {0}; i < pass.writeCount; ++i)
+            {
+                if (pass.writes[i].resource == resource)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // True when pass `later` needs the result of pass `earlier` (declared before it).
+        bool DependsOn(const Pass& later, const Pass& earlier)
+        {
+            for (u32 i {0}; i < later.readCount; ++i)
+            {
+                if (PassWrites(earlier, later.reads[i]))
+                {
+                    return true;
+                }
+            }
+
+            // Drawing on top of an earlier write keeps it, unless the later pass clears first.
+            for (u32 i {0}; i < later.writeCount; ++i)
+            {
+                if (PassWrites(earlier, later.writes[i].resource) && !later.writes[i].clear)
+                {
+                    return true;
+                }
+            }
+            if (later.depth && PassWrites(earlier, later.depth) && !later.clearDepth)
+            {
+                return true;
+            }
+
+            return false;
+        }
+
+        // Passes are declared in submission order, so every dependency points backwards and the
+        // surviving passes keep their declaration order. Culling walks backwards from the passes
+        // that touch the backbuffer.
+        void Cull()
+        {
+            for (u32 i {g_passCount}; i-- > 0;)
+            {
+                Pass& pass {g_passes[i]};
+                if (PassWrites(pass, g_backbuffer))
+                {
+                    pass.alive = true;
+                }
+                if (!pass.alive)
+                {
+                    continue;
+                }
+
+                for (u32 j {0}; j < i; ++j)
+                {
+                    if (!g_passes[j].alive && DependsOn(pass, g_passes[j]))
+                    {
+                        g_passes[j].alive = true;
+                    }
+                }
+            }
+
+            g_orderCount = 0;
+            for (u32 i {0}; i < g_passCount; ++i)
+            {
+                if (g_passes[i].alive)
+                {
+                    g_order[g_orderCount++] = i;
+                }
+            }
+        }
+
+        void ComputeLifetimes()
+        {
+            for (u32 position {0}; position < g_orderCount; ++position)
+            {
+                const Pass& pass {g_passes[g_order[position]]};
+
+                auto touch {[position](RenderGraphResource handle) {
+                    Resource& resource {g_resources[handle - 1]};
+                    if (resource.firstUse == NO_INDEX)
+                    {
+                        resource.firstUse = position;
+                    }
+                    resource.lastUse = position;
+                }};
+
+                for (u32 i {0}; i < pass.readCount; ++i)
+                {
+                    touch(pass.reads[i]);
+                }
+                for (u32 i {0}; i < pass.writeCount; ++i)
+                {
+                    touch(pass.writes[i].resource);
+                }
+                if (pass.depth)
+                {
+                    touch(pass.depth);
+                }
+            }
+        }
+
+        u32 CreatePhysical(const RenderTargetDesc& desc)
+        {
+            FormatInfo info {GetFormatInfo(desc.format)};
+
+            PhysicalTexture physical {};
+            physical.desc = desc;
+            glGenTextures(1, &physical.texture);
+            glBindTexture(GL_TEXTURE_2D, physical.texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, info.internalFormat, desc.width, desc.height, 0, info.format, info.type, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            GpuMemoryTrackAlloc(physical.texture, GpuMemoryCategory::RENDER_TARGET, (utils::Size) desc.width * desc.height * info.bytesPerPixel);
+
+            for (u32 p {0}; p < g_pool.size(); ++p)
+            {
+                if (!g_pool[p].texture)
+                {
+                    g_pool[p] = physical;
+                    return p;
+                }
+            }
+
+            g_pool.push_back(physical);
+            return (u32) g_pool.size() - 1;
+        }
+
+        void AssignPhysicalTextures()
+        {
+            for (PhysicalTexture& physical : g_pool)
+            {
+                physical.assigned  = false;
+                physical.busyUntil = 0;
+            }
+
+            // Walk the resources in order of first use, each takes a free compatible texture.
+            for (u32 position {0}; position < g_orderCount; ++position)
+            {
+                for (u32 i {0}; i < g_resourceCount; ++i)
+                {
+                    Resource& resource {g_resources[i]};
+                    if (resource.backbuffer || resource.firstUse != position)
+                    {
+                        continue;
+                    }
+
+                    u32 chosen {NO_INDEX};
+                    for (u32 p {0}; p < g_pool.size(); ++p)
+                    {
+                        PhysicalTexture& physical {g_pool[p]};
+                        if (physical.texture && SameDesc(physical.desc, resource.desc) && (!physical.assigned || physical.busyUntil < position))
+                        {
+                            chosen = p;
+                            break;
+                        }
+                    }
+
+                    if (chosen == NO_INDEX)
+                    {
+                        chosen = CreatePhysical(resource.desc);
+                    }
+
+                    PhysicalTexture& physical {g_pool[chosen]};
+                    physical.assigned      = true;
+                    physical.busyUntil     = resource.lastUse;
+                    physical.lastUsedFrame = g_frame;
+                    resource.physical      = chosen;
+                }
+            }
+        }
+
+        GLuint GetFramebuffer(const Pass& pass)
+        {
+            GLuint colors[MAX_PASS_COLOR_WRITES] {};
+            for (u32 i {0}; i < pass.writeCount; ++i)
+            {
+                colors[i] = g_pool[g_resources[pass.writes[i].resource - 1].physical].texture;
+            }
+            GLuint depth {pass.depth ? g_pool[g_resources[pass.depth - 1].physical].texture : 0};
+
+            for (Framebuffer& framebuffer : g_framebuffers)
+            {
+                if (framebuffer.colorCount == pass.writeCount && framebuffer.depth == depth &&
+                    !memcmp(framebuffer.colors, colors, sizeof(colors)))
+                {
+                    framebuffer.lastUsedFrame = g_frame;
+                    return framebuffer.fbo;
+                }
+            }
+
+            Framebuffer framebuffer {};
+            framebuffer.colorCount    = pass.writeCount;
+            framebuffer.depth         = depth;
+            framebuffer.lastUsedFrame = g_frame;
+            memcpy(framebuffer.colors, colors, sizeof(colors));
+
+            glGenFramebuffers(1, &framebuffer.fbo);
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.fbo);
+            GLenum drawBuffers[MAX_PASS_COLOR_WRITES] {};
+            for (u32 i {0}; i < pass.writeCount; ++i)
+            {
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colors[i], 0);
+                drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+            }
+            if (depth)
+            {
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+            }
+            glDrawBuffers(pass.writeCount, drawBuffers);
+
+            GLenum status {glCheckFramebufferStatus(GL_FRAMEBUFFER)};
+            if (status != GL_FRAMEBUFFER_COMPLETE)
+            {
+                D_ASSERT(false, "Framebuffer for pass %s is incomplete: 0x%x", pass.name, status);
+            }
+
+            g_framebuffers.push_back(framebuffer);
+            return framebuffer.fbo;
+        }
+
+        void DeleteFramebuffer(Framebuffer& framebuffer)
+        {
+            glDeleteFramebuffers(1, &framebuffer.fbo);
+            framebuffer.fbo = 0;
+        }
+
+        void ReleaseStale()
+        {
+            for (u32 i {0}; i < g_pool.size(); ++i)
+            {
+                PhysicalTexture& physical {g_pool[i]};
+                if (!physical.texture || g_frame - physical.lastUsedFrame <= POOL_MAX_AGE)
+                {
+                    continue;
+                }
+
+                // Framebuffers referencing the texture go with it.
+                for (u32 f {0}; f < g_framebuffers.size();)
+                {
+                    Framebuffer& framebuffer {g_framebuffers[f]};
+                    bool         uses {framebuffer.depth == physical.texture};
+                    for (u32 c {0}; c < framebuffer.colorCount; ++c)
+                    {
+                        uses = uses || framebuffer.colors[c] == physical.texture;
+                    }
+
+                    if (uses)
+                    {
+                        DeleteFramebuffer(framebuffer);
+                        g_framebuffers.erase(g_framebuffers.begin() + f);
+                        continue;
+                    }
+                    ++f;
+                }
+
+                GpuMemoryTrackFree(physical.texture, GpuMemoryCategory::RENDER_TARGET);
+                glDeleteTextures(1, &physical.texture);
+                physical = {};
+
+                // Only resources of an older frame can still point here, RenderGraphGetTexture returns 0 for them.
+                for (u32 r {0}; r < g_resourceCount; ++r)
+                {
+                    if (g_resources[r].physical == i)
+                    {
+                        g_resources[r].physical = NO_INDEX;
+                    }
+                }
+            }
+
+            for (u32 f {0}; f < g_framebuffers.size();)
+            {
+                if (g_frame - g_framebuffers[f].lastUsedFrame > POOL_MAX_AGE)
+                {
+                    DeleteFramebuffer(g_framebuffers[f]);
+                    g_framebuffers.erase(g_framebuffers.begin() + f);
+                    continue;
+                }
+                ++f;
+            }
+        }
+
+        void RunPass(const Pass& pass)
+        {
+            PROFILE_SCOPE(pass.name); // CPU side, the GPU cost is in the GPU timers.
+            RenderPassContext context {};
+            bool              toBackbuffer {pass.writeCount && pass.writes[0].resource == g_backbuffer};
+
+            const Resource& target {g_resources[(pass.writeCount ? pass.writes[0].resource : pass.depth) - 1]};
+            context.width  = target.desc.width;
+            context.height = target.desc.height;
+
+            glBindFramebuffer(GL_FRAMEBUFFER, toBackbuffer ? 0 : GetFramebuffer(pass));
+            glViewport(0, 0, context.width, context.height);
+
+            for (u32 i {0}; i < pass.writeCount; ++i)
+            {
+                if (pass.writes[i].clear)
+                {
+                    glClearBufferfv(GL_COLOR, i, pass.writes[i].clearColor);
+                }
+            }
+            if (pass.depth && pass.clearDepth)
+            {
+                const f32 depth {0.f}; // Reversed depth, GL_GREATER.
+                glDepthMask(GL_TRUE);
+                glClearBufferfv(GL_DEPTH, 0, &depth);
+            }
+
+            pass.function(context, pass.userData);
+        }
+    } // namespace anonymous
+
+    void RenderGraphBegin(u32 backbufferWidth, u32 backbufferHeight)
+    {
+        g_frame++;
+        g_passCount     = 0;
+        g_resourceCount = 0;
+        g_orderCount    = 0;
+
+        Resource& backbuffer {g_resources[g_resourceCount++]};
+        backbuffer            = {};
+        backbuffer.name       = "Backbuffer";
+        backbuffer.backbuffer = true;
+        backbuffer.desc       = {backbufferWidth, backbufferHeight, RenderTargetFormat::RGBA8};
+        g_backbuffer          = (RenderGraphResource) g_resourceCount;
+    }
+
+    RenderGraphResource RenderGraphCreateTexture(const Char* name, const RenderTargetDesc& desc)
+    {
+        if (g_resourceCount == MAX_RENDER_RESOURCES)
+        {
+            D_ASSERT(false, "Too many render graph resources.");
+            return 0;
+        }
+
+        Resource& resource {g_resources[g_resourceCount++]};
+        resource             = {};
+        resource.name        = name;
+        resource.desc        = desc;
+        resource.desc.width  = desc.width ? desc.width : 1;
+        resource.desc.height = desc.height ? desc.height : 1;
+        return (RenderGraphResource) g_resourceCount;
+    }
+
+    RenderGraphResource RenderGraphBackbuffer()
+    {
+        return g_backbuffer;
+    }
+
+    RenderGraphPass RenderGraphAddPass(const Char* name, RenderPassFunction function, void* userData)
+    {
+        if (g_passCount == MAX_RENDER_PASSES)
+        {
+            D_ASSERT(false, "Too many render passes.");
+            return 0;
+        }
+
+        Pass& pass {g_passes[g_passCount++]};
+        pass          = {};
+        pass.name     = name;
+        pass.function = function;
+        pass.userData = userData;
+        return (RenderGraphPass) g_passCount;
+    }
+
+    void RenderGraphRead(RenderGraphPass handle, RenderGraphResource resource)
+    {
+        Pass* pass {GetPass(handle)};
+        if (!pass || !GetResource(resource))
+        {
+            return;
+        }
+        D_ASSERT(resource != g_backbuffer, "Pass %s can't read the backbuffer.", pass->name);
+        if (pass->readCount == MAX_PASS_READS)
+        {
+            D_ASSERT(false, "Pass %s reads too many textures.", pass->name);
+            return;
+        }
+        pass->reads[pass->readCount++] = resource;
+    }
+
+    void RenderGraphWrite(RenderGraphPass handle, RenderGraphResource resource, const f32* clearColor)
+    {
+        Pass*     pass {GetPass(handle)};
+        Resource* target {GetResource(resource)};
+        if (!pass || !target)
+        {
+            return;
+        }
+        if (pass->writeCount == MAX_PASS_COLOR_WRITES)
+        {
+            D_ASSERT(false, "Pass %s writes too many targets.", pass->name);
+            return;
+        }
+        D_ASSERT(target->desc.format != RenderTargetFormat::DEPTH32F, "Depth target written as color by %s.", pass->name);
+        D_ASSERT(resource != g_backbuffer || !pass->writeCount, "Pass %s mixes the backbuffer with other targets.", pass->name);
+
+        ColorWrite& write {pass->writes[pass->writeCount++]};
+        write.resource = resource;
+        write.clear    = clearColor != nullptr;
+        if (clearColor)
+        {
+            memcpy(write.clearColor, clearColor, sizeof(write.clearColor));
+        }
+    }
+
+    void RenderGraphWriteDepth(RenderGraphPass handle, RenderGraphResource resource, bool clear)
+    {
+        Pass*     pass {GetPass(handle)};
+        Resource* target {GetResource(resource)};
+        if (!pass || !target)
+        {
+            return;
+        }
+        D_ASSERT(target->desc.format == RenderTargetFormat::DEPTH32F, "Pass %s depth target is not a depth format.", pass->name);
+        pass->depth      = resource;
+        pass->clearDepth = clear;
+    }
+
+    void RenderGraphExecute()
+    {
+        PROFILE_SCOPE("Render graph");
+        Cull();
+        ComputeLifetimes();
+        AssignPhysicalTextures();
+
+        for (u32 position {0}; position < g_orderCount; ++position)
+        {
+            RunPass(g_passes[g_order[position]]);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        g_stats                  = {};
+        g_stats.passCount        = g_orderCount;
+        g_stats.culledPasses     = g_passCount - g_orderCount;
+        g_stats.physicalTextures = 0;
+        for (u32 i {0}; i < g_resourceCount; ++i)
+        {
+            g_stats.virtualTextures += !g_resources[i].backbuffer && g_resources[i].physical != NO_INDEX;
+        }
+        for (const PhysicalTexture& physical : g_pool)
+        {
+            if (physical.assigned)
+            {
+                g_stats.physicalTextures++;
+                g_stats.physicalBytes += (utils::Size) physical.desc.width * physical.desc.height * GetFormatInfo(physical.desc.format).bytesPerPixel;
+            }
+        }
+
+        ReleaseStale();
+    }
+
+    u32 RenderGraphGetTexture(RenderGraphResource handle)
+    {
+        Resource* resource {GetResource(handle)};
+        if (!resource || resource->backbuffer || resource->physical == NO_INDEX)
+        {
+            return 0;
+        }
+
+        return g_pool[resource->physical].texture;
+    }
+
+    const RenderTargetDesc& RenderGraphGetDesc(RenderGraphResource handle)
+    {
+        static const RenderTargetDesc invalid {};
+        Resource*                     resource {GetResource(handle)};
+        return resource ? resource->desc : invalid;
+    }
+
+    const RenderGraphStats& RenderGraphGetStats()
+    {
+        return g_stats;
+    }
+
+    void RenderGraphShutdown()
+    {
+        for (Framebuffer& framebuffer : g_framebuffers)
+        {
+            DeleteFramebuffer(framebuffer);
+        }
+        g_framebuffers.clear();
+
+        for (PhysicalTexture& physical : g_pool)
+        {
+            if (physical.texture)
+            {
+                GpuMemoryTrackFree(physical.texture, GpuMemoryCategory::RENDER_TARGET);
+                glDeleteTextures(1, &physical.texture);
+            }
+        }
+        g_pool.clear();
+
+        g_passCount     = 0;
+        g_resourceCount = 0;
+        g_orderCount    = 0;
+    }
+} // namespace drop::renderer
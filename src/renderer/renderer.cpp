@@ -0,0 +1,714 @@
+#include "renderer/renderer.hpp"
+#include "renderer/dynamic_resolution.hpp"
+#include "renderer/frame_capture.hpp"
+#include "renderer/font.hpp"
+#include "renderer/gl_loader.hpp"
+#include "renderer/gpu_culling.hpp"
+#include "renderer/gpu_memory.hpp"
+#include "renderer/gpu_timer.hpp"
+#include "renderer/lighting.hpp"
+#include "renderer/particle_system.hpp"
+#include "renderer/post_process.hpp"
+#include "renderer/render_graph.hpp"
+#include "renderer/shader.hpp"
+#include "renderer/sprite_batch.hpp"
+#include "renderer/texture.hpp"
+#include "renderer/texture_streamer.hpp"
+#include "renderer/tilemap.hpp"
+#include "renderer/uniform_ring.hpp"
+#include "utils/profiler.hpp"
+#include "utils/startup_profile.hpp"
+#include "utils/timer.hpp"
+#include "shared/input.hpp"
+
+#include <cmath>  // sqrtf, cosf, sinf.
+#include <cstdio> // snprintf.
+#include <vector>
+
+namespace drop::renderer
+{
+    namespace
+    {
+        constexpr u32 UNIFORM_BYTES_PER_FRAME {KB(64)};
+        constexpr u32 ATLAS_SIZE {1024};
+        constexpr u32 ATLAS_LAYERS {4};
+        constexpr u32 TEXTURE_UPLOAD_BUDGET {MB(8)}; // Per frame, larger images still go in one piece.
+        constexpr u32 PARTICLE_ARENA_BYTES {MB(4)};  // Grown for the stress emitter.
+        constexpr u32 PARTICLE_BYTES {8 * sizeof(f32)};
+        constexpr f32 MAX_PARTICLE_STEP {0.1f}; // Seconds, a hitch must not fling every particle off screen.
+        constexpr u32 STRESS_TILE_COUNT {8};
+        constexpr u32 STRESS_TILE_SIZE {16};
+        constexpr u32 STRESS_TILE_EDITS {64}; // Per frame.
+
+        struct FrameResources
+        {
+            RenderGraphResource sceneColor {0};
+            RenderGraphResource sceneDepth {0};
+            RenderGraphResource sceneSurface {0}; // Normal and emission, the second G-buffer target.
+            RenderGraphResource sceneLit {0};
+            RenderGraphResource bloom {0}; // 0 while bloom is off.
+            InternalResolution  resolution {};
+            f32                 frameMs {0.f};
+            f32                 gpuMs {-1.f};
+        };
+
+        GLuint                g_VAO {0};
+        ShaderHandle          g_quadShader {0};
+        ShaderHandle          g_blitShader {0};
+        GLuint                g_nearestSampler {0};
+        GLuint                g_linearSampler {0};
+        GpuTimerHandle        g_frameTimer {0};
+        FrameResources        g_frameResources {};
+        i64                   g_lastFrameTime {0};
+        f64                   g_animationTime {0.0}; // Seconds.
+        f32                   g_fixedTimestep {0.f}; // Seconds per frame, 0 follows the wall clock.
+        f32                   g_frameDelta {-1.f};   // Seconds for the next frame only, negative when not set.
+        bool                  g_showOverlay {false};
+        u32                   g_stressObjectCount {0};
+        u32                   g_stressParticleCount {0};
+        u32                   g_stressLightCount {0};
+        u32                   g_stressTilemapSize {0};
+        u32                   g_stressTileSeed {0};
+        ParticleEmitterHandle g_stressEmitter {0};
+        TilemapHandle         g_stressTilemap {0};
+        const Char*           g_fontPath {nullptr};
+        FontHandle            g_font {0};
+        const Char*           g_captureVideoPath {nullptr};
+        utils::Size           g_gpuMemoryBudget {0};
+        u32                   g_captureCount {0}; // Numbers the F11 videos and F12 screenshots.
+
+        void DrawFullscreenTriangle()
+        {
+            glBindVertexArray(g_VAO);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+
+        // Everything in world space, into the scene target.
+        void ScenePass(const RenderPassContext&, void*)
+        {
+            // World pixels map to screen pixels whatever the internal resolution.
+            TilemapDrawAll(shared::g_screenSize.width, shared::g_screenSize.height);
+
+            if (GpuCullingObjectCount())
+            {
+                GpuCullingDispatch();
+                GpuCullingDraw();
+            }
+            else if (ShaderIsReady(g_quadShader))
+            {
+                glUseProgram(ShaderGetProgram(g_quadShader));
+                glBindVertexArray(g_VAO);
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+            }
+
+            ParticleSystemDraw();
+        }
+
+        void LightingPass(const RenderPassContext&, void* userData)
+        {
+            const FrameResources* resources {(const FrameResources*) userData};
+            if (LightingBind(RenderGraphGetTexture(resources->sceneColor), RenderGraphGetTexture(resources->sceneSurface)))
+            {
+                glDisable(GL_DEPTH_TEST);
+                DrawFullscreenTriangle();
+                glEnable(GL_DEPTH_TEST);
+            }
+        }
+
+        void CompositePass(const RenderPassContext&, void* userData)
+        {
+            const FrameResources* resources {(const FrameResources*) userData};
+            u32                   scene {RenderGraphGetTexture(resources->sceneLit)};
+            u32                   bloom {resources->bloom ? RenderGraphGetTexture(resources->bloom) : 0};
+
+            // Bloom, tonemap and grading ride along with the upscale. A plain copy until that shader is ready.
+            bool ready {PostProcessBindFinal(scene, bloom)};
+            if (!ready && ShaderIsReady(g_blitShader))
+            {
+                glUseProgram(ShaderGetProgram(g_blitShader));
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, scene);
+                ready = true;
+            }
+            if (!ready)
+            {
+                return;
+            }
+
+            // The sampler overrides the filter of the pooled target only for this draw.
+            const u32* viewport {resources->resolution.viewport};
+            bool       pixelPerfect {DynamicResolutionGetSettings().filter == UpscaleFilter::NEAREST_INTEGER};
+            glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+            glDisable(GL_DEPTH_TEST);
+            glBindSampler(0, pixelPerfect ? g_nearestSampler : g_linearSampler);
+            PostProcessBeginFinal();
+            DrawFullscreenTriangle();
+            PostProcessEndFinal();
+            glBindSampler(0, 0);
+            glEnable(GL_DEPTH_TEST);
+        }
+
+        // F3, frame time and GPU memory in the top left corner.
+        void OverlayPass(const RenderPassContext&, void* userData)
+        {
+            const FrameResources*      resources {(const FrameResources*) userData};
+            const GpuMemoryStats&      memory {GpuMemoryGetStats()};
+            const RenderGraphStats&    graph {RenderGraphGetStats()};
+            const InternalResolution&  resolution {resources->resolution};
+            const TilemapStats         tiles {TilemapGetStats()};
+            const ParticleStats&       particles {ParticleSystemGetStats()};
+            const LightingStats&       lights {LightingGetStats()};
+            const PostProcessSettings& post {PostProcessGetSettings()};
+            const PostProcessTimings&  postTimings {PostProcessGetTimings()};
+            const FrameCaptureStats&   capture {FrameCaptureGetStats()};
+            f32                        frameMs {resources->frameMs};
+
+            Char text[640] {};
+            snprintf(text, sizeof(text), "%.2f ms (%.0f fps), GPU %.2f ms\nGPU %.1f MB, %.1f KB uploaded\nPasses %u (%u culled), targets %u -> %u\nScene %ux%u (%.0f%%)\nTile chunks %u/%u (%u rebuilt), %u tiles\nParticles %u (%s, %u jobs)\nLights %u, %u per tile max, %u refs\nF4 bloom %s (%.2f + %.2f ms), F5 tonemap %s, F6 grade %s (%.2f ms)\nF11 %s, F12 screenshot (%u captured, %u written, %u dropped)",
+                     frameMs, frameMs > 0.f ? 1000.f / frameMs : 0.f, resources->gpuMs,
+                     memory.total / (1024.0 * 1024.0), memory.frameUpload / 1024.0,
+                     graph.passCount, graph.culledPasses, graph.virtualTextures, graph.physicalTextures,
+                     resolution.width, resolution.height, resolution.scale * 100.f,
+                     tiles.visibleChunks, tiles.chunks, tiles.rebuiltChunks, tiles.drawnTiles,
+                     particles.alive, ParticleKernelName(particles.kernel), particles.jobs,
+                     lights.lights, lights.maxPerTile, lights.indices,
+                     post.bloom ? "on" : "off", postTimings.bloomDownMs, postTimings.bloomUpMs,
+                     post.tonemap ? "on" : "off", post.colorGrade ? "on" : "off", postTimings.finalMs,
+                     FrameCaptureIsRecording() ? "stop recording" : "record", capture.captured, capture.written, capture.dropped);
+
+            SpriteBatchBegin();
+            FontDrawText(FONT_DEFAULT, text, 9.f, 9.f, 2.f, 0xFF000000); // Shadow.
+            FontDrawText(FONT_DEFAULT, text, 8.f, 8.f, 2.f, 0xFFFFFFFF);
+            SpriteBatchEnd();
+        }
+
+        // Sample text in the loaded font along the bottom of the screen, nothing while its pages stream in.
+        void FontSpecimenPass(const RenderPassContext&, void*)
+        {
+            if (!FontIsReady(g_font))
+            {
+                return;
+            }
+
+            const Char* text {"The quick brown fox jumps over the lazy dog 0123456789\nAVATAR WAVE To LT"};
+            f32         y {shared::g_screenSize.height - 8.f - FontMeasureText(g_font, text, 1.f).height};
+            SpriteBatchBegin();
+            FontDrawText(g_font, text, 8.f, y, 1.f, 0xFFFFFFFF);
+            SpriteBatchEnd();
+        }
+
+        u32 NextRandom(u32& seed)
+        {
+            seed = seed * 1664525u + 1013904223u; // LCG, only has to look scattered.
+            return seed;
+        }
+
+        // Lights drifting on circles over the whole screen, the same set every frame.
+        void AddStressLights(f32 time)
+        {
+            f32 width {(f32) shared::g_screenSize.width};
+            f32 height {(f32) shared::g_screenSize.height};
+            u32 seed {0x2545F491};
+            for (u32 i {0}; i < g_stressLightCount; ++i)
+            {
+                f32 x {(NextRandom(seed) >> 8) / (f32) (1 << 24)};
+                f32 y {(NextRandom(seed) >> 8) / (f32) (1 << 24)};
+                f32 phase {(NextRandom(seed) >> 8) / (f32) (1 << 24) * 6.2831853f};
+                u32 color {NextRandom(seed)};
+
+                PointLight light {};
+                light.position[0] = x * width + cosf(time + phase) * 40.f;
+                light.position[1] = y * height + sinf(time * 1.3f + phase) * 40.f;
+                light.radius      = 60.f + (color >> 24) / 255.f * 140.f;
+                light.color[0]    = 0.2f + (color & 0xFF) / 255.f;
+                light.color[1]    = 0.2f + ((color >> 8) & 0xFF) / 255.f;
+                light.color[2]    = 0.2f + ((color >> 16) & 0xFF) / 255.f;
+                LightingAddPoint(light);
+            }
+        }
+
+        // Random quads over an area larger than the view, so a good part of them is culled.
+        bool CreateStressObjects(utils::BumpAllocator* transientStorage)
+        {
+            if (!GpuCullingInit(g_stressObjectCount, transientStorage))
+            {
+                return false;
+            }
+
+            std::vector<CullObject> objects(g_stressObjectCount);
+            f32                     radius {1.5f / sqrtf((f32) g_stressObjectCount)};
+            u32                     seed {0x9E3779B9};
+            for (CullObject& object : objects)
+            {
+                object.center[0] = (NextRandom(seed) >> 8) / (f32) (1 << 24) * 3.f - 1.5f;
+                object.center[1] = (NextRandom(seed) >> 8) / (f32) (1 << 24) * 3.f - 1.5f;
+                object.center[2] = 0.5f;
+                object.radius    = radius;
+                object.color     = NextRandom(seed) | 0xFF000000;
+            }
+
+            GpuCullingSetObjects(objects.data(), (u32) objects.size());
+            D_TRACE("GPU culling stress scene, %u objects.", g_stressObjectCount);
+            return true;
+        }
+
+        // Flat tiles with a darker border, so the chunk edges and the scrolling are easy to see.
+        bool CreateStressTilemap()
+        {
+            AtlasRegion tiles[STRESS_TILE_COUNT] {};
+            u8          pixels[STRESS_TILE_SIZE * STRESS_TILE_SIZE * 4] {};
+            u32         seed {0x85EBCA6B};
+            for (AtlasRegion& tile : tiles)
+            {
+                u32 color {NextRandom(seed)};
+                for (u32 y {0}; y < STRESS_TILE_SIZE; ++y)
+                {
+                    for (u32 x {0}; x < STRESS_TILE_SIZE; ++x)
+                    {
+                        bool border {x == 0 || y == 0 || x == STRESS_TILE_SIZE - 1 || y == STRESS_TILE_SIZE - 1};
+                        u8*  pixel {pixels + (y * STRESS_TILE_SIZE + x) * 4};
+                        pixel[0] = (u8) ((color & 0xFF) >> (border ? 1 : 0));
+                        pixel[1] = (u8) (((color >> 8) & 0xFF) >> (border ? 1 : 0));
+                        pixel[2] = (u8) (((color >> 16) & 0xFF) >> (border ? 1 : 0));
+                        pixel[3] = 255;
+                    }
+                }
+
+                if (!TextureAtlasAdd(pixels, STRESS_TILE_SIZE, STRESS_TILE_SIZE, &tile))
+                {
+                    return false;
+                }
+            }
+
+            TilemapDesc desc {};
+            desc.width      = g_stressTilemapSize;
+            desc.height     = g_stressTilemapSize;
+            desc.tileSize   = (f32) STRESS_TILE_SIZE;
+            desc.tiles      = tiles;
+            desc.tileCount  = STRESS_TILE_COUNT;
+            g_stressTilemap = TilemapCreate(desc);
+            if (!g_stressTilemap)
+            {
+                return false;
+            }
+
+            // Some empty tiles too, they must not be drawn.
+            for (u32 y {0}; y < g_stressTilemapSize; ++y)
+            {
+                for (u32 x {0}; x < g_stressTilemapSize; ++x)
+                {
+                    TilemapSetTile(g_stressTilemap, x, y, (u16) (NextRandom(seed) >> 16) % (STRESS_TILE_COUNT + 1));
+                }
+            }
+
+            g_stressTileSeed = seed;
+            D_TRACE("Tilemap stress scene, %ux%u tiles.", g_stressTilemapSize, g_stressTilemapSize);
+            return true;
+        }
+
+        // Pans back and forth over the map and rewrites random tiles, some of them in view.
+        void UpdateStressTilemap(f32 time)
+        {
+            f32 worldSize {(f32) g_stressTilemapSize * STRESS_TILE_SIZE};
+            f32 rangeX {worldSize - shared::g_screenSize.width};
+            f32 rangeY {worldSize - shared::g_screenSize.height};
+            f32 x {rangeX > 0.f ? (0.5f - 0.5f * cosf(time * 0.4f)) * rangeX : 0.f};
+            f32 y {rangeY > 0.f ? (0.5f - 0.5f * cosf(time * 0.3f)) * rangeY : 0.f};
+            TilemapSetScroll(g_stressTilemap, x, y, 1.f);
+
+            for (u32 i {0}; i < STRESS_TILE_EDITS; ++i)
+            {
+                u32 tileX {NextRandom(g_stressTileSeed) % g_stressTilemapSize};
+                u32 tileY {NextRandom(g_stressTileSeed) % g_stressTilemapSize};
+                TilemapSetTile(g_stressTilemap, tileX, tileY, (u16) (NextRandom(g_stressTileSeed) >> 16) % (STRESS_TILE_COUNT + 1));
+            }
+        }
+    } // namespace anonymous
+
+    void RendererSetStressObjects(u32 count)
+    {
+        g_stressObjectCount = count;
+    }
+
+    void RendererSetStressParticles(u32 count)
+    {
+        g_stressParticleCount = count;
+    }
+
+    void RendererSetStressLights(u32 count)
+    {
+        g_stressLightCount = count;
+    }
+
+    void RendererSetStressTilemap(u32 size)
+    {
+        g_stressTilemapSize = size;
+    }
+
+    void RendererSetFont(const Char* filePath)
+    {
+        g_fontPath = filePath;
+    }
+
+    void RendererSetFixedTimestep(f32 seconds)
+    {
+        g_fixedTimestep = seconds;
+    }
+
+    void RendererSetFrameDelta(f32 seconds)
+    {
+        g_frameDelta = seconds;
+    }
+
+    void RendererSetCaptureVideo(const Char* filePath)
+    {
+        g_captureVideoPath = filePath;
+    }
+
+    void RendererSetGpuMemoryBudget(utils::Size bytes)
+    {
+        g_gpuMemoryBudget = bytes;
+    }
+
+    bool RendererSetup(utils::BumpAllocator* transientStorage)
+    {
+        GpuMemoryInit(g_glCaps.nvxMemoryInfo, g_glCaps.atiMemInfo);
+        GpuMemorySetBudget(g_gpuMemoryBudget);
+        GpuTimerInit();
+        g_frameTimer = GpuTimerCreate("Frame");
+
+        if (!UniformRingInit(UNIFORM_BYTES_PER_FRAME))
+        {
+            D_ASSERT(false, "Failed to create uniform ring.");
+            return false;
+        }
+
+        // Initalize shaders. They finish in the background, RendererDrawFrame skips what isn't ready.
+        ShaderManagerInit();
+        g_quadShader = ShaderSubmit({"assets/shaders/quad.vert", "assets/shaders/quad.frag"}, transientStorage);
+        g_blitShader = ShaderSubmit({"assets/shaders/fullscreen.vert", "assets/shaders/blit.frag"}, transientStorage);
+        if (!g_quadShader || !g_blitShader)
+        {
+            D_ASSERT(false, "Failed to submit renderer shaders.");
+            return false;
+        }
+        if (!TextureAtlasInit(ATLAS_SIZE, ATLAS_LAYERS, TextureFilter::NEAREST))
+        {
+            D_ASSERT(false, "Failed to create texture atlas.");
+            return false;
+        }
+
+        if (!TextureStreamInit(TEXTURE_UPLOAD_BUDGET))
+        {
+            D_ASSERT(false, "Failed to create texture streamer.");
+            return false;
+        }
+
+        if (!SpriteBatchInit(transientStorage))
+        {
+            D_ASSERT(false, "Failed to create sprite batch.");
+            return false;
+        }
+
+        if (!TilemapInit(transientStorage))
+        {
+            D_ASSERT(false, "Failed to initialize tilemaps.");
+            return false;
+        }
+
+        if (g_stressTilemapSize && !CreateStressTilemap())
+        {
+            D_WARN("Failed to create the stress tilemap, drawing the scene without it.");
+        }
+
+        utils::Size particleArena {PARTICLE_ARENA_BYTES + (utils::Size) g_stressParticleCount * 2 * PARTICLE_BYTES};
+        if (!ParticleSystemInit(particleArena, transientStorage))
+        {
+            D_ASSERT(false, "Failed to initialize particles.");
+            return false;
+        }
+
+        if (g_stressParticleCount)
+        {
+            // Lifetimes average 1.5 s, the spawn rate holds the requested count.
+            ParticleEmitterDesc desc {};
+            desc.capacity    = g_stressParticleCount + g_stressParticleCount / 2;
+            desc.spawnRate   = g_stressParticleCount / 1.5f;
+            desc.lifetime[0] = 1.f;
+            desc.lifetime[1] = 2.f;
+            desc.speed[0]    = 50.f;
+            desc.speed[1]    = 400.f;
+            desc.size[0]     = 1.f;
+            desc.size[1]     = 3.f;
+            desc.gravity[1]  = 200.f;
+            desc.drag        = 0.3f;
+            desc.colorStart  = 0xFF40A0FF;
+            desc.colorEnd    = 0x001020FF;
+            g_stressEmitter  = ParticleEmitterCreate(desc);
+        }
+
+        if (!LightingInit(transientStorage))
+        {
+            D_ASSERT(false, "Failed to initialize lighting.");
+            return false;
+        }
+
+        if (g_stressLightCount)
+        {
+            LightingSetAmbient(0.05f, 0.05f, 0.1f); // Night.
+        }
+
+        if (!PostProcessInit(transientStorage))
+        {
+            D_ASSERT(false, "Failed to initialize post processing.");
+            return false;
+        }
+
+        if (!FrameCaptureInit())
+        {
+            D_ASSERT(false, "Failed to initialize frame capture.");
+            return false;
+        }
+
+        if (g_captureVideoPath)
+        {
+            FrameCaptureStartVideo(g_captureVideoPath);
+        }
+
+        if (!FontInit())
+        {
+            D_ASSERT(false, "Failed to initialize fonts.");
+            return false;
+        }
+
+        if (g_fontPath)
+        {
+            g_font = FontLoadBMFont(g_fontPath, transientStorage);
+        }
+
+        if (g_stressObjectCount && !CreateStressObjects(transientStorage))
+        {
+            D_WARN("GPU culling is not available, drawing the default scene.");
+        }
+        utils::StartupMark("Shader setup");
+
+        // Upscale filters for the scene target, picked per draw in CompositePass.
+        glGenSamplers(1, &g_nearestSampler);
+        glGenSamplers(1, &g_linearSampler);
+        TRACK_LEAK_ALLOC(&g_nearestSampler, LeakType::OPENGL, "Nearest upscale sampler");
+        TRACK_LEAK_ALLOC(&g_linearSampler, LeakType::OPENGL, "Linear upscale sampler");
+        const GLuint samplers[2] {g_nearestSampler, g_linearSampler};
+        for (GLuint sampler : samplers)
+        {
+            GLint filter {sampler == g_nearestSampler ? GL_NEAREST : GL_LINEAR};
+            glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, filter);
+            glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, filter);
+            glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+
+        glGenVertexArrays(1, &g_VAO);
+        glBindVertexArray(g_VAO);
+        TRACK_LEAK_ALLOC(&g_VAO, LeakType::OPENGL, "OpenGL VAO");
+
+        // Enable depth testing.
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_GREATER);
+
+        g_lastFrameTime = utils::GetTimeNs();
+        g_animationTime = 0.0;
+
+        return true;
+    }
+
+    void RendererDrawFrame()
+    {
+        PROFILE_SCOPE("Draw frame");
+        GpuMemoryBeginFrame();
+        GpuTimerBeginFrame();
+        ShaderManagerUpdate();
+        TextureStreamUpdate();
+        FontBeginFrame();
+        UniformRingBeginFrame();
+
+        i64 now {utils::GetTimeNs()};
+        f32 frameMs {(f32) ((now - g_lastFrameTime) / 1e6)};
+        f32 deltaTime {g_fixedTimestep > 0.f ? g_fixedTimestep : (g_frameDelta >= 0.f ? g_frameDelta : frameMs / 1000.f)};
+        g_frameDelta = -1.f;
+        g_lastFrameTime = now;
+        g_animationTime += deltaTime;
+        if (FrameConstants* frame {UniformRingPush<FrameConstants>(UNIFORM_BINDING_FRAME)})
+        {
+            frame->screenSize[0] = (f32) shared::g_screenSize.width;
+            frame->screenSize[1] = (f32) shared::g_screenSize.height;
+            frame->time          = (f32) g_animationTime;
+            frame->deltaTime     = deltaTime;
+        }
+
+        // Runs on the workers while the rest of the frame is set up, ScenePass waits for it.
+        ParticleEmitterSetPosition(g_stressEmitter, shared::g_screenSize.width * 0.5f, shared::g_screenSize.height * 0.5f);
+        ParticleSystemUpdate(deltaTime < MAX_PARTICLE_STEP ? deltaTime : MAX_PARTICLE_STEP);
+
+        if (g_stressTilemap)
+        {
+            UpdateStressTilemap((f32) g_animationTime);
+        }
+
+        if (CameraConstants* camera {UniformRingPush<CameraConstants>(UNIFORM_BINDING_CAMERA)})
+        {
+            // No camera yet, identity.
+            camera->viewProjection[0]  = 1.f;
+            camera->viewProjection[5]  = 1.f;
+            camera->viewProjection[10] = 1.f;
+            camera->viewProjection[15] = 1.f;
+        }
+
+        if (MaterialConstants* material {UniformRingPush<MaterialConstants>(UNIFORM_BINDING_MATERIAL)})
+        {
+            material->color[0] = 1.f;
+            material->color[1] = 1.f;
+            material->color[2] = 1.f;
+            material->color[3] = 1.f;
+        }
+
+        // Every constant for the frame is written, upload them before any draw.
+        UniformRingFlush();
+
+        if (shared::IsKeyPressed(shared::KEY_F3))
+        {
+            g_showOverlay = !g_showOverlay;
+        }
+
+        PostProcessSettings& post {PostProcessGetSettings()};
+        post.bloom      = shared::IsKeyPressed(shared::KEY_F4) ? !post.bloom : post.bloom;
+        post.tonemap    = shared::IsKeyPressed(shared::KEY_F5) ? !post.tonemap : post.tonemap;
+        post.colorGrade = shared::IsKeyPressed(shared::KEY_F6) ? !post.colorGrade : post.colorGrade;
+
+        if (shared::IsKeyPressed(shared::KEY_F11))
+        {
+            if (FrameCaptureIsRecording())
+            {
+                FrameCaptureStopVideo();
+            }
+            else
+            {
+                Char path[64] {};
+                snprintf(path, sizeof(path), "capture_%u.rgba", ++g_captureCount);
+                FrameCaptureStartVideo(path);
+            }
+        }
+
+        if (shared::IsKeyPressed(shared::KEY_F12))
+        {
+            Char path[64] {};
+            snprintf(path, sizeof(path), "screenshot_%u.png", ++g_captureCount);
+            FrameCaptureScreenshot(path);
+        }
+
+        // The GPU time is a few frames old, the CPU frame time stands in when there are no timer queries.
+        f32 gpuMs {GpuTimerGetMs(g_frameTimer)};
+        DynamicResolutionUpdate(gpuMs >= 0.f ? gpuMs : frameMs);
+
+        u32                width {shared::g_screenSize.width};
+        u32                height {shared::g_screenSize.height};
+        InternalResolution resolution {DynamicResolutionGetSize(width, height)};
+        RenderGraphBegin(width, height);
+
+        LightingBeginFrame();
+        AddStressLights((f32) g_animationTime);
+        LightingCull(resolution.width, resolution.height, (f32) resolution.width / (f32) width);
+
+        g_frameResources              = {};
+        g_frameResources.frameMs      = frameMs;
+        g_frameResources.gpuMs        = gpuMs;
+        g_frameResources.resolution   = resolution;
+        g_frameResources.sceneColor   = RenderGraphCreateTexture("SceneColor", {resolution.width, resolution.height, RenderTargetFormat::RGBA8});
+        g_frameResources.sceneDepth   = RenderGraphCreateTexture("SceneDepth", {resolution.width, resolution.height, RenderTargetFormat::DEPTH32F});
+        g_frameResources.sceneSurface = RenderGraphCreateTexture("SceneSurface", {resolution.width, resolution.height, RenderTargetFormat::RGBA8});
+        g_frameResources.sceneLit     = RenderGraphCreateTexture("SceneLit", {resolution.width, resolution.height, RenderTargetFormat::RGBA16F});
+
+        const f32       clearColor[4] {0.f, 0.f, 0.f, 1.f};
+        RenderGraphPass scene {RenderGraphAddPass("Scene", ScenePass, &g_frameResources)};
+        const f32       clearSurface[4] {0.5f, 0.5f, 0.f, 0.f}; // Flat normal, not emissive.
+        RenderGraphWrite(scene, g_frameResources.sceneColor, clearColor);
+        RenderGraphWrite(scene, g_frameResources.sceneSurface, clearSurface);
+        RenderGraphWriteDepth(scene, g_frameResources.sceneDepth, true);
+
+        RenderGraphPass lighting {RenderGraphAddPass("Lighting", LightingPass, &g_frameResources)};
+        RenderGraphRead(lighting, g_frameResources.sceneColor);
+        RenderGraphRead(lighting, g_frameResources.sceneSurface);
+        RenderGraphWrite(lighting, g_frameResources.sceneLit, clearColor);
+
+        g_frameResources.bloom = PostProcessAddBloom(g_frameResources.sceneLit, resolution.width, resolution.height);
+
+        RenderGraphPass composite {RenderGraphAddPass("Composite", CompositePass, &g_frameResources)};
+        RenderGraphRead(composite, g_frameResources.sceneLit);
+        if (g_frameResources.bloom)
+        {
+            RenderGraphRead(composite, g_frameResources.bloom);
+        }
+        RenderGraphWrite(composite, RenderGraphBackbuffer(), clearColor); // Until the blit shader is ready.
+
+        if (g_font)
+        {
+            RenderGraphPass specimen {RenderGraphAddPass("Font specimen", FontSpecimenPass, nullptr)};
+            RenderGraphWrite(specimen, RenderGraphBackbuffer());
+        }
+
+        if (g_showOverlay)
+        {
+            RenderGraphPass overlay {RenderGraphAddPass("Overlay", OverlayPass, &g_frameResources)};
+            RenderGraphWrite(overlay, RenderGraphBackbuffer());
+        }
+
+        GpuTimerBegin(g_frameTimer);
+        RenderGraphExecute();
+        GpuTimerEnd(g_frameTimer);
+
+        // The whole frame, overlay included, as it is about to be presented.
+        FrameCaptureEndFrame(0, width, height);
+    }
+
+    void RendererTeardown()
+    {
+        GpuMemoryReport();
+        TextureAtlasReport();
+
+        RenderGraphShutdown();
+        GpuTimerShutdown();
+        g_frameTimer = 0;
+
+        glDeleteSamplers(1, &g_nearestSampler);
+        glDeleteSamplers(1, &g_linearSampler);
+        TRACK_LEAK_FREE(&g_nearestSampler);
+        TRACK_LEAK_FREE(&g_linearSampler);
+        g_nearestSampler = 0;
+        g_linearSampler  = 0;
+
+        FontShutdown();
+        g_font = 0;
+        FrameCaptureShutdown();
+        PostProcessShutdown();
+        LightingShutdown();
+        ParticleSystemShutdown();
+        g_stressEmitter = 0;
+        TilemapShutdown();
+        g_stressTilemap = 0;
+        SpriteBatchShutdown();
+        TextureStreamShutdown();
+        TextureAtlasShutdown();
+
+        glDeleteVertexArrays(1, &g_VAO);
+        TRACK_LEAK_FREE(&g_VAO);
+        g_VAO = 0;
+
+        GpuCullingShutdown();
+
+        ShaderManagerShutdown();
+        g_quadShader = 0;
+
+        UniformRingShutdown();
+
+        GpuMemoryShutdown();
+    }
+} // namespace drop::renderer
@@ -0,0 +1,284 @@
+#include "renderer/shader.hpp"
+#include "renderer/gl_loader.hpp"
+#include "renderer/uniform_ring.hpp"
+#include "utils/file_io.hpp"
+#include "utils/timer.hpp"
+
+// With GL_KHR_parallel_shader_compile the driver compiles and links on its own threads and
+// GL_COMPLETION_STATUS_KHR tells us when a result can be read without blocking. Without it,
+// reading a status blocks, so at most one program is finalized per update to spread the cost.
+
+namespace drop::renderer
+{
+    namespace
+    {
+        enum class ProgramState
+        {
+            EMPTY,
+            LINKING,
+            READY,
+            FAILED
+        };
+
+        struct ShaderProgram
+        {
+            ShaderProgramDesc desc {};
+            u64               variantHash {0};
+            GLuint            program {0};
+            GLuint            shaders[2] {};
+            const Char*       paths[2] {};
+            u32               shaderCount {0};
+            ProgramState      state {ProgramState::EMPTY};
+        };
+
+        constexpr u32 MAX_SHADER_PROGRAMS {64};
+
+        ShaderProgram g_programs[MAX_SHADER_PROGRAMS] {};
+        u32           g_programCount {0};
+        u32           g_pendingCount {0};
+        i64           g_submitTime {0};
+
+        ShaderProgram* GetProgram(ShaderHandle handle)
+        {
+            if (!handle || handle > g_programCount)
+            {
+                return nullptr;
+            }
+
+            return &g_programs[handle - 1];
+        }
+
+        u64 HashDesc(const ShaderProgramDesc& desc)
+        {
+            u64 hash {0};
+            hash = ShaderHashVariant(hash, desc.vertexPath, nullptr, 0);
+            hash = ShaderHashVariant(hash, desc.fragmentPath, nullptr, 0);
+            hash = ShaderHashVariant(hash, desc.computePath, desc.defines, desc.defineCount);
+            return hash;
+        }
+
+        bool CompileShader(ShaderProgram& program, GLenum type, const Char* path, utils::BumpAllocator* transientStorage)
+        {
+            i32   sourceSize {0};
+            Char* source {ShaderPreprocess(path, program.desc.defines, program.desc.defineCount, transientStorage, &sourceSize)};
+            if (!source)
+            {
+                D_ASSERT(false, "Failed to preprocess shader: %s", path);
+                return false;
+            }
+
+            GLuint shader {glCreateShader(type)};
+            glShaderSource(shader, 1, &source, nullptr);
+            glCompileShader(shader);
+
+            program.shaders[program.shaderCount] = shader;
+            program.paths[program.shaderCount]   = path;
+            program.shaderCount++;
+            return true;
+        }
+
+        bool IsComplete(const ShaderProgram& program)
+        {
+            if (!g_glCaps.parallelShaderCompile)
+            {
+                return true; // Reading the status will block until it is.
+            }
+
+            GLint complete {GL_FALSE};
+            glGetProgramiv(program.program, GL_COMPLETION_STATUS_KHR, &complete);
+            return complete;
+        }
+
+        void Finalize(ShaderProgram& program)
+        {
+            bool success {true};
+            Char infoLog[2048] {};
+
+            for (u32 i {0}; i < program.shaderCount; ++i)
+            {
+                GLint compiled {GL_FALSE};
+                glGetShaderiv(program.shaders[i], GL_COMPILE_STATUS, &compiled);
+                if (!compiled)
+                {
+                    glGetShaderInfoLog(program.shaders[i], sizeof(infoLog), nullptr, infoLog);
+                    D_ASSERT(false, "Failed to compile shader %s: %s", program.paths[i], infoLog);
+                    success = false;
+                }
+            }
+
+            if (success)
+            {
+                GLint linked {GL_FALSE};
+                glGetProgramiv(program.program, GL_LINK_STATUS, &linked);
+                if (!linked)
+                {
+                    glGetProgramInfoLog(program.program, sizeof(infoLog), nullptr, infoLog);
+                    D_ASSERT(false, "Failed to link program: %s", infoLog);
+                    success = false;
+                }
+                else
+                {
+                    UniformRingBindBlocks(program.program);
+                }
+            }
+
+            // The program keeps the binary, the shader objects are not needed anymore.
+            for (u32 i {0}; i < program.shaderCount; ++i)
+            {
+                glDetachShader(program.program, program.shaders[i]);
+                glDeleteShader(program.shaders[i]);
+                program.shaders[i] = 0;
+            }
+            program.shaderCount = 0;
+
+            program.state = success ? ProgramState::READY : ProgramState::FAILED;
+            g_pendingCount--;
+
+            if (!g_pendingCount)
+            {
+                D_TRACE("All shader programs finished in %.3f ms.", (utils::GetTimeNs() - g_submitTime) / 1e6);
+            }
+        }
+    } // namespace anonymous
+
+    void ShaderManagerInit()
+    {
+        if (g_glCaps.parallelShaderCompile)
+        {
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF); // Let the driver pick.
+        }
+    }
+
+    ShaderHandle ShaderSubmit(const ShaderProgramDesc& desc, utils::BumpAllocator* transientStorage)
+    {
+        u64 variantHash {HashDesc(desc)};
+        for (u32 i {0}; i < g_programCount; ++i)
+        {
+            if (g_programs[i].variantHash == variantHash)
+            {
+                return i + 1;
+            }
+        }
+
+        if (g_programCount == MAX_SHADER_PROGRAMS)
+        {
+            D_ASSERT(false, "Too many shader programs.");
+            return 0;
+        }
+
+        ShaderProgram& program {g_programs[g_programCount]};
+        program             = {};
+        program.desc        = desc;
+        program.variantHash = variantHash;
+
+        bool sourcesRead {true};
+        if (desc.computePath)
+        {
+            sourcesRead = CompileShader(program, GL_COMPUTE_SHADER, desc.computePath, transientStorage);
+        }
+        else
+        {
+            sourcesRead = CompileShader(program, GL_VERTEX_SHADER, desc.vertexPath, transientStorage) &&
+                          CompileShader(program, GL_FRAGMENT_SHADER, desc.fragmentPath, transientStorage);
+        }
+
+        // The defines belong to the caller and are only needed while preprocessing.
+        program.desc.defines     = nullptr;
+        program.desc.defineCount = 0;
+
+        if (!sourcesRead)
+        {
+            for (u32 i {0}; i < program.shaderCount; ++i)
+            {
+                glDeleteShader(program.shaders[i]);
+            }
+            program = {};
+            return 0;
+        }
+
+        // Linking right away is fine, the driver waits for the compiles on its side.
+        program.program = glCreateProgram();
+        for (u32 i {0}; i < program.shaderCount; ++i)
+        {
+            glAttachShader(program.program, program.shaders[i]);
+        }
+        glLinkProgram(program.program);
+        TRACK_LEAK_ALLOC(&program.program, LeakType::OPENGL, "OpenGL program");
+
+        if (!g_pendingCount)
+        {
+            g_submitTime = utils::GetTimeNs();
+        }
+        program.state = ProgramState::LINKING;
+        g_pendingCount++;
+
+        return ++g_programCount;
+    }
+
+    void ShaderManagerUpdate()
+    {
+        for (u32 i {0}; i < g_programCount && g_pendingCount; ++i)
+        {
+            ShaderProgram& program {g_programs[i]};
+            if (program.state != ProgramState::LINKING || !IsComplete(program))
+            {
+                continue;
+            }
+
+            Finalize(program);
+            if (!g_glCaps.parallelShaderCompile)
+            {
+                break; // That was a blocking finalize, leave the rest for the next frames.
+            }
+        }
+    }
+
+    void ShaderWaitAll()
+    {
+        for (u32 i {0}; i < g_programCount; ++i)
+        {
+            if (g_programs[i].state == ProgramState::LINKING)
+            {
+                Finalize(g_programs[i]);
+            }
+        }
+    }
+
+    bool ShaderIsReady(ShaderHandle handle)
+    {
+        ShaderProgram* program {GetProgram(handle)};
+        return program && program->state == ProgramState::READY;
+    }
+
+    bool ShaderIsFailed(ShaderHandle handle)
+    {
+        ShaderProgram* program {GetProgram(handle)};
+        return !program || program->state == ProgramState::FAILED;
+    }
+
+    u32 ShaderGetProgram(ShaderHandle handle)
+    {
+        ShaderProgram* program {GetProgram(handle)};
+        return program && program->state == ProgramState::READY ? program->program : 0;
+    }
+
+    void ShaderManagerShutdown()
+    {
+        for (u32 i {0}; i < g_programCount; ++i)
+        {
+            ShaderProgram& program {g_programs[i]};
+            for (u32 j {0}; j < program.shaderCount; ++j)
+            {
+                glDetachShader(program.program, program.shaders[j]);
+                glDeleteShader(program.shaders[j]);
+            }
+
+            glDeleteProgram(program.program);
+            TRACK_LEAK_FREE(&program.program);
+            program = {};
+        }
+
+        g_programCount = 0;
+        g_pendingCount = 0;
+    }
+} // namespace drop::renderer
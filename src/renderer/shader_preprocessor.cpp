@@ -0,0 +1,209 @@
+#include "renderer/shader_preprocessor.hpp"
+#include "utils/file_io.hpp"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace drop::renderer
+{
+    namespace
+    {
+        constexpr const Char* SHADER_DIRECTORY {"assets/shaders/"};
+        constexpr u32         MAX_INCLUDE_DEPTH {16};
+
+        constexpr u64 FNV_OFFSET_BASIS {0xcbf29ce484222325ull};
+        constexpr u64 FNV_PRIME {0x100000001b3ull};
+
+        struct PreprocessContext
+        {
+            std::string              output;
+            std::vector<std::string> included; // Index is the GLSL source string number used by #line.
+            utils::BumpAllocator*    transientStorage;
+        };
+
+        u64 HashString(u64 hash, const Char* string)
+        {
+            for (; string && *string; ++string)
+            {
+                hash ^= (u8) *string;
+                hash *= FNV_PRIME;
+            }
+
+            // Separator, so {"AB", "C"} and {"A", "BC"} don't collide.
+            hash ^= 0xFF;
+            hash *= FNV_PRIME;
+            return hash;
+        }
+
+        // Returns the file name between the quotes of an #include line, or an empty string.
+        std::string ParseInclude(const Char* line, const Char* lineEnd)
+        {
+            const Char* cursor {line};
+            while (cursor < lineEnd && (*cursor == ' ' || *cursor == '\t'))
+            {
+                cursor++;
+            }
+
+            constexpr u32 INCLUDE_LENGTH {8}; // "#include"
+            if (lineEnd - cursor < INCLUDE_LENGTH || strncmp(cursor, "#include", INCLUDE_LENGTH) != 0)
+            {
+                return {};
+            }
+
+            const Char* open {(const Char*) memchr(cursor, '"', lineEnd - cursor)};
+            if (!open)
+            {
+                return {};
+            }
+
+            const Char* close {(const Char*) memchr(open + 1, '"', lineEnd - open - 1)};
+            if (!close)
+            {
+                return {};
+            }
+
+            return std::string(open + 1, close);
+        }
+
+        bool IsVersionLine(const Char* line, const Char* lineEnd)
+        {
+            while (line < lineEnd && (*line == ' ' || *line == '\t'))
+            {
+                line++;
+            }
+
+            return lineEnd - line >= 8 && strncmp(line, "#version", 8) == 0;
+        }
+
+        bool Expand(PreprocessContext& context, const std::string& filePath, const ShaderDefine* defines, u32 defineCount, u32 depth)
+        {
+            if (depth > MAX_INCLUDE_DEPTH)
+            {
+                D_ERROR("Shader includes nested too deep: %s", filePath.c_str());
+                return false;
+            }
+
+            for (const std::string& included : context.included)
+            {
+                if (included == filePath)
+                {
+                    return true; // Already pasted in, every file behaves as if it had an include guard.
+                }
+            }
+
+            u32 sourceIndex {(u32) context.included.size()};
+            context.included.push_back(filePath);
+
+            i32   fileSize {0};
+            Char* source {utils::ReadFile((Char*) filePath.c_str(), context.transientStorage, &fileSize)};
+            if (!source)
+            {
+                D_ERROR("Failed to read shader: %s", filePath.c_str());
+                return false;
+            }
+
+            // Included text is attributed to its own file, the parent's #line follows it.
+            if (depth > 0)
+            {
+                context.output += "#line 1 " + std::to_string(sourceIndex) + "\n";
+            }
+
+            const Char* cursor {source};
+            const Char* end {source + fileSize};
+            u32         lineNumber {1};
+            while (cursor < end)
+            {
+                const Char* lineEnd {(const Char*) memchr(cursor, '\n', end - cursor)};
+                if (!lineEnd)
+                {
+                    lineEnd = end;
+                }
+
+                std::string include {ParseInclude(cursor, lineEnd)};
+                if (!include.empty())
+                {
+                    if (!Expand(context, SHADER_DIRECTORY + include, nullptr, 0, depth + 1))
+                    {
+                        D_ERROR("Included from %s:%u", filePath.c_str(), lineNumber);
+                        return false;
+                    }
+
+                    // Point compiler messages back at this file.
+                    context.output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceIndex) + "\n";
+                }
+                else
+                {
+                    context.output.append(cursor, lineEnd);
+                    context.output += '\n';
+
+                    // #version must stay first, the permutation defines go right after it.
+                    if (depth == 0 && IsVersionLine(cursor, lineEnd))
+                    {
+                        for (u32 i {0}; i < defineCount; ++i)
+                        {
+                            context.output += "#define ";
+                            context.output += defines[i].name;
+                            if (defines[i].value)
+                            {
+                                context.output += ' ';
+                                context.output += defines[i].value;
+                            }
+                            context.output += '\n';
+                        }
+                        context.output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceIndex) + "\n";
+                    }
+                }
+
+                cursor = lineEnd + 1;
+                lineNumber++;
+            }
+
+            return true;
+        }
+    } // namespace anonymous
+
+    Char* ShaderPreprocess(const Char* path, const ShaderDefine* defines, u32 defineCount,
+                           utils::BumpAllocator* transientStorage, i32* outSize)
+    {
+        D_ASSERT(path, "Shader path is null.");
+        D_ASSERT(outSize, "Size pointer is null.");
+
+        PreprocessContext context {};
+        context.transientStorage = transientStorage;
+        context.output.reserve(KB(16));
+
+        *outSize = 0;
+        if (!Expand(context, path, defines, defineCount, 0))
+        {
+            return nullptr;
+        }
+
+        Char* result {utils::BumpAlloc(transientStorage, context.output.size() + 1)};
+        if (!result)
+        {
+            return nullptr;
+        }
+
+        memcpy(result, context.output.c_str(), context.output.size() + 1);
+        *outSize = (i32) context.output.size();
+        return result;
+    }
+
+    u64 ShaderHashVariant(u64 hash, const Char* path, const ShaderDefine* defines, u32 defineCount)
+    {
+        if (!hash)
+        {
+            hash = FNV_OFFSET_BASIS;
+        }
+
+        hash = HashString(hash, path);
+        for (u32 i {0}; i < defineCount; ++i)
+        {
+            hash = HashString(hash, defines[i].name);
+            hash = HashString(hash, defines[i].value);
+        }
+
+        return hash;
+    }
+} // namespace drop::renderer
@@ -0,0 +1,163 @@
+#include "renderer/sprite_batch.hpp"
+#include "renderer/gl_loader.hpp"
+#include "renderer/gpu_memory.hpp"
+#include "renderer/shader.hpp"
+
+#include <cstddef>
+
+namespace drop::renderer
+{
+    namespace
+    {
+        GLuint         g_spriteVAO {0};
+        GLuint         g_instanceBuffer {0};
+        ShaderHandle   g_spriteShader {0};
+        SpriteInstance g_instances[MAX_SPRITES_PER_BATCH] {};
+        u32            g_instanceCount {0};
+        u32            g_drawCalls {0};
+        bool           g_began {false};
+
+        void Flush()
+        {
+            if (!g_instanceCount || !ShaderIsReady(g_spriteShader))
+            {
+                g_instanceCount = 0;
+                return;
+            }
+
+            utils::Size bytes {(utils::Size) g_instanceCount * sizeof(SpriteInstance)};
+
+            // Orphan the buffer so the driver hands out fresh storage instead of waiting on the last draw.
+            glBindBuffer(GL_ARRAY_BUFFER, g_instanceBuffer);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(g_instances), nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, g_instances);
+            GpuMemoryTrackUpload(bytes);
+
+            // Sprites are layered by submission order, not depth.
+            glDisable(GL_DEPTH_TEST);
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+            glUseProgram(ShaderGetProgram(g_spriteShader));
+            TextureAtlasBind(0);
+            glBindVertexArray(g_spriteVAO);
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, g_instanceCount);
+
+            glDisable(GL_BLEND);
+            glEnable(GL_DEPTH_TEST);
+
+            g_instanceCount = 0;
+            g_drawCalls++;
+        }
+    } // namespace anonymous
+
+    bool SpriteBatchInit(utils::BumpAllocator* transientStorage)
+    {
+        g_spriteShader = ShaderSubmit({"assets/shaders/sprite.vert", "assets/shaders/sprite.frag"}, transientStorage);
+        if (!g_spriteShader)
+        {
+            D_ASSERT(false, "Failed to submit sprite shader.");
+            return false;
+        }
+
+        glGenVertexArrays(1, &g_spriteVAO);
+        glBindVertexArray(g_spriteVAO);
+        TRACK_LEAK_ALLOC(&g_spriteVAO, LeakType::OPENGL, "Sprite VAO");
+
+        glGenBuffers(1, &g_instanceBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, g_instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(g_instances), nullptr, GL_STREAM_DRAW);
+        TRACK_LEAK_ALLOC(&g_instanceBuffer, LeakType::OPENGL, "Sprite instance buffer");
+        GpuMemoryTrackAlloc(g_instanceBuffer, GpuMemoryCategory::VERTEX_BUFFER, sizeof(g_instances));
+
+        GLsizei stride {sizeof(SpriteInstance)};
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*) offsetof(SpriteInstance, position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*) offsetof(SpriteInstance, size));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*) offsetof(SpriteInstance, uv));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*) offsetof(SpriteInstance, color));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, (void*) offsetof(SpriteInstance, layer));
+        glEnableVertexAttribArray(5);
+        glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, stride, (void*) offsetof(SpriteInstance, distanceField));
+        for (u32 i {0}; i < 6; ++i)
+        {
+            glVertexAttribDivisor(i, 1);
+        }
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return true;
+    }
+
+    void SpriteBatchBegin()
+    {
+        D_ASSERT(!g_began, "SpriteBatchBegin called twice.");
+        g_began         = true;
+        g_instanceCount = 0;
+        g_drawCalls     = 0;
+    }
+
+    void SpriteBatchDraw(const AtlasRegion& region, f32 x, f32 y, f32 width, f32 height, u32 color)
+    {
+        SpriteInstance instance {};
+        instance.position[0] = x;
+        instance.position[1] = y;
+        instance.size[0]     = width;
+        instance.size[1]     = height;
+        instance.uv[0]       = region.uv[0];
+        instance.uv[1]       = region.uv[1];
+        instance.uv[2]       = region.uv[2];
+        instance.uv[3]       = region.uv[3];
+        instance.color       = color;
+        instance.layer       = (f32) region.layer;
+        SpriteBatchDrawInstance(instance);
+    }
+
+    void SpriteBatchDrawInstance(const SpriteInstance& instance)
+    {
+        D_ASSERT(g_began, "SpriteBatchDraw outside of Begin/End.");
+
+        if (g_instanceCount == MAX_SPRITES_PER_BATCH)
+        {
+            Flush();
+        }
+
+        g_instances[g_instanceCount++] = instance;
+    }
+
+    void SpriteBatchEnd()
+    {
+        D_ASSERT(g_began, "SpriteBatchEnd without Begin.");
+        Flush();
+        g_began = false;
+    }
+
+    u32 SpriteBatchDrawCalls()
+    {
+        return g_drawCalls;
+    }
+
+    void SpriteBatchShutdown()
+    {
+        if (g_instanceBuffer)
+        {
+            GpuMemoryTrackFree(g_instanceBuffer, GpuMemoryCategory::VERTEX_BUFFER);
+            glDeleteBuffers(1, &g_instanceBuffer);
+            TRACK_LEAK_FREE(&g_instanceBuffer);
+            g_instanceBuffer = 0;
+        }
+
+        if (g_spriteVAO)
+        {
+            glDeleteVertexArrays(1, &g_spriteVAO);
+            TRACK_LEAK_FREE(&g_spriteVAO);
+            g_spriteVAO = 0;
+        }
+
+        g_spriteShader = 0; // Owned by the shader manager.
+    }
+} // namespace drop::renderer
@@ -0,0 +1,349 @@
+#include "renderer/texture.hpp"
+#include "renderer/atlas_packer.hpp"
+#include "renderer/gl_loader.hpp"
+#include "renderer/gpu_memory.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace drop::renderer
+{
+    namespace
+    {
+        struct FreeRect
+        {
+            u32 layer {0};
+            u32 x {0}; // Padded texels, like the packer's.
+            u32 y {0};
+            u32 width {0};
+            u32 height {0};
+        };
+
+        struct TextureAtlas
+        {
+            GLuint                     texture {0};
+            u32                        size {0};
+            u32                        maxLayers {0};
+            std::vector<SkylinePacker> layers;
+            std::vector<FreeRect>      freeRects; // Released regions, see TextureAtlasRelease.
+            AtlasRegion                white {};
+            u32                        imageCount {0};
+        };
+
+        TextureAtlas g_atlas {};
+
+        GLint ToGL(TextureFilter filter)
+        {
+            return filter == TextureFilter::LINEAR ? GL_LINEAR : GL_NEAREST;
+        }
+
+        // Best fit out of the released rectangles. What the image leaves over is split off to the
+        // right and below and stays free.
+        bool TakeFreeRect(u32 paddedWidth, u32 paddedHeight, u32* outLayer, u32* outX, u32* outY)
+        {
+            u32 best {(u32) g_atlas.freeRects.size()};
+            u64 bestArea {~0ull};
+            for (u32 i {0}; i < g_atlas.freeRects.size(); ++i)
+            {
+                const FreeRect& rect {g_atlas.freeRects[i]};
+                u64             area {(u64) rect.width * rect.height};
+                if (rect.width >= paddedWidth && rect.height >= paddedHeight && area < bestArea)
+                {
+                    best     = i;
+                    bestArea = area;
+                }
+            }
+
+            if (best == g_atlas.freeRects.size())
+            {
+                return false;
+            }
+
+            FreeRect rect {g_atlas.freeRects[best]};
+            g_atlas.freeRects[best] = g_atlas.freeRects.back();
+            g_atlas.freeRects.pop_back();
+
+            if (rect.width > paddedWidth)
+            {
+                g_atlas.freeRects.push_back({rect.layer, rect.x + paddedWidth, rect.y, rect.width - paddedWidth, paddedHeight});
+            }
+            if (rect.height > paddedHeight)
+            {
+                g_atlas.freeRects.push_back({rect.layer, rect.x, rect.y + paddedHeight, rect.width, rect.height - paddedHeight});
+            }
+
+            *outLayer = rect.layer;
+            *outX     = rect.x;
+            *outY     = rect.y;
+            return true;
+        }
+    } // namespace anonymous
+
+    bool TextureCreate2D(u32* outTexture, u32 width, u32 height, const u8* rgba, TextureFilter filter, bool mipmaps)
+    {
+        utils::Size bytes {(utils::Size) width * height * 4};
+        if (mipmaps)
+        {
+            bytes += bytes / 3;
+        }
+        if (!GpuMemoryFitsBudget(bytes))
+        {
+            D_ERROR("Texture %ux%u does not fit the GPU memory budget.", width, height);
+            return false;
+        }
+
+        GLuint texture {0};
+        glGenTextures(1, &texture);
+        if (!texture)
+        {
+            D_ASSERT(false, "Failed to create texture.");
+            return false;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, ToGL(filter));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        if (mipmaps)
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter == TextureFilter::LINEAR ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_NEAREST);
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        else
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, ToGL(filter));
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        *outTexture = texture;
+        TRACK_LEAK_ALLOC(outTexture, LeakType::OPENGL, "OpenGL texture");
+        GpuMemoryTrackAlloc(texture, GpuMemoryCategory::TEXTURE, bytes);
+        if (rgba)
+        {
+            GpuMemoryTrackUpload((utils::Size) width * height * 4);
+        }
+
+        return true;
+    }
+
+    void TextureDestroy(u32* texture)
+    {
+        if (!*texture)
+        {
+            return;
+        }
+
+        GpuMemoryTrackFree(*texture, GpuMemoryCategory::TEXTURE);
+        TRACK_LEAK_FREE(texture);
+        glDeleteTextures(1, texture);
+        *texture = 0;
+    }
+
+    bool TextureAtlasInit(u32 size, u32 maxLayers, TextureFilter filter)
+    {
+        GLint maxSize {0};
+        GLint maxArrayLayers {0};
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxArrayLayers);
+        if ((GLint) size > maxSize || (GLint) maxLayers > maxArrayLayers)
+        {
+            D_ASSERT(false, "Atlas %ux%ux%u exceeds the driver limits (%d, %d layers).", size, size, maxLayers, maxSize, maxArrayLayers);
+            return false;
+        }
+
+        // Fewer layers only fail the adds that would have needed them, so the budget trims layers instead of failing.
+        utils::Size layerBytes {(utils::Size) size * size * 4};
+        u32         fittingLayers {maxLayers};
+        while (fittingLayers > 1 && !GpuMemoryFitsBudget(layerBytes * fittingLayers))
+        {
+            fittingLayers--;
+        }
+        if (fittingLayers < maxLayers)
+        {
+            D_WARN("GPU memory budget leaves room for %u of %u atlas layers.", fittingLayers, maxLayers);
+            maxLayers = fittingLayers;
+        }
+
+        g_atlas           = {};
+        g_atlas.size      = size;
+        g_atlas.maxLayers = maxLayers;
+
+        // All layers are allocated up front, a 2D array can't grow without a copy.
+        glGenTextures(1, &g_atlas.texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, g_atlas.texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size, size, maxLayers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, ToGL(filter));
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, ToGL(filter));
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        TRACK_LEAK_ALLOC(&g_atlas.texture, LeakType::OPENGL, "Texture atlas");
+        GpuMemoryTrackAlloc(g_atlas.texture, GpuMemoryCategory::TEXTURE, layerBytes * maxLayers);
+
+        const u8 white[4] {255, 255, 255, 255};
+        if (!TextureAtlasAdd(white, 1, 1, &g_atlas.white))
+        {
+            D_ASSERT(false, "Failed to add the white texel to the atlas.");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool TextureAtlasAdd(const u8* rgba, u32 width, u32 height, AtlasRegion* outRegion)
+    {
+        if (!TextureAtlasReserve(width, height, outRegion))
+        {
+            return false;
+        }
+
+        std::vector<u8> padded((utils::Size) (width + TEXTURE_ATLAS_PADDING * 2) * (height + TEXTURE_ATLAS_PADDING * 2) * 4);
+        TextureAtlasExtrude(rgba, width, height, padded.data());
+        TextureAtlasUpload(*outRegion, padded.data());
+        return true;
+    }
+
+    bool TextureAtlasReserve(u32 width, u32 height, AtlasRegion* outRegion)
+    {
+        D_ASSERT(g_atlas.texture, "Texture atlas is not initialized.");
+
+        u32 paddedWidth {width + TEXTURE_ATLAS_PADDING * 2};
+        u32 paddedHeight {height + TEXTURE_ATLAS_PADDING * 2};
+
+        u32 x {0};
+        u32 y {0};
+        u32 layer {0};
+        bool placed {TakeFreeRect(paddedWidth, paddedHeight, &layer, &x, &y)};
+        for (; !placed && layer < g_atlas.layers.size(); ++layer)
+        {
+            if (SkylinePack(&g_atlas.layers[layer], paddedWidth, paddedHeight, &x, &y))
+            {
+                placed = true;
+                break;
+            }
+        }
+
+        if (!placed)
+        {
+            if (layer == g_atlas.maxLayers)
+            {
+                D_ERROR("Texture atlas is full, %ux%u image rejected.", width, height);
+                return false;
+            }
+
+            g_atlas.layers.emplace_back();
+            SkylineInit(&g_atlas.layers.back(), g_atlas.size, g_atlas.size);
+            if (!SkylinePack(&g_atlas.layers.back(), paddedWidth, paddedHeight, &x, &y))
+            {
+                D_ERROR("Image %ux%u does not fit in a %u atlas layer.", width, height, g_atlas.size);
+                g_atlas.layers.pop_back();
+                return false;
+            }
+        }
+
+        f32 texel {1.f / g_atlas.size};
+        outRegion->uv[0]  = (x + TEXTURE_ATLAS_PADDING) * texel;
+        outRegion->uv[1]  = (y + TEXTURE_ATLAS_PADDING) * texel;
+        outRegion->uv[2]  = (x + TEXTURE_ATLAS_PADDING + width) * texel;
+        outRegion->uv[3]  = (y + TEXTURE_ATLAS_PADDING + height) * texel;
+        outRegion->layer  = layer;
+        outRegion->x      = x;
+        outRegion->y      = y;
+        outRegion->width  = width;
+        outRegion->height = height;
+
+        g_atlas.imageCount++;
+        return true;
+    }
+
+    void TextureAtlasExtrude(const u8* rgba, u32 width, u32 height, u8* outPadded)
+    {
+        u32 paddedWidth {width + TEXTURE_ATLAS_PADDING * 2};
+        u32 paddedHeight {height + TEXTURE_ATLAS_PADDING * 2};
+
+        for (u32 y {0}; y < paddedHeight; ++y)
+        {
+            u32       sourceY {y < TEXTURE_ATLAS_PADDING ? 0 : (y - TEXTURE_ATLAS_PADDING >= height ? height - 1 : y - TEXTURE_ATLAS_PADDING)};
+            const u8* sourceRow {rgba + (utils::Size) sourceY * width * 4};
+            u8*       row {outPadded + (utils::Size) y * paddedWidth * 4};
+
+            // Left border, the row itself, right border.
+            for (u32 x {0}; x < TEXTURE_ATLAS_PADDING; ++x)
+            {
+                memcpy(row + x * 4, sourceRow, 4);
+                memcpy(row + (TEXTURE_ATLAS_PADDING + width + x) * 4, sourceRow + (width - 1) * 4, 4);
+            }
+            memcpy(row + TEXTURE_ATLAS_PADDING * 4, sourceRow, (utils::Size) width * 4);
+        }
+    }
+
+    void TextureAtlasUpload(const AtlasRegion& region, const void* padded)
+    {
+        u32 paddedWidth {region.width + TEXTURE_ATLAS_PADDING * 2};
+        u32 paddedHeight {region.height + TEXTURE_ATLAS_PADDING * 2};
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, g_atlas.texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, region.x, region.y, region.layer, paddedWidth, paddedHeight, 1, GL_RGBA, GL_UNSIGNED_BYTE, padded);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        GpuMemoryTrackUpload((utils::Size) paddedWidth * paddedHeight * 4);
+    }
+
+    void TextureAtlasRelease(const AtlasRegion& region)
+    {
+        if (!region.width || !region.height)
+        {
+            return;
+        }
+
+        D_ASSERT(region.layer < g_atlas.layers.size(), "Region is not in the atlas.");
+        g_atlas.freeRects.push_back({region.layer, region.x, region.y, region.width + TEXTURE_ATLAS_PADDING * 2, region.height + TEXTURE_ATLAS_PADDING * 2});
+        g_atlas.imageCount--;
+    }
+
+    u32 TextureAtlasGetSize()
+    {
+        return g_atlas.size;
+    }
+
+    const AtlasRegion& TextureAtlasWhite()
+    {
+        return g_atlas.white;
+    }
+
+    void TextureAtlasBind(u32 unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, g_atlas.texture);
+    }
+
+    u32 TextureAtlasGetTexture()
+    {
+        return g_atlas.texture;
+    }
+
+    void TextureAtlasReport()
+    {
+        D_TRACE("Texture atlas: %u images in %u / %u layers of %u, %u free rectangles.", g_atlas.imageCount, (u32) g_atlas.layers.size(), g_atlas.maxLayers, g_atlas.size, (u32) g_atlas.freeRects.size());
+        for (u32 i {0}; i < g_atlas.layers.size(); ++i)
+        {
+            D_TRACE("    layer %u: %.1f%% used", i, SkylineOccupancy(&g_atlas.layers[i]) * 100.f);
+        }
+    }
+
+    void TextureAtlasShutdown()
+    {
+        if (!g_atlas.texture)
+        {
+            return;
+        }
+
+        GpuMemoryTrackFree(g_atlas.texture, GpuMemoryCategory::TEXTURE);
+        glDeleteTextures(1, &g_atlas.texture);
+        TRACK_LEAK_FREE(&g_atlas.texture);
+        g_atlas = {};
+    }
+} // namespace drop::renderer
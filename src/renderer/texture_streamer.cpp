@@ -0,0 +1,319 @@
+#include "renderer/texture_streamer.hpp"
+#include "renderer/gl_loader.hpp"
+#include "renderer/gpu_memory.hpp"
+#include "utils/image.hpp"
+#include "utils/job_system.hpp"
+#include "utils/profiler.hpp"
+
+#include <atomic>
+#include <cstring>
+
+namespace drop::renderer
+{
+    namespace
+    {
+        constexpr u32 MAX_STREAM_REQUESTS {256};
+        constexpr u32 MAX_STREAM_PATH {256};
+        constexpr u32 PIXEL_BUFFER_COUNT {4};
+
+        enum class StreamState : u8
+        {
+            EMPTY,
+            DECODING, // Owned by a worker.
+            DECODED,
+            READY,
+            FAILED,
+            RELEASED
+        };
+
+        enum class UploadResult
+        {
+            DONE,
+            RETRY, // Every pixel buffer is still in flight.
+            FAILED
+        };
+
+        struct StreamRequest
+        {
+            Char                     path[MAX_STREAM_PATH] {};
+            std::atomic<StreamState> state {StreamState::EMPTY};
+            utils::Image             image {};
+            AtlasRegion              region {};
+            bool                     release {false}; // Released while a worker had it, dropped once decoded.
+        };
+
+        struct PixelBuffer
+        {
+            GLuint buffer {0};
+            GLsync fence {nullptr}; // Signaled once the upload that last used the buffer is done.
+        };
+
+        StreamRequest     g_requests[MAX_STREAM_REQUESTS] {};
+        u32               g_requestCount {0};
+        PixelBuffer       g_pixelBuffers[PIXEL_BUFFER_COUNT] {};
+        u32               g_pixelBufferCount {0}; // Fewer than PIXEL_BUFFER_COUNT when the GPU memory budget is tight.
+        u32               g_nextPixelBuffer {0};
+        utils::Size       g_pixelBufferSize {0};
+        utils::Size       g_uploadBudget {0};
+        utils::JobCounter g_decodeJobs {};
+
+        void DecodeJob(void* userData)
+        {
+            PROFILE_SCOPE("Image decode");
+            StreamRequest* request {(StreamRequest*) userData};
+            bool           decoded {utils::ImageLoad(request->path, &request->image)};
+            request->state.store(decoded ? StreamState::DECODED : StreamState::FAILED, std::memory_order_release);
+        }
+
+        StreamRequest* GetRequest(TextureStreamHandle handle)
+        {
+            if (!handle || handle > g_requestCount)
+            {
+                return nullptr;
+            }
+
+            return &g_requests[handle - 1];
+        }
+
+        // Next buffer of the ring whose previous upload has finished, or null if the GPU is behind.
+        PixelBuffer* AcquirePixelBuffer()
+        {
+            PixelBuffer& pixelBuffer {g_pixelBuffers[g_nextPixelBuffer]};
+            if (pixelBuffer.fence)
+            {
+                GLenum status {glClientWaitSync(pixelBuffer.fence, 0, 0)};
+                if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                {
+                    return nullptr;
+                }
+
+                glDeleteSync(pixelBuffer.fence);
+                pixelBuffer.fence = nullptr;
+            }
+
+            g_nextPixelBuffer = (g_nextPixelBuffer + 1) % g_pixelBufferCount;
+            return &pixelBuffer;
+        }
+
+        UploadResult Upload(StreamRequest& request)
+        {
+            const utils::Image& image {request.image};
+            utils::Size         paddedBytes {(utils::Size) (image.width + TEXTURE_ATLAS_PADDING * 2) * (image.height + TEXTURE_ATLAS_PADDING * 2) * 4};
+            if (paddedBytes > g_pixelBufferSize)
+            {
+                D_ERROR("Streamed image %s (%ux%u) is larger than an atlas layer.", request.path, image.width, image.height);
+                return UploadResult::FAILED;
+            }
+
+            PixelBuffer* pixelBuffer {AcquirePixelBuffer()};
+            if (!pixelBuffer)
+            {
+                return UploadResult::RETRY;
+            }
+
+            if (!TextureAtlasReserve(image.width, image.height, &request.region))
+            {
+                return UploadResult::FAILED;
+            }
+
+            // The fence says the GPU is done with this buffer, no need for the driver to sync again.
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer->buffer);
+            u8* mapped {(u8*) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, paddedBytes,
+                                               GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT)};
+            if (!mapped)
+            {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                D_ERROR("Failed to map pixel buffer for %s.", request.path);
+                return UploadResult::FAILED;
+            }
+
+            TextureAtlasExtrude(image.pixels, image.width, image.height, mapped);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+            TextureAtlasUpload(request.region, nullptr); // Offset 0 into the bound pixel buffer.
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            pixelBuffer->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            return UploadResult::DONE;
+        }
+    } // namespace anonymous
+
+    bool TextureStreamInit(utils::Size uploadBudgetPerFrame)
+    {
+        // Sized for the largest image the atlas can take, one full layer.
+        u32 atlasSize {TextureAtlasGetSize()};
+        g_pixelBufferSize = (utils::Size) atlasSize * atlasSize * 4;
+        g_uploadBudget    = uploadBudgetPerFrame;
+
+        // One buffer is always made, the rest only while they fit the budget. Fewer buffers just stall uploads sooner.
+        g_pixelBufferCount = 0;
+        for (PixelBuffer& pixelBuffer : g_pixelBuffers)
+        {
+            if (g_pixelBufferCount && !GpuMemoryFitsBudget(g_pixelBufferSize))
+            {
+                D_WARN("GPU memory budget leaves room for %u of %u texture stream pixel buffers.", g_pixelBufferCount, PIXEL_BUFFER_COUNT);
+                break;
+            }
+
+            glGenBuffers(1, &pixelBuffer.buffer);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.buffer);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, g_pixelBufferSize, nullptr, GL_STREAM_DRAW);
+            TRACK_LEAK_ALLOC(&pixelBuffer.buffer, LeakType::OPENGL, "Texture stream pixel buffer");
+            GpuMemoryTrackAlloc(pixelBuffer.buffer, GpuMemoryCategory::STAGING_BUFFER, g_pixelBufferSize);
+            g_pixelBufferCount++;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        return true;
+    }
+
+    TextureStreamHandle TextureStreamLoad(const Char* filePath)
+    {
+        if (g_requestCount == MAX_STREAM_REQUESTS)
+        {
+            D_ASSERT(false, "Too many streamed textures.");
+            return 0;
+        }
+
+        if (strlen(filePath) >= MAX_STREAM_PATH)
+        {
+            D_ASSERT(false, "Texture path too long: %s", filePath);
+            return 0;
+        }
+
+        StreamRequest& request {g_requests[g_requestCount]};
+        strcpy(request.path, filePath);
+        request.state.store(StreamState::DECODING, std::memory_order_relaxed);
+        utils::JobSubmit(DecodeJob, &request, &g_decodeJobs);
+
+        return ++g_requestCount;
+    }
+
+    void TextureStreamUpdate()
+    {
+        utils::Size uploaded {0};
+        for (u32 i {0}; i < g_requestCount && uploaded < g_uploadBudget; ++i)
+        {
+            StreamRequest& request {g_requests[i]};
+            if (request.state.load(std::memory_order_acquire) != StreamState::DECODED)
+            {
+                continue;
+            }
+
+            if (request.release)
+            {
+                utils::ImageFree(&request.image);
+                request.state.store(StreamState::RELEASED, std::memory_order_relaxed);
+                continue;
+            }
+
+            UploadResult result {Upload(request)};
+            if (result == UploadResult::RETRY)
+            {
+                break; // The GPU is behind, next frame.
+            }
+
+            uploaded += (utils::Size) request.image.width * request.image.height * 4;
+            utils::ImageFree(&request.image);
+            request.state.store(result == UploadResult::DONE ? StreamState::READY : StreamState::FAILED, std::memory_order_relaxed);
+        }
+    }
+
+    bool TextureStreamIsReady(TextureStreamHandle handle)
+    {
+        StreamRequest* request {GetRequest(handle)};
+        return request && request->state.load(std::memory_order_acquire) == StreamState::READY;
+    }
+
+    bool TextureStreamIsFailed(TextureStreamHandle handle)
+    {
+        StreamRequest* request {GetRequest(handle)};
+        if (!request)
+        {
+            return true;
+        }
+
+        StreamState state {request->state.load(std::memory_order_acquire)};
+        return state == StreamState::FAILED || state == StreamState::RELEASED || request->release;
+    }
+
+    const AtlasRegion* TextureStreamGetRegion(TextureStreamHandle handle)
+    {
+        return TextureStreamIsReady(handle) ? &GetRequest(handle)->region : nullptr;
+    }
+
+    void TextureStreamRelease(TextureStreamHandle handle)
+    {
+        StreamRequest* request {GetRequest(handle)};
+        if (!request)
+        {
+            return;
+        }
+
+        switch (request->state.load(std::memory_order_acquire))
+        {
+        case StreamState::DECODING:
+            request->release = true; // TextureStreamUpdate drops it once the worker is done.
+            break;
+        case StreamState::DECODED:
+            utils::ImageFree(&request->image);
+            request->state.store(StreamState::RELEASED, std::memory_order_relaxed);
+            break;
+        case StreamState::READY:
+            TextureAtlasRelease(request->region);
+            request->region = {};
+            request->state.store(StreamState::RELEASED, std::memory_order_relaxed);
+            break;
+        case StreamState::FAILED:
+            request->state.store(StreamState::RELEASED, std::memory_order_relaxed);
+            break;
+        default:
+            break;
+        }
+    }
+
+    u32 TextureStreamPendingCount()
+    {
+        u32 pending {0};
+        for (u32 i {0}; i < g_requestCount; ++i)
+        {
+            StreamState state {g_requests[i].state.load(std::memory_order_acquire)};
+            pending += state == StreamState::DECODING || state == StreamState::DECODED;
+        }
+        return pending;
+    }
+
+    void TextureStreamShutdown()
+    {
+        // Workers write into the requests, they must be done before anything is freed.
+        utils::JobWait(&g_decodeJobs);
+
+        for (u32 i {0}; i < g_requestCount; ++i)
+        {
+            utils::ImageFree(&g_requests[i].image);
+            g_requests[i].state.store(StreamState::EMPTY, std::memory_order_relaxed);
+            g_requests[i].region  = {};
+            g_requests[i].release = false;
+        }
+        g_requestCount = 0;
+
+        for (PixelBuffer& pixelBuffer : g_pixelBuffers)
+        {
+            if (pixelBuffer.fence)
+            {
+                glDeleteSync(pixelBuffer.fence);
+                pixelBuffer.fence = nullptr;
+            }
+
+            if (pixelBuffer.buffer)
+            {
+                GpuMemoryTrackFree(pixelBuffer.buffer, GpuMemoryCategory::STAGING_BUFFER);
+                glDeleteBuffers(1, &pixelBuffer.buffer);
+                TRACK_LEAK_FREE(&pixelBuffer.buffer);
+                pixelBuffer.buffer = 0;
+            }
+        }
+        g_pixelBufferCount = 0;
+        g_nextPixelBuffer  = 0;
+    }
+} // namespace drop::renderer
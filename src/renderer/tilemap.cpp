@@ -0,0 +1,369 @@
+#include "renderer/tilemap.hpp"
+#include "renderer/gl_loader.hpp"
+#include "renderer/gpu_memory.hpp"
+#include "renderer/shader.hpp"
+
+#include <cmath>   // floorf, ceilf.
+#include <cstddef> // offsetof.
+#include <vector>
+
+namespace drop::renderer
+{
+    namespace
+    {
+        constexpr u32 MAX_TILEMAPS {16};
+        constexpr u32 CHUNK_TILES {TILEMAP_CHUNK_SIZE * TILEMAP_CHUNK_SIZE};
+
+        // 16 bytes per tile, a full chunk is 16 KB of buffer.
+        struct TileInstance
+        {
+            u16 position[2]; // Map coordinates of the tile.
+            u16 uv[4];       // Normalized.
+            u16 layer;
+            u16 padding;
+        };
+
+        struct TileChunk
+        {
+            u32  instanceCount {0};
+            bool dirty {true};
+        };
+
+        struct Tilemap
+        {
+            bool                     used {false};
+            u32                      width {0};
+            u32                      height {0};
+            u32                      chunksX {0};
+            u32                      chunksY {0};
+            f32                      tileSize {0.f};
+            f32                      scroll[2] {};
+            f32                      zoom {1.f};
+            std::vector<u16>         tiles;
+            std::vector<AtlasRegion> regions;
+            std::vector<TileChunk>   chunks;
+            GLuint                   buffer {0}; // CHUNK_TILES instances per chunk, at the chunk's index.
+        };
+
+        Tilemap      g_tilemaps[MAX_TILEMAPS] {};
+        GLuint       g_VAO {0};
+        ShaderHandle g_tilemapShader {0};
+        GLint        g_viewLocation {-1};
+        TilemapStats g_stats {};
+
+        Tilemap* GetTilemap(TilemapHandle handle)
+        {
+            if (!handle || handle > MAX_TILEMAPS || !g_tilemaps[handle - 1].used)
+            {
+                return nullptr;
+            }
+
+            return &g_tilemaps[handle - 1];
+        }
+
+        u16 ToUnorm16(f32 value)
+        {
+            return (u16) (value * 65535.f + 0.5f);
+        }
+
+        // Rewrites the whole slice of the chunk, empty tiles are skipped so it may draw less than CHUNK_TILES.
+        void RebuildChunk(Tilemap& map, u32 chunkX, u32 chunkY)
+        {
+            TileInstance instances[CHUNK_TILES];
+            u32          count {0};
+
+            u32 startX {chunkX * TILEMAP_CHUNK_SIZE};
+            u32 startY {chunkY * TILEMAP_CHUNK_SIZE};
+            u32 endX {startX + TILEMAP_CHUNK_SIZE < map.width ? startX + TILEMAP_CHUNK_SIZE : map.width};
+            u32 endY {startY + TILEMAP_CHUNK_SIZE < map.height ? startY + TILEMAP_CHUNK_SIZE : map.height};
+            for (u32 y {startY}; y < endY; ++y)
+            {
+                for (u32 x {startX}; x < endX; ++x)
+                {
+                    u16 tile {map.tiles[y * map.width + x]};
+                    if (tile == TILE_EMPTY || tile > map.regions.size())
+                    {
+                        continue;
+                    }
+
+                    const AtlasRegion& region {map.regions[tile - 1]};
+                    TileInstance&      instance {instances[count++]};
+                    instance.position[0] = (u16) x;
+                    instance.position[1] = (u16) y;
+                    instance.uv[0]       = ToUnorm16(region.uv[0]);
+                    instance.uv[1]       = ToUnorm16(region.uv[1]);
+                    instance.uv[2]       = ToUnorm16(region.uv[2]);
+                    instance.uv[3]       = ToUnorm16(region.uv[3]);
+                    instance.layer       = (u16) region.layer;
+                    instance.padding     = 0;
+                }
+            }
+
+            TileChunk& chunk {map.chunks[chunkY * map.chunksX + chunkX]};
+            if (count)
+            {
+                utils::Size offset {(utils::Size) (chunkY * map.chunksX + chunkX) * CHUNK_TILES * sizeof(TileInstance)};
+                glBindBuffer(GL_ARRAY_BUFFER, map.buffer);
+                glBufferSubData(GL_ARRAY_BUFFER, offset, count * sizeof(TileInstance), instances);
+                GpuMemoryTrackUpload(count * sizeof(TileInstance));
+            }
+            chunk.instanceCount = count;
+            chunk.dirty         = false;
+            g_stats.rebuiltChunks++;
+        }
+
+        // One buffer per map, the attributes are re-pointed at each chunk's slice before its draw.
+        void PointAttributes(GLuint buffer, utils::Size offset)
+        {
+            GLsizei stride {sizeof(TileInstance)};
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glVertexAttribPointer(0, 2, GL_UNSIGNED_SHORT, GL_FALSE, stride, (void*) (offset + offsetof(TileInstance, position)));
+            glVertexAttribPointer(1, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*) (offset + offsetof(TileInstance, uv)));
+            glVertexAttribPointer(2, 1, GL_UNSIGNED_SHORT, GL_FALSE, stride, (void*) (offset + offsetof(TileInstance, layer)));
+        }
+
+        void DrawTilemap(Tilemap& map, u32 viewWidth, u32 viewHeight)
+        {
+            // Visible tile rectangle, then the chunks that overlap it.
+            f32 tileSize {map.tileSize * map.zoom};
+            f32 firstX {floorf(map.scroll[0] / map.tileSize)};
+            f32 firstY {floorf(map.scroll[1] / map.tileSize)};
+            f32 lastX {ceilf((map.scroll[0] * map.zoom + viewWidth) / tileSize)};
+            f32 lastY {ceilf((map.scroll[1] * map.zoom + viewHeight) / tileSize)};
+            if (lastX <= 0.f || lastY <= 0.f || firstX >= (f32) map.width || firstY >= (f32) map.height)
+            {
+                return;
+            }
+
+            u32 chunkStartX {firstX > 0.f ? (u32) firstX / TILEMAP_CHUNK_SIZE : 0};
+            u32 chunkStartY {firstY > 0.f ? (u32) firstY / TILEMAP_CHUNK_SIZE : 0};
+            u32 chunkEndX {((u32) lastX + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE};
+            u32 chunkEndY {((u32) lastY + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE};
+            chunkEndX = chunkEndX < map.chunksX ? chunkEndX : map.chunksX;
+            chunkEndY = chunkEndY < map.chunksY ? chunkEndY : map.chunksY;
+
+            glUniform4f(g_viewLocation, map.scroll[0], map.scroll[1], map.zoom, map.tileSize);
+            for (u32 chunkY {chunkStartY}; chunkY < chunkEndY; ++chunkY)
+            {
+                for (u32 chunkX {chunkStartX}; chunkX < chunkEndX; ++chunkX)
+                {
+                    u32        index {chunkY * map.chunksX + chunkX};
+                    TileChunk& chunk {map.chunks[index]};
+                    if (chunk.dirty)
+                    {
+                        RebuildChunk(map, chunkX, chunkY);
+                    }
+
+                    g_stats.visibleChunks++;
+                    if (!chunk.instanceCount)
+                    {
+                        continue;
+                    }
+
+                    PointAttributes(map.buffer, (utils::Size) index * CHUNK_TILES * sizeof(TileInstance));
+                    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, chunk.instanceCount);
+                    g_stats.drawnTiles += chunk.instanceCount;
+                }
+            }
+        }
+    } // namespace anonymous
+
+    bool TilemapInit(utils::BumpAllocator* transientStorage)
+    {
+        g_tilemapShader = ShaderSubmit({"assets/shaders/tilemap.vert", "assets/shaders/tilemap.frag"}, transientStorage);
+        if (!g_tilemapShader)
+        {
+            D_ASSERT(false, "Failed to submit tilemap shader.");
+            return false;
+        }
+
+        glGenVertexArrays(1, &g_VAO);
+        glBindVertexArray(g_VAO);
+        TRACK_LEAK_ALLOC(&g_VAO, LeakType::OPENGL, "Tilemap VAO");
+        for (u32 i {0}; i < 3; ++i)
+        {
+            glEnableVertexAttribArray(i);
+            glVertexAttribDivisor(i, 1);
+        }
+        glBindVertexArray(0);
+
+        return true;
+    }
+
+    TilemapHandle TilemapCreate(const TilemapDesc& desc)
+    {
+        if (!desc.width || !desc.height || desc.width > 65535 || desc.height > 65535)
+        {
+            D_ASSERT(false, "Tilemap size must be between 1 and 65535 tiles.");
+            return 0;
+        }
+
+        u32         chunksX {(desc.width + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE};
+        u32         chunksY {(desc.height + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE};
+        utils::Size bytes {(utils::Size) chunksX * chunksY * CHUNK_TILES * sizeof(TileInstance)};
+        if (!GpuMemoryFitsBudget(bytes))
+        {
+            D_ERROR("Tilemap %ux%u does not fit the GPU memory budget.", desc.width, desc.height);
+            return 0;
+        }
+
+        u32 slot {0};
+        while (slot < MAX_TILEMAPS && g_tilemaps[slot].used)
+        {
+            ++slot;
+        }
+        if (slot == MAX_TILEMAPS)
+        {
+            D_ASSERT(false, "Too many tilemaps.");
+            return 0;
+        }
+
+        Tilemap& map {g_tilemaps[slot]};
+        map          = {};
+        map.used     = true;
+        map.width    = desc.width;
+        map.height   = desc.height;
+        map.chunksX  = chunksX;
+        map.chunksY  = chunksY;
+        map.tileSize = desc.tileSize;
+        map.tiles.assign((utils::Size) desc.width * desc.height, TILE_EMPTY);
+        map.regions.assign(desc.tiles, desc.tiles + desc.tileCount);
+        map.chunks.assign(map.chunksX * map.chunksY, TileChunk {});
+
+        // Edits are rare and partial, the storage is written in place and never reallocated.
+        glGenBuffers(1, &map.buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, map.buffer);
+        glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        TRACK_LEAK_ALLOC(&map.buffer, LeakType::OPENGL, "Tilemap buffer");
+        GpuMemoryTrackAlloc(map.buffer, GpuMemoryCategory::VERTEX_BUFFER, bytes);
+
+        return slot + 1;
+    }
+
+    void TilemapDestroy(TilemapHandle handle)
+    {
+        Tilemap* map {GetTilemap(handle)};
+        if (!map)
+        {
+            return;
+        }
+
+        GpuMemoryTrackFree(map->buffer, GpuMemoryCategory::VERTEX_BUFFER);
+        glDeleteBuffers(1, &map->buffer);
+        TRACK_LEAK_FREE(&map->buffer);
+        *map = {};
+    }
+
+    void TilemapSetTile(TilemapHandle handle, u32 x, u32 y, u16 tile)
+    {
+        Tilemap* map {GetTilemap(handle)};
+        if (!map || x >= map->width || y >= map->height)
+        {
+            return;
+        }
+
+        u16& current {map->tiles[y * map->width + x]};
+        if (current != tile)
+        {
+            current = tile;
+            map->chunks[(y / TILEMAP_CHUNK_SIZE) * map->chunksX + x / TILEMAP_CHUNK_SIZE].dirty = true;
+        }
+    }
+
+    u16 TilemapGetTile(TilemapHandle handle, u32 x, u32 y)
+    {
+        Tilemap* map {GetTilemap(handle)};
+        if (!map || x >= map->width || y >= map->height)
+        {
+            return TILE_EMPTY;
+        }
+
+        return map->tiles[y * map->width + x];
+    }
+
+    void TilemapFill(TilemapHandle handle, u32 x, u32 y, u32 width, u32 height, u16 tile)
+    {
+        for (u32 row {y}; row < y + height; ++row)
+        {
+            for (u32 column {x}; column < x + width; ++column)
+            {
+                TilemapSetTile(handle, column, row, tile);
+            }
+        }
+    }
+
+    void TilemapSetScroll(TilemapHandle handle, f32 x, f32 y, f32 zoom)
+    {
+        if (Tilemap* map {GetTilemap(handle)})
+        {
+            map->scroll[0] = x;
+            map->scroll[1] = y;
+            map->zoom      = zoom > 0.f ? zoom : 1.f;
+        }
+    }
+
+    void TilemapDrawAll(u32 viewWidth, u32 viewHeight)
+    {
+        g_stats = {};
+        for (const Tilemap& map : g_tilemaps)
+        {
+            g_stats.chunks += (u32) map.chunks.size();
+        }
+
+        if (!g_stats.chunks || !ShaderIsReady(g_tilemapShader))
+        {
+            return;
+        }
+
+        u32 program {ShaderGetProgram(g_tilemapShader)};
+        if (g_viewLocation < 0)
+        {
+            g_viewLocation = glGetUniformLocation(program, "view");
+        }
+
+        // Layered by creation order like sprites, not by depth.
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glUseProgram(program);
+        TextureAtlasBind(0);
+        glBindVertexArray(g_VAO);
+
+        for (Tilemap& map : g_tilemaps)
+        {
+            if (map.used)
+            {
+                DrawTilemap(map, viewWidth, viewHeight);
+            }
+        }
+
+        glBindVertexArray(0);
+        glDisable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+    }
+
+    TilemapStats TilemapGetStats()
+    {
+        return g_stats;
+    }
+
+    void TilemapShutdown()
+    {
+        for (u32 i {0}; i < MAX_TILEMAPS; ++i)
+        {
+            TilemapDestroy(i + 1);
+        }
+
+        if (g_VAO)
+        {
+            glDeleteVertexArrays(1, &g_VAO);
+            TRACK_LEAK_FREE(&g_VAO);
+            g_VAO = 0;
+        }
+
+        g_tilemapShader = 0;
+        g_viewLocation  = -1;
+        g_stats         = {};
+    }
+} // namespace drop::renderer
@@ -0,0 +1,145 @@
+#include "renderer/uniform_ring.hpp"
+#include "renderer/gl_loader.hpp"
+#include "renderer/gpu_memory.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace drop::renderer
+{
+    namespace
+    {
+        constexpr u32 UNIFORM_RING_FRAMES {3};
+
+        // Block names in GLSL, indexed by UniformBinding.
+        constexpr const Char* BLOCK_NAMES[UNIFORM_BINDING_COUNT] {
+            "FrameBlock",
+            "CameraBlock",
+            "MaterialBlock",
+        };
+
+        GLuint g_buffer {0};
+        u8*    g_staging {nullptr};
+        u32    g_bytesPerFrame {0};
+        u32    g_alignment {256}; // Worst case until the driver tells us.
+        u32    g_frameIndex {0};
+        u32    g_used {0};
+        bool   g_flushed {false};
+
+        u32 AlignUp(u32 value, u32 alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    } // namespace anonymous
+
+    bool UniformRingInit(u32 bytesPerFrame)
+    {
+        GLint alignment {0};
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        if (alignment > 0)
+        {
+            g_alignment = (u32) alignment;
+        }
+
+        g_bytesPerFrame = AlignUp(bytesPerFrame, g_alignment);
+        g_staging       = (u8*) malloc(g_bytesPerFrame);
+        if (!g_staging)
+        {
+            D_ASSERT(false, "Failed to allocate uniform staging memory.");
+            return false;
+        }
+        TRACK_LEAK_ALLOC(g_staging, LeakType::HEAP, "Uniform staging");
+
+        glGenBuffers(1, &g_buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, g_buffer);
+        glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr) g_bytesPerFrame * UNIFORM_RING_FRAMES, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        TRACK_LEAK_ALLOC(&g_buffer, LeakType::OPENGL, "Uniform ring buffer");
+        GpuMemoryTrackAlloc(g_buffer, GpuMemoryCategory::UNIFORM_BUFFER, (utils::Size) g_bytesPerFrame * UNIFORM_RING_FRAMES);
+
+        D_TRACE("Uniform ring: %u bytes per frame, %u byte alignment.", g_bytesPerFrame, g_alignment);
+        return true;
+    }
+
+    void UniformRingBeginFrame()
+    {
+        g_frameIndex = (g_frameIndex + 1) % UNIFORM_RING_FRAMES;
+        g_used       = 0;
+        g_flushed    = false;
+    }
+
+    UniformAllocation UniformRingAlloc(u32 bytes)
+    {
+        D_ASSERT(!g_flushed, "Uniform allocated after the frame was flushed.");
+
+        u32 offset {AlignUp(g_used, g_alignment)};
+        if (offset + bytes > g_bytesPerFrame)
+        {
+            D_ASSERT(false, "Uniform ring out of space: %u + %u > %u bytes.", offset, bytes, g_bytesPerFrame);
+            return {};
+        }
+        g_used = offset + bytes;
+
+        UniformAllocation allocation {};
+        allocation.data   = g_staging + offset;
+        allocation.offset = g_frameIndex * g_bytesPerFrame + offset;
+        allocation.size   = bytes;
+        return allocation;
+    }
+
+    void UniformRingFlush()
+    {
+        g_flushed = true;
+        if (!g_used)
+        {
+            return;
+        }
+
+        // One upload for everything the frame allocated. Draws recorded after this see the new data.
+        glBindBuffer(GL_UNIFORM_BUFFER, g_buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, (GLintptr) g_frameIndex * g_bytesPerFrame, g_used, g_staging);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        GpuMemoryTrackUpload(g_used);
+    }
+
+    void UniformRingBind(UniformBinding binding, const UniformAllocation& allocation)
+    {
+        if (!allocation.size)
+        {
+            return;
+        }
+
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, g_buffer, allocation.offset, allocation.size);
+    }
+
+    void UniformRingBindBlocks(u32 program)
+    {
+        // GLSL 330 has no layout(binding = N), so the blocks are bound by name after linking.
+        for (u32 i {0}; i < UNIFORM_BINDING_COUNT; ++i)
+        {
+            GLuint index {glGetUniformBlockIndex(program, BLOCK_NAMES[i])};
+            if (index != GL_INVALID_INDEX)
+            {
+                glUniformBlockBinding(program, index, i);
+            }
+        }
+    }
+
+    void UniformRingShutdown()
+    {
+        if (g_buffer)
+        {
+            GpuMemoryTrackFree(g_buffer, GpuMemoryCategory::UNIFORM_BUFFER);
+            glDeleteBuffers(1, &g_buffer);
+            TRACK_LEAK_FREE(&g_buffer);
+            g_buffer = 0;
+        }
+
+        if (g_staging)
+        {
+            TRACK_LEAK_FREE(g_staging);
+            free(g_staging);
+            g_staging = nullptr;
+        }
+    }
+} // namespace drop::renderer
@@ -1,7 +1,218 @@
 #include "shared/input.hpp"
 
+#include <cstring> // memset.
+
 namespace drop::shared
 {
+    namespace
+    {
+        bool TestBit(const u64* bits, u32 index)
+        {
+            return bits[index >> 6] & (1ull << (index & 63));
+        }
+
+        void SetBit(u64* bits, u32 index)
+        {
+            bits[index >> 6] |= 1ull << (index & 63);
+        }
+
+        void ClearBit(u64* bits, u32 index)
+        {
+            bits[index >> 6] &= ~(1ull << (index & 63));
+        }
+
+        InputEventListener g_listener {nullptr};
+        void*              g_listenerData {nullptr};
+
+        void ApplyEvent(const InputEvent& event)
+        {
+            switch (event.type)
+            {
+            case INPUT_EVENT_KEY_DOWN:
+            {
+                // Auto repeat keeps sending KEY_DOWN, only the first one is an edge.
+                if (!TestBit(g_input.keysDown, event.code))
+                {
+                    SetBit(g_input.keysDown, event.code);
+                    SetBit(g_input.keysPressed, event.code);
+                }
+                break;
+            }
+            case INPUT_EVENT_KEY_UP:
+            {
+                if (TestBit(g_input.keysDown, event.code))
+                {
+                    ClearBit(g_input.keysDown, event.code);
+                    SetBit(g_input.keysReleased, event.code);
+                }
+                break;
+            }
+            case INPUT_EVENT_MOUSE_MOVE:
+            {
+                // Without a previous position the delta would be the jump from wherever the pointer was last seen.
+                if (!g_input.hasRawMotion && g_input.hasMousePosition)
+                {
+                    g_input.mouseDeltaX += event.x - g_input.mouseX;
+                    g_input.mouseDeltaY += event.y - g_input.mouseY;
+                }
+                g_input.mouseX           = event.x;
+                g_input.mouseY           = event.y;
+                g_input.hasMousePosition = true;
+                break;
+            }
+            case INPUT_EVENT_MOUSE_RAW_MOTION:
+            {
+                g_input.hasRawMotion = true;
+                g_input.mouseDeltaX += event.x;
+                g_input.mouseDeltaY += event.y;
+                break;
+            }
+            case INPUT_EVENT_MOUSE_BUTTON_DOWN:
+            {
+                u8 bit {(u8) BIT(event.code)};
+                if (!(g_input.mouseButtonsDown & bit))
+                {
+                    g_input.mouseButtonsDown |= bit;
+                    g_input.mouseButtonsPressed |= bit;
+                }
+                break;
+            }
+            case INPUT_EVENT_MOUSE_BUTTON_UP:
+            {
+                u8 bit {(u8) BIT(event.code)};
+                if (g_input.mouseButtonsDown & bit)
+                {
+                    g_input.mouseButtonsDown &= ~bit;
+                    g_input.mouseButtonsReleased |= bit;
+                }
+                break;
+            }
+            case INPUT_EVENT_MOUSE_WHEEL:
+            {
+                g_input.mouseWheel += event.y;
+                break;
+            }
+            case INPUT_EVENT_FOCUS_LOST:
+            {
+                // We won't see the matching up events, so release everything now.
+                for (u32 i {0}; i < INPUT_KEY_WORDS; ++i)
+                {
+                    g_input.keysReleased[i] |= g_input.keysDown[i];
+                    g_input.keysDown[i] = 0;
+                }
+                g_input.mouseButtonsReleased |= g_input.mouseButtonsDown;
+                g_input.mouseButtonsDown = 0;
+                break;
+            }
+            case INPUT_EVENT_MOUSE_LEAVE:
+            {
+                g_input.hasMousePosition = false;
+                break;
+            }
+            default:
+                D_ASSERT(false, "Unknown input event type: %d", event.type);
+                break;
+            }
+        }
+    } // namespace anonymous
+
+    ScreenSize  g_screenSize {};
+    WindowState g_windowState {};
+    InputState  g_input {};
+
+    void RequestRedraw()
+    {
+        g_windowState.redrawRequested = true;
+    }
+
+    void InputBeginFrame()
+    {
+        memset(g_input.keysPressed, 0, sizeof(g_input.keysPressed));
+        memset(g_input.keysReleased, 0, sizeof(g_input.keysReleased));
+        g_input.mouseButtonsPressed  = 0;
+        g_input.mouseButtonsReleased = 0;
+        g_input.mouseDeltaX          = 0;
+        g_input.mouseDeltaY          = 0;
+        g_input.mouseWheel           = 0;
+        g_input.eventCount           = 0;
+        g_input.droppedEvents        = 0;
+    }
+
+    bool InputEventIsValid(const InputEvent& event)
+    {
+        // Codes index the key and button bit sets, one out of range would write past them.
+        switch (event.type)
+        {
+        case INPUT_EVENT_KEY_DOWN:
+        case INPUT_EVENT_KEY_UP:
+            return event.code < KEY_COUNT;
+        case INPUT_EVENT_MOUSE_BUTTON_DOWN:
+        case INPUT_EVENT_MOUSE_BUTTON_UP:
+            return event.code < MOUSE_BUTTON_COUNT;
+        default:
+            return event.type < INPUT_EVENT_COUNT;
+        }
+    }
+
+    void InputPushEvent(const InputEvent& event)
+    {
+        if (!InputEventIsValid(event))
+        {
+            D_ASSERT(false, "Invalid input event: type %d, code %u.", event.type, event.code);
+            return;
+        }
+
+        // State is always applied, only the per-frame log is bounded. The listener sees everything.
+        ApplyEvent(event);
+        RequestRedraw();
+        if (g_listener)
+        {
+            g_listener(event, g_listenerData);
+        }
+
+        if (g_input.eventCount < MAX_INPUT_EVENTS)
+        {
+            g_input.events[g_input.eventCount++] = event;
+        }
+        else
+        {
+            g_input.droppedEvents++;
+        }
+    }
+
+    void InputSetEventListener(InputEventListener listener, void* userData)
+    {
+        g_listener     = listener;
+        g_listenerData = userData;
+    }
+
+    bool IsKeyDown(KeyCode key)
+    {
+        return TestBit(g_input.keysDown, key);
+    }
+
+    bool IsKeyPressed(KeyCode key)
+    {
+        return TestBit(g_input.keysPressed, key);
+    }
+
+    bool IsKeyReleased(KeyCode key)
+    {
+        return TestBit(g_input.keysReleased, key);
+    }
+
+    bool IsMouseButtonDown(MouseButton button)
+    {
+        return g_input.mouseButtonsDown & BIT(button);
+    }
+
+    bool IsMouseButtonPressed(MouseButton button)
+    {
+        return g_input.mouseButtonsPressed & BIT(button);
+    }
 
-    ScreenSize g_screenSize {};
+    bool IsMouseButtonReleased(MouseButton button)
+    {
+        return g_input.mouseButtonsReleased & BIT(button);
+    }
 } // namespace drop::shared
@@ -0,0 +1,270 @@
+#include "shared/input_replay.hpp"
+#include "utils/file_io.hpp"
+#include "utils/timer.hpp"
+
+#include <cstring> // memcpy.
+
+// File layout, all integers are LEB128 varints unless noted:
+//   header: u32 magic, u16 version, u32 frameCount (fixed size, little endian)
+//   frame:  deltaNs, eventCount, events...
+//   event:  u8 type, u8 code, zigzag time offset from the previous event in microseconds,
+//           zigzag x and y for the mouse move / raw motion / wheel events only.
+
+namespace drop::shared
+{
+    namespace
+    {
+        constexpr u32 REPLAY_MAGIC {0x52505244}; // "DRPR".
+        constexpr u16 REPLAY_VERSION {1};
+        constexpr u32 REPLAY_HEADER_SIZE {sizeof(u32) + sizeof(u16) + sizeof(u32)};
+
+        void WriteVarint(std::vector<u8>& data, u64 value)
+        {
+            while (value >= 0x80)
+            {
+                data.push_back((u8) (value | 0x80));
+                value >>= 7;
+            }
+            data.push_back((u8) value);
+        }
+
+        void WriteZigzag(std::vector<u8>& data, i64 value)
+        {
+            WriteVarint(data, ((u64) value << 1) ^ (u64) (value >> 63));
+        }
+
+        bool ReadVarint(InputReplay* replay, u64* outValue)
+        {
+            u64 value {0};
+            for (u32 shift {0}; shift < 64; shift += 7)
+            {
+                if (replay->cursor >= replay->data.size())
+                {
+                    return false;
+                }
+
+                u8 byte {replay->data[replay->cursor++]};
+                value |= (u64) (byte & 0x7F) << shift;
+                if (!(byte & 0x80))
+                {
+                    *outValue = value;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        bool ReadZigzag(InputReplay* replay, i64* outValue)
+        {
+            u64 value {0};
+            if (!ReadVarint(replay, &value))
+            {
+                return false;
+            }
+
+            *outValue = (i64) (value >> 1) ^ -(i64) (value & 1);
+            return true;
+        }
+
+        bool ReadByte(InputReplay* replay, u8* outValue)
+        {
+            if (replay->cursor >= replay->data.size())
+            {
+                return false;
+            }
+
+            *outValue = replay->data[replay->cursor++];
+            return true;
+        }
+
+        void RecordEvent(const InputEvent& event, void* userData)
+        {
+            ((InputRecorder*) userData)->events.push_back(event);
+        }
+
+        bool HasPosition(InputEventType type)
+        {
+            return type == INPUT_EVENT_MOUSE_MOVE || type == INPUT_EVENT_MOUSE_RAW_MOTION || type == INPUT_EVENT_MOUSE_WHEEL;
+        }
+    } // namespace anonymous
+
+    bool InputRecorderBegin(InputRecorder* recorder, const Char* filePath)
+    {
+        D_ASSERT(recorder, "Recorder is null.");
+        D_ASSERT(filePath, "File path is null.");
+
+        recorder->data.clear();
+        recorder->data.resize(REPLAY_HEADER_SIZE);
+        recorder->data.reserve(MB(1));
+        recorder->events.clear();
+        recorder->filePath      = filePath;
+        recorder->frameCount    = 0;
+        recorder->lastFrameTime = utils::GetTimeNs();
+        recorder->active        = true;
+        InputSetEventListener(RecordEvent, recorder);
+
+        D_TRACE("Recording input to %s", filePath);
+        return true;
+    }
+
+    void InputRecorderFrame(InputRecorder* recorder, i64 frameDeltaNs)
+    {
+        if (!recorder->active)
+        {
+            return;
+        }
+
+        std::vector<u8>& data {recorder->data};
+        WriteVarint(data, (u64) frameDeltaNs);
+        WriteVarint(data, recorder->events.size());
+
+        i64 previousTime {recorder->lastFrameTime};
+        for (const InputEvent& event : recorder->events)
+        {
+            data.push_back(event.type);
+            data.push_back(event.code);
+            WriteZigzag(data, (event.timestamp - previousTime) / 1000);
+            if (HasPosition(event.type))
+            {
+                WriteZigzag(data, event.x);
+                WriteZigzag(data, event.y);
+            }
+
+            previousTime = event.timestamp;
+        }
+
+        recorder->events.clear();
+        recorder->lastFrameTime = utils::GetTimeNs();
+        recorder->frameCount++;
+    }
+
+    void InputRecorderEnd(InputRecorder* recorder)
+    {
+        if (!recorder->active)
+        {
+            return;
+        }
+
+        InputSetEventListener(nullptr, nullptr);
+
+        u8* header {recorder->data.data()};
+        memcpy(header, &REPLAY_MAGIC, sizeof(u32));
+        memcpy(header + sizeof(u32), &REPLAY_VERSION, sizeof(u16));
+        memcpy(header + sizeof(u32) + sizeof(u16), &recorder->frameCount, sizeof(u32));
+
+        utils::WriteFile((Char*) recorder->filePath, (Char*) recorder->data.data(), (i32) recorder->data.size());
+        D_TRACE("Recorded %u frames (%llu bytes) to %s", recorder->frameCount, (u64) recorder->data.size(), recorder->filePath);
+
+        recorder->data.clear();
+        recorder->data.shrink_to_fit();
+        recorder->active = false;
+    }
+
+    bool InputReplayBegin(InputReplay* replay, const Char* filePath)
+    {
+        D_ASSERT(replay, "Replay is null.");
+        D_ASSERT(filePath, "File path is null.");
+
+        i32 fileSize {utils::GetFileSize((Char*) filePath)};
+        if (fileSize < (i32) REPLAY_HEADER_SIZE)
+        {
+            D_ERROR("Replay file is missing or too small: %s", filePath);
+            return false;
+        }
+
+        replay->data.resize(fileSize + 1); // ReadFile adds a null terminator.
+        i32 readSize {0};
+        if (!utils::ReadFile((Char*) filePath, (Char*) replay->data.data(), &readSize))
+        {
+            return false;
+        }
+        replay->data.resize(readSize);
+
+        u32 magic {0};
+        u16 version {0};
+        memcpy(&magic, replay->data.data(), sizeof(u32));
+        memcpy(&version, replay->data.data() + sizeof(u32), sizeof(u16));
+        memcpy(&replay->frameCount, replay->data.data() + sizeof(u32) + sizeof(u16), sizeof(u32));
+        if (magic != REPLAY_MAGIC || version != REPLAY_VERSION)
+        {
+            D_ERROR("Not a replay file or unsupported version: %s", filePath);
+            replay->data.clear();
+            return false;
+        }
+
+        replay->cursor      = REPLAY_HEADER_SIZE;
+        replay->frame       = 0;
+        replay->virtualTime = 0;
+        replay->startTime   = utils::GetTimeNs();
+        replay->state       = InputState {};
+        replay->active      = true;
+
+        D_TRACE("Replaying %u frames from %s", replay->frameCount, filePath);
+        return true;
+    }
+
+    bool InputReplayFrame(InputReplay* replay, i64* outFrameDeltaNs)
+    {
+        if (!replay->active || replay->frame >= replay->frameCount)
+        {
+            return false;
+        }
+
+        // Whatever the platform pushed this frame is thrown away, the replayed state takes over.
+        g_input = replay->state;
+        InputBeginFrame();
+
+        u64 frameDeltaNs {0}, eventCount {0};
+        if (!ReadVarint(replay, &frameDeltaNs) || !ReadVarint(replay, &eventCount))
+        {
+            D_ERROR("Replay file is truncated at frame %u.", replay->frame);
+            replay->active = false;
+            return false;
+        }
+
+        i64 time {replay->virtualTime};
+        for (u64 i {0}; i < eventCount; ++i)
+        {
+            InputEvent event {};
+            u8         type {0};
+            i64        offset {0}, x {0}, y {0};
+            bool read {ReadByte(replay, &type) && ReadByte(replay, &event.code) && ReadZigzag(replay, &offset)};
+            event.type = (InputEventType) type;
+            if (!read || !InputEventIsValid(event) ||
+                (HasPosition(event.type) && (!ReadZigzag(replay, &x) || !ReadZigzag(replay, &y))))
+            {
+                D_ERROR("Replay file is corrupted at frame %u.", replay->frame);
+                replay->active = false;
+                return false;
+            }
+
+            time += offset * 1000;
+            event.timestamp = time;
+            event.x         = (i32) x;
+            event.y         = (i32) y;
+            InputPushEvent(event);
+        }
+
+        replay->virtualTime += frameDeltaNs;
+        replay->state = g_input;
+        replay->frame++;
+
+        *outFrameDeltaNs = (i64) frameDeltaNs;
+        return true;
+    }
+
+    void InputReplayEnd(InputReplay* replay)
+    {
+        if (!replay->data.empty())
+        {
+            f64 seconds {(utils::GetTimeNs() - replay->startTime) / 1e9};
+            D_TRACE("Replay finished: %u / %u frames in %.3f s, %.3f ms per frame.",
+                    replay->frame, replay->frameCount, seconds, replay->frame ? seconds * 1000.0 / replay->frame : 0.0);
+        }
+
+        replay->data.clear();
+        replay->data.shrink_to_fit();
+        replay->active = false;
+    }
+} // namespace drop::shared
@@ -1,6 +1,6 @@
 #include "utils/bump_allocator.hpp"
 
-#include <cstdlib> // malloc.
+#include <cstdlib> // malloc, free.
 #include <cstring> // memset.
 
 // C-style managed memory allocator.
@@ -44,4 +44,10 @@ namespace drop::utils
 
         return result;
     }
+
+    void FreeBumpAllocator(BumpAllocator* ba)
+    {
+        free(ba->memory);
+        *ba = {};
+    }
 } // namespace drop::utils
@@ -0,0 +1,26 @@
+#include "utils/cpu.hpp"
+
+namespace drop::utils
+{
+    namespace
+    {
+        CpuFeatures DetectCpuFeatures()
+        {
+            CpuFeatures features {};
+#ifdef D_SIMD_X86
+            __builtin_cpu_init();
+            features.sse2  = __builtin_cpu_supports("sse2");
+            features.ssse3 = __builtin_cpu_supports("ssse3");
+            features.sse41 = __builtin_cpu_supports("sse4.1");
+            features.avx2  = __builtin_cpu_supports("avx2");
+#endif // D_SIMD_X86
+            return features;
+        }
+    } // namespace anonymous
+
+    const CpuFeatures& GetCpuFeatures()
+    {
+        static const CpuFeatures features {DetectCpuFeatures()};
+        return features;
+    }
+} // namespace drop::utils
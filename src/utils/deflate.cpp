@@ -0,0 +1,508 @@
+#include "utils/deflate.hpp"
+
+#include <cstring>
+
+namespace drop::utils
+{
+    namespace
+    {
+        constexpr u32 FAST_BITS {9};
+        constexpr u32 MAX_CODE_LENGTH {15};
+        constexpr u32 MAX_LITERAL_CODES {288};
+        constexpr u32 MAX_DISTANCE_CODES {32};
+
+        constexpr u16 LENGTH_BASE[29] {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                       35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        constexpr u8  LENGTH_EXTRA[29] {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                       3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        constexpr u16 DISTANCE_BASE[30] {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                         193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                         6145, 8193, 12289, 16385, 24577};
+        constexpr u8  DISTANCE_EXTRA[30] {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                         6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+        constexpr u8  CODE_LENGTH_ORDER[19] {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+        struct BitReader
+        {
+            const u8* data {nullptr};
+            Size      size {0};
+            Size      position {0}; // Keeps counting past the end, the zeros fed there are padding.
+            u64       bits {0};
+            u32       count {0};
+        };
+
+        // Codes of up to FAST_BITS bits resolve with one lookup (symbol << 4 | length), longer ones
+        // walk the canonical counts one bit at a time.
+        struct Huffman
+        {
+            u16 fast[1 << FAST_BITS] {};
+            u16 counts[MAX_CODE_LENGTH + 1] {};
+            u16 symbols[MAX_LITERAL_CODES] {};
+        };
+
+        void Refill(BitReader& reader)
+        {
+            while (reader.count <= 56)
+            {
+                u64 byte {reader.position < reader.size ? reader.data[reader.position] : 0u};
+                reader.position++;
+                reader.bits |= byte << reader.count;
+                reader.count += 8;
+            }
+        }
+
+        u32 GetBits(BitReader& reader, u32 count)
+        {
+            if (!count)
+            {
+                return 0;
+            }
+            if (reader.count < count)
+            {
+                Refill(reader);
+            }
+
+            u32 value {(u32) (reader.bits & ((1ull << count) - 1))};
+            reader.bits >>= count;
+            reader.count -= count;
+            return value;
+        }
+
+        bool Overran(const BitReader& reader)
+        {
+            return reader.position - reader.count / 8 > reader.size;
+        }
+
+        u32 ReverseBits(u32 code, u32 length)
+        {
+            u32 reversed {0};
+            for (u32 i {0}; i < length; ++i)
+            {
+                reversed = (reversed << 1) | (code & 1);
+                code >>= 1;
+            }
+            return reversed;
+        }
+
+        bool BuildHuffman(Huffman& huffman, const u8* lengths, u32 count)
+        {
+            huffman = {};
+            for (u32 i {0}; i < count; ++i)
+            {
+                huffman.counts[lengths[i]]++;
+            }
+            huffman.counts[0] = 0;
+
+            i32 left {1};
+            for (u32 length {1}; length <= MAX_CODE_LENGTH; ++length)
+            {
+                left = (left << 1) - huffman.counts[length];
+                if (left < 0)
+                {
+                    return false; // Oversubscribed. Incomplete sets are legal (single distance code).
+                }
+            }
+
+            u16 offsets[MAX_CODE_LENGTH + 2] {};
+            u32 nextCode[MAX_CODE_LENGTH + 1] {};
+            u32 code {0};
+            for (u32 length {1}; length <= MAX_CODE_LENGTH; ++length)
+            {
+                offsets[length + 1] = offsets[length] + huffman.counts[length];
+                code                = (code + huffman.counts[length - 1]) << 1;
+                nextCode[length]    = code;
+            }
+
+            for (u32 symbol {0}; symbol < count; ++symbol)
+            {
+                u32 length {lengths[symbol]};
+                if (!length)
+                {
+                    continue;
+                }
+
+                huffman.symbols[offsets[length]++] = symbol;
+
+                u32 symbolCode {nextCode[length]++};
+                if (length <= FAST_BITS)
+                {
+                    for (u32 fill {ReverseBits(symbolCode, length)}; fill < (1u << FAST_BITS); fill += 1u << length)
+                    {
+                        huffman.fast[fill] = (u16) (symbol << 4 | length);
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        i32 Decode(BitReader& reader, const Huffman& huffman)
+        {
+            if (reader.count < MAX_CODE_LENGTH)
+            {
+                Refill(reader);
+            }
+
+            u16 entry {huffman.fast[reader.bits & ((1u << FAST_BITS) - 1)]};
+            if (entry)
+            {
+                u32 length {entry & 0xFu};
+                reader.bits >>= length;
+                reader.count -= length;
+                return entry >> 4;
+            }
+
+            // Canonical walk, codes come in MSB first.
+            i32 code {0};
+            i32 first {0};
+            i32 index {0};
+            for (u32 length {1}; length <= MAX_CODE_LENGTH; ++length)
+            {
+                code |= GetBits(reader, 1);
+                i32 count {huffman.counts[length]};
+                if (code - first < count)
+                {
+                    return huffman.symbols[index + code - first];
+                }
+                index += count;
+                first = (first + count) << 1;
+                code <<= 1;
+            }
+
+            return -1;
+        }
+
+        bool InflateBlock(BitReader& reader, const Huffman& literals, const Huffman& distances, u8* out, Size outCapacity, Size& outPosition)
+        {
+            while (true)
+            {
+                i32 symbol {Decode(reader, literals)};
+                if (symbol < 0)
+                {
+                    return false;
+                }
+
+                if (symbol < 256)
+                {
+                    if (outPosition == outCapacity)
+                    {
+                        return false;
+                    }
+                    out[outPosition++] = (u8) symbol;
+                    continue;
+                }
+
+                if (symbol == 256)
+                {
+                    return true;
+                }
+
+                symbol -= 257;
+                if (symbol >= 29)
+                {
+                    return false;
+                }
+                u32 length {LENGTH_BASE[symbol] + GetBits(reader, LENGTH_EXTRA[symbol])};
+
+                i32 distanceSymbol {Decode(reader, distances)};
+                if (distanceSymbol < 0 || distanceSymbol >= 30)
+                {
+                    return false;
+                }
+                Size distance {DISTANCE_BASE[distanceSymbol] + GetBits(reader, DISTANCE_EXTRA[distanceSymbol])};
+
+                if (distance > outPosition || length > outCapacity - outPosition)
+                {
+                    return false;
+                }
+
+                // Byte by byte, the ranges overlap whenever distance < length.
+                u8*       target {out + outPosition};
+                const u8* source {target - distance};
+                if (distance >= length)
+                {
+                    memcpy(target, source, length);
+                }
+                else
+                {
+                    for (u32 i {0}; i < length; ++i)
+                    {
+                        target[i] = source[i];
+                    }
+                }
+                outPosition += length;
+            }
+        }
+
+        bool ReadDynamicTables(BitReader& reader, Huffman& literals, Huffman& distances)
+        {
+            u32 literalCount {GetBits(reader, 5) + 257};
+            u32 distanceCount {GetBits(reader, 5) + 1};
+            u32 codeLengthCount {GetBits(reader, 4) + 4};
+            if (literalCount > 286 || distanceCount > 30)
+            {
+                return false;
+            }
+
+            u8 codeLengthLengths[19] {};
+            for (u32 i {0}; i < codeLengthCount; ++i)
+            {
+                codeLengthLengths[CODE_LENGTH_ORDER[i]] = (u8) GetBits(reader, 3);
+            }
+
+            Huffman codeLengths {};
+            if (!BuildHuffman(codeLengths, codeLengthLengths, 19))
+            {
+                return false;
+            }
+
+            u8  lengths[MAX_LITERAL_CODES + MAX_DISTANCE_CODES] {};
+            u32 total {literalCount + distanceCount};
+            for (u32 i {0}; i < total;)
+            {
+                i32 symbol {Decode(reader, codeLengths)};
+                if (symbol < 0)
+                {
+                    return false;
+                }
+
+                if (symbol < 16)
+                {
+                    lengths[i++] = (u8) symbol;
+                    continue;
+                }
+
+                u8  repeat {0};
+                u32 times {0};
+                if (symbol == 16)
+                {
+                    if (!i)
+                    {
+                        return false;
+                    }
+                    repeat = lengths[i - 1];
+                    times  = 3 + GetBits(reader, 2);
+                }
+                else if (symbol == 17)
+                {
+                    times = 3 + GetBits(reader, 3);
+                }
+                else
+                {
+                    times = 11 + GetBits(reader, 7);
+                }
+
+                if (i + times > total)
+                {
+                    return false;
+                }
+                memset(lengths + i, repeat, times);
+                i += times;
+            }
+
+            if (!lengths[256])
+            {
+                return false; // No end of block code.
+            }
+
+            return BuildHuffman(literals, lengths, literalCount) &&
+                   BuildHuffman(distances, lengths + literalCount, distanceCount);
+        }
+
+        void BuildFixedTables(Huffman& literals, Huffman& distances)
+        {
+            u8 lengths[MAX_LITERAL_CODES] {};
+            memset(lengths, 8, 144);
+            memset(lengths + 144, 9, 112);
+            memset(lengths + 256, 7, 24);
+            memset(lengths + 280, 8, 8);
+            BuildHuffman(literals, lengths, MAX_LITERAL_CODES);
+
+            memset(lengths, 5, 30);
+            BuildHuffman(distances, lengths, 30);
+        }
+
+        constexpr u32 MAX_STORED_BLOCK {65535};
+
+        struct Crc32Table
+        {
+            u32 entries[256] {};
+        };
+
+        constexpr Crc32Table MakeCrc32Table()
+        {
+            Crc32Table table {};
+            for (u32 i {0}; i < 256; ++i)
+            {
+                u32 crc {i};
+                for (u32 bit {0}; bit < 8; ++bit)
+                {
+                    crc = crc & 1 ? 0xEDB88320 ^ (crc >> 1) : crc >> 1;
+                }
+                table.entries[i] = crc;
+            }
+            return table;
+        }
+
+        constexpr Crc32Table CRC32_TABLE {MakeCrc32Table()};
+    } // namespace anonymous
+
+    bool Inflate(const u8* data, Size size, u8* out, Size outCapacity, Size* outSize)
+    {
+        D_ASSERT(outSize, "Size pointer is null.");
+
+        BitReader reader {};
+        reader.data = data;
+        reader.size = size;
+
+        Huffman literals {};
+        Huffman distances {};
+
+        Size outPosition {0};
+        bool final {false};
+        while (!final)
+        {
+            final = GetBits(reader, 1);
+            u32 type {GetBits(reader, 2)};
+
+            if (type == 0)
+            {
+                // Stored, realign to a byte boundary first.
+                GetBits(reader, reader.count % 8);
+                u32 length {GetBits(reader, 16)};
+                u32 inverted {GetBits(reader, 16)};
+                if ((length ^ 0xFFFF) != inverted || length > outCapacity - outPosition)
+                {
+                    return false;
+                }
+
+                for (u32 i {0}; i < length; ++i)
+                {
+                    out[outPosition++] = (u8) GetBits(reader, 8);
+                }
+            }
+            else if (type == 1 || type == 2)
+            {
+                if (type == 1)
+                {
+                    BuildFixedTables(literals, distances);
+                }
+                else if (!ReadDynamicTables(reader, literals, distances))
+                {
+                    return false;
+                }
+
+                if (!InflateBlock(reader, literals, distances, out, outCapacity, outPosition))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                return false;
+            }
+
+            if (Overran(reader))
+            {
+                return false;
+            }
+        }
+
+        *outSize = outPosition;
+        return true;
+    }
+
+    bool ZlibDecompress(const u8* data, Size size, u8* out, Size outCapacity, Size* outSize)
+    {
+        if (size < 6)
+        {
+            return false;
+        }
+
+        u8 cmf {data[0]};
+        u8 flg {data[1]};
+        if ((cmf & 0x0F) != 8 || ((cmf << 8) | flg) % 31 || (flg & 0x20))
+        {
+            return false; // Not DEFLATE, bad check bits or a preset dictionary.
+        }
+
+        if (!Inflate(data + 2, size - 6, out, outCapacity, outSize))
+        {
+            return false;
+        }
+
+        const u8* trailer {data + size - 4};
+        u32       expected {(u32) trailer[0] << 24 | (u32) trailer[1] << 16 | (u32) trailer[2] << 8 | trailer[3]};
+        return Adler32(out, *outSize) == expected;
+    }
+
+    Size ZlibStoredBound(Size size)
+    {
+        Size blocks {size ? (size + MAX_STORED_BLOCK - 1) / MAX_STORED_BLOCK : 1};
+        return 2 + blocks * 5 + size + 4;
+    }
+
+    Size ZlibCompressStored(const u8* data, Size size, u8* out)
+    {
+        u8* cursor {out};
+        *cursor++ = 0x78; // DEFLATE, 32K window.
+        *cursor++ = 0x01; // Fastest level, (0x78 << 8 | 0x01) % 31 == 0.
+
+        Size remaining {size};
+        do
+        {
+            u32 length {remaining < MAX_STORED_BLOCK ? (u32) remaining : MAX_STORED_BLOCK};
+            remaining -= length;
+
+            // Stored blocks are byte aligned, the 3 header bits fill a whole byte.
+            *cursor++ = remaining ? 0 : 1;
+            *cursor++ = (u8) length;
+            *cursor++ = (u8) (length >> 8);
+            *cursor++ = (u8) ~length;
+            *cursor++ = (u8) (~length >> 8);
+            memcpy(cursor, data, length);
+            cursor += length;
+            data += length;
+        } while (remaining);
+
+        u32 adler {Adler32(data - size, size)};
+        *cursor++ = (u8) (adler >> 24);
+        *cursor++ = (u8) (adler >> 16);
+        *cursor++ = (u8) (adler >> 8);
+        *cursor++ = (u8) adler;
+        return (Size) (cursor - out);
+    }
+
+    u32 Adler32(const u8* data, Size size)
+    {
+        constexpr u32 MOD_ADLER {65521};
+        constexpr u32 BLOCK {5552}; // Largest n with no u32 overflow before the modulo.
+
+        u32 a {1};
+        u32 b {0};
+        while (size)
+        {
+            u32 block {size < BLOCK ? (u32) size : BLOCK};
+            size -= block;
+            while (block--)
+            {
+                a += *data++;
+                b += a;
+            }
+            a %= MOD_ADLER;
+            b %= MOD_ADLER;
+        }
+
+        return b << 16 | a;
+    }
+
+    u32 Crc32(const u8* data, Size size, u32 crc)
+    {
+        crc = ~crc;
+        for (Size i {0}; i < size; ++i)
+        {
+            crc = CRC32_TABLE.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+} // namespace drop::utils
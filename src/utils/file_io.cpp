@@ -76,7 +76,7 @@ namespace drop::utils
         return file;
     }
 
-    void WriteFile(Char* filePath, Char* buffer, i32 size)
+    bool WriteFile(Char* filePath, Char* buffer, i32 size)
     {
         D_ASSERT(filePath, "File path is null.");
         D_ASSERT(buffer, "Buffer is null.");
@@ -85,10 +85,11 @@ namespace drop::utils
         if (!file)
         {
             D_ERROR("Failed to open file: %s", filePath);
-            return;
+            return false;
         }
 
         file.write(buffer, size);
+        return file.good();
     }
 
     bool CopyFile(Char* fileName, Char* destName, Char* buffer)
@@ -0,0 +1,841 @@
+#include "utils/image.hpp"
+#include "utils/cpu.hpp"
+#include "utils/deflate.hpp"
+#include "utils/file_io.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifdef D_SIMD_X86
+#include <immintrin.h>
+#endif // D_SIMD_X86
+
+namespace drop::utils
+{
+    namespace
+    {
+        constexpr u8 PNG_SIGNATURE[8] {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        constexpr u8 QOI_MAGIC[4] {'q', 'o', 'i', 'f'};
+
+        // Images beyond this are almost certainly corrupt headers, not textures.
+        constexpr u32 MAX_IMAGE_DIMENSION {16384};
+
+        enum PngColorType : u8
+        {
+            PNG_COLOR_GRAY       = 0,
+            PNG_COLOR_RGB        = 2,
+            PNG_COLOR_PALETTE    = 3,
+            PNG_COLOR_GRAY_ALPHA = 4,
+            PNG_COLOR_RGBA       = 6
+        };
+
+        enum PngFilter : u8
+        {
+            PNG_FILTER_NONE,
+            PNG_FILTER_SUB,
+            PNG_FILTER_UP,
+            PNG_FILTER_AVERAGE,
+            PNG_FILTER_PAETH
+        };
+
+        u32 ReadBE32(const u8* data)
+        {
+            return (u32) data[0] << 24 | (u32) data[1] << 16 | (u32) data[2] << 8 | data[3];
+        }
+
+        u8* WriteBE32(u8* out, u32 value)
+        {
+            out[0] = (u8) (value >> 24);
+            out[1] = (u8) (value >> 16);
+            out[2] = (u8) (value >> 8);
+            out[3] = (u8) value;
+            return out + 4;
+        }
+
+        bool AllocatePixels(Image* image, u32 width, u32 height)
+        {
+            if (!width || !height || width > MAX_IMAGE_DIMENSION || height > MAX_IMAGE_DIMENSION)
+            {
+                D_ERROR("Unsupported image size %ux%u.", width, height);
+                return false;
+            }
+
+            image->width  = width;
+            image->height = height;
+            image->pixels = (u8*) malloc((Size) width * height * 4);
+            if (!image->pixels)
+            {
+                D_ERROR("Failed to allocate %ux%u image.", width, height);
+                return false;
+            }
+            TRACK_LEAK_ALLOC(image->pixels, LeakType::HEAP, "Image pixels");
+            return true;
+        }
+
+        // --- QOI ---
+
+        bool DecodeQOI(const u8* data, Size size, Image* outImage)
+        {
+            constexpr Size HEADER_SIZE {14};
+            constexpr Size END_MARKER_SIZE {8};
+            if (size < HEADER_SIZE + END_MARKER_SIZE)
+            {
+                return false;
+            }
+
+            if (!AllocatePixels(outImage, ReadBE32(data + 4), ReadBE32(data + 8)))
+            {
+                return false;
+            }
+
+            u8  index[64][4] {};
+            u8  pixel[4] {0, 0, 0, 255};
+            u32 run {0};
+
+            const u8* cursor {data + HEADER_SIZE};
+            const u8* end {data + size - END_MARKER_SIZE};
+            u8*       out {outImage->pixels};
+            Size      pixelCount {(Size) outImage->width * outImage->height};
+            for (Size i {0}; i < pixelCount; ++i, out += 4)
+            {
+                if (run)
+                {
+                    run--;
+                }
+                else if (cursor < end)
+                {
+                    u8 op {*cursor++};
+                    if (op == 0xFE)
+                    {
+                        pixel[0] = cursor[0];
+                        pixel[1] = cursor[1];
+                        pixel[2] = cursor[2];
+                        cursor += 3;
+                    }
+                    else if (op == 0xFF)
+                    {
+                        memcpy(pixel, cursor, 4);
+                        cursor += 4;
+                    }
+                    else
+                    {
+                        switch (op >> 6)
+                        {
+                        case 0: // Index.
+                            memcpy(pixel, index[op], 4);
+                            break;
+                        case 1: // Small diff, -2..1 per channel.
+                            pixel[0] += ((op >> 4) & 3) - 2;
+                            pixel[1] += ((op >> 2) & 3) - 2;
+                            pixel[2] += (op & 3) - 2;
+                            break;
+                        case 2: // Luma, green diff with red and blue relative to it.
+                        {
+                            i32 greenDiff {(op & 0x3F) - 32};
+                            u8  next {*cursor++};
+                            pixel[0] += greenDiff - 8 + ((next >> 4) & 0x0F);
+                            pixel[1] += greenDiff;
+                            pixel[2] += greenDiff - 8 + (next & 0x0F);
+                            break;
+                        }
+                        case 3:
+                            run = op & 0x3F;
+                            break;
+                        }
+                    }
+
+                    memcpy(index[(pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64], pixel, 4);
+                }
+
+                memcpy(out, pixel, 4);
+            }
+
+            return true;
+        }
+
+        // --- PNG filters ---
+        // Every row is unfiltered in place, prior points at the already unfiltered row above.
+        // Sub, Average and Paeth depend on the pixel to the left, so they are vectorized across
+        // the channels of one pixel, Up has no such dependency and runs 16 bytes at a time.
+
+        void UnfilterScalar(u8 filter, u8* row, const u8* prior, u32 stride, u32 bpp)
+        {
+            switch (filter)
+            {
+            case PNG_FILTER_SUB:
+                for (u32 i {bpp}; i < stride; ++i)
+                {
+                    row[i] += row[i - bpp];
+                }
+                break;
+            case PNG_FILTER_UP:
+                for (u32 i {0}; i < stride; ++i)
+                {
+                    row[i] += prior[i];
+                }
+                break;
+            case PNG_FILTER_AVERAGE:
+                for (u32 i {0}; i < stride; ++i)
+                {
+                    u32 left {i >= bpp ? row[i - bpp] : 0u};
+                    row[i] += (u8) ((left + prior[i]) >> 1);
+                }
+                break;
+            case PNG_FILTER_PAETH:
+                for (u32 i {0}; i < stride; ++i)
+                {
+                    i32 a {i >= bpp ? row[i - bpp] : 0};
+                    i32 b {prior[i]};
+                    i32 c {i >= bpp ? prior[i - bpp] : 0};
+                    i32 p {a + b - c};
+                    i32 pa {abs(p - a)};
+                    i32 pb {abs(p - b)};
+                    i32 pc {abs(p - c)};
+                    row[i] += (u8) (pa <= pb && pa <= pc ? a : (pb <= pc ? b : c));
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+#ifdef D_SIMD_X86
+        D_TARGET("sse2") __m128i LoadPixel(const u8* pixel, u32 bpp)
+        {
+            i32 value {0};
+            memcpy(&value, pixel, bpp);
+            return _mm_cvtsi32_si128(value);
+        }
+
+        D_TARGET("sse2") void StorePixel(u8* pixel, __m128i value, u32 bpp)
+        {
+            i32 packed {_mm_cvtsi128_si32(value)};
+            memcpy(pixel, &packed, bpp);
+        }
+
+        D_TARGET("sse2") __m128i Select(__m128i mask, __m128i a, __m128i b)
+        {
+            return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+        }
+
+        D_TARGET("sse2") __m128i Abs16(__m128i value)
+        {
+            return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+        }
+
+        // 3 and 4 bytes per pixel only, the other layouts are rare enough for the scalar path.
+        D_TARGET("sse2") void UnfilterSSE2(u8 filter, u8* row, const u8* prior, u32 stride, u32 bpp)
+        {
+            const __m128i zero {_mm_setzero_si128()};
+            switch (filter)
+            {
+            case PNG_FILTER_SUB:
+            {
+                __m128i left {zero};
+                for (u32 i {0}; i < stride; i += bpp)
+                {
+                    left = _mm_add_epi8(LoadPixel(row + i, bpp), left);
+                    StorePixel(row + i, left, bpp);
+                }
+                break;
+            }
+            case PNG_FILTER_UP:
+            {
+                u32 i {0};
+                for (; i + 16 <= stride; i += 16)
+                {
+                    __m128i value {_mm_loadu_si128((const __m128i*) (row + i))};
+                    __m128i above {_mm_loadu_si128((const __m128i*) (prior + i))};
+                    _mm_storeu_si128((__m128i*) (row + i), _mm_add_epi8(value, above));
+                }
+                for (; i < stride; ++i)
+                {
+                    row[i] += prior[i];
+                }
+                break;
+            }
+            case PNG_FILTER_AVERAGE:
+            {
+                // avg_epu8 rounds up, PNG wants floor: subtract the carried low bit.
+                const __m128i one {_mm_set1_epi8(1)};
+                __m128i       left {zero};
+                for (u32 i {0}; i < stride; i += bpp)
+                {
+                    __m128i above {LoadPixel(prior + i, bpp)};
+                    __m128i average {_mm_sub_epi8(_mm_avg_epu8(left, above), _mm_and_si128(_mm_xor_si128(left, above), one))};
+                    left = _mm_add_epi8(LoadPixel(row + i, bpp), average);
+                    StorePixel(row + i, left, bpp);
+                }
+                break;
+            }
+            case PNG_FILTER_PAETH:
+            {
+                // In 16 bit lanes: pa = |b - c|, pb = |a - c|, pc = |a + b - 2c|.
+                __m128i a {zero};
+                __m128i c {zero};
+                for (u32 i {0}; i < stride; i += bpp)
+                {
+                    __m128i b {_mm_unpacklo_epi8(LoadPixel(prior + i, bpp), zero)};
+                    __m128i pa {_mm_sub_epi16(b, c)};
+                    __m128i pb {_mm_sub_epi16(a, c)};
+                    __m128i pc {Abs16(_mm_add_epi16(pa, pb))};
+                    pa = Abs16(pa);
+                    pb = Abs16(pb);
+
+                    __m128i smallest {_mm_min_epi16(pc, _mm_min_epi16(pa, pb))};
+                    __m128i predictor {Select(_mm_cmpeq_epi16(smallest, pb), b, c)};
+                    predictor = Select(_mm_cmpeq_epi16(smallest, pa), a, predictor);
+
+                    __m128i value {_mm_add_epi8(LoadPixel(row + i, bpp), _mm_packus_epi16(predictor, predictor))};
+                    StorePixel(row + i, value, bpp);
+
+                    c = b;
+                    a = _mm_unpacklo_epi8(value, zero);
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+        // Four RGB pixels (12 bytes) into four RGBA pixels per shuffle.
+        D_TARGET("ssse3") void ExpandRGBSSSE3(const u8* source, u8* out, u32 width)
+        {
+            const __m128i shuffle {_mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1)};
+            const __m128i alpha {_mm_set1_epi32((i32) 0xFF000000)};
+
+            u32 x {0};
+            // The 16 byte load reads 4 bytes past the 4 pixels, keep it inside the row.
+            for (; x + 6 <= width; x += 4)
+            {
+                __m128i rgb {_mm_loadu_si128((const __m128i*) (source + x * 3))};
+                _mm_storeu_si128((__m128i*) (out + x * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+            }
+            for (; x < width; ++x)
+            {
+                out[x * 4 + 0] = source[x * 3 + 0];
+                out[x * 4 + 1] = source[x * 3 + 1];
+                out[x * 4 + 2] = source[x * 3 + 2];
+                out[x * 4 + 3] = 255;
+            }
+        }
+
+        // Sixteen gray pixels into sixteen RGBA pixels.
+        D_TARGET("sse2") void ExpandGraySSE2(const u8* source, u8* out, u32 width)
+        {
+            const __m128i alpha {_mm_set1_epi32((i32) 0xFF000000)};
+
+            u32 x {0};
+            for (; x + 16 <= width; x += 16)
+            {
+                __m128i gray {_mm_loadu_si128((const __m128i*) (source + x))};
+                __m128i low {_mm_unpacklo_epi8(gray, gray)};
+                __m128i high {_mm_unpackhi_epi8(gray, gray)};
+                __m128i* target {(__m128i*) (out + x * 4)};
+                _mm_storeu_si128(target + 0, _mm_or_si128(_mm_unpacklo_epi16(low, low), alpha));
+                _mm_storeu_si128(target + 1, _mm_or_si128(_mm_unpackhi_epi16(low, low), alpha));
+                _mm_storeu_si128(target + 2, _mm_or_si128(_mm_unpacklo_epi16(high, high), alpha));
+                _mm_storeu_si128(target + 3, _mm_or_si128(_mm_unpackhi_epi16(high, high), alpha));
+            }
+            for (; x < width; ++x)
+            {
+                memset(out + x * 4, source[x], 3);
+                out[x * 4 + 3] = 255;
+            }
+        }
+#endif // D_SIMD_X86
+
+        void Unfilter(u8 filter, u8* row, const u8* prior, u32 stride, u32 bpp)
+        {
+#ifdef D_SIMD_X86
+            if ((bpp == 3 || bpp == 4) && GetCpuFeatures().sse2)
+            {
+                UnfilterSSE2(filter, row, prior, stride, bpp);
+                return;
+            }
+#endif // D_SIMD_X86
+            UnfilterScalar(filter, row, prior, stride, bpp);
+        }
+
+        // --- PNG color conversion ---
+
+        struct PngInfo
+        {
+            u32  width {0};
+            u32  height {0};
+            u8   colorType {0};
+            u32  channels {0};
+            u8   palette[256][4] {};
+            bool hasColorKey {false};
+            u8   colorKey[3] {}; // tRNS for gray / RGB, 8 bit samples.
+        };
+
+        void ConvertRow(const PngInfo& info, const u8* source, u8* out)
+        {
+            u32 width {info.width};
+            switch (info.colorType)
+            {
+            case PNG_COLOR_RGBA:
+                memcpy(out, source, (Size) width * 4);
+                return;
+            case PNG_COLOR_RGB:
+#ifdef D_SIMD_X86
+                if (GetCpuFeatures().ssse3)
+                {
+                    ExpandRGBSSSE3(source, out, width);
+                    break;
+                }
+#endif // D_SIMD_X86
+                for (u32 x {0}; x < width; ++x)
+                {
+                    out[x * 4 + 0] = source[x * 3 + 0];
+                    out[x * 4 + 1] = source[x * 3 + 1];
+                    out[x * 4 + 2] = source[x * 3 + 2];
+                    out[x * 4 + 3] = 255;
+                }
+                break;
+            case PNG_COLOR_GRAY:
+#ifdef D_SIMD_X86
+                if (GetCpuFeatures().sse2)
+                {
+                    ExpandGraySSE2(source, out, width);
+                    break;
+                }
+#endif // D_SIMD_X86
+                for (u32 x {0}; x < width; ++x)
+                {
+                    memset(out + x * 4, source[x], 3);
+                    out[x * 4 + 3] = 255;
+                }
+                break;
+            case PNG_COLOR_GRAY_ALPHA:
+                for (u32 x {0}; x < width; ++x)
+                {
+                    memset(out + x * 4, source[x * 2], 3);
+                    out[x * 4 + 3] = source[x * 2 + 1];
+                }
+                return;
+            case PNG_COLOR_PALETTE:
+                for (u32 x {0}; x < width; ++x)
+                {
+                    memcpy(out + x * 4, info.palette[source[x]], 4);
+                }
+                return;
+            default:
+                return;
+            }
+
+            if (info.hasColorKey)
+            {
+                for (u32 x {0}; x < width; ++x)
+                {
+                    u8* pixel {out + x * 4};
+                    if (pixel[0] == info.colorKey[0] && pixel[1] == info.colorKey[1] && pixel[2] == info.colorKey[2])
+                    {
+                        pixel[3] = 0;
+                    }
+                }
+            }
+        }
+
+        bool DecodePNG(const u8* data, Size size, Image* outImage)
+        {
+            PngInfo         info {};
+            std::vector<u8> compressed;
+            bool            hasHeader {false};
+
+            for (u32 i {0}; i < 256; ++i)
+            {
+                info.palette[i][3] = 255;
+            }
+
+            Size cursor {sizeof(PNG_SIGNATURE)};
+            while (cursor + 12 <= size)
+            {
+                u32       length {ReadBE32(data + cursor)};
+                const u8* type {data + cursor + 4};
+                const u8* chunk {data + cursor + 8};
+                if (length > size - cursor - 12)
+                {
+                    D_ERROR("Truncated PNG chunk.");
+                    return false;
+                }
+                cursor += 12 + (Size) length; // CRCs are not checked, a bad file fails in inflate.
+
+                if (!memcmp(type, "IHDR", 4) && length >= 13)
+                {
+                    info.width     = ReadBE32(chunk);
+                    info.height    = ReadBE32(chunk + 4);
+                    info.colorType = chunk[9];
+
+                    u8 bitDepth {chunk[8]};
+                    u8 interlace {chunk[12]};
+                    if (bitDepth != 8 || interlace)
+                    {
+                        D_ERROR("Unsupported PNG: bit depth %u, interlace %u. Re-export as 8 bit, non-interlaced.", bitDepth, interlace);
+                        return false;
+                    }
+
+                    switch (info.colorType)
+                    {
+                    case PNG_COLOR_GRAY:
+                    case PNG_COLOR_PALETTE:
+                        info.channels = 1;
+                        break;
+                    case PNG_COLOR_GRAY_ALPHA:
+                        info.channels = 2;
+                        break;
+                    case PNG_COLOR_RGB:
+                        info.channels = 3;
+                        break;
+                    case PNG_COLOR_RGBA:
+                        info.channels = 4;
+                        break;
+                    default:
+                        D_ERROR("Unknown PNG color type %u.", info.colorType);
+                        return false;
+                    }
+                    hasHeader = true;
+                }
+                else if (!memcmp(type, "PLTE", 4))
+                {
+                    for (u32 i {0}; i < length / 3 && i < 256; ++i)
+                    {
+                        memcpy(info.palette[i], chunk + i * 3, 3);
+                    }
+                }
+                else if (!memcmp(type, "tRNS", 4))
+                {
+                    if (info.colorType == PNG_COLOR_PALETTE)
+                    {
+                        for (u32 i {0}; i < length && i < 256; ++i)
+                        {
+                            info.palette[i][3] = chunk[i];
+                        }
+                    }
+                    else if (info.colorType == PNG_COLOR_GRAY && length >= 2)
+                    {
+                        info.hasColorKey = true;
+                        memset(info.colorKey, chunk[1], 3);
+                    }
+                    else if (info.colorType == PNG_COLOR_RGB && length >= 6)
+                    {
+                        info.hasColorKey = true;
+                        info.colorKey[0] = chunk[1];
+                        info.colorKey[1] = chunk[3];
+                        info.colorKey[2] = chunk[5];
+                    }
+                }
+                else if (!memcmp(type, "IDAT", 4))
+                {
+                    compressed.insert(compressed.end(), chunk, chunk + length);
+                }
+                else if (!memcmp(type, "IEND", 4))
+                {
+                    break;
+                }
+            }
+
+            if (!hasHeader || compressed.empty())
+            {
+                D_ERROR("PNG has no header or no image data.");
+                return false;
+            }
+
+            if (!AllocatePixels(outImage, info.width, info.height))
+            {
+                return false;
+            }
+
+            // One filter byte in front of every row.
+            Size            stride {(Size) info.width * info.channels};
+            Size            rawSize {(stride + 1) * info.height};
+            std::vector<u8> raw(rawSize);
+            Size            inflated {0};
+            if (!ZlibDecompress(compressed.data(), compressed.size(), raw.data(), rawSize, &inflated) || inflated != rawSize)
+            {
+                D_ERROR("Corrupt PNG image data.");
+                ImageFree(outImage);
+                return false;
+            }
+
+            std::vector<u8> zeroRow(stride);
+            const u8*       prior {zeroRow.data()};
+            for (u32 y {0}; y < info.height; ++y)
+            {
+                u8* line {raw.data() + y * (stride + 1)};
+                u8* row {line + 1};
+                if (line[0] > PNG_FILTER_PAETH)
+                {
+                    D_ERROR("Unknown PNG filter %u.", line[0]);
+                    ImageFree(outImage);
+                    return false;
+                }
+
+                Unfilter(line[0], row, prior, (u32) stride, info.channels);
+                ConvertRow(info, row, outImage->pixels + (Size) y * info.width * 4);
+                prior = row;
+            }
+
+            return true;
+        }
+
+        // --- Encoders ---
+
+        constexpr Size QOI_HEADER_SIZE {14};
+        constexpr Size QOI_END_MARKER_SIZE {8};
+        constexpr Size PNG_CHUNK_OVERHEAD {12}; // Length, type and CRC.
+        constexpr Size PNG_IHDR_SIZE {13};
+
+        Size PngScanlineBytes(u32 width, u32 height)
+        {
+            return (Size) height * (1 + (Size) width * 4); // Filter byte per row.
+        }
+
+        Size EncodeQOI(const Image* image, u8* out)
+        {
+            u8* cursor {out};
+            memcpy(cursor, QOI_MAGIC, sizeof(QOI_MAGIC));
+            cursor = WriteBE32(cursor + 4, image->width);
+            cursor = WriteBE32(cursor, image->height);
+            *cursor++ = 4; // RGBA.
+            *cursor++ = 0; // sRGB with linear alpha.
+
+            u8  index[64][4] {};
+            u8  previous[4] {0, 0, 0, 255};
+            u32 run {0};
+
+            const u8* pixel {image->pixels};
+            Size      pixelCount {(Size) image->width * image->height};
+            for (Size i {0}; i < pixelCount; ++i, pixel += 4)
+            {
+                if (!memcmp(pixel, previous, 4))
+                {
+                    // Runs stop at 62, 0xFE and 0xFF are the RGB and RGBA tags.
+                    if (++run == 62 || i + 1 == pixelCount)
+                    {
+                        *cursor++ = (u8) (0xC0 | (run - 1));
+                        run       = 0;
+                    }
+                    continue;
+                }
+
+                if (run)
+                {
+                    *cursor++ = (u8) (0xC0 | (run - 1));
+                    run       = 0;
+                }
+
+                u32 slot {(pixel[0] * 3u + pixel[1] * 5u + pixel[2] * 7u + pixel[3] * 11u) % 64};
+                if (!memcmp(index[slot], pixel, 4))
+                {
+                    *cursor++ = (u8) slot;
+                }
+                else if (pixel[3] != previous[3])
+                {
+                    *cursor++ = 0xFF;
+                    memcpy(cursor, pixel, 4);
+                    cursor += 4;
+                }
+                else
+                {
+                    i8 dr {(i8) (pixel[0] - previous[0])};
+                    i8 dg {(i8) (pixel[1] - previous[1])};
+                    i8 db {(i8) (pixel[2] - previous[2])};
+                    i8 drg {(i8) (dr - dg)};
+                    i8 dbg {(i8) (db - dg)};
+                    if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+                    {
+                        *cursor++ = (u8) (0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                    }
+                    else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7)
+                    {
+                        *cursor++ = (u8) (0x80 | (dg + 32));
+                        *cursor++ = (u8) ((drg + 8) << 4 | (dbg + 8));
+                    }
+                    else
+                    {
+                        *cursor++ = 0xFE;
+                        memcpy(cursor, pixel, 3);
+                        cursor += 3;
+                    }
+                }
+
+                memcpy(index[slot], pixel, 4);
+                memcpy(previous, pixel, 4);
+            }
+
+            memset(cursor, 0, QOI_END_MARKER_SIZE - 1);
+            cursor[QOI_END_MARKER_SIZE - 1] = 1;
+            return (Size) (cursor + QOI_END_MARKER_SIZE - out);
+        }
+
+        u8* BeginPngChunk(u8* out, const Char* type, u32 length)
+        {
+            out = WriteBE32(out, length);
+            memcpy(out, type, 4);
+            return out + 4;
+        }
+
+        // The CRC covers the type and the data, chunk points at the type.
+        u8* EndPngChunk(u8* chunk, u8* end)
+        {
+            return WriteBE32(end, Crc32(chunk, (Size) (end - chunk)));
+        }
+
+        Size EncodePNG(const Image* image, u8* out)
+        {
+            // Filter 0 on every row, the data is not compressed so predicting it buys nothing.
+            Size scanlineBytes {PngScanlineBytes(image->width, image->height)};
+            u8*  scanlines {(u8*) malloc(scanlineBytes)};
+            if (!scanlines)
+            {
+                D_ERROR("Failed to allocate %ux%u PNG scanlines.", image->width, image->height);
+                return 0;
+            }
+
+            Size rowBytes {(Size) image->width * 4};
+            for (u32 y {0}; y < image->height; ++y)
+            {
+                u8* row {scanlines + y * (rowBytes + 1)};
+                row[0] = PNG_FILTER_NONE;
+                memcpy(row + 1, image->pixels + y * rowBytes, rowBytes);
+            }
+
+            u8* cursor {out};
+            memcpy(cursor, PNG_SIGNATURE, sizeof(PNG_SIGNATURE));
+            cursor += sizeof(PNG_SIGNATURE);
+
+            u8* chunk {cursor + 4};
+            cursor    = BeginPngChunk(cursor, "IHDR", PNG_IHDR_SIZE);
+            cursor    = WriteBE32(cursor, image->width);
+            cursor    = WriteBE32(cursor, image->height);
+            *cursor++ = 8; // Bit depth.
+            *cursor++ = PNG_COLOR_RGBA;
+            *cursor++ = 0; // Compression, filter and interlace methods.
+            *cursor++ = 0;
+            *cursor++ = 0;
+            cursor    = EndPngChunk(chunk, cursor);
+
+            chunk           = cursor + 4;
+            Size dataLength {ZlibStoredBound(scanlineBytes)};
+            cursor          = BeginPngChunk(cursor, "IDAT", (u32) dataLength);
+            cursor += ZlibCompressStored(scanlines, scanlineBytes, cursor);
+            cursor = EndPngChunk(chunk, cursor);
+            free(scanlines);
+
+            chunk  = cursor + 4;
+            cursor = BeginPngChunk(cursor, "IEND", 0);
+            cursor = EndPngChunk(chunk, cursor);
+            return (Size) (cursor - out);
+        }
+    } // namespace anonymous
+
+    bool ImageDecode(const u8* data, Size size, Image* outImage)
+    {
+        D_ASSERT(outImage, "Image pointer is null.");
+
+        *outImage = {};
+        if (size >= sizeof(PNG_SIGNATURE) && !memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)))
+        {
+            return DecodePNG(data, size, outImage);
+        }
+
+        if (size >= sizeof(QOI_MAGIC) && !memcmp(data, QOI_MAGIC, sizeof(QOI_MAGIC)))
+        {
+            return DecodeQOI(data, size, outImage);
+        }
+
+        D_ERROR("Unknown image format.");
+        return false;
+    }
+
+    bool ImageLoad(const Char* filePath, Image* outImage)
+    {
+        // Own heap buffer, the bump allocators belong to the main thread.
+        i32 fileSize {GetFileSize((Char*) filePath)};
+        if (fileSize <= 0)
+        {
+            return false;
+        }
+
+        Char* buffer {(Char*) malloc(fileSize + 1)};
+        if (!buffer)
+        {
+            return false;
+        }
+
+        bool decoded {false};
+        if (ReadFile((Char*) filePath, buffer, &fileSize))
+        {
+            decoded = ImageDecode((const u8*) buffer, fileSize, outImage);
+        }
+        free(buffer);
+
+        if (!decoded)
+        {
+            D_ERROR("Failed to load image: %s", filePath);
+        }
+        return decoded;
+    }
+
+    void ImageFree(Image* image)
+    {
+        if (image->pixels)
+        {
+            TRACK_LEAK_FREE(image->pixels);
+            free(image->pixels);
+        }
+        *image = {};
+    }
+
+    Size ImageEncodeBound(ImageFormat format, u32 width, u32 height)
+    {
+        if (format == ImageFormat::QOI)
+        {
+            // Worst case is every pixel as a 5 byte RGBA op.
+            return QOI_HEADER_SIZE + (Size) width * height * 5 + QOI_END_MARKER_SIZE;
+        }
+
+        return sizeof(PNG_SIGNATURE) + PNG_CHUNK_OVERHEAD * 3 + PNG_IHDR_SIZE + ZlibStoredBound(PngScanlineBytes(width, height));
+    }
+
+    bool ImageEncode(ImageFormat format, const Image* image, u8* out, Size outCapacity, Size* outSize)
+    {
+        D_ASSERT(image && image->pixels, "Image is empty.");
+        D_ASSERT(outSize, "Size pointer is null.");
+
+        *outSize = 0;
+        if (outCapacity < ImageEncodeBound(format, image->width, image->height))
+        {
+            D_ERROR("Encode buffer too small for %ux%u image.", image->width, image->height);
+            return false;
+        }
+
+        *outSize = format == ImageFormat::QOI ? EncodeQOI(image, out) : EncodePNG(image, out);
+        return *outSize != 0;
+    }
+
+    bool ImageSave(const Char* filePath, const Image* image, ImageFormat format)
+    {
+        // Own heap buffer, same as ImageLoad.
+        Size capacity {ImageEncodeBound(format, image->width, image->height)};
+        u8*  buffer {(u8*) malloc(capacity)};
+        if (!buffer)
+        {
+            return false;
+        }
+
+        Size size {0};
+        bool saved {ImageEncode(format, image, buffer, capacity, &size) && WriteFile((Char*) filePath, (Char*) buffer, (i32) size)};
+        free(buffer);
+
+        if (!saved)
+        {
+            D_ERROR("Failed to save image: %s", filePath);
+        }
+        return saved;
+    }
+} // namespace drop::utils
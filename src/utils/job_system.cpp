@@ -0,0 +1,158 @@
+#include "utils/job_system.hpp"
+#include "utils/profiler.hpp"
+#include "utils/sampling_profiler.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace drop::utils
+{
+    namespace
+    {
+        struct Job
+        {
+            JobFunction function {nullptr};
+            void*       userData {nullptr};
+            JobCounter* counter {nullptr};
+        };
+
+        std::vector<std::thread> g_workers;
+        std::deque<Job>          g_queue;
+        std::mutex               g_queueMutex;
+        std::condition_variable  g_queueCondition;
+        bool                     g_stopping {false};
+
+        void Run(const Job& job)
+        {
+            PROFILE_SCOPE("Job");
+            job.function(job.userData);
+            if (job.counter)
+            {
+                job.counter->pending.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        bool TryPop(Job* outJob)
+        {
+            std::lock_guard<std::mutex> lock(g_queueMutex);
+            if (g_queue.empty())
+            {
+                return false;
+            }
+
+            *outJob = g_queue.front();
+            g_queue.pop_front();
+            return true;
+        }
+
+        void WorkerLoop()
+        {
+            PROFILE_THREAD("Job worker");
+            SamplingProfilerRegisterThread("Job worker");
+            while (true)
+            {
+                Job job {};
+                {
+                    std::unique_lock<std::mutex> lock(g_queueMutex);
+                    g_queueCondition.wait(lock, [] { return g_stopping || !g_queue.empty(); });
+                    if (g_queue.empty())
+                    {
+                        return; // Stopping and drained.
+                    }
+
+                    job = g_queue.front();
+                    g_queue.pop_front();
+                }
+
+                Run(job);
+            }
+        }
+    } // namespace anonymous
+
+    bool JobSystemInit(u32 workerCount)
+    {
+        D_ASSERT(g_workers.empty(), "Job system already initialized.");
+
+        if (!workerCount)
+        {
+            u32 hardwareThreads {std::thread::hardware_concurrency()};
+            workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+        }
+
+        g_stopping = false;
+        g_workers.reserve(workerCount);
+        for (u32 i {0}; i < workerCount; ++i)
+        {
+            g_workers.emplace_back(WorkerLoop);
+        }
+
+        D_TRACE("Job system started with %u workers.", workerCount);
+        return true;
+    }
+
+    void JobSubmit(JobFunction function, void* userData, JobCounter* counter)
+    {
+        D_ASSERT(function, "Job function is null.");
+
+        if (counter)
+        {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (g_workers.empty())
+        {
+            Run({function, userData, counter}); // No workers, run inline.
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(g_queueMutex);
+            g_queue.push_back({function, userData, counter});
+        }
+        g_queueCondition.notify_one();
+    }
+
+    bool JobIsDone(const JobCounter* counter)
+    {
+        return counter->pending.load(std::memory_order_acquire) == 0;
+    }
+
+    void JobWait(JobCounter* counter)
+    {
+        while (!JobIsDone(counter))
+        {
+            Job job {};
+            if (TryPop(&job))
+            {
+                Run(job);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    u32 JobWorkerCount()
+    {
+        return (u32) g_workers.size();
+    }
+
+    void JobSystemShutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(g_queueMutex);
+            g_stopping = true;
+        }
+        g_queueCondition.notify_all();
+
+        for (std::thread& worker : g_workers)
+        {
+            worker.join();
+        }
+        g_workers.clear();
+    }
+} // namespace drop::utils
@@ -0,0 +1,199 @@
+#include "utils/profiler.hpp"
+#include "utils/timer.hpp"
+
+#include <atomic>
+#include <cstdio>  // fopen, fprintf.
+#include <cstdlib> // malloc, free.
+
+namespace drop::utils
+{
+    namespace
+    {
+        constexpr u32 MAX_PROFILE_THREADS {64};
+        constexpr u64 PROFILE_EVENT_CAPACITY {1 << 16}; // Per thread, the oldest scopes are overwritten.
+
+        struct ProfileEvent
+        {
+            const Char* name {nullptr};
+            u64         begin {0};
+            u64         end {0};
+        };
+
+        // Only the owning thread writes events, the count publishes them to the trace writer.
+        struct ProfileThread
+        {
+            ProfileEvent*    events {nullptr};
+            std::atomic<u64> count {0}; // Every event ever recorded, the slot is count % capacity.
+            const Char*      name {nullptr};
+            u32              id {0};
+        };
+
+        std::atomic<ProfileThread*> g_threads[MAX_PROFILE_THREADS] {};
+        std::atomic<u32>            g_threadCount {0};
+        thread_local ProfileThread* t_thread {nullptr};
+
+        // The session's reference point, timestamps are converted over the whole session when written.
+        const u64 g_startTicks {ProfileTimestamp()};
+        const i64 g_startNs {GetTimeNs()};
+
+        ProfileThread* RegisterThread()
+        {
+            u32 index {g_threadCount.fetch_add(1, std::memory_order_relaxed)};
+            if (index >= MAX_PROFILE_THREADS)
+            {
+                D_ASSERT(false, "Too many profiled threads.");
+                return nullptr;
+            }
+
+            ProfileThread* thread {new ProfileThread {}};
+            thread->events = (ProfileEvent*) malloc(PROFILE_EVENT_CAPACITY * sizeof(ProfileEvent));
+            thread->id     = index + 1;
+            if (!thread->events)
+            {
+                delete thread;
+                return nullptr;
+            }
+            TRACK_LEAK_ALLOC(thread->events, LeakType::HEAP, "Profiler events");
+
+            g_threads[index].store(thread, std::memory_order_release);
+            return thread;
+        }
+
+        ProfileThread* GetThread()
+        {
+            if (!t_thread)
+            {
+                t_thread = RegisterThread();
+            }
+            return t_thread;
+        }
+
+        void WriteJsonString(FILE* file, const Char* text)
+        {
+            fputc('"', file);
+            for (; *text; ++text)
+            {
+                if (*text == '"' || *text == '\\')
+                {
+                    fputc('\\', file);
+                }
+                fputc((u8) *text < 0x20 ? ' ' : *text, file);
+            }
+            fputc('"', file);
+        }
+    } // namespace anonymous
+
+    void ProfileRecord(const Char* name, u64 begin, u64 end)
+    {
+        ProfileThread* thread {GetThread()};
+        if (!thread)
+        {
+            return;
+        }
+
+        u64 count {thread->count.load(std::memory_order_relaxed)};
+        thread->events[count % PROFILE_EVENT_CAPACITY] = {name, begin, end};
+        thread->count.store(count + 1, std::memory_order_release);
+    }
+
+    void ProfileSetThreadName(const Char* name)
+    {
+        if (ProfileThread* thread {GetThread()})
+        {
+            thread->name = name;
+        }
+    }
+
+    bool ProfileWriteTrace(const Char* filePath)
+    {
+        FILE* file {fopen(filePath, "wb")};
+        if (!file)
+        {
+            D_ERROR("Failed to open trace file: %s", filePath);
+            return false;
+        }
+
+        // Ticks per microsecond measured over the session so far, exact enough with an invariant TSC.
+        u64 nowTicks {ProfileTimestamp()};
+        i64 nowNs {GetTimeNs()};
+        f64 ticksPerUs {nowNs > g_startNs ? (f64) (nowTicks - g_startTicks) * 1000.0 / (f64) (nowNs - g_startNs) : 1.0};
+
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Drop Engine\"}}");
+
+        ProfileEvent* snapshot {(ProfileEvent*) malloc(PROFILE_EVENT_CAPACITY * sizeof(ProfileEvent))};
+        if (!snapshot)
+        {
+            fclose(file);
+            return false;
+        }
+
+        u32 threadCount {g_threadCount.load(std::memory_order_acquire)};
+        threadCount = threadCount < MAX_PROFILE_THREADS ? threadCount : MAX_PROFILE_THREADS;
+        for (u32 i {0}; i < threadCount; ++i)
+        {
+            ProfileThread* thread {g_threads[i].load(std::memory_order_acquire)};
+            if (!thread)
+            {
+                continue;
+            }
+
+            if (thread->name)
+            {
+                fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", thread->id);
+                WriteJsonString(file, thread->name);
+                fprintf(file, "}}");
+            }
+
+            // Copied first, then whatever the owner overwrote during the copy is skipped. The owner may
+            // be writing event `after` into the slot of event `after - capacity` before it bumps the
+            // count, so that one is skipped too.
+            u64 end {thread->count.load(std::memory_order_acquire)};
+            u64 begin {end > PROFILE_EVENT_CAPACITY ? end - PROFILE_EVENT_CAPACITY : 0};
+            for (u64 event {begin}; event < end; ++event)
+            {
+                snapshot[event % PROFILE_EVENT_CAPACITY] = thread->events[event % PROFILE_EVENT_CAPACITY];
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            u64 after {thread->count.load(std::memory_order_relaxed)};
+            u64 intact {after >= PROFILE_EVENT_CAPACITY ? after + 1 - PROFILE_EVENT_CAPACITY : 0};
+            begin = intact > begin ? intact : begin;
+
+            for (u64 event {begin}; event < end; ++event)
+            {
+                const ProfileEvent& scope {snapshot[event % PROFILE_EVENT_CAPACITY]};
+                fprintf(file, ",\n{\"name\":");
+                WriteJsonString(file, scope.name);
+                fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", thread->id,
+                        (f64) (scope.begin - g_startTicks) / ticksPerUs, (f64) (scope.end - scope.begin) / ticksPerUs);
+            }
+        }
+        free(snapshot);
+
+        fprintf(file, "\n]}\n");
+        bool written {!ferror(file)};
+        fclose(file);
+
+        if (written)
+        {
+            D_TRACE("Wrote profile trace %s.", filePath);
+        }
+        return written;
+    }
+
+    void ProfileShutdown()
+    {
+        u32 threadCount {g_threadCount.exchange(0, std::memory_order_acq_rel)};
+        threadCount = threadCount < MAX_PROFILE_THREADS ? threadCount : MAX_PROFILE_THREADS;
+        for (u32 i {0}; i < threadCount; ++i)
+        {
+            ProfileThread* thread {g_threads[i].exchange(nullptr, std::memory_order_acq_rel)};
+            if (thread)
+            {
+                TRACK_LEAK_FREE(thread->events);
+                free(thread->events);
+                delete thread;
+            }
+        }
+    }
+} // namespace drop::utils
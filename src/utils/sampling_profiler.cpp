@@ -0,0 +1,475 @@
+#include "utils/sampling_profiler.hpp"
+
+#ifdef __linux__
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>  // fopen, fprintf, snprintf.
+#include <cstdlib> // free.
+#include <cstring> // strrchr.
+#include <ctime>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <map>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <sys/syscall.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid // Older glibc headers only have the union member.
+#endif
+#endif // __linux__
+
+namespace drop::utils
+{
+#ifdef __linux__
+    namespace
+    {
+        constexpr u32 MAX_SAMPLED_THREADS {64};
+        constexpr u32 MAX_SAMPLE_DEPTH {16};       // Leaf first, deeper frames are cut off.
+        constexpr u32 SAMPLE_TABLE_SIZE {1 << 14}; // Distinct stacks, power of two.
+        constexpr u32 SAMPLE_TABLE_MAX_PROBES {64};
+
+        struct SampledThread
+        {
+            pthread_t   handle {};
+            pid_t       tid {0};
+            const Char* name {nullptr};
+            u64         stackLow {0};
+            u64         stackHigh {0};
+            timer_t     timer {};
+            bool        hasTimer {false};
+        };
+
+        // Written only by the signal handler. A slot is claimed by the hash, filled and then published
+        // by ready, the dump skips slots that aren't ready yet. Two threads racing for the same new
+        // stack may both claim a slot, the dump merges them.
+        struct SampleSlot
+        {
+            std::atomic<u64> hash {0}; // 0 is an empty slot.
+            std::atomic<u32> ready {0};
+            std::atomic<u64> count {0};
+            u32              thread {0};
+            u32              depth {0};
+            u64              frames[MAX_SAMPLE_DEPTH] {};
+        };
+
+        SampledThread         g_sampledThreads[MAX_SAMPLED_THREADS] {};
+        u32                   g_sampledThreadCount {0};
+        std::mutex            g_sampledThreadsMutex {};
+        thread_local i32      t_sampledThread {-1};
+
+        SampleSlot            g_sampleTable[SAMPLE_TABLE_SIZE] {};
+        std::atomic<u64>      g_sampleCount {0};
+        std::atomic<u64>      g_sampleDropped {0};
+        std::atomic<bool>     g_sampling {false};
+        bool                  g_handlerInstalled {false};
+        i64                   g_sampleIntervalNs {0};
+        SamplingProfilerStats g_samplingStats {};
+
+        u64 HashStack(u32 thread, const u64* frames, u32 depth)
+        {
+            u64 hash {14695981039346656037ull ^ thread};
+            for (u32 i {0}; i < depth; ++i)
+            {
+                hash = (hash ^ frames[i]) * 1099511628211ull;
+                hash ^= hash >> 29;
+            }
+            return hash | 1;
+        }
+
+        bool SameStack(const SampleSlot& slot, u32 thread, const u64* frames, u32 depth)
+        {
+            if (slot.thread != thread || slot.depth != depth)
+            {
+                return false;
+            }
+            for (u32 i {0}; i < depth; ++i)
+            {
+                if (slot.frames[i] != frames[i])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void RecordSample(u32 thread, const u64* frames, u32 depth)
+        {
+            u64 hash {HashStack(thread, frames, depth)};
+            for (u32 probe {0}; probe < SAMPLE_TABLE_MAX_PROBES; ++probe)
+            {
+                SampleSlot& slot {g_sampleTable[(hash + probe) & (SAMPLE_TABLE_SIZE - 1)]};
+                u64         slotHash {slot.hash.load(std::memory_order_acquire)};
+                if (slotHash == 0 && slot.hash.compare_exchange_strong(slotHash, hash, std::memory_order_acq_rel))
+                {
+                    slot.thread = thread;
+                    slot.depth  = depth;
+                    for (u32 i {0}; i < depth; ++i)
+                    {
+                        slot.frames[i] = frames[i];
+                    }
+                    slot.count.store(1, std::memory_order_relaxed);
+                    slot.ready.store(1, std::memory_order_release);
+                    g_sampleCount.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                if (slotHash == hash && slot.ready.load(std::memory_order_acquire) && SameStack(slot, thread, frames, depth))
+                {
+                    slot.count.fetch_add(1, std::memory_order_relaxed);
+                    g_sampleCount.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            g_sampleDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Runs on the sampled thread, so only atomics and the thread's own stack are touched.
+        void SampleHandler(i32, siginfo_t*, void* context)
+        {
+            i32 savedErrno {errno};
+            i32 index {t_sampledThread};
+            if (index < 0 || !g_sampling.load(std::memory_order_relaxed))
+            {
+                errno = savedErrno;
+                return;
+            }
+
+            const mcontext_t& machine {((ucontext_t*) context)->uc_mcontext};
+#if defined(__x86_64__)
+            u64 pc {(u64) machine.gregs[REG_RIP]};
+            u64 fp {(u64) machine.gregs[REG_RBP]};
+#elif defined(__aarch64__)
+            u64 pc {(u64) machine.pc};
+            u64 fp {(u64) machine.regs[29]};
+#else
+            u64 pc {0};
+            u64 fp {0};
+#endif
+
+            // Every frame starts with the caller's frame pointer and the return address. Anything
+            // outside this thread's stack or not strictly moving up ends the walk, so code built
+            // without frame pointers gives a shorter stack instead of a crash.
+            const SampledThread& thread {g_sampledThreads[index]};
+            u64                  frames[MAX_SAMPLE_DEPTH];
+            u32                  depth {0};
+            frames[depth++] = pc;
+            while (depth < MAX_SAMPLE_DEPTH && fp >= thread.stackLow && fp + 2 * sizeof(u64) <= thread.stackHigh &&
+                   (fp & (sizeof(u64) - 1)) == 0)
+            {
+                const u64* frame {(const u64*) fp};
+                if (!frame[1])
+                {
+                    break;
+                }
+                frames[depth++] = frame[1];
+                if (frame[0] <= fp)
+                {
+                    break;
+                }
+                fp = frame[0];
+            }
+
+            RecordSample((u32) index, frames, depth);
+            errno = savedErrno;
+        }
+
+        // Measures this thread's CPU time, so the signal always lands on the thread it samples.
+        bool StartThreadTimer(SampledThread* thread)
+        {
+            clockid_t clock {};
+            if (pthread_getcpuclockid(thread->handle, &clock) != 0)
+            {
+                D_WARN("No CPU clock for thread %s, it won't be sampled.", thread->name ? thread->name : "?");
+                return false;
+            }
+
+            sigevent event {};
+            event.sigev_notify           = SIGEV_THREAD_ID;
+            event.sigev_signo            = SIGPROF;
+            event.sigev_notify_thread_id = thread->tid;
+            if (timer_create(clock, &event, &thread->timer) != 0)
+            {
+                D_WARN("Failed to create the sampling timer for thread %s.", thread->name ? thread->name : "?");
+                return false;
+            }
+
+            itimerspec interval {};
+            interval.it_interval.tv_sec  = g_sampleIntervalNs / 1000000000;
+            interval.it_interval.tv_nsec = g_sampleIntervalNs % 1000000000;
+            interval.it_value            = interval.it_interval;
+            if (timer_settime(thread->timer, 0, &interval, nullptr) != 0)
+            {
+                timer_delete(thread->timer);
+                return false;
+            }
+
+            thread->hasTimer = true;
+            return true;
+        }
+
+        std::string SymbolName(u64 address)
+        {
+            Char    text[256];
+            Dl_info info {};
+            if (dladdr((void*) address, &info) && info.dli_sname)
+            {
+                i32   status {0};
+                Char* demangled {abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status)};
+                std::string name {status == 0 && demangled ? demangled : info.dli_sname};
+                free(demangled);
+                return name;
+            }
+
+            // Internal linkage functions aren't exported, module+offset still resolves with addr2line.
+            if (info.dli_fname)
+            {
+                const Char* module {strrchr(info.dli_fname, '/')};
+                snprintf(text, sizeof(text), "%s+0x%llx", module ? module + 1 : info.dli_fname, (unsigned long long) (address - (u64) info.dli_fbase));
+                return text;
+            }
+
+            snprintf(text, sizeof(text), "0x%llx", (unsigned long long) address);
+            return text;
+        }
+
+        // The folded format splits frames on ';' and the count off at the last space.
+        void AppendFrame(std::string* line, const std::string& name)
+        {
+            for (Char c : name)
+            {
+                line->push_back(c == ';' ? ':' : (c == '\n' ? ' ' : c));
+            }
+        }
+    } // namespace anonymous
+
+    bool SamplingProfilerStart(u32 hz)
+    {
+        std::lock_guard<std::mutex> lock {g_sampledThreadsMutex};
+        if (g_sampling.load(std::memory_order_relaxed))
+        {
+            return true;
+        }
+
+        if (!g_handlerInstalled)
+        {
+            struct sigaction action {};
+            action.sa_sigaction = SampleHandler;
+            action.sa_flags     = SA_SIGINFO | SA_RESTART;
+            sigemptyset(&action.sa_mask);
+            if (sigaction(SIGPROF, &action, nullptr) != 0)
+            {
+                D_ASSERT(false, "Failed to install the SIGPROF handler.");
+                return false;
+            }
+            // Stays installed after Stop, a signal still pending from a deleted timer must not kill the process.
+            g_handlerInstalled = true;
+        }
+
+        // A prime rate doesn't line up with the frame loop or other periodic work.
+        hz                 = hz ? hz : 997;
+        g_sampleIntervalNs = 1000000000ll / hz;
+        for (SampleSlot& slot : g_sampleTable)
+        {
+            slot.hash.store(0, std::memory_order_relaxed);
+            slot.ready.store(0, std::memory_order_relaxed);
+            slot.count.store(0, std::memory_order_relaxed);
+        }
+        g_sampleCount.store(0, std::memory_order_relaxed);
+        g_sampleDropped.store(0, std::memory_order_relaxed);
+        g_sampling.store(true, std::memory_order_release);
+
+        for (u32 i {0}; i < g_sampledThreadCount; ++i)
+        {
+            StartThreadTimer(&g_sampledThreads[i]);
+        }
+
+        D_TRACE("Sampling profiler started at %u Hz per thread.", hz);
+        return true;
+    }
+
+    void SamplingProfilerRegisterThread(const Char* name)
+    {
+        if (t_sampledThread >= 0)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock {g_sampledThreadsMutex};
+        if (g_sampledThreadCount >= MAX_SAMPLED_THREADS)
+        {
+            D_WARN("Too many sampled threads, %s won't be sampled.", name);
+            return;
+        }
+
+        SampledThread* thread {&g_sampledThreads[g_sampledThreadCount]};
+        thread->handle = pthread_self();
+        thread->tid    = (pid_t) syscall(SYS_gettid);
+        thread->name   = name;
+
+        // The walk only follows frame pointers inside these bounds.
+        pthread_attr_t attributes {};
+        if (pthread_getattr_np(thread->handle, &attributes) == 0)
+        {
+            void*  stack {nullptr};
+            size_t stackSize {0};
+            if (pthread_attr_getstack(&attributes, &stack, &stackSize) == 0)
+            {
+                thread->stackLow  = (u64) stack;
+                thread->stackHigh = (u64) stack + stackSize;
+            }
+            pthread_attr_destroy(&attributes);
+        }
+
+        t_sampledThread = (i32) g_sampledThreadCount++;
+        if (g_sampling.load(std::memory_order_relaxed))
+        {
+            StartThreadTimer(thread);
+        }
+    }
+
+    bool SamplingProfilerIsRunning()
+    {
+        return g_sampling.load(std::memory_order_relaxed);
+    }
+
+    bool SamplingProfilerDump(const Char* filePath)
+    {
+        // Symbolized outside the handler, every address is looked up once.
+        std::map<std::string, u64> folded {};
+        std::map<u64, std::string> symbols {};
+        u32                        threadCount {0};
+        {
+            std::lock_guard<std::mutex> lock {g_sampledThreadsMutex};
+            threadCount = g_sampledThreadCount;
+        }
+
+        for (SampleSlot& slot : g_sampleTable)
+        {
+            if (!slot.ready.load(std::memory_order_acquire) || slot.thread >= threadCount)
+            {
+                continue;
+            }
+
+            std::string line {};
+            Char        threadName[32];
+            const Char* name {g_sampledThreads[slot.thread].name};
+            if (!name)
+            {
+                snprintf(threadName, sizeof(threadName), "Thread %u", slot.thread);
+                name = threadName;
+            }
+            AppendFrame(&line, name);
+
+            // Stored leaf first, written root first. Return addresses point past the call, one byte
+            // back is still inside it.
+            for (u32 i {slot.depth}; i-- > 0;)
+            {
+                u64 address {i == 0 ? slot.frames[i] : slot.frames[i] - 1};
+                auto symbol {symbols.find(address)};
+                if (symbol == symbols.end())
+                {
+                    symbol = symbols.emplace(address, SymbolName(address)).first;
+                }
+                line.push_back(';');
+                AppendFrame(&line, symbol->second);
+            }
+            folded[line] += slot.count.load(std::memory_order_relaxed);
+        }
+
+        FILE* file {fopen(filePath, "wb")};
+        if (!file)
+        {
+            D_ERROR("Failed to open sample file: %s", filePath);
+            return false;
+        }
+
+        for (const auto& stack : folded)
+        {
+            fprintf(file, "%s %llu\n", stack.first.c_str(), (unsigned long long) stack.second);
+        }
+        bool written {!ferror(file)};
+        fclose(file);
+
+        if (written)
+        {
+            const SamplingProfilerStats& stats {SamplingProfilerGetStats()};
+            D_TRACE("Wrote %llu samples in %u stacks to %s, %llu dropped.", (unsigned long long) stats.samples,
+                    (u32) folded.size(), filePath, (unsigned long long) stats.dropped);
+        }
+        return written;
+    }
+
+    const SamplingProfilerStats& SamplingProfilerGetStats()
+    {
+        u32 stacks {0};
+        for (const SampleSlot& slot : g_sampleTable)
+        {
+            stacks += slot.ready.load(std::memory_order_relaxed) ? 1 : 0;
+        }
+
+        g_samplingStats.samples = g_sampleCount.load(std::memory_order_relaxed);
+        g_samplingStats.dropped = g_sampleDropped.load(std::memory_order_relaxed);
+        g_samplingStats.stacks  = stacks;
+        g_samplingStats.threads = g_sampledThreadCount;
+        return g_samplingStats;
+    }
+
+    void SamplingProfilerStop()
+    {
+        std::lock_guard<std::mutex> lock {g_sampledThreadsMutex};
+        if (!g_sampling.exchange(false, std::memory_order_acq_rel))
+        {
+            return;
+        }
+
+        for (u32 i {0}; i < g_sampledThreadCount; ++i)
+        {
+            SampledThread& thread {g_sampledThreads[i]};
+            if (thread.hasTimer)
+            {
+                timer_delete(thread.timer);
+                thread.hasTimer = false;
+            }
+        }
+    }
+#else
+    namespace
+    {
+        SamplingProfilerStats g_samplingStats {};
+    } // namespace anonymous
+
+    bool SamplingProfilerStart(u32)
+    {
+        D_WARN("The sampling profiler is only implemented on Linux.");
+        return false;
+    }
+
+    void SamplingProfilerRegisterThread(const Char*)
+    {
+    }
+
+    bool SamplingProfilerIsRunning()
+    {
+        return false;
+    }
+
+    bool SamplingProfilerDump(const Char*)
+    {
+        return false;
+    }
+
+    const SamplingProfilerStats& SamplingProfilerGetStats()
+    {
+        return g_samplingStats;
+    }
+
+    void SamplingProfilerStop()
+    {
+    }
+#endif // __linux__
+} // namespace drop::utils
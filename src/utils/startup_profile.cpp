@@ -0,0 +1,56 @@
+#include "utils/startup_profile.hpp"
+#include "utils/timer.hpp"
+
+namespace drop::utils
+{
+    namespace
+    {
+        struct StartupPhase
+        {
+            const Char* name;
+            i64         end;
+        };
+
+        constexpr u32 MAX_STARTUP_PHASES {16};
+
+        StartupPhase g_phases[MAX_STARTUP_PHASES] {};
+        u32          g_phaseCount {0};
+        i64          g_startTime {0};
+        bool         g_reported {false};
+    } // namespace anonymous
+
+    void StartupBegin()
+    {
+        g_startTime  = GetTimeNs();
+        g_phaseCount = 0;
+        g_reported   = false;
+    }
+
+    void StartupMark(const Char* phase)
+    {
+        // Marks after the report (a second window, a context recreation) are not startup anymore.
+        if (g_reported || g_phaseCount == MAX_STARTUP_PHASES)
+        {
+            return;
+        }
+
+        g_phases[g_phaseCount++] = {phase, GetTimeNs()};
+    }
+
+    void StartupReport()
+    {
+        if (g_reported)
+        {
+            return;
+        }
+        g_reported = true;
+
+        i64 previous {g_startTime};
+        for (u32 i {0}; i < g_phaseCount; ++i)
+        {
+            D_TRACE("Startup: %-20s %8.3f ms", g_phases[i].name, (g_phases[i].end - previous) / 1e6);
+            previous = g_phases[i].end;
+        }
+        D_TRACE("Startup: %-20s %8.3f ms", "Time to first frame", (previous - g_startTime) / 1e6);
+    }
+} // namespace drop::utils
@@ -0,0 +1,67 @@
+#include "utils/timer.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#elif defined(__linux__)
+#include <ctime>
+#endif // _WIN32
+
+#include <algorithm> // std::sort.
+
+namespace drop::utils
+{
+    i64 GetTimeNs()
+    {
+#ifdef _WIN32
+        static LARGE_INTEGER frequency {};
+        if (!frequency.QuadPart)
+        {
+            QueryPerformanceFrequency(&frequency);
+        }
+
+        LARGE_INTEGER counter {};
+        QueryPerformanceCounter(&counter);
+
+        // Split to avoid overflowing the multiplication.
+        i64 seconds {counter.QuadPart / frequency.QuadPart};
+        i64 remainder {counter.QuadPart % frequency.QuadPart};
+        return seconds * 1000000000ll + remainder * 1000000000ll / frequency.QuadPart;
+#elif defined(__linux__)
+        timespec ts {};
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (i64) ts.tv_sec * 1000000000ll + ts.tv_nsec;
+#endif // _WIN32
+    }
+
+    TimingStats ComputeTimingStats(f64* samples, u32 count)
+    {
+        TimingStats stats {};
+        if (!count)
+        {
+            return stats;
+        }
+
+        std::sort(samples, samples + count);
+
+        f64 sum {0.0};
+        for (u32 i {0}; i < count; ++i)
+        {
+            sum += samples[i];
+        }
+
+        // Nearest rank: the smallest sample with at least p of the samples at or below it.
+        u32 p95 {(u32) (((u64) count * 95 + 99) / 100)};
+        u32 p99 {(u32) (((u64) count * 99 + 99) / 100)};
+
+        stats.count  = count;
+        stats.min    = samples[0];
+        stats.mean   = sum / count;
+        stats.median = count % 2 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) * 0.5;
+        stats.p95    = samples[p95 - 1];
+        stats.p99    = samples[p99 - 1];
+        stats.max    = samples[count - 1];
+        return stats;
+    }
+} // namespace drop::utils
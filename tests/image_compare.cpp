@@ -0,0 +1,87 @@
+#include "utils/image.hpp"
+
+#include <cstdio>  // printf.
+#include <cstdlib> // atoi, atof.
+
+using namespace drop;
+
+// image_compare <actual> <golden> <channel tolerance> <max differing %> [diff image]
+// A pixel differs when any channel is further than the tolerance from the golden one. The run
+// fails when more than the given share of pixels differ. The diff image shows the golden frame
+// darkened with the differing pixels in red.
+// Exit code 0 on a match, 1 on a mismatch, 2 when an image can't be read.
+int main(int argc, char** argv)
+{
+    if (argc < 5)
+    {
+        printf("Usage: %s <actual> <golden> <channel tolerance> <max differing %%> [diff image]\n", argv[0]);
+        return 2;
+    }
+
+    utils::Image actual {};
+    utils::Image golden {};
+    if (!utils::ImageLoad(argv[1], &actual) || !utils::ImageLoad(argv[2], &golden))
+    {
+        utils::ImageFree(&actual);
+        utils::ImageFree(&golden);
+        return 2;
+    }
+
+    if (actual.width != golden.width || actual.height != golden.height)
+    {
+        printf("%s is %ux%u, the golden image is %ux%u.\n", argv[1], actual.width, actual.height, golden.width, golden.height);
+        utils::ImageFree(&actual);
+        utils::ImageFree(&golden);
+        return 1;
+    }
+
+    i32 tolerance {atoi(argv[3])};
+    f64 maxDifferingPercent {atof(argv[4])};
+
+    // Written over the golden pixels, they are not needed after the comparison.
+    u32         differing {0};
+    i32         maxDifference {0};
+    utils::Size pixelCount {(utils::Size) golden.width * golden.height};
+    for (utils::Size i {0}; i < pixelCount; ++i)
+    {
+        u8* expected {golden.pixels + i * 4};
+        u8* pixel {actual.pixels + i * 4};
+
+        i32 difference {0};
+        for (u32 channel {0}; channel < 4; ++channel)
+        {
+            i32 channelDifference {abs((i32) pixel[channel] - (i32) expected[channel])};
+            difference = channelDifference > difference ? channelDifference : difference;
+        }
+        maxDifference = difference > maxDifference ? difference : maxDifference;
+
+        if (difference > tolerance)
+        {
+            differing++;
+            expected[0] = 255;
+            expected[1] = 0;
+            expected[2] = 0;
+        }
+        else
+        {
+            expected[0] /= 4;
+            expected[1] /= 4;
+            expected[2] /= 4;
+        }
+        expected[3] = 255;
+    }
+
+    f64  differingPercent {100.0 * differing / pixelCount};
+    bool match {differingPercent <= maxDifferingPercent};
+    printf("%s: %u pixels over tolerance %d (%.3f%%, limit %.3f%%), max channel difference %d.\n",
+           argv[1], differing, tolerance, differingPercent, maxDifferingPercent, maxDifference);
+
+    if (!match && argc > 5)
+    {
+        utils::ImageSave(argv[5], &golden, utils::ImageFormat::PNG);
+    }
+
+    utils::ImageFree(&actual);
+    utils::ImageFree(&golden);
+    return match ? 0 : 1;
+}
@@ -0,0 +1,415 @@
+#include "utils/bump_allocator.hpp"
+#include "utils/cpu.hpp"
+#include "utils/deflate.hpp"
+#include "utils/file_io.hpp"
+#include "utils/image.hpp"
+#include "utils/job_system.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/timer.hpp"
+
+#include <cstdio>  // printf, fflush.
+#include <cstdlib> // malloc, free, atoi.
+#include <cstring> // memset, strstr.
+#include <fcntl.h>
+#include <thread>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif // _WIN32
+
+#ifdef D_SIMD_X86
+#include <x86intrin.h> // __rdtsc.
+#endif // D_SIMD_X86
+
+using namespace drop;
+
+// Microbenchmarks for the utilities the engine leans on. Each benchmark runs its body a fixed
+// number of operations per run. A few warmup runs are thrown away, then the per-op time of every
+// measured run goes into the median / p99. Cycles are TSC ticks, a constant rate on modern x86
+// that only matches core cycles at the nominal clock.
+//   microbench [filter] [runs]   only the benchmarks whose name contains filter.
+
+namespace
+{
+    constexpr u32         WARMUP_RUNS {5};
+    constexpr u32         DEFAULT_RUNS {51};
+    constexpr u32         MAX_RUNS {1001};
+    constexpr const Char* SCRATCH_DIR {"build/bench_tmp"};
+
+    using BenchFunction = void (*)(u32 operations, void* userData);
+
+    struct Bench
+    {
+        const Char*   name {nullptr};
+        BenchFunction function {nullptr};
+        u32           operations {0}; // Per run, what the times are divided by.
+        void*         userData {nullptr};
+    };
+
+    struct Scratch
+    {
+        utils::BumpAllocator arena {};
+        Char*                fileBuffer {nullptr};
+        utils::Size          fileBufferSize {0};
+        u8*                  bytes {nullptr};
+        utils::Size          byteCount {0};
+        Char                 smallFile[128] {};
+        Char                 largeFile[128] {};
+        Char                 copyTarget[128] {};
+    };
+
+    u64 ReadCycles()
+    {
+#ifdef D_SIMD_X86
+        return __rdtsc();
+#else
+        return 0;
+#endif // D_SIMD_X86
+    }
+
+    // The logger benchmarks would bury the results, their output goes to the null device.
+    i32 SilenceStdout()
+    {
+        fflush(stdout);
+#ifdef _WIN32
+        i32 saved {_dup(_fileno(stdout))};
+        i32 null {_open("NUL", _O_WRONLY)};
+        _dup2(null, _fileno(stdout));
+        _close(null);
+#else
+        i32 saved {dup(fileno(stdout))};
+        i32 null {open("/dev/null", O_WRONLY)};
+        dup2(null, fileno(stdout));
+        close(null);
+#endif // _WIN32
+        return saved;
+    }
+
+    void RestoreStdout(i32 saved)
+    {
+        fflush(stdout);
+#ifdef _WIN32
+        _dup2(saved, _fileno(stdout));
+        _close(saved);
+#else
+        dup2(saved, fileno(stdout));
+        close(saved);
+#endif // _WIN32
+    }
+
+    void RunBench(const Bench& bench, u32 runs)
+    {
+        static f64 nsPerOp[MAX_RUNS] {};
+        static f64 cyclesPerOp[MAX_RUNS] {};
+
+        for (u32 i {0}; i < WARMUP_RUNS; ++i)
+        {
+            bench.function(bench.operations, bench.userData);
+        }
+
+        for (u32 i {0}; i < runs; ++i)
+        {
+            i64 start {utils::GetTimeNs()};
+            u64 startCycles {ReadCycles()};
+            bench.function(bench.operations, bench.userData);
+            u64 endCycles {ReadCycles()};
+            i64 end {utils::GetTimeNs()};
+
+            nsPerOp[i]     = (f64) (end - start) / bench.operations;
+            cyclesPerOp[i] = (f64) (endCycles - startCycles) / bench.operations;
+        }
+
+        utils::TimingStats time {utils::ComputeTimingStats(nsPerOp, runs)};
+        utils::TimingStats cycles {utils::ComputeTimingStats(cyclesPerOp, runs)};
+        printf("%-32s %10u %12.2f %12.2f %12.2f %12.1f\n", bench.name, bench.operations, time.median, time.p99, time.min, cycles.median);
+    }
+
+    // --- Bump allocator ---
+
+    void BumpAlloc16(u32 operations, void* userData)
+    {
+        utils::BumpAllocator* arena {&((Scratch*) userData)->arena};
+        arena->used = 0;
+        for (u32 i {0}; i < operations; ++i)
+        {
+            utils::BumpAlloc(arena, 16);
+        }
+    }
+
+    void BumpAlloc4K(u32 operations, void* userData)
+    {
+        utils::BumpAllocator* arena {&((Scratch*) userData)->arena};
+        arena->used = 0;
+        for (u32 i {0}; i < operations; ++i)
+        {
+            utils::BumpAlloc(arena, KB(4));
+        }
+    }
+
+    // What BumpAlloc is there to beat.
+    void MallocFree16(u32 operations, void*)
+    {
+        for (u32 i {0}; i < operations; ++i)
+        {
+            void* volatile pointer {malloc(16)};
+            free(pointer);
+        }
+    }
+
+    // --- File IO ---
+
+    void ReadSmallFile(u32 operations, void* userData)
+    {
+        Scratch* scratch {(Scratch*) userData};
+        i32      size {0};
+        for (u32 i {0}; i < operations; ++i)
+        {
+            utils::ReadFile(scratch->smallFile, scratch->fileBuffer, &size);
+        }
+    }
+
+    void ReadLargeFile(u32 operations, void* userData)
+    {
+        Scratch* scratch {(Scratch*) userData};
+        i32      size {0};
+        for (u32 i {0}; i < operations; ++i)
+        {
+            utils::ReadFile(scratch->largeFile, scratch->fileBuffer, &size);
+        }
+    }
+
+    // GetFileSize plus a bump allocation plus the read, what most asset loads go through.
+    void ReadSmallFileBump(u32 operations, void* userData)
+    {
+        Scratch* scratch {(Scratch*) userData};
+        i32      size {0};
+        scratch->arena.used = 0;
+        for (u32 i {0}; i < operations; ++i)
+        {
+            utils::ReadFile(scratch->smallFile, &scratch->arena, &size);
+        }
+    }
+
+    void CopyLargeFile(u32 operations, void* userData)
+    {
+        Scratch* scratch {(Scratch*) userData};
+        for (u32 i {0}; i < operations; ++i)
+        {
+            utils::CopyFile(scratch->largeFile, scratch->copyTarget, scratch->fileBuffer);
+        }
+    }
+
+    // --- Logger ---
+
+    void LogTrace(u32 operations, void*)
+    {
+        i32 saved {SilenceStdout()};
+        for (u32 i {0}; i < operations; ++i)
+        {
+            D_TRACE("Benchmark message %u with a %s and a %.2f.", i, "string", 1.5f);
+        }
+        RestoreStdout(saved);
+    }
+
+    void LogError(u32 operations, void*)
+    {
+        i32 saved {SilenceStdout()};
+        for (u32 i {0}; i < operations; ++i)
+        {
+            D_ERROR("Benchmark error %u.", i);
+        }
+        RestoreStdout(saved);
+    }
+
+    // --- Leak tracker ---
+
+    // Entries are never removed, a run registers on top of everything earlier runs left behind.
+    // The p99 going up with the run count is the linear search in _Unregister.
+    void LeakRegisterUnregister(u32 operations, void* userData)
+    {
+        u8* pointers {((Scratch*) userData)->bytes};
+        for (u32 i {0}; i < operations; ++i)
+        {
+            _Register(pointers + i, LeakType::CUSTOM, __FILE__, __LINE__, "Benchmark");
+        }
+        for (u32 i {0}; i < operations; ++i)
+        {
+            _Unregister(pointers + i);
+        }
+    }
+
+    // --- Containers ---
+
+    utils::SpscQueue<u64, 1024> g_queue {};
+
+    void SpscPushPop(u32 operations, void*)
+    {
+        u64 value {0};
+        for (u32 i {0}; i < operations; ++i)
+        {
+            utils::SpscPush(&g_queue, (u64) i);
+            utils::SpscPop(&g_queue, &value);
+        }
+    }
+
+    void ProduceItems(u32 count)
+    {
+        for (u32 i {0}; i < count; ++i)
+        {
+            while (!utils::SpscPush(&g_queue, (u64) i))
+            {
+                std::this_thread::yield(); // The consumer may share the core.
+            }
+        }
+    }
+
+    // One producer thread, the calling thread consumes. Per op is per item through the queue.
+    void SpscCrossThread(u32 operations, void*)
+    {
+        std::thread producer(ProduceItems, operations);
+
+        u64 value {0};
+        for (u32 received {0}; received < operations;)
+        {
+            if (utils::SpscPop(&g_queue, &value))
+            {
+                received++;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+    }
+
+    void EmptyJob(void*)
+    {
+    }
+
+    void JobSubmitWait(u32 operations, void*)
+    {
+        utils::JobCounter counter {};
+        for (u32 i {0}; i < operations; ++i)
+        {
+            utils::JobSubmit(EmptyJob, nullptr, &counter);
+        }
+        utils::JobWait(&counter);
+    }
+
+    // --- Checksums and encoders, per byte ---
+
+    void Crc32Bytes(u32 operations, void* userData)
+    {
+        Scratch* scratch {(Scratch*) userData};
+        u32 volatile crc {utils::Crc32(scratch->bytes, operations)};
+        (void) crc;
+    }
+
+    void Adler32Bytes(u32 operations, void* userData)
+    {
+        Scratch* scratch {(Scratch*) userData};
+        u32 volatile adler {utils::Adler32(scratch->bytes, operations)};
+        (void) adler;
+    }
+
+    void ZlibStoredBytes(u32 operations, void* userData)
+    {
+        Scratch* scratch {(Scratch*) userData};
+        utils::ZlibCompressStored(scratch->bytes, operations, (u8*) scratch->fileBuffer);
+    }
+
+    // --- Setup ---
+
+    bool WriteScratchFile(const Char* path, utils::Size size)
+    {
+        Char* data {(Char*) malloc(size)};
+        if (!data)
+        {
+            return false;
+        }
+
+        for (utils::Size i {0}; i < size; ++i)
+        {
+            data[i] = (Char) ('a' + i % 26);
+        }
+        bool written {utils::WriteFile((Char*) path, data, (i32) size)};
+        free(data);
+        return written;
+    }
+} // namespace anonymous
+
+int main(int argc, char** argv)
+{
+    const Char* filter {argc > 1 ? argv[1] : nullptr};
+    u32         runs {argc > 2 ? (u32) atoi(argv[2]) : DEFAULT_RUNS};
+    runs = runs < 1 ? 1 : runs > MAX_RUNS ? MAX_RUNS : runs;
+
+    if (!utils::JobSystemInit(0))
+    {
+        printf("Failed to start the job system.\n");
+        return 1;
+    }
+
+    Scratch scratch {};
+    scratch.arena          = utils::MakeBumpAllocator(MB(64));
+    scratch.fileBufferSize = MB(2);
+    scratch.fileBuffer     = (Char*) malloc(scratch.fileBufferSize);
+    scratch.byteCount      = MB(1);
+    scratch.bytes          = (u8*) malloc(scratch.byteCount);
+    snprintf(scratch.smallFile, sizeof(scratch.smallFile), "%s/small.txt", SCRATCH_DIR);
+    snprintf(scratch.largeFile, sizeof(scratch.largeFile), "%s/large.bin", SCRATCH_DIR);
+    snprintf(scratch.copyTarget, sizeof(scratch.copyTarget), "%s/copy.bin", SCRATCH_DIR);
+    if (!scratch.arena.memory || !scratch.fileBuffer || !scratch.bytes ||
+        !WriteScratchFile(scratch.smallFile, KB(4)) || !WriteScratchFile(scratch.largeFile, MB(1)))
+    {
+        printf("Failed to set up the scratch data, is %s there?\n", SCRATCH_DIR);
+        return 1;
+    }
+
+    u32 seed {1};
+    for (utils::Size i {0}; i < scratch.byteCount; ++i)
+    {
+        seed             = seed * 1664525 + 1013904223;
+        scratch.bytes[i] = (u8) (seed >> 24);
+    }
+
+    const Bench benches[] {
+        {"BumpAlloc 16 B", BumpAlloc16, 1000000, &scratch},
+        {"BumpAlloc 4 KB", BumpAlloc4K, 16000, &scratch},
+        {"malloc + free 16 B", MallocFree16, 1000000, &scratch},
+        {"ReadFile 4 KB", ReadSmallFile, 200, &scratch},
+        {"ReadFile 4 KB (bump)", ReadSmallFileBump, 200, &scratch},
+        {"ReadFile 1 MB", ReadLargeFile, 10, &scratch},
+        {"CopyFile 1 MB", CopyLargeFile, 10, &scratch},
+        {"D_TRACE formatted", LogTrace, 10000, &scratch},
+        {"D_ERROR", LogError, 10000, &scratch},
+        {"_Register + _Unregister", LeakRegisterUnregister, 1000, &scratch},
+        {"SpscQueue push + pop", SpscPushPop, 1000000, &scratch},
+        {"SpscQueue across threads", SpscCrossThread, 100000, &scratch},
+        {"JobSubmit + JobWait (empty)", JobSubmitWait, 10000, &scratch},
+        {"Crc32 per byte", Crc32Bytes, (u32) MB(1), &scratch},
+        {"Adler32 per byte", Adler32Bytes, (u32) MB(1), &scratch},
+        {"ZlibCompressStored per byte", ZlibStoredBytes, (u32) MB(1), &scratch},
+    };
+
+    const utils::CpuFeatures& cpu {utils::GetCpuFeatures()};
+    printf("%u runs after %u warmup runs, %u job workers, sse4.1 %s, avx2 %s.\n\n", runs, WARMUP_RUNS, utils::JobWorkerCount(),
+           cpu.sse41 ? "yes" : "no", cpu.avx2 ? "yes" : "no");
+    printf("%-32s %10s %12s %12s %12s %12s\n", "benchmark", "ops/run", "median ns", "p99 ns", "min ns", "cycles/op");
+    for (const Bench& bench : benches)
+    {
+        if (!filter || strstr(bench.name, filter))
+        {
+            RunBench(bench, runs);
+        }
+    }
+
+    utils::JobSystemShutdown();
+    utils::FreeBumpAllocator(&scratch.arena);
+    free(scratch.fileBuffer);
+    free(scratch.bytes);
+    return 0;
+}
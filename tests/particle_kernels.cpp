@@ -0,0 +1,167 @@
+#include "renderer/particle_kernels.hpp"
+
+#include <cstdio>  // printf.
+#include <cstring> // memcpy.
+#include <vector>
+
+using namespace drop;
+using namespace drop::renderer;
+
+// Runs every particle kernel the CPU has on the same random particles and checks that the SIMD
+// ones give the same bits as the scalar one: positions, velocities, lifetimes, colors and the
+// order of the survivors. Exits with 1 on the first difference.
+
+namespace
+{
+    constexpr u32 CASE_COUNT {64};
+    constexpr u32 MAX_PARTICLES {4096};
+    constexpr u32 FIELD_COUNT {8};
+
+    const Char* FIELD_NAMES[FIELD_COUNT] {"x", "y", "vx", "vy", "life", "invLifetime", "size", "color"};
+
+    struct Buffers
+    {
+        std::vector<u32> fields[FIELD_COUNT]; // Raw bits, the floats are compared exactly.
+        ParticleArrays   arrays {};
+    };
+
+    u32 NextRandom(u32& seed)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return seed;
+    }
+
+    f32 RandomRange(u32& seed, f32 min, f32 max)
+    {
+        return min + (max - min) * ((NextRandom(seed) >> 8) / (f32) (1 << 24));
+    }
+
+    void Allocate(Buffers& buffers, u32 capacity)
+    {
+        for (std::vector<u32>& field : buffers.fields)
+        {
+            field.assign(capacity, 0);
+        }
+
+        buffers.arrays.x           = (f32*) buffers.fields[0].data();
+        buffers.arrays.y           = (f32*) buffers.fields[1].data();
+        buffers.arrays.vx          = (f32*) buffers.fields[2].data();
+        buffers.arrays.vy          = (f32*) buffers.fields[3].data();
+        buffers.arrays.life        = (f32*) buffers.fields[4].data();
+        buffers.arrays.invLifetime = (f32*) buffers.fields[5].data();
+        buffers.arrays.size        = (f32*) buffers.fields[6].data();
+        buffers.arrays.color       = buffers.fields[7].data();
+    }
+
+    void Copy(Buffers& target, const Buffers& source)
+    {
+        Allocate(target, (u32) source.fields[0].size());
+        for (u32 field {0}; field < FIELD_COUNT; ++field)
+        {
+            memcpy(target.fields[field].data(), source.fields[field].data(), source.fields[field].size() * sizeof(u32));
+        }
+    }
+
+    // Some particles die this step, some land exactly on 0 and some colors on a .5 tie, the cases
+    // where the kernels used to disagree.
+    void Fill(Buffers& buffers, u32 count, UpdateParams& params, u32& seed)
+    {
+        params.deltaTime  = RandomRange(seed, 0.001f, 0.1f);
+        params.gravity[0] = RandomRange(seed, -10.f, 10.f);
+        params.gravity[1] = RandomRange(seed, -10.f, 10.f);
+        params.damping    = RandomRange(seed, 0.9f, 1.f);
+        for (u32 channel {0}; channel < 4; ++channel)
+        {
+            bool tie {NextRandom(seed) % 2 == 0};
+            params.colorStart[channel] = tie ? (f32) (NextRandom(seed) % 255) + 0.5f : RandomRange(seed, 0.f, 255.f);
+            params.colorDelta[channel] = tie ? 0.f : RandomRange(seed, -params.colorStart[channel], 255.f - params.colorStart[channel]);
+        }
+
+        const ParticleArrays& p {buffers.arrays};
+        for (u32 i {0}; i < count; ++i)
+        {
+            p.x[i]           = RandomRange(seed, -2000.f, 2000.f);
+            p.y[i]           = RandomRange(seed, -2000.f, 2000.f);
+            p.vx[i]          = RandomRange(seed, -500.f, 500.f);
+            p.vy[i]          = RandomRange(seed, -500.f, 500.f);
+            p.life[i]        = NextRandom(seed) % 16 == 0 ? params.deltaTime : RandomRange(seed, -0.1f, 3.f);
+            p.invLifetime[i] = 1.f / RandomRange(seed, 0.5f, 3.f);
+            p.size[i]        = RandomRange(seed, 1.f, 4.f);
+            p.color[i]       = NextRandom(seed);
+        }
+    }
+
+    // Survivors are packed to begin.
+    bool Compare(const Buffers& expected, u32 expectedCount, const Buffers& actual, u32 actualCount, u32 begin, const Char* kernel, u32 testCase)
+    {
+        if (expectedCount != actualCount)
+        {
+            printf("FAIL %s, case %u: %u survivors, the scalar kernel has %u.\n", kernel, testCase, actualCount, expectedCount);
+            return false;
+        }
+
+        for (u32 field {0}; field < FIELD_COUNT; ++field)
+        {
+            for (u32 i {begin}; i < begin + expectedCount; ++i)
+            {
+                if (expected.fields[field][i] != actual.fields[field][i])
+                {
+                    printf("FAIL %s, case %u: %s of particle %u is 0x%08x, the scalar kernel has 0x%08x.\n",
+                           kernel, testCase, FIELD_NAMES[field], i - begin, actual.fields[field][i], expected.fields[field][i]);
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+} // namespace anonymous
+
+int main()
+{
+    ParticleKernelsInit();
+
+    const ParticleKernel kernels[] {ParticleKernel::SSSE3, ParticleKernel::AVX2};
+    ParticleKernelFunction scalar {ParticleKernelGet(ParticleKernel::SCALAR)};
+    u32                    failures {0};
+    for (ParticleKernel kernel : kernels)
+    {
+        ParticleKernelFunction function {ParticleKernelGet(kernel)};
+        if (!function)
+        {
+            printf("SKIP %s: not supported here.\n", ParticleKernelName(kernel));
+            continue;
+        }
+
+        u32  seed {0x27D4EB2F};
+        bool passed {true};
+        for (u32 testCase {0}; testCase < CASE_COUNT && passed; ++testCase)
+        {
+            // Counts off the lane width, and a chunk that starts past 0 like the later jobs.
+            u32 count {1 + NextRandom(seed) % MAX_PARTICLES};
+            u32 begin {(NextRandom(seed) % 4) * PARTICLE_LANES};
+            u32 capacity {(begin + count + PARTICLE_LANES - 1) & ~(PARTICLE_LANES - 1)};
+
+            Buffers      input {};
+            UpdateParams params {};
+            Allocate(input, capacity);
+            Fill(input, begin + count, params, seed);
+
+            Buffers expected {};
+            Buffers actual {};
+            Copy(expected, input);
+            Copy(actual, input);
+            u32 expectedCount {scalar(expected.arrays, begin, begin + count, params)};
+            u32 actualCount {function(actual.arrays, begin, begin + count, params)};
+            passed = Compare(expected, expectedCount, actual, actualCount, begin, ParticleKernelName(kernel), testCase);
+        }
+
+        if (passed)
+        {
+            printf("PASS %s: %u random cases match the scalar kernel.\n", ParticleKernelName(kernel), CASE_COUNT);
+        }
+        failures += !passed;
+    }
+
+    return failures ? 1 : 0;
+}
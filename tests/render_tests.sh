@@ -0,0 +1,100 @@
+#!/bin/bash
+
+# Renders each scene below headless (EGL pbuffer, llvmpipe, no GPU or X server needed), compares one frame of it to
+# the golden image in tests/golden and fails when the frame times regress past the limits in
+# tests/golden/perf_thresholds.txt. Run through build.sh:
+#   ./build.sh test          check against the golden images
+#   ./build.sh test --bless  make this run's frames the new golden images
+
+GAME="$1"
+COMPARE="$2"
+MODE="$3"
+
+GOLDEN_DIR="tests/golden"
+OUTPUT_DIR="build/test_output"
+THRESHOLDS="${GOLDEN_DIR}/perf_thresholds.txt"
+
+FRAMES=120
+SCREENSHOT_FRAME=90 # Late enough for streamed textures to be in.
+FIXED_STEP_MS=16.667
+CHANNEL_TOLERANCE=8 # Rasterization and blending differences between Mesa versions.
+MAX_DIFFERING_PERCENT=0.5
+
+# name|arguments
+SCENES=(
+    "default|"
+    "nearest_half|--upscale nearest --resolution-scale 0.5"
+    "particles|--particles 20000"
+    "lights|--lights 256"
+    "gpu_culling|--objects 10000"
+    "tilemap|--tilemap 512"
+    "font|--font assets/fonts/debug_16.fnt"
+)
+
+export LIBGL_ALWAYS_SOFTWARE=1
+export GALLIUM_DRIVER=llvmpipe
+
+mkdir -p "$OUTPUT_DIR"
+failures=0
+
+for scene in "${SCENES[@]}"; do
+    name="${scene%%|*}"
+    arguments="${scene#*|}"
+    frame="${OUTPUT_DIR}/${name}.qoi"
+    stats="${OUTPUT_DIR}/${name}_stats.txt"
+    rm -f "$frame" "$stats"
+
+    # The fixed scale comes first so a scene can override it.
+    "$GAME" --headless --resolution-scale 1 $arguments --frames $FRAMES --fixed-step $FIXED_STEP_MS \
+        --screenshot $SCREENSHOT_FRAME "$frame" --frame-stats "$stats" > "${OUTPUT_DIR}/${name}.log" 2>&1
+    status=$?
+    if [[ $status -ne 0 || ! -f "$frame" ]]; then
+        echo "FAIL ${name}: exited with ${status}, see ${OUTPUT_DIR}/${name}.log"
+        failures=$((failures + 1))
+        continue
+    fi
+
+    if [[ "$MODE" == "--bless" ]]; then
+        cp "$frame" "${GOLDEN_DIR}/${name}.qoi"
+        echo "BLESS ${name}"
+        continue
+    fi
+
+    if [[ ! -f "${GOLDEN_DIR}/${name}.qoi" ]]; then
+        echo "FAIL ${name}: no golden image, run ./build.sh test --bless once and commit tests/golden."
+        failures=$((failures + 1))
+        continue
+    fi
+
+    if ! "$COMPARE" "$frame" "${GOLDEN_DIR}/${name}.qoi" $CHANNEL_TOLERANCE $MAX_DIFFERING_PERCENT "${OUTPUT_DIR}/${name}_diff.png"; then
+        echo "FAIL ${name}: image differs from the golden one, see ${OUTPUT_DIR}/${name}_diff.png"
+        failures=$((failures + 1))
+        continue
+    fi
+
+    # A missing or cut off stats file would make every comparison below pass.
+    median="$(awk '$1 == "median_ms" { print $2 }' "$stats" 2> /dev/null)"
+    p99="$(awk '$1 == "p99_ms" { print $2 }' "$stats" 2> /dev/null)"
+    if [[ -z "$median" ]]; then
+        echo "FAIL ${name}: no median_ms in ${stats}"
+        failures=$((failures + 1))
+        continue
+    fi
+
+    # "<scene> <median ms>", scenes without a line only get the image check. Only the median is gated: the tail of
+    # 120 frames on a shared single core runner is mostly scheduler noise, p99 is printed for reference.
+    maxMedian="$(awk -v scene="$name" '$1 == scene { print $2 }' "$THRESHOLDS")"
+    if [[ -n "$maxMedian" ]] && awk -v m="$median" -v mm="$maxMedian" 'BEGIN { exit !(m > mm) }'; then
+        echo "FAIL ${name}: frame time median ${median} ms, limit ${maxMedian} ms"
+        failures=$((failures + 1))
+        continue
+    fi
+
+    echo "PASS ${name}: median ${median} ms, p99 ${p99} ms"
+done
+
+if [[ $failures -ne 0 ]]; then
+    echo "${failures} render test(s) failed."
+    exit 1
+fi
+echo "All render tests passed."